@@ -7,52 +7,181 @@ Inevitably tokens must be mapped to values (some of them).
 */
 namespace sds
 {
+	/// <summary>
+	/// The keywords of the first three fields of a MapInformation token, in the order of the fields.
+	/// </summary>
+	enum class Keyword : std::uint8_t
+	{
+		X, Y, A, B, LTHUMB, RTHUMB, LTRIGGER, RTRIGGER, LSHOULDER, RSHOULDER, DPAD, START, BACK,
+		LEFT, DOWN, UP, RIGHT, NONE,
+		NORM, TOGGLE, RAPID, MACRO,
+		UNKNOWN
+	};
+	/// <summary>
+	/// The field of a MapInformation token a keyword is valid in.
+	/// </summary>
+	enum class KeywordField : std::uint8_t
+	{
+		NOT_KEYWORD,
+		CONTROL,
+		DIRECTION,
+		SIM_TYPE
+	};
+
+	/// <summary>
+	/// Compile time tables of the keywords, and a perfect hash from a string to its Keyword.
+	/// The hash seed is fixed and checked at compile time to put no two keywords in one slot, a lookup is then
+	/// one hash of the string, one slot read and one compare, ignoring the case of the string.
+	/// </summary>
+	namespace KeywordTable
+	{
+		//Keyword Count is the number of keywords, Keyword::UNKNOWN excluded.
+		constexpr size_t KEYWORD_COUNT = static_cast<size_t>(Keyword::UNKNOWN);
+		//Slot Count is the size of the hash table, a power of two, 64 one byte slots fill one cache line.
+		constexpr size_t SLOT_COUNT = 64;
+		//Text is the upper case text of each keyword, indexed by Keyword.
+		constexpr std::array<std::string_view, KEYWORD_COUNT> TEXT =
+		{
+			"X", "Y", "A", "B", "LTHUMB", "RTHUMB", "LTRIGGER", "RTRIGGER", "LSHOULDER", "RSHOULDER", "DPAD", "START", "BACK",
+			"LEFT", "DOWN", "UP", "RIGHT", "NONE",
+			"NORM", "TOGGLE", "RAPID", "MACRO"
+		};
+		static_assert(SLOT_COUNT >= KEYWORD_COUNT && (SLOT_COUNT & (SLOT_COUNT - 1)) == 0);
+
+		constexpr char ToUpper(const char c)
+		{
+			return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+		}
+		/// <summary>
+		/// Multiplicative hash of the length and the upper case first and last characters, the keywords differ in those,
+		/// so the cost does not depend on the length of the string.
+		/// </summary>
+		constexpr size_t GetSlot(const std::string_view s, const std::uint32_t seed)
+		{
+			if (s.empty())
+				return 0;
+			const std::uint32_t key = (static_cast<std::uint32_t>(static_cast<unsigned char>(ToUpper(s.front()))) << 16)
+				| (static_cast<std::uint32_t>(static_cast<unsigned char>(ToUpper(s.back()))) << 8)
+				| static_cast<std::uint32_t>(s.size() & 0xFF);
+			return (key * seed) >> (32 - std::countr_zero(SLOT_COUNT));
+		}
+		/// <summary>
+		/// Returns true if the seed gives each keyword a slot of its own.
+		/// </summary>
+		consteval bool IsCollisionFree(const std::uint32_t seed)
+		{
+			std::array<bool, SLOT_COUNT> used{};
+			for (size_t i = 0; i < KEYWORD_COUNT; i++)
+			{
+				const size_t slot = GetSlot(TEXT[i], seed);
+				if (used[slot])
+					return false;
+				used[slot] = true;
+			}
+			return true;
+		}
+		//Seed is the multiplier of GetSlot(), the first odd number from 0x9E3779B1, the golden ratio, that is collision free.
+		//A changed keyword list needs a new one, found by stepping the seed by two until IsCollisionFree() holds.
+		constexpr std::uint32_t SEED = 0x9E377B13u;
+		static_assert(IsCollisionFree(SEED), "The keywords collide with KeywordTable::SEED, find a new seed or increase SLOT_COUNT.");
+		consteval std::array<Keyword, SLOT_COUNT> BuildSlots()
+		{
+			std::array<Keyword, SLOT_COUNT> slots{};
+			slots.fill(Keyword::UNKNOWN);
+			for (size_t i = 0; i < KEYWORD_COUNT; i++)
+				slots[GetSlot(TEXT[i], SEED)] = static_cast<Keyword>(i);
+			return slots;
+		}
+		//Slots maps a hash slot to the keyword in it, Keyword::UNKNOWN for an empty slot.
+		constexpr std::array<Keyword, SLOT_COUNT> SLOTS = BuildSlots();
+
+		constexpr std::string_view GetText(const Keyword keyword)
+		{
+			return keyword == Keyword::UNKNOWN ? std::string_view() : TEXT[static_cast<size_t>(keyword)];
+		}
+		constexpr KeywordField GetField(const Keyword keyword)
+		{
+			if (keyword < Keyword::LEFT)
+				return KeywordField::CONTROL;
+			if (keyword < Keyword::NORM)
+				return KeywordField::DIRECTION;
+			if (keyword < Keyword::UNKNOWN)
+				return KeywordField::SIM_TYPE;
+			return KeywordField::NOT_KEYWORD;
+		}
+		/// <summary>
+		/// Compares a string to an upper case keyword, ignoring the case of the string.
+		/// </summary>
+		constexpr bool IsKeywordNoCase(const std::string_view s, const std::string_view keyword)
+		{
+			if (s.size() != keyword.size())
+				return false;
+			for (size_t i = 0; i < s.size(); i++)
+			{
+				if (ToUpper(s[i]) != keyword[i])
+					return false;
+			}
+			return true;
+		}
+		/// <summary>
+		/// Returns the keyword a string is, ignoring its case, Keyword::UNKNOWN if it is none.
+		/// </summary>
+		constexpr Keyword Find(const std::string_view s)
+		{
+			const Keyword keyword = SLOTS[GetSlot(s, SEED)];
+			return keyword != Keyword::UNKNOWN && IsKeywordNoCase(s, GetText(keyword)) ? keyword : Keyword::UNKNOWN;
+		}
+		static_assert(Find("ltrigger") == Keyword::LTRIGGER && Find("Macro") == Keyword::MACRO && Find("LTRIGGERS") == Keyword::UNKNOWN);
+	}
+
 	/// <summary>
 	/// ActionDescriptors is a big structure full of keywords that are used by other classes to enable
 	/// processing of an sds::ActionDetails string into meaningful information for the program.
-	/// It has a map&lt;string,int&gt; named "xin_buttons" that is very useful for mapping the string into XINPUT defines
+	/// Every member is a compile time constant, the keyword lookups use the perfect hash in KeywordTable.
+	/// It has an array of (token, bitmask) pairs named "xin_buttons" that is very useful for mapping the string into XINPUT defines
 	/// It also has member functions for validating each field of a properly formed token.
 	/// </summary>
 	struct ActionDescriptors
 	{
 		//using this declaration syntax gives intellisense the comments per variable.
-		const std::string x = "X"; // the string "X"
-		const std::string y = "Y"; // the string "Y"
-		const std::string a = "A"; // the string "A"
-		const std::string b = "B"; // the string "B"
-		const std::string lThumb = "LTHUMB"; // the string "LTHUMB"
-		const std::string rThumb = "RTHUMB"; // the string "RTHUMB"
-		const std::string lTrigger = "LTRIGGER"; // the string "LTRIGGER"
-		const std::string rTrigger = "RTRIGGER"; // the string "RTRIGGER"
-		const std::string lShoulder = "LSHOULDER"; // the string "LSHOULDER"
-		const std::string rShoulder = "RSHOULDER"; // the string "RSHOULDER"
-		const std::string dpad = "DPAD"; // the string "DPAD"
-		const std::string left = "LEFT"; // the string "LEFT"
-		const std::string down = "DOWN"; // the string "DOWN"
-		const std::string up = "UP"; // the string "UP"
-		const std::string right = "RIGHT"; // the string "RIGHT"
-		const std::string none = "NONE"; // the string "NONE"
-		const std::string start = "START"; // the string "START"
-		const std::string back = "BACK"; // the string "BACK"
-		const std::string vk = "VK"; // the string "VK"
-		const std::string norm = "NORM"; // the string "NORM"
-		const std::string toggle = "TOGGLE"; // the string "TOGGLE"
-		const std::string rapid = "RAPID"; // the string "RAPID"
+		static constexpr std::string_view x = KeywordTable::GetText(Keyword::X); // the string "X"
+		static constexpr std::string_view y = KeywordTable::GetText(Keyword::Y); // the string "Y"
+		static constexpr std::string_view a = KeywordTable::GetText(Keyword::A); // the string "A"
+		static constexpr std::string_view b = KeywordTable::GetText(Keyword::B); // the string "B"
+		static constexpr std::string_view lThumb = KeywordTable::GetText(Keyword::LTHUMB); // the string "LTHUMB"
+		static constexpr std::string_view rThumb = KeywordTable::GetText(Keyword::RTHUMB); // the string "RTHUMB"
+		static constexpr std::string_view lTrigger = KeywordTable::GetText(Keyword::LTRIGGER); // the string "LTRIGGER"
+		static constexpr std::string_view rTrigger = KeywordTable::GetText(Keyword::RTRIGGER); // the string "RTRIGGER"
+		static constexpr std::string_view lShoulder = KeywordTable::GetText(Keyword::LSHOULDER); // the string "LSHOULDER"
+		static constexpr std::string_view rShoulder = KeywordTable::GetText(Keyword::RSHOULDER); // the string "RSHOULDER"
+		static constexpr std::string_view dpad = KeywordTable::GetText(Keyword::DPAD); // the string "DPAD"
+		static constexpr std::string_view left = KeywordTable::GetText(Keyword::LEFT); // the string "LEFT"
+		static constexpr std::string_view down = KeywordTable::GetText(Keyword::DOWN); // the string "DOWN"
+		static constexpr std::string_view up = KeywordTable::GetText(Keyword::UP); // the string "UP"
+		static constexpr std::string_view right = KeywordTable::GetText(Keyword::RIGHT); // the string "RIGHT"
+		static constexpr std::string_view none = KeywordTable::GetText(Keyword::NONE); // the string "NONE"
+		static constexpr std::string_view start = KeywordTable::GetText(Keyword::START); // the string "START"
+		static constexpr std::string_view back = KeywordTable::GetText(Keyword::BACK); // the string "BACK"
+		static constexpr std::string_view vk = "VK"; // the string "VK"
+		static constexpr std::string_view norm = KeywordTable::GetText(Keyword::NORM); // the string "NORM"
+		static constexpr std::string_view toggle = KeywordTable::GetText(Keyword::TOGGLE); // the string "TOGGLE"
+		static constexpr std::string_view rapid = KeywordTable::GetText(Keyword::RAPID); // the string "RAPID"
+		static constexpr std::string_view macro = KeywordTable::GetText(Keyword::MACRO); // the string "MACRO"
 
-		const char moreInfo = ':'; // the char ':'
-		const char delimiter = ' ';//spacebar space
+		static constexpr char moreInfo = ':'; // the char ':'
+		static constexpr char delimiter = ' ';//spacebar space
 
-		const std::vector<std::string> FirstFieldValidKeywords
+		static constexpr std::array<std::string_view, 13> FirstFieldValidKeywords
 		{
 			x,y,a,b,lThumb,rThumb,lTrigger,rTrigger,lShoulder,rShoulder,dpad,start,back
 		};
-		const std::vector<std::string> SecondFieldValidKeywords
+		static constexpr std::array<std::string_view, 5> SecondFieldValidKeywords
 		{
 			left,down,up,right,none
 		};
-		const std::vector<std::string> ThirdFieldValidKeywords
+		static constexpr std::array<std::string_view, 4> ThirdFieldValidKeywords
 		{
-			norm,toggle,rapid
+			norm,toggle,rapid,macro
 		};
 		//Maps the tokens above to XINPUT library #defines
 		//Because the XINPUT lib doesn't send a "down" signal 
@@ -60,33 +189,75 @@ namespace sds
 		//isn't mapped to an xinput lib define bitmask here.
 		//instead lTrigger, rTrigger are tested against the current value
 		//in BYTE bLeftTrigger and bRightTrigger in the XINPUT_GAMEPAD struct
-		const std::map<const std::string, int> xin_buttons = 
-		{
+		static constexpr std::array<std::pair<std::string_view, int>, 14> xin_buttons =
+		{ {
 			{x,XINPUT_GAMEPAD_X},
 			{y,XINPUT_GAMEPAD_Y},
 			{a,XINPUT_GAMEPAD_A},
 			{b,XINPUT_GAMEPAD_B},
 			{lShoulder,XINPUT_GAMEPAD_LEFT_SHOULDER},
 			{rShoulder,XINPUT_GAMEPAD_RIGHT_SHOULDER},
-			{dpad + moreInfo + left, XINPUT_GAMEPAD_DPAD_LEFT},
-			{dpad + moreInfo + right, XINPUT_GAMEPAD_DPAD_RIGHT},
-			{dpad + moreInfo + up, XINPUT_GAMEPAD_DPAD_UP},
-			{dpad + moreInfo + down, XINPUT_GAMEPAD_DPAD_DOWN},
+			{"DPAD:LEFT", XINPUT_GAMEPAD_DPAD_LEFT},
+			{"DPAD:RIGHT", XINPUT_GAMEPAD_DPAD_RIGHT},
+			{"DPAD:UP", XINPUT_GAMEPAD_DPAD_UP},
+			{"DPAD:DOWN", XINPUT_GAMEPAD_DPAD_DOWN},
 			{start, XINPUT_GAMEPAD_START},
 			{back, XINPUT_GAMEPAD_BACK},
 			{lThumb, XINPUT_GAMEPAD_LEFT_THUMB},
 			{rThumb, XINPUT_GAMEPAD_RIGHT_THUMB}
-		};
+		} };
+		/// <summary>
+		/// Returns the XINPUT bitmask of a button token in xin_buttons, 0 if it is not one.
+		/// </summary>
+		static constexpr int GetButtonMask(const std::string_view token)
+		{
+			for (const auto &[buttonToken, mask] : xin_buttons)
+			{
+				if (buttonToken == token)
+					return mask;
+			}
+			return 0;
+		}
+		/// <summary>
+		/// Compares a string to an upper case keyword, ignoring the case of the string. Does not allocate.
+		/// </summary>
+		static constexpr bool IsKeywordNoCase(const std::string_view s, const std::string_view keyword)
+		{
+			return KeywordTable::IsKeywordNoCase(s, keyword);
+		}
+		/// <summary>
+		/// Finds a string in the keywords of a field, ignoring the case of the string.
+		/// </summary>
+		/// <returns>the keyword found, an empty string_view if there is none</returns>
+		static constexpr std::string_view FindKeyword(const KeywordField field, const std::string_view s)
+		{
+			const Keyword keyword = KeywordTable::Find(s);
+			return KeywordTable::GetField(keyword) == field ? KeywordTable::GetText(keyword) : std::string_view();
+		}
+		/// <summary>
+		/// Parses a fourth field of the "VK#" form, the number must be a decimal virtual keycode that fits in an unsigned char.
+		/// </summary>
+		/// <returns>the virtual keycode, -1 if the field is not of the "VK#" form</returns>
+		static int ParseVirtualKey(const std::string_view s)
+		{
+			if (s.size() <= vk.size() || !IsKeywordNoCase(s.substr(0, vk.size()), vk))
+				return -1;
+			const std::string_view digits = s.substr(vk.size());
+			unsigned int vki = 0;
+			const auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), vki);
+			if (ec != std::errc() || ptr != digits.data() + digits.size() || vki > std::numeric_limits<unsigned char>::max())
+				return -1;
+			return static_cast<int>(vki);
+		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
 		/// a member const keyword included in this struct.
 		/// </summary>
-		/// <param name="s">std::string s, the token you would test for acceptability in the first field.</param>
+		/// <param name="s">the token you would test for acceptability in the first field.</param>
 		/// <returns>returns true if string s is in the valid first field keywords list</returns>
-		bool IsFirstFieldKeyword(std::string s) const
+		static constexpr bool IsFirstFieldKeyword(const std::string_view s)
 		{
-			std::for_each(s.begin(), s.end(), [](char &c) { c = static_cast<char>(std::toupper(c)); });
-			return (std::find(FirstFieldValidKeywords.cbegin(), FirstFieldValidKeywords.cend(), s) != FirstFieldValidKeywords.cend());
+			return !FindKeyword(KeywordField::CONTROL, s).empty();
 		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
@@ -96,61 +267,53 @@ namespace sds
 		/// <param name="s">the string to test</param>
 		/// <param name="fixedOut">reference set to the case-fixed copy of the string</param>
 		/// <returns></returns>
-		bool IsFirstFieldKeyword(std::string s, std::string &fixedOut) const
+		static bool IsFirstFieldKeyword(const std::string_view s, std::string &fixedOut)
 		{
-			std::for_each(s.begin(), s.end(), [](char &c) { c = static_cast<char>(std::toupper(c)); });
-			fixedOut = s;
-			return (std::find(FirstFieldValidKeywords.cbegin(), FirstFieldValidKeywords.cend(), s) != FirstFieldValidKeywords.cend());
+			return FixCase(FindKeyword(KeywordField::CONTROL, s), s, fixedOut);
 		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
 		/// a member const keyword included in this struct.
 		/// </summary>
-		/// <param name="s">std::string s, the token you would test for acceptability in the second field.</param>
+		/// <param name="s">the token you would test for acceptability in the second field.</param>
 		/// <returns>returns true if string s is in the valid second field keywords list</returns>
-		bool IsSecondFieldKeyword(std::string s) const
+		static constexpr bool IsSecondFieldKeyword(const std::string_view s)
 		{
-			std::for_each(s.begin(), s.end(), [](char &c) { c = static_cast<char>(std::toupper(c)); });
-			return (std::find(SecondFieldValidKeywords.cbegin(), SecondFieldValidKeywords.cend(), s) != SecondFieldValidKeywords.cend());
+			return !FindKeyword(KeywordField::DIRECTION, s).empty();
 		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
 		/// a member const keyword included in this struct.
 		/// This version returns the case-fixed version via "fixedOut" reference.
 		/// </summary>
-		/// <param name="s">std::string s, the token you would test for acceptability in the second field.</param>
+		/// <param name="s">the token you would test for acceptability in the second field.</param>
 		/// <param name="fixedOut">reference set to the case-fixed copy of the string</param>
 		/// <returns>returns true if string s is in the valid second field keywords list</returns>
-		bool IsSecondFieldKeyword(std::string s, std::string &fixedOut) const
+		static bool IsSecondFieldKeyword(const std::string_view s, std::string &fixedOut)
 		{
-			std::for_each(s.begin(), s.end(), [](char &c) { c = static_cast<char>(std::toupper(c)); });
-			fixedOut = s;
-			return (std::find(SecondFieldValidKeywords.cbegin(), SecondFieldValidKeywords.cend(), s) != SecondFieldValidKeywords.cend());
+			return FixCase(FindKeyword(KeywordField::DIRECTION, s), s, fixedOut);
 		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
 		/// a member const keyword included in this struct.
 		/// </summary>
-		/// <param name="s">std::string s, the token you would test for acceptability in the third field.</param>
+		/// <param name="s">the token you would test for acceptability in the third field.</param>
 		/// <returns>returns true if string s is in the valid third field keywords list</returns>
-		bool IsThirdFieldKeyword(std::string s) const
+		static constexpr bool IsThirdFieldKeyword(const std::string_view s)
 		{
-			std::for_each(s.begin(), s.end(), [](char &c) { c = static_cast<char>(std::toupper(c)); });
-			return (std::find(ThirdFieldValidKeywords.cbegin(), ThirdFieldValidKeywords.cend(), s) != ThirdFieldValidKeywords.cend());
+			return !FindKeyword(KeywordField::SIM_TYPE, s).empty();
 		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
 		/// a member const keyword included in this struct.
 		/// This version returns the case-fixed version via "fixedOut" reference.
 		/// </summary>
-		/// <param name="s">std::string s, the token you would test for acceptability in the third field.</param>
+		/// <param name="s">the token you would test for acceptability in the third field.</param>
 		/// <param name="fixedOut">reference set to the case-fixed copy of the string</param>
 		/// <returns>returns true if string s is in the valid third field keywords list</returns>
-		bool IsThirdFieldKeyword(std::string s, std::string &fixedOut) const
+		static bool IsThirdFieldKeyword(const std::string_view s, std::string &fixedOut)
 		{
-			std::for_each(s.begin(), s.end(), [](char &c) { c = static_cast<char>(std::toupper(c)); });
-			fixedOut = s;
-			return (std::find(ThirdFieldValidKeywords.cbegin(), ThirdFieldValidKeywords.cend(), s) != ThirdFieldValidKeywords.cend());
+			return FixCase(FindKeyword(KeywordField::SIM_TYPE, s), s, fixedOut);
 		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
@@ -158,45 +321,12 @@ namespace sds
 		/// For the fourth field, if it contains one character it returns true.
 		/// If it starts with VK and also contains an integer number after, it returns true.
 		/// </summary>
-		/// <param name="s">std::string s, the token you would test for acceptability in the fourth field.</param>
+		/// <param name="s">the token you would test for acceptability in the fourth field.</param>
 		/// <returns>returns true if valid field, false otherwise</returns>
-		bool IsFourthFieldKeyword(const std::string s) const
+		static bool IsFourthFieldKeyword(const std::string_view s)
 		{
 			//single character case, good
-			if (s.size() == 1)
-				return true;
-			//check for starting with "VK" but also has a decimal value after
-			if (s.size() > vk.size())
-			{
-				std::string theFirst = s.substr(0, vk.size());
-				std::for_each(theFirst.begin(), theFirst.end(), [](char &c)
-					{
-						if(!std::isupper(c))
-							c = static_cast<char>(std::toupper(c));
-					});
-				//if first two characters are "VK"
-				if (theFirst == vk)
-				{
-					//grab everything after "VK"
-					const std::string val = s.substr(vk.size());//everything after "VK"
-					int vki = 0;
-					//be sure to catch the "out of range exception" if some massive value is attempted
-					try
-					{
-						vki = std::stoi(val); // can throw an exception
-						// virtual keycodes fit in a character.
-						if (vki > std::numeric_limits<unsigned char>::max() || vki < std::numeric_limits<unsigned char>::min())
-							return false;
-						else
-							return true;
-					}
-					catch (...)
-					{
-						return false;
-					}
-				}
-			}
-			return false;
+			return s.size() == 1 || ParseVirtualKey(s) >= 0;
 		}
 		/// <summary>
 		/// This member function can be used to verify that a string is
@@ -205,51 +335,30 @@ namespace sds
 		/// If it starts with VK and also contains an integer number after, it returns true.
 		/// This version returns the case-fixed version via "fixedOut" reference.
 		/// </summary>
-		/// <param name="s">std::string s, the token you would test for acceptability in the fourth field.</param>
+		/// <param name="s">the token you would test for acceptability in the fourth field.</param>
 		/// <param name="fixedOut">reference set to the case-fixed copy of the string IF the string is of the "VK#" style,
 		/// otherwise the single character already in "s"</param>
 		/// <returns>returns true if valid field, false otherwise</returns>
-		bool IsFourthFieldKeyword(const std::string s, std::string &fixedOut) const
+		static bool IsFourthFieldKeyword(const std::string_view s, std::string &fixedOut)
 		{
-			//single character case, good
-			if (s.size() == 1)
+			if (!IsFourthFieldKeyword(s))
+				return false;
+			fixedOut = s.size() == 1 ? std::string(s) : std::string(vk) + std::string(s.substr(vk.size()));
+			return true;
+		}
+	private:
+		/// <summary>
+		/// Sets fixedOut to the keyword found, or to an upper case copy of the string if none was.
+		/// </summary>
+		static bool FixCase(const std::string_view keyword, const std::string_view s, std::string &fixedOut)
+		{
+			if (!keyword.empty())
 			{
-				fixedOut = s;
+				fixedOut = keyword;
 				return true;
 			}
-			//check for starting with "VK" but also has a decimal value after
-			if (s.size() > vk.size())
-			{
-				std::string theFirst = s.substr(0, vk.size());
-				std::ranges::for_each(theFirst.begin(), theFirst.end(), [](char &c)
-					{
-						if (!std::isupper(c))
-							c = static_cast<char>(std::toupper(c));
-					});
-				//if first two characters are "VK"
-				if (theFirst == vk)
-				{
-					//grab everything after "VK"
-					const std::string val = s.substr(vk.size());//everything after "VK"
-					//be sure to catch the "out of range exception" if some massive value is attempted
-					try
-					{
-						const int vki = std::stoi(val); // can throw an exception
-						// virtual keycodes fit in an unsigned character.
-						if (vki > std::numeric_limits<unsigned char>::max() || vki < std::numeric_limits<unsigned char>::min())
-							return false;
-						else
-						{
-							fixedOut = theFirst + val;
-							return true;
-						}
-					}
-					catch (...)
-					{
-						return false;
-					}
-				}
-			}
+			fixedOut = s;
+			std::for_each(fixedOut.begin(), fixedOut.end(), [](char &c) { c = static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
 			return false;
 		}
 	};
@@ -0,0 +1,463 @@
+#pragma once
+#include "stdafx.h"
+#include <condition_variable>
+#include <source_location>
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Severity of a logged message, messages below the minimum set on the AsyncLogger are discarded.
+		/// </summary>
+		enum class LogSeverity : std::uint8_t
+		{
+			SEVERITY_DEBUG,
+			SEVERITY_INFO,
+			SEVERITY_WARNING,
+			SEVERITY_ERROR
+		};
+		/// <summary>
+		/// One logged message, copied into the ring buffer by the thread logging it.
+		/// Messages longer than LOG_MESSAGE_MAX are truncated.
+		/// </summary>
+		struct LogRecord
+		{
+			LogSeverity severity = LogSeverity::SEVERITY_INFO;
+			std::uint32_t line = 0;
+			const char *file = "";
+			//number of messages from the same call site suppressed by the rate limit before this one
+			std::uint32_t suppressed = 0;
+			std::uint16_t length = 0;
+			std::array<char, XinSettings::LOG_MESSAGE_MAX> text{};
+
+			std::string_view GetText() const
+			{
+				return { text.data(), length };
+			}
+			static std::string_view GetSeverityName(const LogSeverity severity)
+			{
+				switch (severity)
+				{
+				case LogSeverity::SEVERITY_DEBUG: return "DEBUG";
+				case LogSeverity::SEVERITY_INFO: return "INFO";
+				case LogSeverity::SEVERITY_WARNING: return "WARNING";
+				default: return "ERROR";
+				}
+			}
+			/// <summary>
+			/// The line written by the console and file sinks, "[SEVERITY] message" followed by the suppressed count if any.
+			/// </summary>
+			std::string Format() const
+			{
+				std::string line = "[" + std::string(GetSeverityName(severity)) + "] " + std::string(GetText());
+				if (suppressed > 0)
+					line += " (" + std::to_string(suppressed) + " more suppressed)";
+				return line;
+			}
+		};
+
+		/// <summary>
+		/// Destination of the log records, written only by the flush thread of the AsyncLogger.
+		/// </summary>
+		class LogSink
+		{
+		public:
+			LogSink() = default;
+			LogSink(const LogSink& other) = delete;
+			LogSink(LogSink&& other) = delete;
+			LogSink& operator=(const LogSink& other) = delete;
+			LogSink& operator=(LogSink&& other) = delete;
+			virtual ~LogSink() = default;
+			virtual void Write(const LogRecord &record) = 0;
+			/// <summary>
+			/// Called after each batch of records is written.
+			/// </summary>
+			virtual void Flush() { }
+		};
+		/// <summary>
+		/// Writes to std::cerr, flushed once per batch instead of once per line.
+		/// </summary>
+		class ConsoleLogSink : public LogSink
+		{
+		public:
+			void Write(const LogRecord &record) override
+			{
+				std::cerr << record.Format() << '\n';
+			}
+			void Flush() override
+			{
+				std::cerr.flush();
+			}
+		};
+		/// <summary>
+		/// Appends to a file.
+		/// </summary>
+		class FileLogSink : public LogSink
+		{
+			std::ofstream m_file;
+		public:
+			/// <returns>A std::string containing an error message if there is an error, empty string otherwise.</returns>
+			[[nodiscard]] std::string Open(const std::string &fileName)
+			{
+				m_file.open(fileName, std::ios::out | std::ios::app);
+				if (!m_file)
+					return "Error in sds::Utilities::FileLogSink::Open(), failed to open file: " + fileName;
+				return "";
+			}
+			void Write(const LogRecord &record) override
+			{
+				if (m_file)
+					m_file << record.Format() << '\n';
+			}
+			void Flush() override
+			{
+				m_file.flush();
+			}
+		};
+		/// <summary>
+		/// Keeps the records in memory, for tests.
+		/// </summary>
+		class MemoryLogSink : public LogSink
+		{
+			mutable std::mutex m_recordsMutex;
+			std::vector<LogRecord> m_records;
+		public:
+			void Write(const LogRecord &record) override
+			{
+				std::lock_guard<std::mutex> l1(m_recordsMutex);
+				m_records.push_back(record);
+			}
+			[[nodiscard]] std::vector<LogRecord> GetRecords() const
+			{
+				std::lock_guard<std::mutex> l1(m_recordsMutex);
+				return m_records;
+			}
+			void Clear()
+			{
+				std::lock_guard<std::mutex> l1(m_recordsMutex);
+				m_records.clear();
+			}
+		};
+
+		/// <summary>
+		/// Logger that never blocks the thread logging. A message is copied into a bounded multi-producer single-consumer
+		/// ring buffer, each producer claims a cell with a compare-exchange and publishes it with a per-cell sequence number,
+		/// and a background thread drains the ring into the sinks every LOG_FLUSH_INTERVAL_MILLI, when it is half full
+		/// or when Flush() is called.
+		/// A message logged with the ring full is dropped and counted.
+		/// Each call site, told apart by its std::source_location, may log LOG_RATE_LIMIT_PER_SITE messages per
+		/// LOG_RATE_WINDOW_MILLI, the rest are counted and the count is reported with the next message let through.
+		/// Call sites hashing to the same one of the LOG_RATE_SITES slots share a limit.
+		/// </summary>
+		class AsyncLogger
+		{
+		public:
+			using ClockType = std::chrono::steady_clock;
+			/// <summary>
+			/// Totals since construction.
+			/// </summary>
+			struct Stats
+			{
+				std::uint64_t logged = 0;
+				std::uint64_t suppressed = 0;
+				std::uint64_t dropped = 0;
+			};
+		private:
+			/// <summary>
+			/// Sequence equals the position of the write that may claim the cell, and that position + 1 once the record is published.
+			/// </summary>
+			struct Cell
+			{
+				std::atomic<size_t> sequence{ 0 };
+				LogRecord record;
+			};
+			struct RateSlot
+			{
+				std::atomic<std::int64_t> window{ -1 };
+				std::atomic<std::uint32_t> count{ 0 };
+				std::atomic<std::uint32_t> suppressed{ 0 };
+			};
+			const size_t m_capacity;
+			std::unique_ptr<Cell[]> m_cells;
+			alignas(XinSettings::CACHE_LINE_SIZE) std::atomic<size_t> m_writePosition{ 0 };
+			alignas(XinSettings::CACHE_LINE_SIZE) size_t m_readPosition = 0;
+			std::unique_ptr<RateSlot[]> m_rateSlots;
+			std::atomic<std::uint32_t> m_ratePerSite{ XinSettings::LOG_RATE_LIMIT_PER_SITE };
+			std::atomic<LogSeverity> m_minSeverity{ LogSeverity::SEVERITY_INFO };
+			std::atomic<std::uint64_t> m_logged{ 0 };
+			std::atomic<std::uint64_t> m_suppressed{ 0 };
+			std::atomic<std::uint64_t> m_dropped{ 0 };
+			const ClockType::time_point m_startTime;
+			//held by the flush thread while writing to the sinks
+			std::mutex m_sinksMutex;
+			ConsoleLogSink m_consoleSink;
+			std::vector<LogSink*> m_sinks;
+			std::mutex m_flushMutex;
+			std::condition_variable m_flushWake;
+			std::condition_variable m_flushDone;
+			std::uint64_t m_flushRequested = 0;
+			std::uint64_t m_flushCompleted = 0;
+			bool m_isStopRequested = false;
+			//work posted to run on the flush thread, guarded by m_flushMutex
+			std::vector<std::function<void()>> m_tasks;
+			//set by the producer that fills the ring to half or finds it full, so a burst does not wait for the flush interval
+			std::atomic<bool> m_isDrainRequested{ false };
+			std::thread m_flushThread;
+		public:
+			/// <summary>
+			/// Ctor, starts the flush thread writing to the console sink. Capacity must be a power of two, at least 2.
+			/// </summary>
+			explicit AsyncLogger(const size_t capacity = XinSettings::LOG_RING_CAPACITY)
+				: m_capacity(capacity),
+				m_cells(std::make_unique<Cell[]>(capacity)),
+				m_rateSlots(std::make_unique<RateSlot[]>(XinSettings::LOG_RATE_SITES)),
+				m_startTime(ClockType::now()),
+				m_sinks{ &m_consoleSink }
+			{
+				for (size_t i = 0; i < m_capacity; i++)
+					m_cells[i].sequence.store(i, std::memory_order_relaxed);
+				m_flushThread = std::thread([this]() { Run(); });
+			}
+			AsyncLogger(const AsyncLogger& other) = delete;
+			AsyncLogger(AsyncLogger&& other) = delete;
+			AsyncLogger& operator=(const AsyncLogger& other) = delete;
+			AsyncLogger& operator=(AsyncLogger&& other) = delete;
+			/// <summary>
+			/// Dtor, the records still in the ring are written before the flush thread exits.
+			/// </summary>
+			~AsyncLogger()
+			{
+				{
+					std::lock_guard<std::mutex> l1(m_flushMutex);
+					m_isStopRequested = true;
+				}
+				m_flushWake.notify_one();
+				m_flushThread.join();
+			}
+			/// <summary>
+			/// The process wide logger used by XErrorLogger.
+			/// </summary>
+			static AsyncLogger& Get()
+			{
+				static AsyncLogger logger;
+				return logger;
+			}
+			/// <summary>
+			/// Copies a message into the ring, never blocks.
+			/// </summary>
+			/// <returns>true if the message was queued, false if it was below the minimum severity, rate limited or dropped</returns>
+			bool Log(const LogSeverity severity, const std::string_view message, const std::source_location location = std::source_location::current())
+			{
+				return LogWith(severity, location, [message](char *out, const size_t capacity)
+					{
+						const size_t length = std::min(message.size(), capacity);
+						std::copy_n(message.data(), length, out);
+						return length;
+					});
+			}
+			/// <summary>
+			/// Like Log(), the message is written straight into the ring by "writeMessage" only if it passes the minimum severity
+			/// and the rate limit, so a message that is not logged is never built.
+			/// </summary>
+			/// <param name="writeMessage">called as writeMessage(char *out, size_t capacity), returns the length of the message,
+			/// which is truncated to the capacity</param>
+			template<typename Writer>
+			bool LogWith(const LogSeverity severity, const std::source_location &location, Writer &&writeMessage)
+			{
+				if (severity < m_minSeverity.load(std::memory_order_relaxed))
+					return false;
+				std::uint32_t suppressed = 0;
+				if (!IsAllowed(location, suppressed))
+				{
+					m_suppressed.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				size_t position = m_writePosition.load(std::memory_order_relaxed);
+				Cell *cell;
+				for (;;)
+				{
+					cell = &m_cells[position & (m_capacity - 1)];
+					const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+					const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+					if (difference == 0)
+					{
+						if (m_writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+							break;
+					}
+					else if (difference < 0)
+					{
+						m_dropped.fetch_add(1, std::memory_order_relaxed);
+						RequestDrain();
+						return false;
+					}
+					else
+						position = m_writePosition.load(std::memory_order_relaxed);
+				}
+				LogRecord &record = cell->record;
+				record.severity = severity;
+				record.line = location.line();
+				record.file = location.file_name();
+				record.suppressed = suppressed;
+				record.length = static_cast<std::uint16_t>(std::min(static_cast<size_t>(writeMessage(record.text.data(), record.text.size())), record.text.size()));
+				cell->sequence.store(position + 1, std::memory_order_release);
+				m_logged.fetch_add(1, std::memory_order_relaxed);
+				if (((position + 1) & (m_capacity / 2 - 1)) == 0)
+					RequestDrain();
+				return true;
+			}
+			/// <summary>
+			/// Waits until the records logged before the call are written to the sinks.
+			/// </summary>
+			void Flush()
+			{
+				std::unique_lock<std::mutex> l1(m_flushMutex);
+				const std::uint64_t ticket = ++m_flushRequested;
+				m_flushWake.notify_one();
+				m_flushDone.wait(l1, [this, ticket]() { return m_flushCompleted >= ticket || m_isStopRequested; });
+			}
+			/// <summary>
+			/// Runs the task on the flush thread after its next drain, to keep slow work such as writing a file off a hot thread.
+			/// Takes a lock and may allocate, so it is for rare events. A task posted after the logger stops is not run.
+			/// </summary>
+			void Post(std::function<void()> task)
+			{
+				{
+					std::lock_guard<std::mutex> l1(m_flushMutex);
+					if (m_isStopRequested)
+						return;
+					m_tasks.push_back(std::move(task));
+				}
+				m_flushWake.notify_one();
+			}
+			/// <summary>
+			/// Adds a sink, it must outlive the logger or be removed first.
+			/// </summary>
+			void AddSink(LogSink *sink)
+			{
+				std::lock_guard<std::mutex> l1(m_sinksMutex);
+				if (sink != nullptr && std::find(m_sinks.begin(), m_sinks.end(), sink) == m_sinks.end())
+					m_sinks.push_back(sink);
+			}
+			/// <summary>
+			/// Removes a sink, it is not written to once this returns.
+			/// </summary>
+			void RemoveSink(LogSink *sink)
+			{
+				std::lock_guard<std::mutex> l1(m_sinksMutex);
+				m_sinks.erase(std::remove(m_sinks.begin(), m_sinks.end(), sink), m_sinks.end());
+			}
+			/// <summary>
+			/// The console sink added by the ctor, to remove it.
+			/// </summary>
+			LogSink *GetConsoleSink()
+			{
+				return &m_consoleSink;
+			}
+			void SetMinSeverity(const LogSeverity severity)
+			{
+				m_minSeverity.store(severity, std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Sets the number of messages a call site may log per LOG_RATE_WINDOW_MILLI, zero disables the limit.
+			/// </summary>
+			void SetRateLimit(const std::uint32_t perSite)
+			{
+				m_ratePerSite.store(perSite, std::memory_order_relaxed);
+			}
+			Stats GetStats() const
+			{
+				return { m_logged.load(std::memory_order_relaxed), m_suppressed.load(std::memory_order_relaxed), m_dropped.load(std::memory_order_relaxed) };
+			}
+		private:
+			/// <summary>
+			/// Wakes the flush thread before its interval, called when the ring is half full or a message is dropped.
+			/// Only the first request before the flush thread wakes takes the mutex, which closes the window between
+			/// the flush thread checking the request and waiting, so a wake is never lost.
+			/// </summary>
+			void RequestDrain()
+			{
+				if (m_isDrainRequested.exchange(true, std::memory_order_relaxed))
+					return;
+				{
+					std::lock_guard<std::mutex> l1(m_flushMutex);
+				}
+				m_flushWake.notify_one();
+			}
+			/// <summary>
+			/// Counts a message against the limit of its call site. The first message of a new window takes the count
+			/// of those suppressed in the windows before it.
+			/// </summary>
+			bool IsAllowed(const std::source_location &location, std::uint32_t &suppressedOut)
+			{
+				const std::uint32_t perSite = m_ratePerSite.load(std::memory_order_relaxed);
+				if (perSite == 0)
+					return true;
+				const size_t hash = std::hash<const void*>{}(location.file_name()) ^ (static_cast<size_t>(location.line()) * 0x9E3779B97F4A7C15ull);
+				RateSlot &slot = m_rateSlots[hash % XinSettings::LOG_RATE_SITES];
+				const std::int64_t window = std::chrono::duration_cast<std::chrono::milliseconds>(ClockType::now() - m_startTime).count() / XinSettings::LOG_RATE_WINDOW_MILLI;
+				std::int64_t lastWindow = slot.window.load(std::memory_order_relaxed);
+				if (lastWindow != window && slot.window.compare_exchange_strong(lastWindow, window, std::memory_order_relaxed))
+				{
+					slot.count.store(1, std::memory_order_relaxed);
+					suppressedOut = slot.suppressed.exchange(0, std::memory_order_relaxed);
+					return true;
+				}
+				if (slot.count.fetch_add(1, std::memory_order_relaxed) < perSite)
+					return true;
+				slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			/// <summary>
+			/// Pops the published records in order and writes them to the sinks.
+			/// </summary>
+			void Drain()
+			{
+				std::lock_guard<std::mutex> l1(m_sinksMutex);
+				bool isWritten = false;
+				for (;;)
+				{
+					Cell &cell = m_cells[m_readPosition & (m_capacity - 1)];
+					if (cell.sequence.load(std::memory_order_acquire) != m_readPosition + 1)
+						break;
+					for (LogSink *sink : m_sinks)
+						sink->Write(cell.record);
+					cell.sequence.store(m_readPosition + m_capacity, std::memory_order_release);
+					m_readPosition++;
+					isWritten = true;
+				}
+				if (isWritten)
+				{
+					for (LogSink *sink : m_sinks)
+						sink->Flush();
+				}
+			}
+			void Run()
+			{
+				std::unique_lock<std::mutex> l1(m_flushMutex);
+				for (;;)
+				{
+					m_flushWake.wait_for(l1, std::chrono::milliseconds(XinSettings::LOG_FLUSH_INTERVAL_MILLI),
+						[this]() { return m_isStopRequested || m_flushRequested > m_flushCompleted || !m_tasks.empty() || m_isDrainRequested.load(std::memory_order_relaxed); });
+					m_isDrainRequested.store(false, std::memory_order_relaxed);
+					const std::uint64_t requested = m_flushRequested;
+					const bool isStopping = m_isStopRequested;
+					std::vector<std::function<void()>> tasks;
+					tasks.swap(m_tasks);
+					l1.unlock();
+					Drain();
+					for (const std::function<void()> &task : tasks)
+						task();
+					//records the tasks logged are written before a flush waiting on them returns
+					if (!tasks.empty())
+						Drain();
+					l1.lock();
+					m_flushCompleted = requested;
+					m_flushDone.notify_all();
+					if (isStopping)
+						return;
+				}
+			}
+		};
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "stdafx.h"
 #include "MapFunctions.h"
+#include "RadialDeadzone.h"
 
 namespace sds
 {
@@ -12,13 +13,22 @@ namespace sds
 	class ButtonStateDown
 	{
 		sds::PlayerInfo m_localPlayer;
+		//Direction-to-key translation only needs the radius and sector tests, so SCALED_RADIAL is treated as RADIAL here.
+		RadialDeadzone m_leftRadial;
+		RadialDeadzone m_rightRadial;
 		using MyVariant = std::variant<std::less<>, std::greater<>>;
 		using MyTuple = std::tuple<int, int, MyVariant>;
+		static DeadzoneMode GetKeyDeadzoneMode(const sds::PlayerInfo &player)
+		{
+			return player.deadzone_mode == DeadzoneMode::AXIAL ? DeadzoneMode::AXIAL : DeadzoneMode::RADIAL;
+		}
 	public:
-		ButtonStateDown() = default;
+		ButtonStateDown() : ButtonStateDown(sds::PlayerInfo{}) { }
 		ButtonStateDown(const sds::PlayerInfo &player)
+			: m_localPlayer(player),
+			m_leftRadial(GetKeyDeadzoneMode(player), RadialDeadzone::GetRadiusFromPlayer(player, true)),
+			m_rightRadial(GetKeyDeadzoneMode(player), RadialDeadzone::GetRadiusFromPlayer(player, false))
 		{
-			m_localPlayer = player;
 		}
 		ButtonStateDown(const ButtonStateDown& other) = delete;
 		ButtonStateDown(ButtonStateDown&& other) = delete;
@@ -31,14 +41,9 @@ namespace sds
 		/// <param name="state"> an XINPUT_STATE with current input from the controller</param>
 		/// <param name="token"> a string specifying the button info for comparison</param>
 		/// <returns>true if the button is depressed, false otherwise</returns>
-		bool ButtonDown(const XINPUT_STATE& state, const std::string token) const
+		bool ButtonDown(const XINPUT_STATE& state, const std::string_view token) const
 		{
-			using namespace Utilities::MapFunctions;
-			if(IsInMap<const std::string,int>(token,sds::sdsActionDescriptors.xin_buttons))
-			{
-				return state.Gamepad.wButtons & sds::sdsActionDescriptors.xin_buttons.at(token);
-			}
-			return false;
+			return state.Gamepad.wButtons & sds::sdsActionDescriptors.GetButtonMask(token);
 		}
 		/// <summary>
 		/// Utility function that returns true if the trigger "token" is reported as depressed
@@ -47,7 +52,7 @@ namespace sds
 		/// <param name="state">is an XINPUT_STATE struct with details on the current reported controller state</param>
 		/// <param name="token">is a one-part token containing normally a trigger designation "LTRIGGER" or "RTRIGGER"</param>
 		/// <returns>true if trigger is depressed, false otherwise</returns>
-		bool TriggerDown(const XINPUT_STATE& state, const std::string token) const
+		bool TriggerDown(const XINPUT_STATE& state, const std::string_view token) const
 		{
 			if (token == sds::sdsActionDescriptors.lTrigger)
 			{
@@ -73,9 +78,11 @@ namespace sds
 		/// <param name="token"> is a two-part token containing normally a button and a direction for the thumbsticks,
 		/// colon delimited</param>
 		/// <returns>true if thumbstick+direction is pressed</returns>
-		bool ThumbstickDown(const XINPUT_STATE& state, const std::string token) const
+		bool ThumbstickDown(const XINPUT_STATE& state, const std::string &token) const
 		{
 			using namespace Utilities::MapFunctions;
+			if (m_leftRadial.IsRadial())
+				return ThumbstickDownRadial(state, token);
 			auto &&m_thumbstickMap = BuildThumbstickMap(state);
 			MyTuple myTup;
 			if (IsInMap<std::string,MyTuple,int,MyVariant>(token, m_thumbstickMap,myTup))
@@ -89,6 +96,42 @@ namespace sds
 			return false;
 		}
 		/// <summary>
+		/// Radial deadzone version of ThumbstickDown(), the thumbstick must be outside of the deadzone radius
+		/// and within the 8-way sector of the token's direction.
+		/// </summary>
+		/// <param name="state"> is an XINPUT_STATE struct with details on the current reported controller state</param>
+		/// <param name="token"> is a two-part token containing normally a button and a direction for the thumbsticks,
+		/// colon delimited</param>
+		/// <returns>true if thumbstick+direction is pressed</returns>
+		bool ThumbstickDownRadial(const XINPUT_STATE& state, const std::string_view token) const
+		{
+			using sds::sdsActionDescriptors;
+			//token is "<thumb>:<direction>", the thumb names are the same length so the split needs no search
+			static_assert(ActionDescriptors::lThumb.size() == ActionDescriptors::rThumb.size());
+			constexpr size_t thumbSize = ActionDescriptors::lThumb.size();
+			if (token.size() <= thumbSize || token[thumbSize] != sdsActionDescriptors.moreInfo)
+				return false;
+			const std::string_view thumb = token.substr(0, thumbSize);
+			const bool isLeft = thumb == sdsActionDescriptors.lThumb;
+			if (!isLeft && thumb != sdsActionDescriptors.rThumb)
+				return false;
+			const std::string_view direction = token.substr(thumbSize + 1);
+			const int x = isLeft ? state.Gamepad.sThumbLX : state.Gamepad.sThumbRX;
+			const int y = isLeft ? state.Gamepad.sThumbLY : state.Gamepad.sThumbRY;
+			const RadialDeadzone &radial = isLeft ? m_leftRadial : m_rightRadial;
+			if (!radial.IsBeyondDeadzone(x, y))
+				return false;
+			if (direction == sdsActionDescriptors.left)
+				return RadialDeadzone::IsWithinSector(-x, y);
+			if (direction == sdsActionDescriptors.right)
+				return RadialDeadzone::IsWithinSector(x, y);
+			if (direction == sdsActionDescriptors.up)
+				return RadialDeadzone::IsWithinSector(y, x);
+			if (direction == sdsActionDescriptors.down)
+				return RadialDeadzone::IsWithinSector(-y, x);
+			return false;
+		}
+		/// <summary>
 		/// Builds a map of string tokens to the tuple type with deadzone, current value, and functor
 		///	from an XINPUT_STATE arg.
 		/// </summary>
@@ -103,19 +146,19 @@ namespace sds
 			//map each string to each deadzone, current value, and operation "functor"
 			map<string, MyTuple> someOtherMap;
 
-			string temp = sds::sdsActionDescriptors.lThumb + sds::sdsActionDescriptors.moreInfo;
+			string temp = string(sdsActionDescriptors.lThumb) + sdsActionDescriptors.moreInfo;
 			//left thumbstick tokens
-			someOtherMap[temp + sdsActionDescriptors.left] = make_tuple(-static_cast<int>(m_localPlayer.left_x_dz), state.Gamepad.sThumbLX, std::less<>());
-			someOtherMap[temp + sdsActionDescriptors.right] = make_tuple(static_cast<int>(m_localPlayer.left_x_dz), state.Gamepad.sThumbLX, std::greater<>());
-			someOtherMap[temp + sdsActionDescriptors.down] = make_tuple(-static_cast<int>(m_localPlayer.left_y_dz), state.Gamepad.sThumbLY, std::less<>());
-			someOtherMap[temp + sdsActionDescriptors.up] = make_tuple(static_cast<int>(m_localPlayer.left_y_dz), state.Gamepad.sThumbLY, std::greater<>());
+			someOtherMap[temp + string(sdsActionDescriptors.left)] = make_tuple(-static_cast<int>(m_localPlayer.left_x_dz), state.Gamepad.sThumbLX, std::less<>());
+			someOtherMap[temp + string(sdsActionDescriptors.right)] = make_tuple(static_cast<int>(m_localPlayer.left_x_dz), state.Gamepad.sThumbLX, std::greater<>());
+			someOtherMap[temp + string(sdsActionDescriptors.down)] = make_tuple(-static_cast<int>(m_localPlayer.left_y_dz), state.Gamepad.sThumbLY, std::less<>());
+			someOtherMap[temp + string(sdsActionDescriptors.up)] = make_tuple(static_cast<int>(m_localPlayer.left_y_dz), state.Gamepad.sThumbLY, std::greater<>());
 
 			//right thumbstick tokens
-			temp = sds::sdsActionDescriptors.rThumb + sds::sdsActionDescriptors.moreInfo;
-			someOtherMap[temp + sdsActionDescriptors.left] = make_tuple(-static_cast<int>(m_localPlayer.right_x_dz), state.Gamepad.sThumbRX, std::less<>());
-			someOtherMap[temp + sdsActionDescriptors.right] = make_tuple(static_cast<int>(m_localPlayer.right_x_dz), state.Gamepad.sThumbRX, std::greater<>());
-			someOtherMap[temp + sdsActionDescriptors.down] = make_tuple(-static_cast<int>(m_localPlayer.right_y_dz), state.Gamepad.sThumbRY, std::less<>());
-			someOtherMap[temp + sdsActionDescriptors.up] = make_tuple(static_cast<int>(m_localPlayer.right_y_dz), state.Gamepad.sThumbRY, std::greater<>());
+			temp = string(sdsActionDescriptors.rThumb) + sdsActionDescriptors.moreInfo;
+			someOtherMap[temp + string(sdsActionDescriptors.left)] = make_tuple(-static_cast<int>(m_localPlayer.right_x_dz), state.Gamepad.sThumbRX, std::less<>());
+			someOtherMap[temp + string(sdsActionDescriptors.right)] = make_tuple(static_cast<int>(m_localPlayer.right_x_dz), state.Gamepad.sThumbRX, std::greater<>());
+			someOtherMap[temp + string(sdsActionDescriptors.down)] = make_tuple(-static_cast<int>(m_localPlayer.right_y_dz), state.Gamepad.sThumbRY, std::less<>());
+			someOtherMap[temp + string(sdsActionDescriptors.up)] = make_tuple(static_cast<int>(m_localPlayer.right_y_dz), state.Gamepad.sThumbRY, std::greater<>());
 			return someOtherMap;
 		}
 	};
@@ -5,6 +5,7 @@ Base class for async operations.
 #include <thread>
 #include <mutex>
 #include <functional>
+#include "ThreadPolicy.h"
 
 namespace sds
 {
@@ -18,6 +19,26 @@ namespace sds
 	template <class InternalData> class CPPThreadRunner
 	{
 		std::unique_ptr<std::thread> localThread;
+		const ThreadPolicy threadPolicy;
+		std::string threadPolicyError;
+		std::mutex policyErrorMutex;
+		/// <summary>
+		/// Entry point of the thread, applies the ThreadPolicy before running "workThread".
+		/// A policy that cannot be fully applied is logged as a warning, for the first thread only,
+		/// and the thread runs with whatever was applied. GetThreadPolicyError() has it for every thread.
+		/// </summary>
+		void runWithPolicy()
+		{
+			const ThreadPolicyScope policyScope(threadPolicy);
+			const std::string err = policyScope.GetError();
+			{
+				lock l1(policyErrorMutex);
+				threadPolicyError = err;
+			}
+			if (!err.empty() && ThreadPolicyScope::IsFirstFailure())
+				Utilities::XErrorLogger::Log(Utilities::LogSeverity::SEVERITY_WARNING, "Thread policy for \"" + threadPolicy.name + "\" only partly applied: " + err);
+			workThread();
+		}
 	protected:
 		//Interestingly, accessibility modifiers (public/private/etc.) work on "using" typedefs!
 		using lock = std::lock_guard<std::mutex>;
@@ -41,7 +62,7 @@ namespace sds
 				{
 					this->isStopRequested = false;
 					this->isThreadRunning = true;
-					this->localThread = std::make_unique<std::thread>([this] { workThread(); });
+					this->localThread = std::make_unique<std::thread>([this] { runWithPolicy(); });
 				}
 				else
 				{
@@ -53,7 +74,7 @@ namespace sds
 					this->localThread.reset(); //reset the shared_ptr (call's dtor, deletes object if unique)
 					this->isStopRequested = false;
 					this->isThreadRunning = true;
-					this->localThread = std::make_unique<std::thread>([this] { workThread(); });
+					this->localThread = std::make_unique<std::thread>([this] { runWithPolicy(); });
 				}
 			}
 		}
@@ -126,6 +147,12 @@ namespace sds
 		CPPThreadRunner() : isThreadRunning(false), isStopRequested(false), local_state()
 		{
 		}
+		/// <summary>
+		/// Constructor, the worker thread applies the ThreadPolicy to itself each time it is started.
+		/// </summary>
+		explicit CPPThreadRunner(const ThreadPolicy &policy) : threadPolicy(policy), isThreadRunning(false), isStopRequested(false), local_state()
+		{
+		}
 		CPPThreadRunner(const CPPThreadRunner& other) = delete;
 		CPPThreadRunner(CPPThreadRunner&& other) = delete;
 		CPPThreadRunner& operator=(const CPPThreadRunner& other) = delete;
@@ -135,6 +162,19 @@ namespace sds
 		/// before the member function "workThread" is destructed.
 		/// </summary>
 		virtual ~CPPThreadRunner() = default;
+		/// <summary>
+		/// Returns the settings of the ThreadPolicy the last started thread could not apply,
+		/// empty string if all were applied or the thread has not applied it yet.
+		/// </summary>
+		std::string GetThreadPolicyError()
+		{
+			lock l1(policyErrorMutex);
+			return threadPolicyError;
+		}
+		const ThreadPolicy &GetThreadPolicy() const
+		{
+			return threadPolicy;
+		}
 
 	};
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#pragma once
+#include "stdafx.h"
+#ifndef _WIN32
+#include <ctime>
+#include <cerrno>
+#endif
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Source of the time read and slept on by the timing code: DelayManager, DelayHighPrecision, the Mapper,
+		/// the mouse move coalescing, the worker loops, the output retries and TraceReplay pacing.
+		/// The time points are std::chrono::steady_clock ones, so they mix with the existing steady_clock based types.
+		/// The process wide clock is a SteadyClock unless another is set with SetClock(), a ManualClock for a simulation.
+		/// </summary>
+		class Clock
+		{
+		public:
+			using TimePoint = std::chrono::steady_clock::time_point;
+			using Duration = std::chrono::steady_clock::duration;
+		private:
+			inline static std::atomic<Clock*> s_clock{ nullptr };
+		public:
+			Clock() = default;
+			Clock(const Clock& other) = delete;
+			Clock(Clock&& other) = delete;
+			Clock& operator=(const Clock& other) = delete;
+			Clock& operator=(Clock&& other) = delete;
+			virtual ~Clock() = default;
+			virtual TimePoint Now() const = 0;
+			/// <summary>
+			/// Blocks the calling thread until the time point.
+			/// </summary>
+			virtual void SleepUntil(const TimePoint until) = 0;
+			/// <summary>
+			/// Busy waits until the time point, for waits shorter than the platform timer resolution.
+			/// </summary>
+			virtual void SpinUntil(const TimePoint until) = 0;
+			void SleepFor(const Duration d)
+			{
+				SleepUntil(Now() + d);
+			}
+			/// <summary>
+			/// Replaces the process wide clock, pass nullptr to restore the SteadyClock. The clock must outlive its use,
+			/// set it while the workers reading it are stopped.
+			/// </summary>
+			static void SetClock(Clock *clock)
+			{
+				s_clock.store(clock, std::memory_order_release);
+			}
+			/// <summary>
+			/// Returns the process wide clock.
+			/// </summary>
+			static Clock &Get()
+			{
+				Clock *clock = s_clock.load(std::memory_order_acquire);
+				return clock != nullptr ? *clock : GetSteady();
+			}
+			static Clock &GetSteady();
+		};
+
+		/// <summary>
+		/// The real time, std::chrono::steady_clock. Sleeps on a high resolution waitable timer on Windows, the one
+		/// std::this_thread uses is only as fine as the system timer period, and on CLOCK_MONOTONIC, the clock of
+		/// steady_clock, with clock_nanosleep() on Linux.
+		/// </summary>
+		class SteadyClock : public Clock
+		{
+#ifdef _WIN32
+			/// <summary>
+			/// Waitable timer of a thread, high resolution where the OS supports it (Windows 10 1803 and later).
+			/// </summary>
+			struct ThreadTimer
+			{
+				HANDLE handle;
+				ThreadTimer() : handle(CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS))
+				{
+					if (handle == nullptr)
+						handle = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+				}
+				ThreadTimer(const ThreadTimer& other) = delete;
+				ThreadTimer(ThreadTimer&& other) = delete;
+				ThreadTimer& operator=(const ThreadTimer& other) = delete;
+				ThreadTimer& operator=(ThreadTimer&& other) = delete;
+				~ThreadTimer()
+				{
+					if (handle != nullptr)
+						CloseHandle(handle);
+				}
+			};
+#endif
+		public:
+			TimePoint Now() const override
+			{
+				return std::chrono::steady_clock::now();
+			}
+			void SleepUntil(const TimePoint until) override
+			{
+#ifdef _WIN32
+				const Duration remaining = until - std::chrono::steady_clock::now();
+				if (remaining <= Duration::zero())
+					return;
+				thread_local ThreadTimer timer;
+				if (timer.handle != nullptr)
+				{
+					//negative for a time relative to now, in 100 nanosecond units
+					using TimerUnits = std::chrono::duration<LONGLONG, std::ratio<1, 10000000>>;
+					LARGE_INTEGER due;
+					due.QuadPart = -std::max<LONGLONG>(1, std::chrono::duration_cast<TimerUnits>(remaining).count());
+					if (SetWaitableTimer(timer.handle, &due, 0, nullptr, nullptr, FALSE))
+					{
+						WaitForSingleObject(timer.handle, INFINITE);
+						return;
+					}
+				}
+				std::this_thread::sleep_until(until);
+#else
+				using namespace std::chrono;
+				const nanoseconds sinceEpoch = duration_cast<nanoseconds>(until.time_since_epoch());
+				timespec ts;
+				ts.tv_sec = static_cast<time_t>(duration_cast<seconds>(sinceEpoch).count());
+				ts.tv_nsec = static_cast<long>((sinceEpoch - seconds(ts.tv_sec)).count());
+				while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+				{
+				}
+#endif
+			}
+			void SpinUntil(const TimePoint until) override
+			{
+				while (std::chrono::steady_clock::now() < until)
+				{
+					//std::this_thread::yield();
+				}
+			}
+		};
+
+		inline Clock &Clock::GetSteady()
+		{
+			static SteadyClock clock;
+			return clock;
+		}
+
+		/// <summary>
+		/// A simulated clock that only moves when told to. Sleeping on it fast-forwards it to the end of the sleep,
+		/// so a single threaded pipeline, the REACTOR mode loop or a TraceReplay driving InputPoller::ProcessState(),
+		/// runs hours of input timing as fast as it can process it and with the same timing every run.
+		/// With more than one thread sleeping on it the time advances by whichever sleeps, so the THREADED
+		/// workers are not deterministic on it.
+		/// </summary>
+		class ManualClock : public Clock
+		{
+			std::atomic<Duration::rep> m_sinceEpoch;
+		public:
+			/// <param name="start">the time the clock starts at, the current steady_clock time if not given</param>
+			explicit ManualClock(const TimePoint start = std::chrono::steady_clock::now()) : m_sinceEpoch(start.time_since_epoch().count()) { }
+			TimePoint Now() const override
+			{
+				return TimePoint(Duration(m_sinceEpoch.load(std::memory_order_acquire)));
+			}
+			void SleepUntil(const TimePoint until) override
+			{
+				AdvanceTo(until);
+			}
+			void SpinUntil(const TimePoint until) override
+			{
+				AdvanceTo(until);
+			}
+			/// <summary>
+			/// Moves the time forward, a time point in the past is ignored.
+			/// </summary>
+			void AdvanceTo(const TimePoint until)
+			{
+				const Duration::rep target = until.time_since_epoch().count();
+				Duration::rep current = m_sinceEpoch.load(std::memory_order_relaxed);
+				while (current < target && !m_sinceEpoch.compare_exchange_weak(current, target, std::memory_order_acq_rel))
+				{
+				}
+			}
+			void Advance(const Duration d)
+			{
+				if (d > Duration::zero())
+					m_sinceEpoch.fetch_add(d.count(), std::memory_order_acq_rel);
+			}
+		};
+	}
+}
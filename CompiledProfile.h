@@ -0,0 +1,460 @@
+#pragma once
+#include "stdafx.h"
+#include "Mapper.h"
+#include "XInputBoostMouse.h"
+#include "MappedFile.h"
+
+namespace sds
+{
+	/// <summary>
+	/// A profile, the bindings of a MapInformation string and the mouse and deadzone settings, compiled into a versioned binary format.
+	/// A compiled profile is loaded by mapping the file and validating its header, the bindings are used as they are stored
+	/// instead of parsing and validating the MapInformation string again. Compile text profiles offline with XNMProfileCompiler.
+	/// The text format has one setting per line as "name=value", every other line holds MapInformation tokens and "#" starts a comment.
+	/// <example>
+	/// sensitivity=65
+	/// mouse_stick=RIGHT
+	/// LTHUMB:LEFT:NORM:a LTHUMB:RIGHT:NORM:d
+	/// </example>
+	/// The binary format is the Header, the Binding records at bindingsOffset, and the strings they refer to at stringsOffset.
+	/// Integers are stored in the byte order of the machine that compiled the profile, the magic number does not match on another.
+	/// </summary>
+	class CompiledProfile
+	{
+	public:
+		//Magic is "XNMP" read as a little endian integer.
+		constexpr static const std::uint32_t MAGIC = 0x504D4E58;
+		//Version is changed whenever the layout of the records changes.
+		constexpr static const std::uint16_t VERSION = 1;
+		/// <summary>
+		/// The settings of the mouse and the deadzones, the enums are stored as their integer values.
+		/// </summary>
+		struct Settings
+		{
+			std::int32_t sensitivity = XinSettings::SENSITIVITY_DEFAULT;
+			std::int32_t coalesceMicro = XinSettings::MOUSE_COALESCE_MICRO;
+			std::int32_t mouseStick = static_cast<std::int32_t>(MouseMap::NEITHER_STICK);
+			std::int32_t deadzoneMode = static_cast<std::int32_t>(DeadzoneMode::AXIAL);
+			std::int32_t leftXDeadzone = XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE;
+			std::int32_t leftYDeadzone = XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE;
+			std::int32_t rightXDeadzone = XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE;
+			std::int32_t rightYDeadzone = XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE;
+			std::int32_t leftTriggerDeadzone = XINPUT_GAMEPAD_TRIGGER_THRESHOLD;
+			std::int32_t rightTriggerDeadzone = XINPUT_GAMEPAD_TRIGGER_THRESHOLD;
+		};
+		/// <summary>
+		/// A string in the string table, by offset from the start of the table and size.
+		/// </summary>
+		struct StringRef
+		{
+			std::uint32_t offset;
+			std::uint32_t size;
+		};
+		struct Header
+		{
+			std::uint32_t magic;
+			std::uint16_t version;
+			std::uint16_t headerSize;
+			std::uint32_t fileSize;
+			//FNV-1a hash of everything after the header
+			std::uint32_t checksum;
+			std::uint32_t bindingCount;
+			std::uint32_t bindingsOffset;
+			std::uint32_t stringsOffset;
+			std::uint32_t stringsSize;
+			StringRef mapInfo;
+			Settings settings;
+		};
+		struct Binding
+		{
+			ControlMask required;
+			ControlMask excluded;
+			std::uint32_t isChord;
+			StringRef control;
+			StringRef info;
+			StringRef simType;
+			StringRef value;
+		};
+		static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Binding>);
+		static_assert(sizeof(Header) == 80 && sizeof(Binding) == 44);
+	private:
+		Utilities::MappedFile m_file;
+		std::vector<char> m_buffer;
+		const char *m_data = nullptr;
+		Header m_header = {};
+	public:
+		CompiledProfile() = default;
+		CompiledProfile(const CompiledProfile& other) = delete;
+		CompiledProfile(CompiledProfile&& other) = delete;
+		CompiledProfile& operator=(const CompiledProfile& other) = delete;
+		CompiledProfile& operator=(CompiledProfile&& other) = delete;
+		~CompiledProfile() = default;
+		/// <summary>
+		/// Maps a compiled profile file and validates it, the file stays mapped until another profile is loaded.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] std::string Load(const std::string &fileName)
+		{
+			Reset();
+			std::string err = m_file.Open(fileName);
+			if (err.empty())
+				err = Validate(m_file.GetData(), m_file.GetSize(), m_header);
+			if (!err.empty())
+			{
+				Reset();
+				return err;
+			}
+			m_data = m_file.GetData();
+			return "";
+		}
+		/// <summary>
+		/// Takes a compiled profile that is already in memory, such as the output of Compile(), and validates it.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] std::string LoadFromMemory(std::vector<char> data)
+		{
+			Reset();
+			const std::string err = Validate(data.data(), data.size(), m_header);
+			if (!err.empty())
+				return err;
+			m_buffer = std::move(data);
+			m_data = m_buffer.data();
+			return "";
+		}
+		bool IsLoaded() const
+		{
+			return m_data != nullptr;
+		}
+		const Settings &GetSettings() const
+		{
+			return m_header.settings;
+		}
+		size_t GetBindingCount() const
+		{
+			return IsLoaded() ? m_header.bindingCount : 0;
+		}
+		/// <summary>
+		/// Returns the MapInformation string the profile was compiled from.
+		/// </summary>
+		[[nodiscard]] MapInformation GetMapInfo() const
+		{
+			return IsLoaded() ? MapInformation(GetString(m_header.mapInfo)) : MapInformation();
+		}
+		/// <summary>
+		/// Gives the Mapper the compiled bindings, replacing those of its active profile.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] std::string ApplyTo(Mapper &mapper) const
+		{
+			if (!IsLoaded())
+				return "Error in sds::CompiledProfile::ApplyTo(), no profile loaded.";
+			return mapper.SetBindings(GetBindingRecords(), GetMapInfo());
+		}
+		/// <summary>
+		/// Adds the compiled bindings to the profile cache of the Mapper, see Mapper::ActivateProfile().
+		/// The settings are not profile specific and are not applied.
+		/// </summary>
+		/// <param name="idOut">receives the id of the profile</param>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] std::string AddTo(Mapper &mapper, size_t &idOut) const
+		{
+			if (!IsLoaded())
+				return "Error in sds::CompiledProfile::AddTo(), no profile loaded.";
+			return mapper.AddProfile(GetBindingRecords(), GetMapInfo(), idOut);
+		}
+		/// <summary>
+		/// Sets the sensitivity, the coalesce window and the stick of the mouse in one published change.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] std::string ApplyTo(XInputBoostMouse &mouse) const
+		{
+			if (!IsLoaded())
+				return "Error in sds::CompiledProfile::ApplyTo(), no profile loaded.";
+			return mouse.ApplySettings(m_header.settings.sensitivity, m_header.settings.coalesceMicro, static_cast<MouseMap>(m_header.settings.mouseStick));
+		}
+		/// <summary>
+		/// Sets the deadzones of a PlayerInfo, for constructing a GamepadUser. The player id is not changed.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] std::string ApplyTo(PlayerInfo &player) const
+		{
+			if (!IsLoaded())
+				return "Error in sds::CompiledProfile::ApplyTo(), no profile loaded.";
+			const Settings &s = m_header.settings;
+			player.left_x_dz = s.leftXDeadzone;
+			player.left_y_dz = s.leftYDeadzone;
+			player.right_x_dz = s.rightXDeadzone;
+			player.right_y_dz = s.rightYDeadzone;
+			player.left_trigger_dz = s.leftTriggerDeadzone;
+			player.right_trigger_dz = s.rightTriggerDeadzone;
+			player.deadzone_mode = static_cast<DeadzoneMode>(s.deadzoneMode);
+			return "";
+		}
+		/// <summary>
+		/// Reads a text profile into a MapInformation string and Settings, settings not in the text keep their defaults.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		static std::string ParseText(const std::string &text, MapInformation &mapOut, Settings &settingsOut)
+		{
+			auto errText = [](const std::string &s, const size_t lineNumber)
+			{
+				return "Error in sds::CompiledProfile::ParseText(), line " + std::to_string(lineNumber) + ": " + s;
+			};
+			Settings settings;
+			MapInformation map;
+			std::stringstream ss(text);
+			std::string line;
+			size_t lineNumber = 0;
+			while (std::getline(ss, line))
+			{
+				lineNumber++;
+				const size_t commentAt = line.find('#');
+				if (commentAt != std::string::npos)
+					line.erase(commentAt);
+				const size_t equalsAt = line.find('=');
+				if (equalsAt == std::string::npos)
+				{
+					map += " " + line;
+					continue;
+				}
+				std::string name;
+				std::string value;
+				std::stringstream(line.substr(0, equalsAt)) >> name;
+				std::stringstream(line.substr(equalsAt + 1)) >> value;
+				const std::string err = SetSetting(name, value, settings);
+				if (!err.empty())
+					return errText(err, lineNumber);
+			}
+			mapOut = map;
+			settingsOut = settings;
+			return "";
+		}
+		/// <summary>
+		/// Compiles a text profile into the binary format, the bindings are validated by a Mapper.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		static std::string Compile(const std::string &text, std::vector<char> &out)
+		{
+			MapInformation map;
+			Settings settings;
+			std::string err = ParseText(text, map, settings);
+			if (!err.empty())
+				return err;
+			err = ValidateSettings(settings);
+			if (!err.empty())
+				return err;
+			Mapper mapper;
+			err = mapper.SetMapInfo(map);
+			if (!err.empty())
+				return err;
+			const std::vector<Mapper::BindingRecord> records = mapper.GetBindings();
+			std::string strings;
+			auto addString = [&strings](const std::string_view s)
+			{
+				const StringRef ref = { static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(s.size()) };
+				strings.append(s);
+				return ref;
+			};
+			Header header = {};
+			header.magic = MAGIC;
+			header.version = VERSION;
+			header.headerSize = sizeof(Header);
+			header.bindingCount = static_cast<std::uint32_t>(records.size());
+			header.bindingsOffset = sizeof(Header);
+			header.stringsOffset = static_cast<std::uint32_t>(sizeof(Header) + records.size() * sizeof(Binding));
+			header.mapInfo = addString(map);
+			header.settings = settings;
+			std::vector<Binding> bindings;
+			for (const Mapper::BindingRecord &r : records)
+				bindings.push_back({ r.required, r.excluded, r.isChord ? 1u : 0u, addString(r.control), addString(r.info), addString(r.simType), addString(r.value) });
+			header.stringsSize = static_cast<std::uint32_t>(strings.size());
+			header.fileSize = header.stringsOffset + header.stringsSize;
+			std::vector<char> data(header.fileSize);
+			if (!bindings.empty())
+				memcpy(data.data() + header.bindingsOffset, bindings.data(), bindings.size() * sizeof(Binding));
+			if (!strings.empty())
+				memcpy(data.data() + header.stringsOffset, strings.data(), strings.size());
+			header.checksum = Checksum(data.data() + sizeof(Header), data.size() - sizeof(Header));
+			memcpy(data.data(), &header, sizeof(Header));
+			out = std::move(data);
+			return "";
+		}
+		/// <summary>
+		/// Compiles a text profile file into a binary profile file.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		static std::string CompileFile(const std::string &textFile, const std::string &binaryFile)
+		{
+			std::ifstream inFile(textFile);
+			if (!inFile)
+				return "Error in sds::CompiledProfile::CompileFile(), failed to open file: " + textFile;
+			std::stringstream text;
+			text << inFile.rdbuf();
+			std::vector<char> data;
+			const std::string err = Compile(text.str(), data);
+			if (!err.empty())
+				return err;
+			std::ofstream outFile(binaryFile, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!outFile)
+				return "Error in sds::CompiledProfile::CompileFile(), failed to open file: " + binaryFile;
+			outFile.write(data.data(), static_cast<std::streamsize>(data.size()));
+			if (!outFile)
+				return "Error in sds::CompiledProfile::CompileFile(), failed writing file: " + binaryFile;
+			return "";
+		}
+		/// <summary>
+		/// Validates a compiled profile, the header, the bounds of every record and string, the checksum and the settings.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		static std::string Validate(const char *data, const size_t size, Header &headerOut)
+		{
+			auto errText = [](const std::string &s)
+			{
+				return "Error in sds::CompiledProfile::Validate(), " + s;
+			};
+			Header header = {};
+			if (data == nullptr || size < sizeof(Header))
+				return errText("too small to hold the header.");
+			memcpy(&header, data, sizeof(Header));
+			if (header.magic != MAGIC)
+				return errText("not a compiled profile.");
+			if (header.version != VERSION || header.headerSize != sizeof(Header))
+				return errText("compiled by an incompatible version " + std::to_string(header.version) + ".");
+			if (header.fileSize != size)
+				return errText("size does not match the header, the file is truncated.");
+			const std::uint64_t bindingsEnd = header.bindingsOffset + static_cast<std::uint64_t>(header.bindingCount) * sizeof(Binding);
+			const std::uint64_t stringsEnd = static_cast<std::uint64_t>(header.stringsOffset) + header.stringsSize;
+			if (header.bindingsOffset < sizeof(Header) || bindingsEnd > size || header.stringsOffset < bindingsEnd || stringsEnd > size)
+				return errText("a table is out of bounds.");
+			if (Checksum(data + sizeof(Header), size - sizeof(Header)) != header.checksum)
+				return errText("checksum mismatch, the file is corrupt.");
+			auto isInStrings = [&header](const StringRef &ref)
+			{
+				return static_cast<std::uint64_t>(ref.offset) + ref.size <= header.stringsSize;
+			};
+			if (!isInStrings(header.mapInfo))
+				return errText("a string is out of bounds.");
+			for (std::uint32_t i = 0; i < header.bindingCount; i++)
+			{
+				const Binding b = GetBinding(data, header, i);
+				if (!isInStrings(b.control) || !isInStrings(b.info) || !isInStrings(b.simType) || !isInStrings(b.value))
+					return errText("a string is out of bounds.");
+			}
+			const std::string err = ValidateSettings(header.settings);
+			if (!err.empty())
+				return err;
+			headerOut = header;
+			return "";
+		}
+		static std::string ValidateSettings(const Settings &s)
+		{
+			auto errText = [](const std::string &name)
+			{
+				return "Error in sds::CompiledProfile::ValidateSettings(), " + name + " out of range.";
+			};
+			auto isValidTrigger = [](const int dz) { return dz >= 0 && dz <= std::numeric_limits<BYTE>::max(); };
+			if (!XinSettings::IsValidSensitivityValue(s.sensitivity))
+				return errText("sensitivity");
+			if (!XinSettings::IsValidCoalesceValue(s.coalesceMicro))
+				return errText("coalesce_micro");
+			if (s.mouseStick < static_cast<int>(MouseMap::NEITHER_STICK) || s.mouseStick > static_cast<int>(MouseMap::LEFT_STICK))
+				return errText("mouse_stick");
+			if (s.deadzoneMode < static_cast<int>(DeadzoneMode::AXIAL) || s.deadzoneMode > static_cast<int>(DeadzoneMode::SCALED_RADIAL))
+				return errText("deadzone_mode");
+			if (!XinSettings::IsValidDeadzoneValue(s.leftXDeadzone) || !XinSettings::IsValidDeadzoneValue(s.leftYDeadzone)
+				|| !XinSettings::IsValidDeadzoneValue(s.rightXDeadzone) || !XinSettings::IsValidDeadzoneValue(s.rightYDeadzone))
+				return errText("thumbstick deadzone");
+			if (!isValidTrigger(s.leftTriggerDeadzone) || !isValidTrigger(s.rightTriggerDeadzone))
+				return errText("trigger deadzone");
+			return "";
+		}
+	private:
+		std::vector<Mapper::BindingRecord> GetBindingRecords() const
+		{
+			std::vector<Mapper::BindingRecord> records;
+			records.reserve(m_header.bindingCount);
+			for (std::uint32_t i = 0; i < m_header.bindingCount; i++)
+			{
+				const Binding b = GetBinding(m_data, m_header, i);
+				records.push_back({ GetString(b.control), GetString(b.info), GetString(b.simType), GetString(b.value), b.required, b.excluded, b.isChord != 0 });
+			}
+			return records;
+		}
+		void Reset()
+		{
+			m_file.Close();
+			m_buffer.clear();
+			m_data = nullptr;
+			m_header = {};
+		}
+		std::string_view GetString(const StringRef &ref) const
+		{
+			return std::string_view(m_data + m_header.stringsOffset + ref.offset, ref.size);
+		}
+		static Binding GetBinding(const char *data, const Header &header, const std::uint32_t index)
+		{
+			Binding b = {};
+			memcpy(&b, data + header.bindingsOffset + static_cast<size_t>(index) * sizeof(Binding), sizeof(Binding));
+			return b;
+		}
+		static std::uint32_t Checksum(const char *data, const size_t size)
+		{
+			std::uint32_t hash = 2166136261u;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= static_cast<unsigned char>(data[i]);
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+		static std::string SetSetting(const std::string &name, const std::string &value, Settings &s)
+		{
+			const std::map<std::string, std::int32_t Settings::*> numbers =
+			{
+				{"sensitivity", &Settings::sensitivity},
+				{"coalesce_micro", &Settings::coalesceMicro},
+				{"left_x_dz", &Settings::leftXDeadzone},
+				{"left_y_dz", &Settings::leftYDeadzone},
+				{"right_x_dz", &Settings::rightXDeadzone},
+				{"right_y_dz", &Settings::rightYDeadzone},
+				{"left_trigger_dz", &Settings::leftTriggerDeadzone},
+				{"right_trigger_dz", &Settings::rightTriggerDeadzone}
+			};
+			const std::map<std::string, std::int32_t> sticks =
+			{
+				{"NEITHER", static_cast<std::int32_t>(MouseMap::NEITHER_STICK)},
+				{"RIGHT", static_cast<std::int32_t>(MouseMap::RIGHT_STICK)},
+				{"LEFT", static_cast<std::int32_t>(MouseMap::LEFT_STICK)}
+			};
+			const std::map<std::string, std::int32_t> modes =
+			{
+				{"AXIAL", static_cast<std::int32_t>(DeadzoneMode::AXIAL)},
+				{"RADIAL", static_cast<std::int32_t>(DeadzoneMode::RADIAL)},
+				{"SCALED_RADIAL", static_cast<std::int32_t>(DeadzoneMode::SCALED_RADIAL)}
+			};
+			std::string upper = value;
+			std::for_each(upper.begin(), upper.end(), [](char &c) { c = static_cast<char>(std::toupper(c)); });
+			if (name == "mouse_stick" && sticks.contains(upper))
+				s.mouseStick = sticks.at(upper);
+			else if (name == "deadzone_mode" && modes.contains(upper))
+				s.deadzoneMode = modes.at(upper);
+			else if (numbers.contains(name))
+			{
+				try
+				{
+					size_t parsed = 0;
+					s.*numbers.at(name) = std::stoi(value, &parsed);
+					if (parsed != value.size())
+						return "invalid value \"" + value + "\" for " + name;
+				}
+				catch (...)
+				{
+					return "invalid value \"" + value + "\" for " + name;
+				}
+			}
+			else
+				return "unknown setting \"" + name + "\" or value \"" + value + "\"";
+			return "";
+		}
+	};
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	/// <summary>
+	/// One complete, validated configuration of a GamepadUser: the deadzones and player id of a PlayerInfo
+	/// and the mouse settings. A published snapshot is never changed, a change is a new snapshot with a higher version.
+	/// </summary>
+	struct ConfigSnapshot
+	{
+		PlayerInfo player;
+		int sensitivity = XinSettings::SENSITIVITY_DEFAULT;
+		int coalesceMicros = XinSettings::MOUSE_COALESCE_MICRO;
+		//fixed mouse output frames per second, 0 for the per axis delay timers
+		int mouseFrameRate = XinSettings::MOUSE_FRAME_RATE_DEFAULT;
+		MouseMap stickMap = MouseMap::NEITHER_STICK;
+		//set by ConfigStore::Publish()
+		std::uint64_t version = 0;
+
+		/// <summary>
+		/// Checks every setting.
+		/// </summary>
+		/// <returns>error message, empty string if the snapshot may be published</returns>
+		[[nodiscard]] std::string Validate() const
+		{
+			const std::array<int, 4> stickDeadzones = { player.left_x_dz, player.left_y_dz, player.right_x_dz, player.right_y_dz };
+			if (!std::ranges::all_of(stickDeadzones, XinSettings::IsValidDeadzoneValue))
+				return "Error in sds::ConfigSnapshot::Validate(), thumbstick deadzone out of range.";
+			if (!IsValidTriggerDeadzone(player.left_trigger_dz) || !IsValidTriggerDeadzone(player.right_trigger_dz))
+				return "Error in sds::ConfigSnapshot::Validate(), trigger deadzone out of range.";
+			if (player.player_id < 0 || player.player_id >= XinSettings::PLAYER_COUNT)
+				return "Error in sds::ConfigSnapshot::Validate(), player id out of range.";
+			if (player.deadzone_mode < DeadzoneMode::AXIAL || player.deadzone_mode > DeadzoneMode::SCALED_RADIAL)
+				return "Error in sds::ConfigSnapshot::Validate(), unknown deadzone mode.";
+			if (!XinSettings::IsValidSensitivityValue(sensitivity))
+				return "Error in sds::ConfigSnapshot::Validate(), sensitivity out of range.";
+			if (!XinSettings::IsValidCoalesceValue(coalesceMicros))
+				return "Error in sds::ConfigSnapshot::Validate(), coalesce window out of range.";
+			if (!XinSettings::IsValidFrameRateValue(mouseFrameRate))
+				return "Error in sds::ConfigSnapshot::Validate(), mouse frame rate out of range.";
+			if (stickMap < MouseMap::NEITHER_STICK || stickMap > MouseMap::LEFT_STICK)
+				return "Error in sds::ConfigSnapshot::Validate(), unknown mouse stick.";
+			return "";
+		}
+	private:
+		static bool IsValidTriggerDeadzone(const int dz)
+		{
+			return dz >= 0 && dz <= std::numeric_limits<BYTE>::max();
+		}
+	};
+
+	/// <summary>
+	/// Publishes ConfigSnapshot objects through one atomic pointer. A reader takes the current snapshot once,
+	/// at the start of a frame, and reads plain fields from it for the whole frame, so it never sees a change half applied
+	/// and the hot paths do no atomic loads. A snapshot lives for as long as a reader holds it.
+	/// GetVersion() is a single load, for a reader polling for a change without taking the snapshot.
+	/// </summary>
+	class ConfigStore
+	{
+		std::atomic<std::shared_ptr<const ConfigSnapshot>> m_current;
+		std::atomic<std::uint64_t> m_version;
+		//serializes the writers, so an Update() is never lost to another
+		std::mutex m_publishMutex;
+	public:
+		/// <summary>
+		/// Publishes the initial snapshot, the default configuration if it does not validate.
+		/// </summary>
+		explicit ConfigStore(const ConfigSnapshot &initial = {}) : m_version(0)
+		{
+			const std::string err = Publish(initial);
+			if (!err.empty())
+			{
+				Utilities::XErrorLogger::LogError(err);
+				Publish(ConfigSnapshot{});
+			}
+		}
+		ConfigStore(const ConfigStore& other) = delete;
+		ConfigStore(ConfigStore&& other) = delete;
+		ConfigStore& operator=(const ConfigStore& other) = delete;
+		ConfigStore& operator=(ConfigStore&& other) = delete;
+		~ConfigStore() = default;
+		/// <summary>
+		/// Validates the snapshot and, if it is valid, publishes it as the current one with the next version.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		std::string Publish(ConfigSnapshot snapshot)
+		{
+			std::lock_guard lock(m_publishMutex);
+			return PublishLocked(std::move(snapshot));
+		}
+		/// <summary>
+		/// Publishes a copy of the current snapshot changed by "edit", a void(ConfigSnapshot&amp;) function.
+		/// Nothing is published if the result does not validate.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		template<typename Edit>
+		std::string Update(Edit &&edit)
+		{
+			std::lock_guard lock(m_publishMutex);
+			ConfigSnapshot snapshot = *m_current.load(std::memory_order_acquire);
+			std::forward<Edit>(edit)(snapshot);
+			return PublishLocked(std::move(snapshot));
+		}
+		/// <summary>
+		/// Returns the current snapshot, to be held for the frame.
+		/// </summary>
+		[[nodiscard]] std::shared_ptr<const ConfigSnapshot> Acquire() const
+		{
+			return m_current.load(std::memory_order_acquire);
+		}
+		/// <summary>
+		/// Version of the current snapshot, it increases with each publish.
+		/// </summary>
+		std::uint64_t GetVersion() const
+		{
+			return m_version.load(std::memory_order_acquire);
+		}
+	private:
+		std::string PublishLocked(ConfigSnapshot snapshot)
+		{
+			std::string err = snapshot.Validate();
+			if (!err.empty())
+				return err;
+			snapshot.version = m_version.load(std::memory_order_relaxed) + 1;
+			const std::uint64_t version = snapshot.version;
+			m_current.store(std::make_shared<const ConfigSnapshot>(std::move(snapshot)), std::memory_order_release);
+			m_version.store(version, std::memory_order_release);
+			return "";
+		}
+	};
+}
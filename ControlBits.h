@@ -0,0 +1,124 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	/// <summary>
+	/// A snapshot of the controls reported as down in one frame, one bit per ActionDetails token.
+	/// </summary>
+	using ControlMask = std::uint32_t;
+
+	/// <summary>
+	/// Bit assignments for a ControlMask and the parsing of chord bindings into masks.
+	/// The buttons use their XINPUT_GAMEPAD bit, the triggers and the thumbstick directions use the bits above.
+	/// A chord is written in the first field of a MapInformation token as controls joined with '+',
+	/// a control that needs a direction is written with '-' and a control prefixed with '!' must not be down.
+	/// <example>
+	/// LSHOULDER+A:NONE:NORM:VK13 or LSHOULDER+DPAD-UP+!B:NONE:NORM:x
+	/// </example>
+	/// </summary>
+	struct ControlBits
+	{
+		//Left Trigger is the bit of the "LTRIGGER" token.
+		constexpr static const ControlMask LEFT_TRIGGER = 1u << 16;
+		//Right Trigger is the bit of the "RTRIGGER" token.
+		constexpr static const ControlMask RIGHT_TRIGGER = 1u << 17;
+		//Left Thumb First is the bit of "LTHUMB:LEFT", followed by RIGHT, UP and DOWN.
+		constexpr static const int LEFT_THUMB_FIRST = 18;
+		//Right Thumb First is the bit of "RTHUMB:LEFT", followed by RIGHT, UP and DOWN.
+		constexpr static const int RIGHT_THUMB_FIRST = 22;
+		//Never is the bit of a control and direction pair that is never reported, such as DPAD:NONE.
+		constexpr static const ControlMask NEVER = 1u << 31;
+		//Chord Join is the character joining the controls of a chord.
+		constexpr static const char CHORD_JOIN = '+';
+		//Chord Direction is the character between a chord control and its direction.
+		constexpr static const char CHORD_DIRECTION = '-';
+		//Chord Exclude is the prefix of a chord control that must not be down.
+		constexpr static const char CHORD_EXCLUDE = '!';
+
+		/// <summary>
+		/// Returns the bit of an ActionDetails token such as "A", "DPAD:LEFT" or "LTHUMB:UP", NEVER if it is not one.
+		/// </summary>
+		static ControlMask GetTokenBit(const std::string &token)
+		{
+			const std::map<std::string, ControlMask> &table = GetTable();
+			const auto it = table.find(token);
+			return it == table.end() ? NEVER : it->second;
+		}
+		/// <summary>
+		/// Returns the bit of an upper case control and direction pair from the first two fields of a MapInformation token,
+		/// NEVER if the pair is never reported.
+		/// </summary>
+		static ControlMask GetBit(const std::string &control, const std::string &info)
+		{
+			if (info == sdsActionDescriptors.none)
+				return GetTokenBit(control);
+			return GetTokenBit(control + sdsActionDescriptors.moreInfo + info);
+		}
+		static bool IsChord(const std::string &firstField)
+		{
+			return firstField.find(CHORD_JOIN) != std::string::npos;
+		}
+		/// <summary>
+		/// Compiles the first field of a chord binding into the masks of the controls that must be down and must not be down.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		static std::string ParseChord(const std::string &firstField, ControlMask &requiredOut, ControlMask &excludedOut)
+		{
+			if (firstField.empty() || firstField.back() == CHORD_JOIN)
+				return "Chord " + firstField + " ends without a control";
+			ControlMask required = 0;
+			ControlMask excluded = 0;
+			std::stringstream ss(firstField);
+			std::string part;
+			while (std::getline(ss, part, CHORD_JOIN))
+			{
+				const bool isExcluded = !part.empty() && part.front() == CHORD_EXCLUDE;
+				if (isExcluded)
+					part.erase(0, 1);
+				std::string control = part;
+				std::string info(sdsActionDescriptors.none);
+				const size_t directionAt = part.find(CHORD_DIRECTION);
+				if (directionAt != std::string::npos)
+				{
+					control = part.substr(0, directionAt);
+					info = part.substr(directionAt + 1);
+				}
+				if (!sdsActionDescriptors.IsFirstFieldKeyword(control, control) || !sdsActionDescriptors.IsSecondFieldKeyword(info, info))
+					return "Unknown control \"" + part + "\" in chord " + firstField;
+				const ControlMask bit = GetBit(control, info);
+				if (bit == NEVER)
+					return "Control \"" + part + "\" in chord " + firstField + " is never reported";
+				(isExcluded ? excluded : required) |= bit;
+			}
+			if (required == 0)
+				return "Chord " + firstField + " has no required control";
+			if (required & excluded)
+				return "Chord " + firstField + " both requires and excludes a control";
+			requiredOut = required;
+			excludedOut = excluded;
+			return "";
+		}
+	private:
+		static const std::map<std::string, ControlMask> &GetTable()
+		{
+			static const std::map<std::string, ControlMask> table = []()
+			{
+				const ActionDescriptors &ad = sdsActionDescriptors;
+				std::map<std::string, ControlMask> t;
+				for (const auto &[token, xinBit] : ad.xin_buttons)
+					t[std::string(token)] = static_cast<ControlMask>(xinBit);
+				t[std::string(ad.lTrigger)] = LEFT_TRIGGER;
+				t[std::string(ad.rTrigger)] = RIGHT_TRIGGER;
+				const std::array<std::string_view, 4> directions = { ad.left, ad.right, ad.up, ad.down };
+				for (int i = 0; i < 4; i++)
+				{
+					t[std::string(ad.lThumb) + ad.moreInfo + std::string(directions[i])] = 1u << (LEFT_THUMB_FIRST + i);
+					t[std::string(ad.rThumb) + ad.moreInfo + std::string(directions[i])] = 1u << (RIGHT_THUMB_FIRST + i);
+				}
+				return t;
+			}();
+			return table;
+		}
+	};
+}
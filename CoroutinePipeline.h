@@ -0,0 +1,146 @@
+#pragma once
+#include "stdafx.h"
+#include "CoroutineScheduler.h"
+#include "GamepadUser.h"
+#include "MouseMoveStepper.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Source of controller frames for a coroutine, "co_await frames.Next()" resumes at the next poll deadline
+	/// with the polled state, or an empty optional if the controller is not connected.
+	/// Poll deadlines are a fixed period apart, a late poll moves the following deadlines instead of bunching them.
+	/// </summary>
+	class ControllerFrames
+	{
+		CoroutineScheduler &m_scheduler;
+		const DWORD m_playerId;
+		const CoroutineScheduler::ClockType::duration m_period;
+		InputPoller::StateSource m_stateSource;
+		CoroutineScheduler::TimePoint m_nextPoll;
+	public:
+		/// <param name="scheduler">scheduler the awaiting coroutine runs on</param>
+		/// <param name="playerId">controller to poll</param>
+		/// <param name="period">time between polls</param>
+		/// <param name="source">function used to get the controller state, XInputGetState by default</param>
+		ControllerFrames(CoroutineScheduler &scheduler, const DWORD playerId, const CoroutineScheduler::ClockType::duration period,
+			InputPoller::StateSource source = [](const DWORD id, XINPUT_STATE *state) { return XInputGetState(id, state); })
+			: m_scheduler(scheduler), m_playerId(playerId), m_period(period), m_stateSource(std::move(source)),
+			m_nextPoll(Utilities::Clock::Get().Now())
+		{
+		}
+		ControllerFrames(const ControllerFrames& other) = delete;
+		ControllerFrames(ControllerFrames&& other) = delete;
+		ControllerFrames& operator=(const ControllerFrames& other) = delete;
+		ControllerFrames& operator=(ControllerFrames&& other) = delete;
+		~ControllerFrames() = default;
+		/// <summary>
+		/// Awaitable for the next controller frame.
+		/// </summary>
+		auto Next()
+		{
+			struct FrameAwaiter
+			{
+				ControllerFrames &frames;
+				bool await_ready() const noexcept { return false; }
+				void await_suspend(const std::coroutine_handle<> h)
+				{
+					frames.m_scheduler.ResumeAt(frames.m_nextPoll, h);
+				}
+				std::optional<XINPUT_STATE> await_resume()
+				{
+					const auto now = Utilities::Clock::Get().Now();
+					frames.m_nextPoll = std::max(frames.m_nextPoll + frames.m_period, now);
+					XINPUT_STATE state = {};
+					if (frames.m_stateSource(frames.m_playerId, &state) != ERROR_SUCCESS)
+						return {};
+					return state;
+				}
+			};
+			return FrameAwaiter{ *this };
+		}
+	};
+
+	/// <summary>
+	/// Runs the pipeline of one GamepadUser as coroutines on a CoroutineScheduler, instead of the poller,
+	/// mouse and mouse move threads. The GamepadUser must be constructed with ExecutionMode::REACTOR so the mouse
+	/// does not start its own thread, and its poller is not started. Many pipelines can share one scheduler.
+	/// The polling coroutine translates and maps each frame, the mouse coroutine sleeps until the next MouseMoveStepper task.
+	/// </summary>
+	class CoroutinePipeline
+	{
+		CoroutineScheduler &m_scheduler;
+		GamepadUser &m_user;
+		ControllerFrames m_frames;
+	public:
+		/// <param name="scheduler">scheduler to spawn the coroutines on, must outlive the coroutines</param>
+		/// <param name="user">GamepadUser in ExecutionMode::REACTOR, the controller polled is the player_id of its mouse PlayerInfo</param>
+		/// <param name="source">function used to get the controller state, XInputGetState by default</param>
+		CoroutinePipeline(CoroutineScheduler &scheduler, GamepadUser &user,
+			InputPoller::StateSource source = [](const DWORD id, XINPUT_STATE *state) { return XInputGetState(id, state); })
+			: m_scheduler(scheduler), m_user(user),
+			m_frames(scheduler, user.mouse.GetPlayerInfo().player_id, std::chrono::milliseconds(XinSettings::THREAD_DELAY_POLLER), std::move(source))
+		{
+			if (user.mouse.GetExecutionMode() != ExecutionMode::REACTOR)
+				Utilities::XErrorLogger::LogError("sds::CoroutinePipeline(), GamepadUser is not in ExecutionMode::REACTOR, mouse moves will be sent twice.");
+		}
+		CoroutinePipeline(const CoroutinePipeline& other) = delete;
+		CoroutinePipeline(CoroutinePipeline&& other) = delete;
+		CoroutinePipeline& operator=(const CoroutinePipeline& other) = delete;
+		CoroutinePipeline& operator=(CoroutinePipeline&& other) = delete;
+		~CoroutinePipeline() = default;
+		/// <summary>
+		/// Spawns the polling and mouse coroutines, the pipeline must outlive them.
+		/// </summary>
+		void Spawn()
+		{
+			m_scheduler.Spawn(PollFrames());
+			m_scheduler.Spawn(MoveMouse());
+		}
+	private:
+		/// <summary>
+		/// Processes each controller frame with the mouse and the Mapper, as the InputPoller thread does.
+		/// Held keys are released when stopped.
+		/// </summary>
+		PipelineTask PollFrames()
+		{
+			bool wasConnected = false;
+			while (!m_scheduler.IsStopRequested())
+			{
+				const std::optional<XINPUT_STATE> state = co_await m_frames.Next();
+				if (!state)
+				{
+					if (wasConnected)
+						Utilities::FlightRecorder::Get().DumpOnError();
+					wasConnected = false;
+					continue;
+				}
+				wasConnected = true;
+				m_user.poller.ProcessState(*state);
+			}
+			const XINPUT_STATE released = {};
+			m_user.poller.ProcessState(released);
+		}
+		/// <summary>
+		/// Does the work of the XInputBoostMouse worker and its MouseMoveThread with a MouseMoveStepper,
+		/// as the reactor loop does, so the step rules, the settings rebuild and the frame mode are the stepper's.
+		/// The coroutine wakes for the earliest stepper task, and at least once a poll period to see the thumbstick.
+		/// </summary>
+		PipelineTask MoveMouse()
+		{
+			DeadlineQueue queue(MouseMoveStepper::TASK_COUNT);
+			//a pending move is sent when the stepper is destroyed, at the end of the coroutine
+			MouseMoveStepper stepper(m_user.mouse, 0);
+			const std::chrono::milliseconds idlePeriod(XinSettings::THREAD_DELAY_POLLER);
+			Utilities::Clock &clock = Utilities::Clock::Get();
+			while (!m_scheduler.IsStopRequested())
+			{
+				const DeadlineQueue::TimePoint now = clock.Now();
+				stepper.Update(now, queue);
+				while (const std::optional<size_t> task = queue.PopDue(now))
+					stepper.RunTask(*task, now, queue);
+				co_await m_scheduler.SleepUntil(std::min(now + idlePeriod, queue.NextDue()));
+			}
+		}
+	};
+}
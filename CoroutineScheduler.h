@@ -0,0 +1,210 @@
+#pragma once
+#include "stdafx.h"
+#include <coroutine>
+#include <deque>
+#include "Clock.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Coroutine return type for a pipeline stage run by a CoroutineScheduler.
+	/// The coroutine starts suspended, and is started and owned by the scheduler it is given to with Spawn().
+	/// An exception escaping the coroutine is logged and ends it.
+	/// </summary>
+	class PipelineTask
+	{
+	public:
+		struct promise_type
+		{
+			PipelineTask get_return_object()
+			{
+				return PipelineTask(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() { }
+			void unhandled_exception()
+			{
+				try
+				{
+					std::rethrow_exception(std::current_exception());
+				}
+				catch (const std::exception &e)
+				{
+					Utilities::XErrorLogger::LogError(std::string("Exception in sds::PipelineTask coroutine: ") + e.what());
+				}
+				catch (...)
+				{
+					Utilities::XErrorLogger::LogError("Unknown exception in sds::PipelineTask coroutine.");
+				}
+			}
+		};
+		using Handle = std::coroutine_handle<promise_type>;
+	private:
+		Handle m_handle;
+		explicit PipelineTask(const Handle h) : m_handle(h) { }
+	public:
+		PipelineTask(const PipelineTask& other) = delete;
+		PipelineTask(PipelineTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) { }
+		PipelineTask& operator=(const PipelineTask& other) = delete;
+		PipelineTask& operator=(PipelineTask&& other) = delete;
+		~PipelineTask()
+		{
+			if (m_handle)
+				m_handle.destroy();
+		}
+		/// <summary>
+		/// Gives up ownership of the coroutine, used by the scheduler.
+		/// </summary>
+		Handle Release()
+		{
+			return std::exchange(m_handle, nullptr);
+		}
+	};
+
+	/// <summary>
+	/// Runs PipelineTask coroutines on the thread that calls Run(), an alternative to a CPPThreadRunner thread per stage.
+	/// Coroutines suspend on awaitables that resume them at a deadline, the scheduler sleeps until the earliest one.
+	/// Any number of pipelines can be spawned on one scheduler, run one scheduler per thread to use more threads.
+	/// Spawn() is called before Run() or from a coroutine on the scheduler, RequestStop() may be called from any thread.
+	/// </summary>
+	class CoroutineScheduler
+	{
+	public:
+		using ClockType = std::chrono::steady_clock;
+		using TimePoint = ClockType::time_point;
+	private:
+		struct Timer
+		{
+			TimePoint due;
+			//keeps equal deadlines in the order they were added
+			std::uint64_t sequence;
+			std::coroutine_handle<> handle;
+			bool operator>(const Timer &other) const
+			{
+				return due != other.due ? due > other.due : sequence > other.sequence;
+			}
+		};
+		std::vector<Timer> m_timers;
+		std::deque<std::coroutine_handle<>> m_ready;
+		std::vector<PipelineTask::Handle> m_tasks;
+		std::uint64_t m_sequence = 0;
+		std::atomic<bool> m_isStopRequested{ false };
+	public:
+		CoroutineScheduler() = default;
+		CoroutineScheduler(const CoroutineScheduler& other) = delete;
+		CoroutineScheduler(CoroutineScheduler&& other) = delete;
+		CoroutineScheduler& operator=(const CoroutineScheduler& other) = delete;
+		CoroutineScheduler& operator=(CoroutineScheduler&& other) = delete;
+		/// <summary>
+		/// Dtor destroys any coroutine that has not finished, running the destructors of its locals.
+		/// </summary>
+		~CoroutineScheduler()
+		{
+			for (const PipelineTask::Handle h : m_tasks)
+				h.destroy();
+		}
+		/// <summary>
+		/// Takes ownership of the task, it is started by Run().
+		/// </summary>
+		void Spawn(PipelineTask task)
+		{
+			const PipelineTask::Handle h = task.Release();
+			m_tasks.push_back(h);
+			m_ready.push_back(h);
+		}
+		/// <summary>
+		/// Resumes the coroutine at the deadline, or as soon as possible once a stop is requested.
+		/// Used by awaitables from their await_suspend().
+		/// </summary>
+		void ResumeAt(const TimePoint due, const std::coroutine_handle<> h)
+		{
+			m_timers.push_back({ due, m_sequence++, h });
+			std::push_heap(m_timers.begin(), m_timers.end(), std::greater<>());
+		}
+		/// <summary>
+		/// Awaitable that suspends the calling coroutine until the deadline.
+		/// </summary>
+		auto SleepUntil(const TimePoint due)
+		{
+			struct SleepAwaiter
+			{
+				CoroutineScheduler &scheduler;
+				TimePoint due;
+				//always suspends, so a coroutine with a deadline in the past still lets the others run
+				bool await_ready() const noexcept { return false; }
+				void await_suspend(const std::coroutine_handle<> h) { scheduler.ResumeAt(due, h); }
+				void await_resume() const noexcept { }
+			};
+			return SleepAwaiter{ *this, due };
+		}
+		auto SleepFor(const ClockType::duration d)
+		{
+			return SleepUntil(Utilities::Clock::Get().Now() + d);
+		}
+		/// <summary>
+		/// Asks the coroutines to finish, they are woken early and are expected to check IsStopRequested().
+		/// </summary>
+		void RequestStop()
+		{
+			m_isStopRequested = true;
+		}
+		bool IsStopRequested() const
+		{
+			return m_isStopRequested;
+		}
+		size_t GetTaskCount() const
+		{
+			return m_tasks.size();
+		}
+		/// <summary>
+		/// Runs the spawned coroutines until they have all finished.
+		/// </summary>
+		void Run()
+		{
+			const std::chrono::milliseconds stopCheckPeriod(XinSettings::THREAD_DELAY_POLLER);
+			while (!m_tasks.empty())
+			{
+				ReleaseDueTimers(Utilities::Clock::Get().Now());
+				while (!m_ready.empty())
+				{
+					const std::coroutine_handle<> h = m_ready.front();
+					m_ready.pop_front();
+					h.resume();
+				}
+				ReapFinished();
+				if (m_tasks.empty())
+					return;
+				if (m_timers.empty())
+				{
+					Utilities::XErrorLogger::LogError("sds::CoroutineScheduler::Run(), coroutines are suspended with nothing to resume them.");
+					return;
+				}
+				//capped so a stop request is seen while sleeping towards a distant deadline
+				if (!m_isStopRequested)
+					Utilities::Clock::Get().SleepUntil(std::min(m_timers.front().due, Utilities::Clock::Get().Now() + stopCheckPeriod));
+			}
+		}
+	private:
+		void ReleaseDueTimers(const TimePoint now)
+		{
+			while (!m_timers.empty() && (m_isStopRequested || m_timers.front().due <= now))
+			{
+				m_ready.push_back(m_timers.front().handle);
+				std::pop_heap(m_timers.begin(), m_timers.end(), std::greater<>());
+				m_timers.pop_back();
+			}
+		}
+		void ReapFinished()
+		{
+			const auto it = std::remove_if(m_tasks.begin(), m_tasks.end(), [](const PipelineTask::Handle h)
+				{
+					if (!h.done())
+						return false;
+					h.destroy();
+					return true;
+				});
+			m_tasks.erase(it, m_tasks.end());
+		}
+	};
+}
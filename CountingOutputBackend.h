@@ -0,0 +1,52 @@
+#pragma once
+#include "stdafx.h"
+#include "OutputBackend.h"
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Null OutputBackend, discards the INPUT records and only counts them by kind.
+		/// Used to profile the mapper and mouse pipeline without any injection cost.
+		/// </summary>
+		class CountingOutputBackend : public OutputBackend
+		{
+			std::atomic<std::uint64_t> m_keyCount{ 0 };
+			std::atomic<std::uint64_t> m_mouseMoveCount{ 0 };
+			std::atomic<std::uint64_t> m_mouseButtonCount{ 0 };
+		protected:
+			size_t SendFrameImpl(const INPUT *inputs, const size_t count) override
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					const INPUT &inp = inputs[i];
+					if (inp.type == INPUT_KEYBOARD)
+						m_keyCount.fetch_add(1, std::memory_order_relaxed);
+					else if (inp.mi.dwFlags & MOUSEEVENTF_MOVE)
+						m_mouseMoveCount.fetch_add(1, std::memory_order_relaxed);
+					else
+						m_mouseButtonCount.fetch_add(1, std::memory_order_relaxed);
+				}
+				return count;
+			}
+		public:
+			std::string GetName() const override
+			{
+				return "null";
+			}
+			std::uint64_t GetKeyCount() const
+			{
+				return m_keyCount.load(std::memory_order_relaxed);
+			}
+			std::uint64_t GetMouseMoveCount() const
+			{
+				return m_mouseMoveCount.load(std::memory_order_relaxed);
+			}
+			std::uint64_t GetMouseButtonCount() const
+			{
+				return m_mouseButtonCount.load(std::memory_order_relaxed);
+			}
+		};
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Min-heap of deadlines for a fixed set of task ids, used by the reactor loop to find the next step to run.
+	/// Each task has at most one live deadline, scheduling a task again replaces its deadline and cancelling removes it.
+	/// Replaced and cancelled entries are left in the heap and skipped when they reach the top.
+	/// Used by a single thread.
+	/// </summary>
+	class DeadlineQueue
+	{
+	public:
+		using ClockType = std::chrono::steady_clock;
+		using TimePoint = ClockType::time_point;
+	private:
+		struct Entry
+		{
+			TimePoint due;
+			size_t task;
+			std::uint64_t generation;
+			bool operator>(const Entry &other) const
+			{
+				return due > other.due;
+			}
+		};
+		std::vector<Entry> m_heap;
+		//an entry is live only while its generation matches the task's current one
+		std::vector<std::uint64_t> m_generations;
+		std::vector<bool> m_isScheduled;
+	public:
+		/// <param name="taskCount">number of task ids, valid ids are 0 to taskCount-1</param>
+		explicit DeadlineQueue(const size_t taskCount)
+			: m_generations(taskCount, 0), m_isScheduled(taskCount, false)
+		{
+			m_heap.reserve(taskCount * 4);
+		}
+		DeadlineQueue(const DeadlineQueue& other) = delete;
+		DeadlineQueue(DeadlineQueue&& other) = delete;
+		DeadlineQueue& operator=(const DeadlineQueue& other) = delete;
+		DeadlineQueue& operator=(DeadlineQueue&& other) = delete;
+		~DeadlineQueue() = default;
+		/// <summary>
+		/// Schedules the task to run at the deadline, replacing any deadline it already has.
+		/// </summary>
+		void Schedule(const size_t task, const TimePoint due)
+		{
+			m_isScheduled[task] = true;
+			m_heap.push_back({ due, task, ++m_generations[task] });
+			std::push_heap(m_heap.begin(), m_heap.end(), std::greater<>());
+		}
+		/// <summary>
+		/// Removes the task's deadline, if it has one.
+		/// </summary>
+		void Cancel(const size_t task)
+		{
+			if (!m_isScheduled[task])
+				return;
+			m_isScheduled[task] = false;
+			++m_generations[task];
+		}
+		bool IsScheduled(const size_t task) const
+		{
+			return m_isScheduled[task];
+		}
+		/// <summary>
+		/// Returns the earliest deadline, or TimePoint::max() if no task is scheduled.
+		/// </summary>
+		TimePoint NextDue()
+		{
+			DropStale();
+			return m_heap.empty() ? TimePoint::max() : m_heap.front().due;
+		}
+		/// <summary>
+		/// Removes and returns the task with the earliest deadline if that deadline is not after "now".
+		/// Tasks with equal deadlines are returned in no particular order.
+		/// </summary>
+		std::optional<size_t> PopDue(const TimePoint now)
+		{
+			DropStale();
+			if (m_heap.empty() || m_heap.front().due > now)
+				return {};
+			const size_t task = m_heap.front().task;
+			PopFront();
+			m_isScheduled[task] = false;
+			return task;
+		}
+	private:
+		void PopFront()
+		{
+			std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<>());
+			m_heap.pop_back();
+		}
+		void DropStale()
+		{
+			while (!m_heap.empty() && m_heap.front().generation != m_generations[m_heap.front().task])
+				PopFront();
+		}
+	};
+}
@@ -0,0 +1,15 @@
+#pragma once
+namespace sds
+{
+	/// <summary>
+	/// Used to denote how a thumbstick deadzone is applied.
+	///	AXIAL is the original independent per-axis (square) deadzone, RADIAL tests the stick magnitude
+	///	against a single radius, SCALED_RADIAL also rescales the magnitude beyond the radius to the full range.
+	/// </summary>
+	enum class DeadzoneMode : int
+	{
+		AXIAL,
+		RADIAL,
+		SCALED_RADIAL
+	};
+}
@@ -1,5 +1,7 @@
 ﻿#pragma once
 #include "stdafx.h"
+#include "Clock.h"
+#include "TimerSettings.h"
 #include <chrono>
 #include <thread>
 
@@ -9,14 +11,31 @@ namespace sds
 	{
 		namespace DelayHighPrecision
 		{
-			inline void SleepFor(const std::chrono::microseconds delayValueMicroseconds)
+			/// <summary>
+			/// Waits until the time point on the clock, the process wide one if not given. Sleeps on the platform timer
+			/// until "spinMargin" before the time point and busy waits only for the rest, so a long wait costs
+			/// next to no CPU and still does not end early or much late. The margin is the calibrated one of TimerSettings if not given.
+			/// </summary>
+			inline void SleepUntil(const Clock::TimePoint until, Clock &clock = Clock::Get(),
+				const Clock::Duration spinMargin = TimerSettings::Get().GetSpinMargin())
 			{
-				const auto start = std::chrono::high_resolution_clock::now();
-				const auto end = start + delayValueMicroseconds;
-				do
-				{
-					//std::this_thread::yield();
-				} while (std::chrono::high_resolution_clock::now() < end);
+				if (until - clock.Now() > spinMargin)
+					clock.SleepUntil(until - spinMargin);
+				clock.SpinUntil(until);
+			}
+			/// <summary>
+			/// Waits for the delay, see SleepUntil().
+			/// </summary>
+			inline void SleepFor(const std::chrono::microseconds delayValueMicroseconds, Clock &clock = Clock::Get())
+			{
+				SleepUntil(clock.Now() + delayValueMicroseconds, clock);
+			}
+			/// <summary>
+			/// Busy waits for the whole delay, the most accurate wait and a full core for its length.
+			/// </summary>
+			inline void SpinFor(const std::chrono::microseconds delayValueMicroseconds, Clock &clock = Clock::Get())
+			{
+				clock.SpinUntil(clock.Now() + delayValueMicroseconds);
 			}
 		}
 	}
@@ -1,18 +1,21 @@
 #pragma once
 #include "stdafx.h"
+#include "Clock.h"
 
 namespace sds
 {
 	class DelayManager
 	{
 	public:
-		using TimeType = std::chrono::time_point<std::chrono::high_resolution_clock>;
+		using TimeType = Utilities::Clock::TimePoint;
 	private:
+		const Utilities::Clock &m_clock;
 		TimeType m_startTime;
 		size_t m_duration;
 		bool m_hasFired;
 	public:
-		DelayManager(size_t duration_us) : m_startTime(std::chrono::high_resolution_clock::now()), m_duration(duration_us), m_hasFired(false)
+		/// <param name="clock">the clock read, the process wide one if not given</param>
+		DelayManager(size_t duration_us, const Utilities::Clock &clock = Utilities::Clock::Get()) : m_clock(clock), m_startTime(clock.Now()), m_duration(duration_us), m_hasFired(false)
 		{
 		}
 		/// <summary>
@@ -20,20 +23,27 @@ namespace sds
 		/// </summary>
 		bool operator()()
 		{
-			if (std::chrono::high_resolution_clock::now() > (m_startTime + std::chrono::microseconds(m_duration)))
+			if (m_clock.Now() > (m_startTime + std::chrono::microseconds(m_duration)))
 			{
 				m_hasFired = true;
 				return true;
 			}
 			return false;
 		}
+		/// <summary>
+		/// Time point after which the delay has elapsed.
+		/// </summary>
+		TimeType GetDeadline() const
+		{
+			return m_startTime + std::chrono::microseconds(m_duration);
+		}
 		bool HasFired() const
 		{
 			return m_hasFired;
 		}
 		void Reset(size_t newDuration)
 		{
-			m_startTime = std::chrono::high_resolution_clock::now();
+			m_startTime = m_clock.Now();
 			m_hasFired = false;
 			m_duration = newDuration;
 		}
@@ -0,0 +1,14 @@
+#pragma once
+namespace sds
+{
+	/// <summary>
+	/// Used to denote how a GamepadUser runs its pipeline.
+	///	THREADED is the original mode with a poller thread, a mouse thread and a mouse move thread handing data
+	///	to each other, REACTOR runs polling, mapping and mouse moves as steps of one event loop on the poller thread.
+	/// </summary>
+	enum class ExecutionMode : int
+	{
+		THREADED,
+		REACTOR
+	};
+}
@@ -0,0 +1,269 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Always-on fixed size ring buffer of the controller states polled and the INPUT records sent,
+		/// with monotonic timestamps. Used to find out what happened when input "felt laggy".
+		/// Recording is wait-free, each producing thread claims a slot with a single fetch_add and publishes
+		/// it with a per-slot sequence number, so readers never block writers.
+		/// The most recent events can be dumped to a text file on demand, or on error with DumpOnError().
+		/// </summary>
+		class FlightRecorder
+		{
+		public:
+			using ClockType = std::chrono::steady_clock;
+			enum class EventType : std::uint8_t
+			{
+				CONTROLLER_STATE,
+				OUTPUT_INPUT
+			};
+			/// <summary>
+			/// A single recorded event, the timestamp is in nanoseconds since the recorder was constructed.
+			/// </summary>
+			struct Event
+			{
+				std::uint64_t timestampNs;
+				EventType type;
+				union
+				{
+					XINPUT_STATE state;
+					INPUT input;
+				};
+				Event() : timestampNs(0), type(EventType::CONTROLLER_STATE), input{} { }
+			};
+		private:
+			/// <summary>
+			/// Sequence is odd while the slot is being written, and 2 * (event index + 1) once published.
+			/// </summary>
+			struct Slot
+			{
+				std::atomic<std::uint64_t> sequence{ 0 };
+				Event event;
+			};
+			const size_t m_capacity;
+			std::unique_ptr<Slot[]> m_slots;
+			std::atomic<std::uint64_t> m_writeIndex;
+			std::atomic<bool> m_isEnabled;
+			std::atomic<std::int64_t> m_lastErrorDumpNs;
+			const ClockType::time_point m_startTime;
+		public:
+			/// <summary>
+			/// Ctor, capacity must be a power of two.
+			/// </summary>
+			explicit FlightRecorder(const size_t capacity = XinSettings::FLIGHT_RECORDER_CAPACITY)
+				: m_capacity(capacity),
+				m_slots(std::make_unique<Slot[]>(capacity)),
+				m_writeIndex(0),
+				m_isEnabled(true),
+				m_lastErrorDumpNs(std::numeric_limits<std::int64_t>::min()),
+				m_startTime(ClockType::now())
+			{
+				assert((capacity & (capacity - 1)) == 0);
+			}
+			FlightRecorder(const FlightRecorder& other) = delete;
+			FlightRecorder(FlightRecorder&& other) = delete;
+			FlightRecorder& operator=(const FlightRecorder& other) = delete;
+			FlightRecorder& operator=(FlightRecorder&& other) = delete;
+			/// <summary>
+			/// Dtor, waits for a dump posted by DumpOnError() to be written.
+			/// </summary>
+			~FlightRecorder()
+			{
+				if (m_lastErrorDumpNs.load(std::memory_order_relaxed) != std::numeric_limits<std::int64_t>::min())
+					AsyncLogger::Get().Flush();
+			}
+			/// <summary>
+			/// The process wide recorder used by InputPoller and SendKey.
+			/// </summary>
+			static FlightRecorder& Get()
+			{
+				//the logger is constructed first, so it is destroyed after the recorder
+				[[maybe_unused]] static AsyncLogger &logger = AsyncLogger::Get();
+				static FlightRecorder recorder;
+				return recorder;
+			}
+			void SetEnabled(const bool isEnabled)
+			{
+				m_isEnabled.store(isEnabled, std::memory_order_relaxed);
+			}
+			bool IsEnabled() const
+			{
+				return m_isEnabled.load(std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Records a polled controller state.
+			/// </summary>
+			void RecordState(const XINPUT_STATE &state)
+			{
+				if (!IsEnabled())
+					return;
+				const std::uint64_t index = ClaimSlot();
+				Slot &slot = SlotAt(index);
+				slot.event.type = EventType::CONTROLLER_STATE;
+				slot.event.state = state;
+				Publish(index);
+			}
+			/// <summary>
+			/// Records each INPUT in an array about to be passed to SendInput.
+			/// </summary>
+			void RecordInput(const INPUT *inputs, const size_t count)
+			{
+				if (!IsEnabled())
+					return;
+				for (size_t i = 0; i < count; i++)
+				{
+					const std::uint64_t index = ClaimSlot();
+					Slot &slot = SlotAt(index);
+					slot.event.type = EventType::OUTPUT_INPUT;
+					slot.event.input = inputs[i];
+					Publish(index);
+				}
+			}
+			/// <summary>
+			/// Returns the number of events recorded since construction, including those overwritten.
+			/// </summary>
+			std::uint64_t GetEventCount() const
+			{
+				return m_writeIndex.load(std::memory_order_acquire);
+			}
+			/// <summary>
+			/// Copies out the published events no older than "window" relative to the newest one, oldest first.
+			/// Slots being written during the copy are skipped.
+			/// </summary>
+			[[nodiscard]] std::vector<Event> Snapshot(const std::chrono::nanoseconds window) const
+			{
+				const std::uint64_t endIndex = m_writeIndex.load(std::memory_order_acquire);
+				const std::uint64_t beginIndex = endIndex > m_capacity ? endIndex - m_capacity : 0;
+				std::vector<Event> events;
+				events.reserve(static_cast<size_t>(endIndex - beginIndex));
+				for (std::uint64_t i = beginIndex; i < endIndex; i++)
+				{
+					const Slot &slot = SlotAt(i);
+					const std::uint64_t expected = (i + 1) * 2;
+					if (slot.sequence.load(std::memory_order_acquire) != expected)
+						continue;
+					const Event copy = slot.event;
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (slot.sequence.load(std::memory_order_relaxed) != expected)
+						continue;
+					events.push_back(copy);
+				}
+				//slots are published out of order by concurrent writers
+				std::ranges::stable_sort(events, {}, &Event::timestampNs);
+				if (!events.empty())
+				{
+					const std::uint64_t newest = events.back().timestampNs;
+					const std::uint64_t windowNs = static_cast<std::uint64_t>(window.count());
+					const std::uint64_t oldest = newest > windowNs ? newest - windowNs : 0;
+					std::erase_if(events, [oldest](const Event &e) { return e.timestampNs < oldest; });
+				}
+				return events;
+			}
+			/// <summary>
+			/// Writes the last "window" of events to a text file, one event per line.
+			/// <list type="bullet">
+			/// <item>microseconds STATE packet buttons ltrigger rtrigger lx ly rx ry</item>
+			/// <item>microseconds KEY vk scancode flags</item>
+			/// <item>microseconds MOUSE dx dy flags</item>
+			/// </list>
+			/// </summary>
+			/// <returns>A std::string containing an error message if there is an error, empty string otherwise.</returns>
+			[[nodiscard]] std::string DumpToFile(const std::string &fileName,
+				const std::chrono::seconds window = std::chrono::seconds(XinSettings::FLIGHT_RECORDER_SECONDS)) const
+			{
+				std::ofstream outFile(fileName, std::ios::out | std::ios::trunc);
+				if (!outFile)
+					return "Error in sds::Utilities::FlightRecorder::DumpToFile(), failed to open file: " + fileName;
+				outFile << "# xinmapper flight recorder, timestamps in microseconds\n";
+				for (const Event &e : Snapshot(window))
+					outFile << FormatEvent(e) << '\n';
+				if (!outFile)
+					return "Error in sds::Utilities::FlightRecorder::DumpToFile(), failed writing file: " + fileName;
+				return "";
+			}
+			/// <summary>
+			/// Dumps to XinSettings::FLIGHT_RECORDER_DUMP_FILE, to be called from error paths.
+			/// At most one dump is written per XinSettings::FLIGHT_RECORDER_SECONDS so an error repeated
+			/// every frame results in a single file. The file is written by a task on the flush thread of the AsyncLogger,
+			/// so the calling thread, often the polling or output thread, only checks the time.
+			/// </summary>
+			void DumpOnError()
+			{
+				const std::int64_t nowNs = GetNowNs();
+				std::int64_t lastNs = m_lastErrorDumpNs.load(std::memory_order_relaxed);
+				const std::int64_t minGapNs = std::chrono::nanoseconds(std::chrono::seconds(XinSettings::FLIGHT_RECORDER_SECONDS)).count();
+				if (lastNs != std::numeric_limits<std::int64_t>::min() && (nowNs - lastNs) < minGapNs)
+					return;
+				if (!m_lastErrorDumpNs.compare_exchange_strong(lastNs, nowNs))
+					return;
+				AsyncLogger::Get().Post([this]()
+					{
+						const std::string err = DumpToFile(XinSettings::FLIGHT_RECORDER_DUMP_FILE);
+						if (!err.empty())
+							XErrorLogger::LogError(err);
+					});
+			}
+			/// <summary>
+			/// Formats an Event as a line of the dump file, without the newline.
+			/// </summary>
+			static std::string FormatEvent(const Event &e)
+			{
+				const std::string body = e.type == EventType::CONTROLLER_STATE ? FormatState(e.state) : FormatInput(e.input);
+				return std::to_string(e.timestampNs / 1000) + ' ' + body;
+			}
+			/// <summary>
+			/// Formats an XINPUT_STATE as "STATE packet buttons ltrigger rtrigger lx ly rx ry"
+			/// </summary>
+			static std::string FormatState(const XINPUT_STATE &state)
+			{
+				std::stringstream ss;
+				const XINPUT_GAMEPAD &g = state.Gamepad;
+				ss << "STATE " << state.dwPacketNumber << ' ' << g.wButtons << ' '
+					<< static_cast<int>(g.bLeftTrigger) << ' ' << static_cast<int>(g.bRightTrigger) << ' '
+					<< g.sThumbLX << ' ' << g.sThumbLY << ' ' << g.sThumbRX << ' ' << g.sThumbRY;
+				return ss.str();
+			}
+			/// <summary>
+			/// Formats an INPUT as "KEY vk scancode flags" or "MOUSE dx dy flags"
+			/// </summary>
+			static std::string FormatInput(const INPUT &input)
+			{
+				std::stringstream ss;
+				if (input.type == INPUT_KEYBOARD)
+					ss << "KEY " << input.ki.wVk << ' ' << input.ki.wScan << ' ' << input.ki.dwFlags;
+				else
+					ss << "MOUSE " << input.mi.dx << ' ' << input.mi.dy << ' ' << input.mi.dwFlags;
+				return ss.str();
+			}
+		private:
+			std::int64_t GetNowNs() const
+			{
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(ClockType::now() - m_startTime).count();
+			}
+			/// <summary>
+			/// Claims the next slot and marks it as being written.
+			/// </summary>
+			std::uint64_t ClaimSlot()
+			{
+				const std::uint64_t index = m_writeIndex.fetch_add(1, std::memory_order_acq_rel);
+				Slot &slot = SlotAt(index);
+				slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				slot.event.timestampNs = static_cast<std::uint64_t>(GetNowNs());
+				return index;
+			}
+			Slot &SlotAt(const std::uint64_t index) const
+			{
+				return m_slots[static_cast<size_t>(index & (m_capacity - 1))];
+			}
+			void Publish(const std::uint64_t index) const
+			{
+				SlotAt(index).sequence.store((index + 1) * 2, std::memory_order_release);
+			}
+		};
+	}
+}
@@ -9,11 +9,16 @@ namespace sds
 {
 	/// <summary>
 	/// Highest level class for usage, contains instances of InputPoller, Mapper, XInputTranslater, and XInputBoostMouse.
+	///	The ExecutionMode given to the constructor selects whether they run on three threads or on one reactor thread.
 	///	Note the order in which the data members are declared in the class definition is the order in which they are
 	///	initialized in the constructor initializer list. Regardless of the order of the initializers!
 	/// </summary>
 	class GamepadUser
 	{
+		/// <summary>
+		/// The configuration snapshots shared by the XInputTranslater, XInputBoostMouse and InputPoller.
+		/// </summary>
+		ConfigStore config;
 	public:
 		/// <summary>
 		/// Pointer to Mapper instance, remember to set the map info with the
@@ -41,8 +46,10 @@ namespace sds
 		/// </summary>
 		InputPoller poller;
 	public:
-		GamepadUser() : poller(mapper,transl,mouse)	{ }
-		GamepadUser(const sds::PlayerInfo &player) : transl(player), mouse(player), poller(mapper,transl,mouse) { }
+		/// <param name="mode">THREADED for the poller, mouse and mouse move threads, REACTOR to run them all on the poller thread</param>
+		explicit GamepadUser(const ExecutionMode mode = ExecutionMode::THREADED) : mouse(config, mode), poller(mapper,transl,mouse)	{ }
+		GamepadUser(const sds::PlayerInfo &player, const ExecutionMode mode = ExecutionMode::THREADED)
+			: config(ConfigSnapshot{ player }), transl(player), mouse(config, mode), poller(mapper,transl,mouse) { }
 		GamepadUser(const GamepadUser& other) = delete;
 		GamepadUser(GamepadUser&& other) = delete;
 		GamepadUser& operator=(const GamepadUser& other) = delete;
@@ -50,7 +57,16 @@ namespace sds
 		~GamepadUser()
 		{
 			poller.Stop();
+			mapper.ReleaseHeldKeys();
 			mouse.EnableProcessing(MouseMap::NEITHER_STICK);
 		}
+		/// <summary>
+		/// Returns the runtime counters: polls, frames processed and the output sent.
+		/// The counters are process wide, with more than one GamepadUser they are the totals of all of them.
+		/// </summary>
+		Utilities::RuntimeStats GetStats() const
+		{
+			return Utilities::RuntimeCounters::Get().Snapshot();
+		}
 	};
 }
\ No newline at end of file
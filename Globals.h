@@ -6,10 +6,10 @@ namespace sds
 {
 	/// <summary>
 	/// ActionDescriptors is a struct containing string tokens used to build a string describing how controller
-	/// buttons are mapped to Keyboard and Mouse buttons. It also has a std::map xin_buttons mapping some string tokens
-	/// to XINPUT lib defines.
+	/// buttons are mapped to Keyboard and Mouse buttons. It also has an array xin_buttons mapping some string tokens
+	/// to XINPUT lib defines. Its members are compile time constants, this is the one definition shared by every translation unit.
 	/// </summary>
-	static ActionDescriptors sdsActionDescriptors;
+	inline constexpr ActionDescriptors sdsActionDescriptors{};
 
 	/// <summary>
 	/// ActionDetails is a std::string specifically used to transmit state information
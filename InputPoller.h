@@ -3,42 +3,128 @@
 #include "Mapper.h"
 #include "XInputTranslater.h"
 #include "XInputBoostMouse.h"
+#include "MouseMoveStepper.h"
 #include "CPPThreadRunner.h"
+#include "FlightRecorder.h"
+#include "ProfileSelector.h"
+#include "RuntimeCounters.h"
+#include "Clock.h"
+#include "DelayHighPrecision.h"
 
 namespace sds
 {
 	/// <summary>
 	/// Polls for input from the XInput library in it's worker thread function,
 	/// sends them to XInputBoostMouse and Mapper for processing.
+	/// If the XInputBoostMouse is in ExecutionMode::REACTOR, the worker thread also sends the mouse moves,
+	/// and the whole pipeline runs on this one thread.
 	/// </summary>
 	class InputPoller : public CPPThreadRunner<XINPUT_STATE>
 	{
+	public:
+		/// <summary>
+		/// Function used to get the controller state, XInputGetState unless replaced with SetStateSource().
+		/// </summary>
+		using StateSource = std::function<DWORD(DWORD, XINPUT_STATE*)>;
+	private:
 		Mapper &m_mapper;
 		XInputTranslater &m_translater;
 		XInputBoostMouse &m_mouse;
-		PlayerInfo m_localPlayer;
+		//the configuration of the GamepadUser, shared with the mouse
+		ConfigStore &m_config;
+		std::atomic<ProfileSelector*> m_profileSelector{ nullptr };
+		StateSource m_stateSource = [](const DWORD playerId, XINPUT_STATE *state) { return XInputGetState(playerId, state); };
 	protected:
 		/// <summary>
 		/// Worker thread overriding the base pure virtual workThread,
 		/// uses a sds::Mapper, sds::XInputTranslater, sds::XInputBoostMouse
 		/// runs a constant loop of getting state information in the form of an XINPUT_STATE
 		/// it then processes with either the XInputBoostMouse or the Mapper.
+		/// Each polled state is recorded in the FlightRecorder, which is dumped if the controller is lost while polling.
 		/// </summary>
 		void workThread() override
 		{
 			//because there is only one thread modifying the local_state struct, we won't use the mutex.
 			memset(&local_state, 0, sizeof(XINPUT_STATE));
+			if (m_mouse.GetExecutionMode() == ExecutionMode::REACTOR)
+			{
+				RunReactor();
+				return;
+			}
+			bool wasConnected = false;
 			while( ! this->isStopRequested )
 			{	
-				const DWORD error = XInputGetState(m_localPlayer.player_id, &local_state);
-				if (error != ERROR_SUCCESS)
+				PollOnce(wasConnected);
+				Utilities::Clock::Get().SleepFor(std::chrono::milliseconds(XinSettings::THREAD_DELAY_POLLER));
+			}
+			this->isThreadRunning = false;
+		}
+	private:
+		/// <summary>
+		/// Gets and processes one controller state.
+		/// </summary>
+		/// <param name="wasConnected">connected status of the previous poll, updated</param>
+		/// <returns>true if a state was processed</returns>
+		bool PollOnce(bool &wasConnected)
+		{
+			using Utilities::RuntimeCounters;
+			//output the backend did not insert is retried at the poll rate
+			Utilities::SendKey::RetryPendingOutput();
+			const std::shared_ptr<const ConfigSnapshot> config = m_config.Acquire();
+			const DWORD error = m_stateSource(config->player.player_id, &local_state);
+			RuntimeCounters::Get().Add(RuntimeCounters::Counter::POLLS);
+			if (error != ERROR_SUCCESS)
+			{
+				RuntimeCounters::Get().Add(RuntimeCounters::Counter::POLL_FAILURES);
+				if (wasConnected)
+					Utilities::FlightRecorder::Get().DumpOnError();
+				wasConnected = false;
+				return false;
+			}
+			wasConnected = true;
+			ProcessState(local_state, *config);
+			return true;
+		}
+		/// <summary>
+		/// Event loop of ExecutionMode::REACTOR, polling and the mouse moves are tasks in a DeadlineQueue
+		/// and the thread sleeps until the earliest deadline. The poll task is always scheduled,
+		/// so a stop request is seen within one poll period.
+		/// </summary>
+		void RunReactor()
+		{
+			enum ReactorTask : size_t
+			{
+				POLL,
+				MOUSE_FIRST,
+				TASK_COUNT = MOUSE_FIRST + MouseMoveStepper::TASK_COUNT
+			};
+			DeadlineQueue queue(TASK_COUNT);
+			MouseMoveStepper stepper(m_mouse, MOUSE_FIRST);
+			const std::chrono::milliseconds pollPeriod(XinSettings::THREAD_DELAY_POLLER);
+			bool wasConnected = false;
+			Utilities::Clock &clock = Utilities::Clock::Get();
+			queue.Schedule(POLL, clock.Now());
+			while (!this->isStopRequested)
+			{
+				//while the mouse moves its deadlines are waited for precisely, see TimerSettings
+				if (stepper.IsMoving())
+					Utilities::DelayHighPrecision::SleepUntil(queue.NextDue(), clock);
+				else
+					clock.SleepUntil(queue.NextDue());
+				const DeadlineQueue::TimePoint now = clock.Now();
+				while (const std::optional<size_t> task = queue.PopDue(now))
 				{
-					std::this_thread::sleep_for(std::chrono::milliseconds(XinSettings::THREAD_DELAY_POLLER));
-					continue;
+					if (*task == POLL)
+					{
+						if (PollOnce(wasConnected))
+							stepper.Update(now, queue);
+						queue.Schedule(POLL, now + pollPeriod);
+					}
+					else
+					{
+						stepper.RunTask(*task, now, queue);
+					}
 				}
-				m_mouse.ProcessState(local_state);
-				m_mapper.ProcessActionDetails(m_translater.ProcessState(local_state));
-				std::this_thread::sleep_for(std::chrono::milliseconds(XinSettings::THREAD_DELAY_POLLER));
 			}
 			this->isThreadRunning = false;
 		}
@@ -50,21 +136,24 @@ namespace sds
 		/// <param name="transl"></param>
 		/// <param name="mouse"></param>
 		InputPoller(Mapper &mapper, XInputTranslater &transl, XInputBoostMouse &mouse)
-			: CPPThreadRunner(), m_mapper(mapper), m_translater(transl), m_mouse(mouse)
+			: CPPThreadRunner(ThreadPolicy::ForPoller()), m_mapper(mapper), m_translater(transl), m_mouse(mouse), m_config(mouse.GetConfigStore())
 		{
 			memset(&local_state, 0, sizeof(XINPUT_STATE));
 		}
 		/// <summary>
 		/// Alt constructor, requires ref to objects: Mapper, XInputTranslater, XInputBoostMouse
-		///	and a PlayerInfo object.
+		///	and a PlayerInfo object, published as the player of the configuration shared with the mouse.
 		/// </summary>
 		/// <param name="mapper"></param>
 		/// <param name="transl"></param>
 		/// <param name="mouse"></param>
 		/// <param name="p">custom playerinfo object</param>
 		InputPoller(Mapper &mapper, XInputTranslater &transl, XInputBoostMouse &mouse, const PlayerInfo &p)
-			: CPPThreadRunner(), m_mapper(mapper), m_translater(transl), m_mouse(mouse), m_localPlayer(p)
+			: InputPoller(mapper, transl, mouse)
 		{
+			const std::string err = m_config.Update([&p](ConfigSnapshot &c) { c.player = p; });
+			if (!err.empty())
+				Utilities::XErrorLogger::LogError(err);
 			memset(&local_state, 0, sizeof(XINPUT_STATE));
 		}
 		InputPoller() = delete;
@@ -81,6 +170,51 @@ namespace sds
 			this->stopThread();
 		}
 		/// <summary>
+		/// Processes a single controller state with the XInputBoostMouse and the Mapper, as the worker thread
+		/// does for each polled state. Public so a recorded trace can drive the pipeline without polling.
+		/// A profile selected by the ProfileSelector is activated before the state is mapped.
+		/// </summary>
+		/// <param name="state">XINPUT_STATE to process</param>
+		void ProcessState(const XINPUT_STATE &state)
+		{
+			ProcessState(state, *m_config.Acquire());
+		}
+		/// <summary>
+		/// Processes a single controller state with the configuration snapshot taken for the frame.
+		/// </summary>
+		void ProcessState(const XINPUT_STATE &state, const ConfigSnapshot &config)
+		{
+			Utilities::FlightRecorder::Get().RecordState(state);
+			Utilities::RuntimeCounters::Get().Add(Utilities::RuntimeCounters::Counter::FRAMES);
+			if (ProfileSelector *selector = m_profileSelector.load(std::memory_order_acquire); selector != nullptr)
+			{
+				if (const std::optional<size_t> id = selector->PollSelection(); id.has_value())
+				{
+					const std::string err = m_mapper.ActivateProfile(*id);
+					if (!err.empty())
+						Utilities::XErrorLogger::LogError(err);
+				}
+			}
+			m_mouse.ProcessState(state, config);
+			m_mapper.ProcessActionDetails(m_translater.ProcessState(state, config));
+		}
+		/// <summary>
+		/// Replaces the function used to get the controller state, to drive the poller from a test or a recording.
+		/// Call while polling is stopped.
+		/// </summary>
+		void SetStateSource(StateSource source)
+		{
+			m_stateSource = std::move(source);
+		}
+		/// <summary>
+		/// Sets the ProfileSelector polled for a profile to switch to before each state is processed, nullptr for none.
+		/// The selector must outlive its use by the poller.
+		/// </summary>
+		void SetProfileSelector(ProfileSelector *selector)
+		{
+			m_profileSelector.store(selector, std::memory_order_release);
+		}
+		/// <summary>
 		/// Start polling for input (and processing via Mapper, XInputBoostMouse, XInputTranslater)
 		/// </summary>
 		/// <returns> true if thread started running (or was already running) </returns>
@@ -114,7 +248,7 @@ namespace sds
 		{
 			XINPUT_STATE ss = {};
 			memset(&ss, 0, sizeof(XINPUT_STATE));
-			return XInputGetState(m_localPlayer.player_id, &ss) == ERROR_SUCCESS;
+			return m_stateSource(m_config.Acquire()->player.player_id, &ss) == ERROR_SUCCESS;
 		}
 		/// <summary>
 		/// Returns status of XINPUT library detecting a controller.
@@ -125,7 +259,7 @@ namespace sds
 		{
 			XINPUT_STATE ss = {};
 			memset(&ss, 0, sizeof(XINPUT_STATE));
-			return XInputGetState(p.player_id, &ss) == ERROR_SUCCESS;
+			return m_stateSource(p.player_id, &ss) == ERROR_SUCCESS;
 		}
 	};
 
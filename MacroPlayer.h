@@ -0,0 +1,284 @@
+#pragma once
+#include "stdafx.h"
+#include "CPPThreadRunner.h"
+#include "MacroSequence.h"
+#include <condition_variable>
+
+namespace sds
+{
+	/// <summary>
+	/// Plays MacroSequence bindings on a thread of its own, so a macro with waits never blocks the thread that polls the controller.
+	/// Trigger() only stores an atomic request and wakes the player, a macro triggered while it is playing is restarted,
+	/// and Cancel() stops it. Either way the keys it holds are released first, from records built when the macro was compiled,
+	/// so neither allocates. The player sleeps until shortly before the next frame is due and spins the rest of the way.
+	/// The macros are bound as a MacroSet, built once with the playback state of each macro. SetMacros() publishes a set
+	/// through an atomic pointer and wakes the player, which releases the keys of the set it was playing and takes up the new one,
+	/// so a profile switch neither stops the thread nor allocates. The thread is started by the first set with any macros.
+	/// </summary>
+	class MacroPlayer : public CPPThreadRunner<int>
+	{
+	public:
+		using ClockType = std::chrono::steady_clock;
+		/// <summary>
+		/// Timing of the frames sent, the lateness is how long after its due time a frame was sent.
+		/// </summary>
+		struct Counters
+		{
+			std::atomic<std::uint64_t> framesSent{ 0 };
+			std::atomic<std::uint64_t> restarts{ 0 };
+			std::atomic<std::uint64_t> totalLatenessMicro{ 0 };
+			std::atomic<std::uint64_t> maxLatenessMicro{ 0 };
+		};
+	private:
+		/// <summary>
+		/// Playback state of one macro, the request is written by Trigger() and Cancel() and the rest by the player thread.
+		/// The request is a count of requests shifted left by one, with the low bit set for a trigger, so the last one wins.
+		/// </summary>
+		struct Slot
+		{
+			std::atomic<std::uint32_t> request{ 0 };
+			std::uint32_t seenRequest = 0;
+			bool isPlaying = false;
+			size_t nextFrame = 0;
+			ClockType::time_point startTime;
+		};
+	public:
+		/// <summary>
+		/// Macros and their playback state, to be played by one MacroPlayer at a time.
+		/// </summary>
+		class MacroSet
+		{
+			friend class MacroPlayer;
+			std::vector<MacroSequence> m_macros;
+			std::unique_ptr<Slot[]> m_slots;
+		public:
+			explicit MacroSet(std::vector<MacroSequence> macros)
+				: m_macros(std::move(macros)), m_slots(std::make_unique<Slot[]>(m_macros.size()))
+			{
+			}
+			MacroSet(const MacroSet& other) = delete;
+			MacroSet(MacroSet&& other) = delete;
+			MacroSet& operator=(const MacroSet& other) = delete;
+			MacroSet& operator=(MacroSet&& other) = delete;
+			~MacroSet() = default;
+			size_t GetCount() const
+			{
+				return m_macros.size();
+			}
+		};
+	private:
+		//the set Trigger() and Cancel() write to, on the thread calling them
+		std::shared_ptr<MacroSet> m_bound = std::make_shared<MacroSet>(std::vector<MacroSequence>{});
+		//the set published to the player thread
+		std::atomic<std::shared_ptr<MacroSet>> m_published{ m_bound };
+		//the set the player thread plays, only used on it
+		std::shared_ptr<MacroSet> m_playing = m_bound;
+		Utilities::SendKey m_keySend;
+		Counters m_counters;
+		std::mutex m_wakeMutex;
+		std::condition_variable m_wakeCondition;
+		std::uint64_t m_wakeCount = 0;
+	protected:
+		void workThread() override
+		{
+			this->isThreadRunning = true;
+			const ClockType::duration spinTime = std::chrono::microseconds(XinSettings::MACRO_SPIN_MICRO);
+			std::uint64_t seenWakeCount = 0;
+			while (!this->isStopRequested)
+			{
+				std::shared_ptr<MacroSet> published = m_published.load(std::memory_order_acquire);
+				if (published != m_playing)
+				{
+					ReleaseAll();
+					m_playing = std::move(published);
+				}
+				const ClockType::time_point nextDue = PlayDue(ClockType::now());
+				bool isWoken = true;
+				{
+					std::unique_lock<std::mutex> l1(m_wakeMutex);
+					const auto isWakeRequested = [this, &seenWakeCount]() { return this->isStopRequested || m_wakeCount != seenWakeCount; };
+					if (nextDue == ClockType::time_point::max())
+						m_wakeCondition.wait(l1, isWakeRequested);
+					else
+						isWoken = m_wakeCondition.wait_until(l1, nextDue - spinTime, isWakeRequested);
+					seenWakeCount = m_wakeCount;
+				}
+				//a trigger, cancel or new set is applied at once, and the next frame due found again, it may be sooner
+				if (isWoken)
+					continue;
+				//the tail is spun, sleeping would overshoot it by the platform timer resolution
+				while (!this->isStopRequested && ClockType::now() < nextDue)
+					std::this_thread::yield();
+			}
+			ReleaseAll();
+			this->isThreadRunning = false;
+		}
+	public:
+		MacroPlayer() : CPPThreadRunner<int>(ThreadPolicy::ForMacro())
+		{
+		}
+		MacroPlayer(const MacroPlayer& other) = delete;
+		MacroPlayer(MacroPlayer&& other) = delete;
+		MacroPlayer& operator=(const MacroPlayer& other) = delete;
+		MacroPlayer& operator=(MacroPlayer&& other) = delete;
+		~MacroPlayer() override
+		{
+			Stop();
+		}
+		/// <summary>
+		/// Replaces the macros, the ones playing are cancelled. Not to be called at the same time as Trigger() or Cancel().
+		/// </summary>
+		void SetMacros(std::vector<MacroSequence> macros)
+		{
+			SetMacros(std::make_shared<MacroSet>(std::move(macros)));
+		}
+		/// <summary>
+		/// Binds the player to a set of macros, nullptr for none, without stopping the thread. The player cancels the macros
+		/// of the set it was playing. Otherwise as SetMacros() of a vector.
+		/// </summary>
+		void SetMacros(std::shared_ptr<MacroSet> macros)
+		{
+			if (macros == nullptr)
+				macros = std::make_shared<MacroSet>(std::vector<MacroSequence>{});
+			m_bound = macros;
+			m_published.store(std::move(macros), std::memory_order_release);
+			if (m_bound->GetCount() > 0 && !this->isThreadRunning)
+				this->startThread();
+			else
+				Wake();
+		}
+		size_t GetMacroCount() const
+		{
+			return m_bound->GetCount();
+		}
+		/// <summary>
+		/// Starts the macro, or restarts it from the beginning if it is playing.
+		/// </summary>
+		void Trigger(const size_t index)
+		{
+			Request(index, true);
+		}
+		/// <summary>
+		/// Stops the macro if it is playing, releasing the keys it holds.
+		/// </summary>
+		void Cancel(const size_t index)
+		{
+			Request(index, false);
+		}
+		/// <summary>
+		/// Stops the thread, the keys held by playing macros are released.
+		/// </summary>
+		void Stop()
+		{
+			{
+				std::lock_guard<std::mutex> l1(m_wakeMutex);
+				this->isStopRequested = true;
+			}
+			m_wakeCondition.notify_one();
+			this->stopThread();
+		}
+		/// <summary>
+		/// Stops the macros playing and releases the keys they hold, returning once the key-ups are sent.
+		/// The thread is started again, so the macros can still be triggered.
+		/// </summary>
+		void ReleaseHeld()
+		{
+			Stop();
+			if (m_bound->GetCount() > 0)
+				this->startThread();
+		}
+		const Counters &GetCounters() const
+		{
+			return m_counters;
+		}
+	private:
+		void Request(const size_t index, const bool isTrigger)
+		{
+			if (index >= m_bound->GetCount())
+				return;
+			std::atomic<std::uint32_t> &request = m_bound->m_slots[index].request;
+			const std::uint32_t next = ((request.load(std::memory_order_relaxed) >> 1) + 1) << 1;
+			request.store(isTrigger ? next | 1u : next, std::memory_order_release);
+			Wake();
+		}
+		void Wake()
+		{
+			{
+				std::lock_guard<std::mutex> l1(m_wakeMutex);
+				m_wakeCount++;
+			}
+			m_wakeCondition.notify_one();
+		}
+		/// <summary>
+		/// Applies the triggers and cancels, and sends every frame that is due.
+		/// </summary>
+		/// <returns>time the next frame is due, time_point::max() if no macro is playing</returns>
+		ClockType::time_point PlayDue(const ClockType::time_point now)
+		{
+			ClockType::time_point nextDue = ClockType::time_point::max();
+			const std::vector<MacroSequence> &macros = m_playing->m_macros;
+			for (size_t i = 0; i < macros.size(); i++)
+			{
+				Slot &slot = m_playing->m_slots[i];
+				const MacroSequence &macro = macros[i];
+				const std::uint32_t request = slot.request.load(std::memory_order_acquire);
+				if (request != slot.seenRequest)
+				{
+					slot.seenRequest = request;
+					const bool isTrigger = (request & 1u) != 0;
+					if (isTrigger && slot.isPlaying)
+						m_counters.restarts.fetch_add(1, std::memory_order_relaxed);
+					ReleaseHeld(slot, macro);
+					slot.isPlaying = isTrigger;
+					slot.nextFrame = 0;
+					slot.startTime = now;
+				}
+				while (slot.isPlaying && slot.nextFrame < macro.frames.size())
+				{
+					const MacroSequence::Frame &frame = macro.frames[slot.nextFrame];
+					const ClockType::time_point due = slot.startTime + frame.offset;
+					if (due > ClockType::now())
+					{
+						nextDue = std::min(nextDue, due);
+						break;
+					}
+					if (frame.count > 0)
+						m_keySend.CallSendInput(macro.inputs.data() + frame.first, frame.count);
+					RecordLateness(ClockType::now() - due);
+					slot.nextFrame++;
+				}
+				if (slot.nextFrame >= macro.frames.size())
+					slot.isPlaying = false;
+			}
+			return nextDue;
+		}
+		/// <summary>
+		/// Sends the release records of the last frame the macro sent.
+		/// </summary>
+		void ReleaseHeld(Slot &slot, const MacroSequence &macro)
+		{
+			if (!slot.isPlaying || slot.nextFrame == 0)
+				return;
+			const MacroSequence::Frame &frame = macro.frames[slot.nextFrame - 1];
+			if (frame.releaseCount > 0)
+				m_keySend.CallSendInput(macro.releases.data() + frame.releaseFirst, frame.releaseCount);
+		}
+		void ReleaseAll()
+		{
+			const std::vector<MacroSequence> &macros = m_playing->m_macros;
+			for (size_t i = 0; i < macros.size(); i++)
+			{
+				ReleaseHeld(m_playing->m_slots[i], macros[i]);
+				m_playing->m_slots[i].isPlaying = false;
+			}
+		}
+		void RecordLateness(const ClockType::duration lateness)
+		{
+			const auto micros = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(lateness).count());
+			m_counters.framesSent.fetch_add(1, std::memory_order_relaxed);
+			m_counters.totalLatenessMicro.fetch_add(micros, std::memory_order_relaxed);
+			if (micros > m_counters.maxLatenessMicro.load(std::memory_order_relaxed))
+				m_counters.maxLatenessMicro.store(micros, std::memory_order_relaxed);
+		}
+	};
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include "stdafx.h"
+#include "SendKey.h"
+
+namespace sds
+{
+	/// <summary>
+	/// A macro binding compiled ahead of time into the INPUT records it sends, so playing it back
+	/// builds nothing and allocates nothing.
+	/// The fourth field of a MACRO binding is a list of steps separated by ',':
+	/// a key ("q" or "VK13") is tapped, "+q" presses it, "-q" releases it, and "~30" waits 30 milliseconds
+	/// (fractions such as "~0.5" are allowed). Steps with no wait between them are sent as one frame.
+	/// Keys still held at the end of the macro are released after its last step, so a trailing wait holds them longer.
+	/// <example>
+	/// A:NONE:MACRO:q,~30,e or X:NONE:MACRO:+VK16,~10,a,~10,-VK16
+	/// </example>
+	/// </summary>
+	struct MacroSequence
+	{
+		//Step Separator is the character between the steps of a macro.
+		constexpr static const char STEP_SEPARATOR = ',';
+		//Press Prefix is the prefix of a step that only presses a key.
+		constexpr static const char PRESS_PREFIX = '+';
+		//Release Prefix is the prefix of a step that only releases a key.
+		constexpr static const char RELEASE_PREFIX = '-';
+		//Wait Prefix is the prefix of a step that waits a number of milliseconds.
+		constexpr static const char WAIT_PREFIX = '~';
+
+		/// <summary>
+		/// INPUT records sent at the same time, "first" and "count" index into "inputs".
+		/// "releaseFirst" and "releaseCount" index into "releases", the records that release the keys
+		/// this frame and the ones before it leave held, sent when the macro is cancelled after this frame.
+		/// </summary>
+		struct Frame
+		{
+			std::chrono::microseconds offset;
+			size_t first;
+			size_t count;
+			size_t releaseFirst;
+			size_t releaseCount;
+		};
+		std::vector<INPUT> inputs;
+		std::vector<INPUT> releases;
+		std::vector<Frame> frames;
+
+		/// <summary>
+		/// Compiles the fourth field of a MACRO binding.
+		/// </summary>
+		/// <param name="value">the steps of the macro</param>
+		/// <param name="out">receives the compiled macro, unchanged on error</param>
+		/// <returns>error message, empty string on success</returns>
+		static std::string Compile(const std::string &value, MacroSequence &out)
+		{
+			const Utilities::SendKey keySend;
+			MacroSequence seq;
+			std::vector<int> held;
+			std::chrono::microseconds offset(0);
+			bool isFrameOpen = false;
+			size_t stepCount = 0;
+			//the trailing empty step getline drops is caught here
+			if (value.empty() || value.back() == STEP_SEPARATOR)
+				return "Macro " + value + " ends without a step";
+			std::stringstream ss(value);
+			std::string step;
+			while (std::getline(ss, step, STEP_SEPARATOR))
+			{
+				if (++stepCount > XinSettings::MACRO_STEPS_MAX)
+					return "Macro " + value + " has more than " + std::to_string(XinSettings::MACRO_STEPS_MAX) + " steps";
+				if (step.empty())
+					return "Empty step in macro " + value;
+				if (step.size() > 1 && step.front() == WAIT_PREFIX)
+				{
+					double millis = 0.0;
+					try
+					{
+						size_t parsed = 0;
+						millis = std::stod(step.substr(1), &parsed);
+						if (parsed != step.size() - 1)
+							millis = 0.0;
+					}
+					catch (...)
+					{
+						millis = 0.0;
+					}
+					if (!XinSettings::IsValidMacroWaitValue(millis))
+						return "Invalid wait \"" + step + "\" in macro " + value;
+					offset += std::chrono::microseconds(static_cast<long long>(millis * 1000.0));
+					if (isFrameOpen)
+						seq.CloseFrame(held);
+					isFrameOpen = false;
+					continue;
+				}
+				const bool isPress = step.size() > 1 && step.front() == PRESS_PREFIX;
+				const bool isRelease = step.size() > 1 && step.front() == RELEASE_PREFIX;
+				const std::string key = (isPress || isRelease) ? step.substr(1) : step;
+				const int vk = GetVk(key);
+				if (vk < 0)
+					return "Unknown key \"" + step + "\" in macro " + value;
+				if (!isFrameOpen)
+					seq.frames.push_back({ offset, seq.inputs.size(), 0, 0, 0 });
+				isFrameOpen = true;
+				const bool isHeld = std::find(held.begin(), held.end(), vk) != held.end();
+				if (!isRelease && !isHeld)
+					seq.inputs.push_back(keySend.BuildInput(vk, true));
+				if (!isPress && (isHeld || !isRelease))
+					seq.inputs.push_back(keySend.BuildInput(vk, false));
+				if (isPress && !isHeld)
+					held.push_back(vk);
+				if (!isPress)
+					held.erase(std::remove(held.begin(), held.end(), vk), held.end());
+			}
+			//a macro of releases of keys it never pressed compiles to frames without input
+			if (seq.inputs.empty())
+				return "Macro " + value + " sends no input";
+			//release what is still held, in a frame of its own after a trailing wait
+			if (!isFrameOpen)
+				seq.frames.push_back({ offset, seq.inputs.size(), 0, 0, 0 });
+			for (auto it = held.rbegin(); it != held.rend(); ++it)
+				seq.inputs.push_back(keySend.BuildInput(*it, false));
+			held.clear();
+			seq.CloseFrame(held);
+			if (seq.frames.back().count == 0)
+				seq.frames.pop_back();
+			out = std::move(seq);
+			return "";
+		}
+		std::chrono::microseconds GetDuration() const
+		{
+			return frames.empty() ? std::chrono::microseconds(0) : frames.back().offset;
+		}
+	private:
+		/// <summary>
+		/// Ends the open frame, recording the records that release the keys held after it.
+		/// </summary>
+		void CloseFrame(const std::vector<int> &held)
+		{
+			const Utilities::SendKey keySend;
+			Frame &frame = frames.back();
+			frame.count = inputs.size() - frame.first;
+			frame.releaseFirst = releases.size();
+			frame.releaseCount = held.size();
+			for (auto it = held.rbegin(); it != held.rend(); ++it)
+				releases.push_back(keySend.BuildInput(*it, false));
+		}
+		/// <summary>
+		/// Returns the virtual keycode of a single character or "VK#" key, -1 if it is neither.
+		/// </summary>
+		static int GetVk(const std::string &key)
+		{
+			std::string fixed;
+			if (!sdsActionDescriptors.IsFourthFieldKeyword(key, fixed))
+				return -1;
+			if (fixed.size() == 1)
+			{
+				const SHORT scan = VkKeyScanExA(fixed.front(), GetKeyboardLayout(0));
+				return scan == -1 ? -1 : (scan & 0xFF);
+			}
+			return std::stoi(fixed.substr(sdsActionDescriptors.vk.size()));
+		}
+	};
+}
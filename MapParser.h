@@ -0,0 +1,163 @@
+#pragma once
+#include "stdafx.h"
+#include "ControlBits.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Single pass parser of a MapInformation string. The tokens are string_views into the map, the keyword fields
+	/// are matched in place ignoring case and the VK codes are read with std::from_chars, so nothing is copied.
+	/// An error gives the token index and the column it was found at, the column is the 1-based offset in the map.
+	/// The first field of a chord is checked by ControlBits::ParseChord() and a MACRO value by MacroSequence::Compile().
+	/// </summary>
+	struct MapParser
+	{
+		/// <summary>
+		/// The four fields of a token. control is the raw text of a chord, the other keyword fields view the upper case keywords
+		/// in sdsActionDescriptors, value is the raw text.
+		/// </summary>
+		struct Token
+		{
+			std::string_view text;
+			std::string_view control;
+			std::string_view info;
+			std::string_view simType;
+			std::string_view value;
+			//the virtual keycode of a "VK#" value, -1 otherwise
+			int virtualKey = -1;
+			bool isChord = false;
+			//1-based offset of the token in the map
+			size_t column = 0;
+		};
+		/// <summary>
+		/// Where an error was found, the column of the first character at fault.
+		/// </summary>
+		struct Position
+		{
+			size_t tokenIndex = 0;
+			size_t column = 0;
+		};
+		//Field Count is the number of ':' separated fields in a token.
+		static constexpr size_t FIELD_COUNT = 4;
+
+		/// <summary>
+		/// Parses a map into tokens, tokensOut is cleared first and its capacity reused.
+		/// </summary>
+		/// <param name="map">the MapInformation string, the tokens view it and are valid while it is</param>
+		/// <param name="tokensOut">receives the tokens</param>
+		/// <param name="errorOut">receives the position of an error</param>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] static std::string Parse(const std::string_view map, std::vector<Token> &tokensOut, Position &errorOut)
+		{
+			tokensOut.clear();
+			size_t i = 0;
+			while (i < map.size())
+			{
+				if (IsSpace(map[i]))
+				{
+					i++;
+					continue;
+				}
+				const size_t tokenStart = i;
+				while (i < map.size() && !IsSpace(map[i]))
+					i++;
+				Token token;
+				token.text = map.substr(tokenStart, i - tokenStart);
+				token.column = tokenStart + 1;
+				const std::string err = ParseToken(token.text, token, errorOut.column);
+				if (!err.empty())
+				{
+					errorOut.tokenIndex = tokensOut.size();
+					errorOut.column += tokenStart;
+					return FormatError(errorOut, token.text, err);
+				}
+				tokensOut.push_back(token);
+			}
+			if (tokensOut.empty())
+			{
+				errorOut = { 0, map.size() + 1 };
+				return FormatError(errorOut, map, "Empty map string, consists entirely of white spaces.");
+			}
+			return "";
+		}
+		/// <summary>
+		/// Formats an error found in a token, for the checks made after parsing.
+		/// </summary>
+		static std::string FormatError(const Position &position, const std::string_view tokenText, const std::string_view message)
+		{
+			return "Token " + std::to_string(position.tokenIndex) + " at column " + std::to_string(position.column)
+				+ " \"" + std::string(tokenText) + "\": " + std::string(message);
+		}
+	private:
+		static bool IsSpace(const char c)
+		{
+			return std::isspace(static_cast<unsigned char>(c)) != 0;
+		}
+		/// <summary>
+		/// Splits and checks the fields of one token.
+		/// </summary>
+		/// <param name="columnOut">receives the 1-based offset in the token of an error</param>
+		/// <returns>error message, empty string on success</returns>
+		static std::string ParseToken(const std::string_view text, Token &tokenOut, size_t &columnOut)
+		{
+			const ActionDescriptors &ad = sdsActionDescriptors;
+			std::array<std::string_view, FIELD_COUNT> fields;
+			std::array<size_t, FIELD_COUNT> fieldStart{};
+			size_t fieldCount = 0;
+			size_t start = 0;
+			for (size_t i = 0; i <= text.size(); i++)
+			{
+				if (i < text.size() && text[i] != ad.moreInfo)
+					continue;
+				if (fieldCount == FIELD_COUNT)
+				{
+					columnOut = start + 1;
+					return "more than " + std::to_string(FIELD_COUNT) + " fields";
+				}
+				fieldStart[fieldCount] = start;
+				fields[fieldCount++] = text.substr(start, i - start);
+				start = i + 1;
+			}
+			if (fieldCount < FIELD_COUNT)
+			{
+				columnOut = text.size() + 1;
+				return std::to_string(fieldCount) + " of " + std::to_string(FIELD_COUNT) + " fields";
+			}
+			for (size_t f = 0; f < FIELD_COUNT; f++)
+			{
+				if (fields[f].empty())
+				{
+					columnOut = fieldStart[f] + 1;
+					return "field " + std::to_string(f + 1) + " is empty";
+				}
+			}
+			auto fieldError = [&](const size_t f, const std::string &what)
+			{
+				columnOut = fieldStart[f] + 1;
+				return what + " \"" + std::string(fields[f]) + "\" in field " + std::to_string(f + 1);
+			};
+			tokenOut.isChord = fields[0].find(ControlBits::CHORD_JOIN) != std::string_view::npos;
+			tokenOut.control = tokenOut.isChord ? fields[0] : ActionDescriptors::FindKeyword(KeywordField::CONTROL, fields[0]);
+			if (tokenOut.control.empty())
+				return fieldError(0, "unknown control");
+			tokenOut.info = ActionDescriptors::FindKeyword(KeywordField::DIRECTION, fields[1]);
+			if (tokenOut.info.empty())
+				return fieldError(1, "unknown direction");
+			if (tokenOut.isChord && tokenOut.info != ad.none)
+				return fieldError(1, "a chord needs NONE, not");
+			tokenOut.simType = ActionDescriptors::FindKeyword(KeywordField::SIM_TYPE, fields[2]);
+			if (tokenOut.simType.empty())
+				return fieldError(2, "unknown simulation type");
+			tokenOut.value = fields[3];
+			tokenOut.virtualKey = -1;
+			//a MACRO value is a list of steps, compiled by MacroSequence
+			if (tokenOut.simType != ad.macro)
+			{
+				tokenOut.virtualKey = ad.ParseVirtualKey(fields[3]);
+				if (fields[3].size() != 1 && tokenOut.virtualKey < 0)
+					return fieldError(3, "bad key, a single character or VK with a decimal keycode up to 255 is expected, not");
+			}
+			return "";
+		}
+	};
+}
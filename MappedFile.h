@@ -0,0 +1,125 @@
+#pragma once
+#include "stdafx.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// A file mapped read only into memory for the lifetime of the object, so it can be used in place without reading it.
+		/// Uses CreateFileMapping on Windows and mmap on Linux.
+		/// </summary>
+		class MappedFile
+		{
+			const char *m_data = nullptr;
+			size_t m_size = 0;
+#ifdef _WIN32
+			HANDLE m_file = INVALID_HANDLE_VALUE;
+			HANDLE m_mapping = nullptr;
+#endif
+		public:
+			MappedFile() = default;
+			MappedFile(const MappedFile& other) = delete;
+			MappedFile(MappedFile&& other) = delete;
+			MappedFile& operator=(const MappedFile& other) = delete;
+			MappedFile& operator=(MappedFile&& other) = delete;
+			~MappedFile()
+			{
+				Close();
+			}
+			/// <summary>
+			/// Maps the whole file, a file already open is closed first.
+			/// </summary>
+			/// <returns>error message, empty string on success</returns>
+			[[nodiscard]] std::string Open(const std::string &fileName)
+			{
+				Close();
+				auto errText = [&fileName](const std::string &s)
+				{
+					return "Error in sds::Utilities::MappedFile::Open(), " + s + ": " + fileName;
+				};
+#ifdef _WIN32
+				m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (m_file == INVALID_HANDLE_VALUE)
+					return errText("failed to open file, error " + std::to_string(GetLastError()));
+				LARGE_INTEGER fileSize = {};
+				if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart <= 0)
+				{
+					Close();
+					return errText("file is empty or its size is unknown");
+				}
+				m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (m_mapping == nullptr)
+				{
+					const DWORD err = GetLastError();
+					Close();
+					return errText("failed to create the file mapping, error " + std::to_string(err));
+				}
+				const void *view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+				if (view == nullptr)
+				{
+					const DWORD err = GetLastError();
+					Close();
+					return errText("failed to map the file, error " + std::to_string(err));
+				}
+				m_data = static_cast<const char *>(view);
+				m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+				const int fd = open(fileName.c_str(), O_RDONLY);
+				if (fd < 0)
+					return errText("failed to open file, error " + std::to_string(errno));
+				struct stat fileStat = {};
+				if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+				{
+					close(fd);
+					return errText("file is empty or its size is unknown");
+				}
+				void *view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				//the mapping stays valid once the descriptor is closed
+				close(fd);
+				if (view == MAP_FAILED)
+					return errText("failed to map the file, error " + std::to_string(errno));
+				m_data = static_cast<const char *>(view);
+				m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+				return "";
+			}
+			void Close()
+			{
+#ifdef _WIN32
+				if (m_data != nullptr)
+					UnmapViewOfFile(m_data);
+				if (m_mapping != nullptr)
+					CloseHandle(m_mapping);
+				if (m_file != INVALID_HANDLE_VALUE)
+					CloseHandle(m_file);
+				m_mapping = nullptr;
+				m_file = INVALID_HANDLE_VALUE;
+#else
+				if (m_data != nullptr)
+					munmap(const_cast<char *>(m_data), m_size);
+#endif
+				m_data = nullptr;
+				m_size = 0;
+			}
+			bool IsOpen() const
+			{
+				return m_data != nullptr;
+			}
+			const char *GetData() const
+			{
+				return m_data;
+			}
+			size_t GetSize() const
+			{
+				return m_size;
+			}
+		};
+	}
+}
@@ -2,47 +2,199 @@
 #include "stdafx.h"
 #include "MultiBool.h"
 #include "SendKey.h"
+#include "ControlBits.h"
+#include "MapParser.h"
+#include "MacroPlayer.h"
+#include "Clock.h"
 
 namespace sds
 {
 	/// <summary>
 	/// Contains the logic for determining if a key press or mouse click should occur, uses sds::SendKey m_keySend to send the input.
 	/// Processes the ActionDetails utility class.
+	/// Each binding is compiled by SetMapInfo() into a required and an excluded ControlMask, so matching a frame against
+	/// single and chord bindings alike is a few bitwise operations per binding. A chord that is down suppresses the
+	/// bindings made of a subset of its controls, see ControlBits for the chord syntax.
+	/// MACRO bindings are compiled by SetMapInfo() into a MacroSequence and played by a MacroPlayer thread, see MacroSequence for the syntax.
 	/// Further design considerations may incorporate a queue for sending input, as SendInput will allow an entire array to be
 	/// sent in one call.
 	/// </summary>
 	class Mapper
 	{
+		using ClockType = Utilities::Clock;
 		/// <summary>
-		/// Utility class for processing MapInformation strings.
+		/// Simulation type of a binding, compiled from the third field of its token.
 		/// </summary>
-		struct WordData
+		enum class SimType : std::uint8_t
+		{
+			NORM,
+			TOGGLE,
+			RAPID,
+			MACRO
+		};
+		/// <summary>
+		/// The fields of a MapInformation token as compiled, case fixed and with a VK value as "VK#".
+		/// Cold data, read for GetBindings() and diagnostics only.
+		/// </summary>
+		struct BindingText
 		{
-			using ClockType = std::chrono::high_resolution_clock;
-			//using Milli = std::chrono::milliseconds;
 			std::string control; //LTHUMB
 			std::string info; //LEFT
-			std::string sim_type; //NORM
+			std::string simType; //NORM
 			std::string value; //'a'
-			sds::MultiBool fsm;
-			bool down;
-			std::chrono::time_point<ClockType> lastSentTime;
-			//TODO add a timer variable here, so we can know when to send repeat events.
-			WordData() : down(false), lastSentTime(ClockType::now()) {}
+		};
+		/// <summary>
+		/// The compiled bindings of a profile as a structure of arrays, one array per field, so processing a frame
+		/// reads only the fields it uses from a few contiguous cache lines, about 28 bytes per binding in all.
+		/// The strings of the tokens are kept apart in the cold "text" table.
+		/// </summary>
+		struct BindingTable
+		{
+			//Chord Control is the control of a chord binding, which has no single control keyword.
+			static constexpr Keyword CHORD_CONTROL = Keyword::UNKNOWN;
+			//Key Character is the virtual keycode of a binding sending its "character" instead.
+			static constexpr std::int16_t KEY_CHARACTER = -1;
+			//controls that must be down, and must not be down, for the binding to match
+			std::vector<ControlMask> required;
+			std::vector<ControlMask> excluded;
+			//the first and second field keywords, CHORD_CONTROL for a chord
+			std::vector<Keyword> control;
+			std::vector<Keyword> direction;
+			std::vector<SimType> simType;
+			std::vector<std::int16_t> virtualKey;
+			std::vector<char> character;
+			std::vector<MultiBool::BUTTONSTATE> state;
+			std::vector<std::uint8_t> down;
+			//index of the compiled macro in the MacroPlayer, for a MACRO binding
+			std::vector<std::uint32_t> macroIndex;
+			//time the key of the binding was last sent, on the process wide Clock
+			std::vector<ClockType::TimePoint> lastSentTime;
+			std::vector<BindingText> text;
+
+			size_t size() const
+			{
+				return required.size();
+			}
+			bool IsChord(const size_t i) const
+			{
+				return control[i] == CHORD_CONTROL;
+			}
+			void reserve(const size_t count)
+			{
+				required.reserve(count);
+				excluded.reserve(count);
+				control.reserve(count);
+				direction.reserve(count);
+				simType.reserve(count);
+				virtualKey.reserve(count);
+				character.reserve(count);
+				state.reserve(count);
+				down.reserve(count);
+				macroIndex.reserve(count);
+				lastSentTime.reserve(count);
+				text.reserve(count);
+			}
+			/// <summary>
+			/// Appends a binding, the hot fields are derived from its text once here.
+			/// </summary>
+			void Add(BindingText bindingText, const ControlMask requiredMask, const ControlMask excludedMask, const bool isChord, const std::uint32_t macro)
+			{
+				const SimType sim = GetSimType(bindingText.simType);
+				const int vk = sim == SimType::MACRO ? -1 : ActionDescriptors::ParseVirtualKey(bindingText.value);
+				required.push_back(requiredMask);
+				excluded.push_back(excludedMask);
+				control.push_back(isChord ? CHORD_CONTROL : KeywordTable::Find(bindingText.control));
+				direction.push_back(KeywordTable::Find(bindingText.info));
+				simType.push_back(sim);
+				virtualKey.push_back(vk >= 0 ? static_cast<std::int16_t>(vk) : KEY_CHARACTER);
+				character.push_back(vk < 0 && !bindingText.value.empty() ? bindingText.value.front() : '\0');
+				state.push_back(MultiBool::BUTTONSTATE::STATE_ONE);
+				down.push_back(0);
+				macroIndex.push_back(macro);
+				lastSentTime.push_back(ClockType::Get().Now());
+				text.push_back(std::move(bindingText));
+			}
+		private:
+			static SimType GetSimType(const std::string_view simTypeText)
+			{
+				switch (KeywordTable::Find(simTypeText))
+				{
+				case Keyword::TOGGLE:
+					return SimType::TOGGLE;
+				case Keyword::RAPID:
+					return SimType::RAPID;
+				case Keyword::MACRO:
+					return SimType::MACRO;
+				default:
+					return SimType::NORM;
+				}
+			}
+		};
+
+		/// <summary>
+		/// One compiled MapInformation string, the Mapper holds a cache of them and processes the active one.
+		/// </summary>
+		struct Profile
+		{
+			BindingTable bindings;
+			//indices into bindings, chords with more required controls first and the single bindings last
+			std::vector<size_t> precedenceOrder;
+			MapInformation map;
+			//played by the MacroPlayer of the Mapper while the profile is active, built once so a switch only publishes it
+			std::shared_ptr<MacroPlayer::MacroSet> macros;
 		};
 
 		Utilities::SendKey m_keySend;
-		std::vector<WordData> m_mapTokenInfo;
-		MapInformation m_map;
+		//one player for every profile, bound to the macros of the active one
+		MacroPlayer m_macroPlayer;
+		//slots are filled in order and never emptied, so the processing thread can read any slot below the count
+		std::array<std::unique_ptr<Profile>, XinSettings::PROFILE_CACHE_MAX> m_profiles;
+		std::atomic<size_t> m_profileCount;
+		//profile asked for by ActivateProfile(), switched to by the next ProcessActionDetails()
+		std::atomic<size_t> m_requestedProfile;
+		std::atomic<size_t> m_activeProfile;
 	public:
+		/// <summary>
+		/// A binding as compiled by SetMapInfo(), the strings are the case-fixed fields of its MapInformation token.
+		/// Used to store compiled bindings and load them again with SetBindings() without parsing the map.
+		/// </summary>
+		struct BindingRecord
+		{
+			std::string_view control;
+			std::string_view info;
+			std::string_view simType;
+			std::string_view value;
+			ControlMask required;
+			ControlMask excluded;
+			bool isChord;
+		};
+		/// <summary>
+		/// Constructor, the Mapper starts with one empty profile.
+		/// </summary>
+		Mapper() : m_profileCount(1), m_requestedProfile(0), m_activeProfile(0)
+		{
+			m_profiles[0] = std::make_unique<Profile>();
+		}
+		Mapper(const Mapper& other) = delete;
+		Mapper(Mapper&& other) = delete;
+		Mapper& operator=(const Mapper& other) = delete;
+		Mapper& operator=(Mapper&& other) = delete;
+		~Mapper() = default;
 		/// <summary>
 		/// Function to process an sds::ActionDetails string created by sds::XInputTranslater
+		/// An empty ActionDetails is still processed, it releases any keys held down.
+		/// A profile switch asked for by ActivateProfile() is made first.
 		/// </summary>
 		/// <param name="details">An sds::ActionDetails containing actions to perform, translated from controller input.</param>
 		void ProcessActionDetails(const ActionDetails &details)
 		{
-			if (details.empty())
-				return;
+			const size_t requested = m_requestedProfile.load(std::memory_order_acquire);
+			if (requested != m_activeProfile.load(std::memory_order_relaxed))
+			{
+				ReleaseAll(ActiveProfile());
+				m_activeProfile.store(requested, std::memory_order_release);
+				m_macroPlayer.SetMacros(ActiveProfile().macros);
+			}
 			std::vector<std::string> tokens;
 			//Get input tokens.
 			GetTokens(details,tokens);
@@ -55,245 +207,467 @@ namespace sds
 		/// <returns></returns>
 		[[nodiscard]] MapInformation GetMapInfo() const
 		{
-			return m_map;
+			return ActiveProfile().map;
 		}
 		/// <summary>
 		/// Takes a "MapInformation" string and internalizes (copies) it to adjust how controller input is mapped
 		/// to keyboard and mouse input.
 		/// An empty map string is acceptable. If an error is detected while parsing the tokens, the
 		/// internal state will not be altered and it will return an error message.
+		/// The bindings of the active profile are replaced.
 		/// </summary>
 		/// <param name="newMap">MapInformation string containing info on how to map controller input to kbd/mouse.</param>
 		/// <returns>A std::string indicating the presence of an error, and the error message.</returns>
 		[[nodiscard]] std::string SetMapInfo(const MapInformation &newMap)
+		{
+			BindingTable bindings;
+			std::vector<MacroSequence> macros;
+			const std::string err = CompileMap(newMap, bindings, macros);
+			if (!err.empty())
+				return err;
+			ApplyBindings(ActiveProfile(), std::move(bindings), std::move(macros), newMap);
+			return "";
+		}
+		/// <summary>
+		/// Returns the compiled bindings of the active profile, the strings refer to the Mapper and are valid until the map is changed.
+		/// </summary>
+		[[nodiscard]] std::vector<BindingRecord> GetBindings() const
+		{
+			const Profile &profile = ActiveProfile();
+			std::vector<BindingRecord> records;
+			records.reserve(profile.bindings.size());
+			const BindingTable &bindings = profile.bindings;
+			for (size_t i = 0; i < bindings.size(); i++)
+			{
+				const BindingText &text = bindings.text[i];
+				records.push_back({ text.control, text.info, text.simType, text.value, bindings.required[i], bindings.excluded[i], bindings.IsChord(i) });
+			}
+			return records;
+		}
+		/// <summary>
+		/// Replaces the bindings of the active profile with ones compiled earlier by SetMapInfo(), see GetBindings().
+		/// The fields are not validated again, only the macros are compiled.
+		/// </summary>
+		/// <param name="records">compiled bindings, copied</param>
+		/// <param name="mapInfo">the MapInformation string the bindings were compiled from</param>
+		/// <returns>A std::string indicating the presence of an error, and the error message.</returns>
+		[[nodiscard]] std::string SetBindings(const std::vector<BindingRecord> &records, const MapInformation &mapInfo)
+		{
+			BindingTable bindings;
+			std::vector<MacroSequence> macros;
+			const std::string err = BuildBindings(records, bindings, macros);
+			if (!err.empty())
+				return err;
+			ApplyBindings(ActiveProfile(), std::move(bindings), std::move(macros), mapInfo);
+			return "";
+		}
+		/// <summary>
+		/// Compiles a MapInformation string into a new profile in the cache, to be switched to with ActivateProfile().
+		/// Not to be called while another thread adds a profile.
+		/// </summary>
+		/// <param name="newMap">MapInformation string of the profile</param>
+		/// <param name="idOut">receives the id of the profile</param>
+		/// <returns>A std::string indicating the presence of an error, and the error message.</returns>
+		[[nodiscard]] std::string AddProfile(const MapInformation &newMap, size_t &idOut)
+		{
+			BindingTable bindings;
+			std::vector<MacroSequence> macros;
+			const std::string err = CompileMap(newMap, bindings, macros);
+			if (!err.empty())
+				return err;
+			return AddProfile(std::move(bindings), std::move(macros), newMap, idOut);
+		}
+		/// <summary>
+		/// Adds a new profile to the cache from bindings compiled earlier, see SetBindings().
+		/// </summary>
+		/// <returns>A std::string indicating the presence of an error, and the error message.</returns>
+		[[nodiscard]] std::string AddProfile(const std::vector<BindingRecord> &records, const MapInformation &mapInfo, size_t &idOut)
+		{
+			BindingTable bindings;
+			std::vector<MacroSequence> macros;
+			const std::string err = BuildBindings(records, bindings, macros);
+			if (!err.empty())
+				return err;
+			return AddProfile(std::move(bindings), std::move(macros), mapInfo, idOut);
+		}
+		/// <summary>
+		/// Switches to a profile in the cache, the switch is made by the next ProcessActionDetails() call on the processing thread.
+		/// The keys held by the bindings of the previous profile are released, and its macros cancelled.
+		/// Safe to call from any thread, the switch is the store of an index.
+		/// </summary>
+		/// <param name="id">id of a profile, 0 is the profile the Mapper starts with</param>
+		/// <returns>A std::string indicating the presence of an error, and the error message.</returns>
+		[[nodiscard]] std::string ActivateProfile(const size_t id)
+		{
+			if (id >= m_profileCount.load(std::memory_order_acquire))
+				return "Error in sds::Mapper::ActivateProfile(), no profile with id " + std::to_string(id);
+			m_requestedProfile.store(id, std::memory_order_release);
+			return "";
+		}
+		/// <summary>
+		/// Returns the id of the profile being processed, a switch asked for is not made until the next ProcessActionDetails().
+		/// </summary>
+		size_t GetActiveProfile() const
+		{
+			return m_activeProfile.load(std::memory_order_acquire);
+		}
+		size_t GetProfileCount() const
+		{
+			return m_profileCount.load(std::memory_order_acquire);
+		}
+		/// <summary>
+		/// Releases the keys held by the bindings and the macros of the active profile, then waits for the key-ups
+		/// to be delivered, retrying those the backend does not insert. Called when mapping stops, so no key is left stuck down.
+		/// Not to be called while ProcessActionDetails() runs on another thread.
+		/// </summary>
+		/// <returns>true if every key-up was delivered</returns>
+		bool ReleaseHeldKeys()
+		{
+			Profile &profile = ActiveProfile();
+			ReleaseAll(profile);
+			m_macroPlayer.ReleaseHeld();
+			return Utilities::SendKey::FlushOutput();
+		}
+		/// <summary>
+		/// Returns the timing counters of the thread playing the MACRO bindings, accumulated over every profile.
+		/// </summary>
+		const MacroPlayer::Counters &GetMacroCounters() const
+		{
+			return m_macroPlayer.GetCounters();
+		}
+	private:
+		Profile &ActiveProfile()
+		{
+			return *m_profiles[m_activeProfile.load(std::memory_order_acquire)];
+		}
+		const Profile &ActiveProfile() const
+		{
+			return *m_profiles[m_activeProfile.load(std::memory_order_acquire)];
+		}
+		/// <summary>
+		/// Parses and validates a MapInformation string into bindings and the macros they play.
+		/// </summary>
+		/// <returns>A std::string indicating the presence of an error, and the error message.</returns>
+		std::string CompileMap(const MapInformation &newMap, BindingTable &bindingsOut, std::vector<MacroSequence> &macrosOut) const
 		{
 			auto errText = [](const std::string &s)
 			{
 				return "Error in sds::Mapper::SetMapInfo()\n" + s;
 			};
-			if (newMap.empty())
+			std::vector<MapParser::Token> tokens;
+			MapParser::Position errorAt;
+			const std::string parseErr = MapParser::Parse(newMap, tokens, errorAt);
+			if (!parseErr.empty())
+				return errText(parseErr);
+			//Set the binding table.
+			BindingTable table;
+			std::vector<MacroSequence> macros;
+			table.reserve(tokens.size());
+			for (size_t i = 0; i < tokens.size(); i++)
 			{
-				return errText("MapInformation newMap size() is 0.");
+				const std::string err = CompileToken(tokens[i], table, macros);
+				if (!err.empty())
+					return errText(MapParser::FormatError({ i, tokens[i].column }, tokens[i].text, err));
 			}
-			// Check if s consists only of whitespaces
-			const bool whiteSpacesOnly = std::all_of(newMap.begin(), newMap.end(), isspace);
-			if (whiteSpacesOnly)
-				return errText("[1]Empty map string, consists entirely of white spaces.");
-			//Set WordData vector.
-			std::vector<WordData> tempVec;
-			std::string previousToken;
-			std::string t;
-			std::stringstream ss(newMap);
-			while( ss >> t )
+			bindingsOut = std::move(table);
+			macrosOut = std::move(macros);
+			return "";
+		}
+		/// <summary>
+		/// Copies compiled bindings, compiling the macros they play.
+		/// </summary>
+		/// <returns>A std::string indicating the presence of an error, and the error message.</returns>
+		static std::string BuildBindings(const std::vector<BindingRecord> &records, BindingTable &bindingsOut, std::vector<MacroSequence> &macrosOut)
+		{
+			BindingTable table;
+			std::vector<MacroSequence> macros;
+			table.reserve(records.size());
+			for (const BindingRecord &record : records)
 			{
-				std::string aToken = t;//copy
-				WordData data;
-				std::replace(t.begin(), t.end(), sds::sdsActionDescriptors.moreInfo, ' ');
-				std::stringstream(t) >> data.control >> data.info >> data.sim_type >> data.value;
-				//if all of those pieces don't have something in them
-				if (data.control.empty() && data.info.empty() && data.sim_type.empty() && data.value.empty())
-				{
-					//return error message
-					return errText("[2]Failed to parse a token.\n Previous token: " + previousToken + "\n");
-				}
-				//validate token pieces
-				const bool goodToken = ValidateTokenPieces(data);
-				if (goodToken)
+				const std::uint32_t macroIndex = static_cast<std::uint32_t>(macros.size());
+				if (record.simType == sdsActionDescriptors.macro)
 				{
-					tempVec.push_back(data);
-					previousToken = aToken;
-				}
-				else
-				{
-					return errText("[3]Failed to parse a token.\n Previous token: " + previousToken + "\n");
+					MacroSequence macro;
+					const std::string err = MacroSequence::Compile(std::string(record.value), macro);
+					if (!err.empty())
+						return "Error in sds::Mapper::SetBindings()\n" + err;
+					macros.push_back(std::move(macro));
 				}
+				table.Add({ std::string(record.control), std::string(record.info), std::string(record.simType), std::string(record.value) },
+					record.required, record.excluded, record.isChord, macroIndex);
 			}
+			bindingsOut = std::move(table);
+			macrosOut = std::move(macros);
+			return "";
+		}
+		/// <summary>
+		/// Sets the bindings of a profile, the MacroPlayer is bound to its macros if it is the active profile.
+		/// </summary>
+		void ApplyBindings(Profile &profile, BindingTable bindings, std::vector<MacroSequence> macros, const MapInformation &mapInfo)
+		{
 			//Reset map token info.
-			m_mapTokenInfo = tempVec;
+			profile.bindings = std::move(bindings);
+			profile.precedenceOrder = BuildPrecedenceOrder(profile.bindings);
+			profile.macros = std::make_shared<MacroPlayer::MacroSet>(std::move(macros));
+			if (&profile == &ActiveProfile())
+				m_macroPlayer.SetMacros(profile.macros);
 			//Set MapInformation
-			m_map = newMap;
+			profile.map = mapInfo;
+		}
+		std::string AddProfile(BindingTable bindings, std::vector<MacroSequence> macros, const MapInformation &mapInfo, size_t &idOut)
+		{
+			const size_t id = m_profileCount.load(std::memory_order_relaxed);
+			if (id >= m_profiles.size())
+				return "Error in sds::Mapper::AddProfile(), the profile cache holds at most " + std::to_string(m_profiles.size()) + " profiles.";
+			auto profile = std::make_unique<Profile>();
+			ApplyBindings(*profile, std::move(bindings), std::move(macros), mapInfo);
+			m_profiles[id] = std::move(profile);
+			m_profileCount.store(id + 1, std::memory_order_release);
+			idOut = id;
 			return "";
 		}
-	private:
-		bool ValidateTokenPieces(WordData &data) const
-		{
-			std::array<bool, 4> testArray = { false,false,false,false };
-			testArray[0] = sdsActionDescriptors.IsFirstFieldKeyword(data.control,data.control);
-			testArray[1] = sdsActionDescriptors.IsSecondFieldKeyword(data.info,data.info);
-			testArray[2] = sdsActionDescriptors.IsThirdFieldKeyword(data.sim_type,data.sim_type);
-			testArray[3] = sdsActionDescriptors.IsFourthFieldKeyword(data.value,data.value);
-			return (testArray[0] && testArray[1] && testArray[2] && testArray[3]);
+		/// <summary>
+		/// Releases the keys held by the bindings of the active profile and cancels its macros, used when switching away from it.
+		/// A toggled key is held until its binding is pressed again.
+		/// </summary>
+		void ReleaseAll(Profile &profile)
+		{
+			BindingTable &bindings = profile.bindings;
+			for (size_t i = 0; i < bindings.size(); i++)
+			{
+				const MultiBool::BUTTONSTATE state = bindings.state[i];
+				const bool isNormHeld = bindings.simType[i] == SimType::NORM && state == MultiBool::BUTTONSTATE::STATE_TWO;
+				const bool isToggleHeld = bindings.simType[i] == SimType::TOGGLE
+					&& (state == MultiBool::BUTTONSTATE::STATE_TWO || state == MultiBool::BUTTONSTATE::STATE_THREE);
+				if (isNormHeld || isToggleHeld)
+					SendBindingKey(bindings, i, false);
+				bindings.down[i] = 0;
+				bindings.state[i] = MultiBool::BUTTONSTATE::STATE_ONE;
+			}
+			for (size_t i = 0; i < m_macroPlayer.GetMacroCount(); i++)
+				m_macroPlayer.Cancel(i);
 		}
 		/// <summary>
-		/// Process ActionDetails type string tokens into WordData internal utility data structures.
-		/// The string tokens are in the form of btn / trigr / thumb : more info : input sim type : value mapped to
+		/// Compiles a parsed token into a binding, the control masks of a chord and the steps of a MACRO value are compiled here.
 		/// </summary>
-		/// <param name="detail">(std::vector&lt;std::string&gt;) is a ref to vector of strings containing ActionDetails style tokens</param>
-		void ProcessTokens(std::vector<std::string> &detail)
-		{
-			//using wit_type = std::vector<WordData>::iterator;
-			//using sit_type = std::vector<std::string>::iterator;
-			using std::string;
-			//set all worddata "down" fields to false, the "down" member denotes that the button is currently being pressed
-			//according to the current info from the XINPUT lib, translated and sent here. A finite state machine type is used
-			//to keep track of the state of the key press
-			std::for_each(m_mapTokenInfo.begin(), m_mapTokenInfo.end(), [](WordData& d) 
+		/// <returns>error message, empty string on success</returns>
+		static std::string CompileToken(const MapParser::Token &token, BindingTable &tableOut, std::vector<MacroSequence> &macrosOut)
+		{
+			BindingText text{ std::string(token.control), std::string(token.info), std::string(token.simType),
+				token.virtualKey >= 0 ? std::string(sdsActionDescriptors.vk) + std::to_string(token.virtualKey) : std::string(token.value) };
+			ControlMask required = 0;
+			ControlMask excluded = 0;
+			if (token.isChord)
+			{
+				std::for_each(text.control.begin(), text.control.end(), [](char &c) { c = static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+				const std::string err = ControlBits::ParseChord(text.control, required, excluded);
+				if (!err.empty())
+					return err;
+			}
+			else
+				required = ControlBits::GetBit(text.control, text.info);
+			const std::uint32_t macroIndex = static_cast<std::uint32_t>(macrosOut.size());
+			if (text.simType == sdsActionDescriptors.macro)
+			{
+				MacroSequence macro;
+				const std::string err = MacroSequence::Compile(text.value, macro);
+				if (!err.empty())
+					return err;
+				macrosOut.push_back(std::move(macro));
+			}
+			tableOut.Add(std::move(text), required, excluded, token.isChord, macroIndex);
+			return "";
+		}
+		/// <summary>
+		/// Orders the bindings for matching, chords by descending number of required controls, then the single bindings.
+		/// Bindings with the same number of controls keep their map order.
+		/// </summary>
+		static std::vector<size_t> BuildPrecedenceOrder(const BindingTable &bindings)
+		{
+			std::vector<size_t> order(bindings.size());
+			for (size_t i = 0; i < order.size(); i++)
+				order[i] = i;
+			std::stable_sort(order.begin(), order.end(), [&bindings](const size_t lhs, const size_t rhs)
 				{
-					d.down = false;
+					return GetPrecedence(bindings, lhs) > GetPrecedence(bindings, rhs);
 				});
-			//This section sets a bool if the map is in the input;
-			//meaning if the button is reported as being pressed from the XINPUT library
-			string controlButton, buttonExtraDetail;
-			//iterate the vector<string> containing map tokens
-			for(auto it = detail.begin(); it != detail.end(); ++it)
+			return order;
+		}
+		//Precedence group of a binding, single bindings are below any chord.
+		static int GetPrecedence(const BindingTable &bindings, const size_t i)
+		{
+			return bindings.IsChord(i) ? std::popcount(bindings.required[i]) + 1 : 0;
+		}
+		/// <summary>
+		/// Process ActionDetails type string tokens into the down flags of the binding table.
+		/// The string tokens are in the form of btn / trigr / thumb : more info : input sim type : value mapped to
+		/// The tokens are reduced to a ControlMask, then each binding is matched against it in precedence order.
+		/// A matched chord claims its controls, a binding whose required controls are all claimed by a chord with more
+		/// controls is suppressed. Bindings in the same precedence group do not suppress each other.
+		/// </summary>
+		/// <param name="detail">(std::vector&lt;std::string&gt;) is a ref to vector of strings containing ActionDetails style tokens</param>
+		void ProcessTokens(const std::vector<std::string> &detail)
+		{
+			ControlMask frame = 0;
+			for (const std::string &token : detail)
+				frame |= ControlBits::GetTokenBit(token);
+			//a token that is never reported must not satisfy a binding that could not be compiled to a bit
+			frame &= ~ControlBits::NEVER;
+			Profile &profile = ActiveProfile();
+			BindingTable &bindings = profile.bindings;
+			ControlMask claimed = 0;
+			ControlMask groupClaimed = 0;
+			int group = std::numeric_limits<int>::max();
+			for (const size_t i : profile.precedenceOrder)
 			{
-				//replace the "moreInfo" character (which is separating values) with whitespace in the string.
-				std::replace(it->begin(), it->end(), sds::sdsActionDescriptors.moreInfo, ' ');
-				//grab two tokens from the input string "detail", i.e., "LTHUMB" and "LEFT"
-				std::stringstream(*it) >> controlButton >> buttonExtraDetail;
-				//iterate the vector of worddata internal to this class, 
-				//if controlButton matches the current "worddata" AND the extra detail is NONE or matches the current "worddata"
-				//then set "down" to true
-				for(auto ij = m_mapTokenInfo.begin(); ij != m_mapTokenInfo.end(); ++ij)
+				const int precedence = GetPrecedence(bindings, i);
+				if (precedence != group)
 				{
-					if (controlButton == ij->control 
-						&& (buttonExtraDetail + sds::sdsActionDescriptors.none == ij->info 
-							|| buttonExtraDetail == ij->info))
-					{
-						ij->down = true;
-					}
+					claimed |= groupClaimed;
+					groupClaimed = 0;
+					group = precedence;
 				}
+				const ControlMask required = bindings.required[i];
+				const bool isDown = (frame & required) == required
+					&& (frame & bindings.excluded[i]) == 0
+					&& (required & ~claimed) != 0;
+				bindings.down[i] = isDown;
+				if (isDown && bindings.IsChord(i))
+					groupClaimed |= required;
 			}
-			//Pass on the tokenized and processed info in the form of the vector<WordData> to the input simulation helper func
-			ProcessStates(this->m_mapTokenInfo);
+			//Pass on the processed binding table to the input simulation helper func
+			ProcessStates(bindings);
 		}
 		/// <summary>
 		/// Use the tokenized and processed form of the info we got from XInputTranslater to simulate the proper input.
-		///	Does modify the vector of WordData, states
+		///	Does modify the state of the bindings.
 		/// </summary>
-		/// <param name="states">is a ref to a vector of WordData used to finally simulate the input contained within</param>
-		void ProcessStates(std::vector<WordData> &states)
+		/// <param name="states">is a ref to the binding table used to finally simulate the input contained within</param>
+		void ProcessStates(BindingTable &states)
 		{
-			for(auto it = states.begin(); it != states.end(); ++it)
+			for (size_t i = 0; i < states.size(); i++)
 			{
 				//Update this if more sim types are added.
-				if( it->sim_type == sds::sdsActionDescriptors.norm )
-					Normal(*it);
-				if( it->sim_type == sds::sdsActionDescriptors.toggle )
-					Toggle(*it);
-				if( it->sim_type == sds::sdsActionDescriptors.rapid )
-					Rapid(*it);
+				switch (states.simType[i])
+				{
+				case SimType::NORM:
+					Normal(states, i);
+					break;
+				case SimType::TOGGLE:
+					Toggle(states, i);
+					break;
+				case SimType::RAPID:
+					Rapid(states, i);
+					break;
+				case SimType::MACRO:
+					Macro(states, i);
+					break;
+				}
 			}
 		}
 		/// <summary>
-		/// Normal keypress simulation logic. The enum "MultiBool" is used to good effect for
+		/// Sends the key of a binding, its virtual keycode or its character.
+		/// </summary>
+		void SendBindingKey(BindingTable &bindings, const size_t i, const bool down)
+		{
+			bindings.lastSentTime[i] = ClockType::Get().Now();
+			if (bindings.virtualKey[i] != BindingTable::KEY_CHARACTER)
+				m_keySend.Send(static_cast<int>(bindings.virtualKey[i]), down);
+			else
+				m_keySend.Send(std::string(1, bindings.character[i]), down);
+		}
+		/// <summary>
+		/// Normal keypress simulation logic. The enum "MultiBool::BUTTONSTATE" is used to good effect for
 		/// tracking the current state of the keypress logic.
 		/// </summary>
-		/// <param name="detail"> (WordData) is a utility structure to hold info pertaining to a key binding aka MapInformation token</param>
-		void Normal(WordData &detail)
+		/// <param name="bindings">the binding table</param>
+		/// <param name="i">index of the binding aka MapInformation token</param>
+		void Normal(BindingTable &bindings, const size_t i)
 		{
 			/*
 			Normal keypress logic.
-			The bool down member is important.
+			The down flag is important.
 			*/
-			//TODO add the logic for key repeat events using the timepoint variable in the WordData struct.
-			std::string strVal;
-			if( detail.down )
+			//TODO add the logic for key repeat events using the lastSentTime of the binding.
+			MultiBool::BUTTONSTATE &state = bindings.state[i];
+			if( bindings.down[i] )
 			{
-				if (detail.fsm.current_state == MultiBool::BUTTONSTATE::STATE_ONE)
+				if (state == MultiBool::BUTTONSTATE::STATE_ONE)
 				{
-					//Check for VK.
-					const int keyCode = GetVkFromTokenString(detail.value);
-					if( keyCode >= 0 )
-					{
-						m_keySend.Send(keyCode,true);
-					}
-					else
-						m_keySend.Send(detail.value,true);
-					detail.fsm.current_state = MultiBool::BUTTONSTATE::STATE_TWO;
+					SendBindingKey(bindings, i, true);
+					state = MultiBool::BUTTONSTATE::STATE_TWO;
 				}
 			}
 			else
 			{
-				if( detail.fsm.current_state == MultiBool::BUTTONSTATE::STATE_TWO )
+				if( state == MultiBool::BUTTONSTATE::STATE_TWO )
 				{
-					//Check for VK.
-					const int keyCode = GetVkFromTokenString(detail.value);
-					if( keyCode >= 0 )
-					{
-						m_keySend.Send(keyCode,false);
-					}
-					else
-						m_keySend.Send(detail.value,false);
-					detail.fsm.ResetState();
+					SendBindingKey(bindings, i, false);
+					state = MultiBool::BUTTONSTATE::STATE_ONE;
 				}
 			}
 		}
 		/// <summary>
 		/// Experimental, probably doesn't work right.
 		/// </summary>
-		/// <param name="detail"></param>
-		void Toggle(WordData &detail) 
+		void Toggle(BindingTable &bindings, const size_t i)
 		{
 			//Toggle keypress logic.
-			std::string strVal;
-			if( detail.down )
+			MultiBool::BUTTONSTATE &state = bindings.state[i];
+			if( bindings.down[i] )
 			{
-				if( detail.fsm.current_state == MultiBool::BUTTONSTATE::STATE_ONE )
+				if( state == MultiBool::BUTTONSTATE::STATE_ONE )
 				{
-					//Check for VK
-					const int keyCode = GetVkFromTokenString(detail.value);
-					if(keyCode >= 0)
-						m_keySend.Send(keyCode,true);
-					else
-						m_keySend.Send(detail.value,true);
-					detail.fsm.current_state = MultiBool::BUTTONSTATE::STATE_TWO;
+					SendBindingKey(bindings, i, true);
+					state = MultiBool::BUTTONSTATE::STATE_TWO;
 				}
-				if( detail.fsm.current_state == MultiBool::BUTTONSTATE::STATE_THREE )
+				if( state == MultiBool::BUTTONSTATE::STATE_THREE )
 				{
-					const int keyCode = GetVkFromTokenString(detail.value);
-					if(keyCode >= 0)
-						m_keySend.Send(keyCode,false);
-					else
-						m_keySend.Send(detail.value,false);
-					detail.fsm.current_state = MultiBool::BUTTONSTATE::STATE_FOUR;
+					SendBindingKey(bindings, i, false);
+					state = MultiBool::BUTTONSTATE::STATE_FOUR;
 				}
 			}
 			else
 			{
-				if( detail.fsm.current_state == MultiBool::BUTTONSTATE::STATE_TWO )
+				if( state == MultiBool::BUTTONSTATE::STATE_TWO )
 				{
-					detail.fsm.current_state = MultiBool::BUTTONSTATE::STATE_THREE;
+					state = MultiBool::BUTTONSTATE::STATE_THREE;
 				}
-				if( detail.fsm.current_state == MultiBool::BUTTONSTATE::STATE_FOUR )
+				if( state == MultiBool::BUTTONSTATE::STATE_FOUR )
 				{
-					detail.fsm.ResetState();
+					state = MultiBool::BUTTONSTATE::STATE_ONE;
 				}
 			}
 		}
 		/// <summary>
 		/// Experimental, probably doesn't work right.
 		/// </summary>
-		/// <param name="detail"></param>
-		void Rapid(const WordData &detail) 
+		void Rapid(BindingTable &bindings, const size_t i)
 		{
 			//Rapid keypress logic.
-			std::string strVal;
-			if(detail.down)
+			if(bindings.down[i])
 			{
-				const int keyCode = GetVkFromTokenString(detail.value);
-				if( keyCode >= 0 )
-				{
-					m_keySend.Send(keyCode,true);
-					m_keySend.Send(keyCode,false);
-				}
-				else
+				SendBindingKey(bindings, i, true);
+				SendBindingKey(bindings, i, false);
+			}
+		}
+		/// <summary>
+		/// Macro logic, the macro is triggered when the binding goes down and restarted if it goes down again while playing.
+		/// It is played on the MacroPlayer thread.
+		/// </summary>
+		void Macro(BindingTable &bindings, const size_t i)
+		{
+			MultiBool::BUTTONSTATE &state = bindings.state[i];
+			if (bindings.down[i])
+			{
+				if (state == MultiBool::BUTTONSTATE::STATE_ONE)
 				{
-					m_keySend.Send(detail.value,true);
-					m_keySend.Send(detail.value,false);
+					m_macroPlayer.Trigger(bindings.macroIndex[i]);
+					state = MultiBool::BUTTONSTATE::STATE_TWO;
 				}
-
 			}
+			else
+				state = MultiBool::BUTTONSTATE::STATE_ONE;
 		}
 		/// <summary>
 		/// Tokenizes a string into a vector&lt;string&gt;
@@ -310,24 +684,6 @@ namespace sds
 			while( ss >> t )
 				tokenOut.push_back(t);
 		}
-		/// <summary>
-		/// Searches the input string "std::string in" and returns the Virtual Keycode as an integer.
-		/// Note that it only extracts the VK code from the string, it doesn't translate to a scancode!
-		/// The input string is of the form "VK2"
-		/// </summary>
-		/// <param name="in">std::string in is a token containing a Virtual Keycode in string form</param>
-		/// <returns>Returns the virtual keycode in decimal integer form, or -1 for error.</returns>
-		constexpr int GetVkFromTokenString(std::string in) const
-		{
-			int keyCode = -1;
-			if( in.find(sds::sdsActionDescriptors.vk) != std::string::npos )
-			{
-				std::string strVal;
-				strVal = in.substr(sds::sdsActionDescriptors.vk.size());
-				std::stringstream(strVal) >> keyCode;
-			}
-			return keyCode;
-		}
 	};
 
 }
\ No newline at end of file
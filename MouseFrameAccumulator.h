@@ -0,0 +1,70 @@
+#pragma once
+#include "stdafx.h"
+#include "MouseStep.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Turns the per axis delays of ThumbstickToDelay, microseconds per pixel, into the integer dx/dy of fixed rate
+	/// mouse output frames. Each frame adds the distance an axis covers in one frame period to its position, in
+	/// 1/FRACTION_ONE pixel units, sends the whole pixels and carries the remainder into the next frame, so the
+	/// average speed is that of the variable delay timers while the output is at most one move per frame.
+	/// A frame costs two integer divisions and at most one SendInput call, the output rate is bounded by the frame rate.
+	/// </summary>
+	class MouseFrameAccumulator
+	{
+	public:
+		static constexpr std::int64_t FRACTION_ONE = 1 << 16;
+	private:
+		//position gained in one frame by an axis with a delay of one microsecond, divided by the delay for the step
+		std::int64_t m_stepPerMicro;
+		std::chrono::nanoseconds m_framePeriod;
+		std::int64_t m_remainderX = 0;
+		std::int64_t m_remainderY = 0;
+	public:
+		/// <param name="frameRate">frames per second, greater than zero</param>
+		explicit MouseFrameAccumulator(const int frameRate)
+			: m_stepPerMicro(FRACTION_ONE * XinSettings::PIXELS_MAGNITUDE * 1'000'000 / std::max(frameRate, 1)),
+			m_framePeriod(std::chrono::nanoseconds(1'000'000'000) / std::max(frameRate, 1))
+		{
+		}
+		std::chrono::nanoseconds GetFramePeriod() const
+		{
+			return m_framePeriod;
+		}
+		/// <summary>
+		/// Advances one frame with the axis state given to MouseMoveThread::UpdateState().
+		/// An axis that is not moving, or that changed direction, drops its remainder.
+		/// </summary>
+		/// <returns>the move of the frame, the screen dx and dy in the directions of MouseStep</returns>
+		std::pair<int, int> Step(const size_t xDelay, const bool isXMoving, const bool isXPositive,
+			const size_t yDelay, const bool isYMoving, const bool isYPositive)
+		{
+			const int dx = Advance(m_remainderX, xDelay, isXMoving, MouseStep::IsScreenPositive(isXPositive, false));
+			const int dy = Advance(m_remainderY, yDelay, isYMoving, MouseStep::IsScreenPositive(isYPositive, true));
+			return { dx, dy };
+		}
+		void Reset()
+		{
+			m_remainderX = 0;
+			m_remainderY = 0;
+		}
+	private:
+		int Advance(std::int64_t &remainder, const size_t delay, const bool isMoving, const bool isScreenPositive) const
+		{
+			if (!isMoving || delay == 0)
+			{
+				remainder = 0;
+				return 0;
+			}
+			if (remainder != 0 && (remainder > 0) != isScreenPositive)
+				remainder = 0;
+			const std::int64_t step = m_stepPerMicro / static_cast<std::int64_t>(delay);
+			remainder += isScreenPositive ? step : -step;
+			//truncates toward zero, the remainder keeps the sign of the movement
+			const std::int64_t whole = remainder / FRACTION_ONE;
+			remainder -= whole * FRACTION_ONE;
+			return static_cast<int>(whole);
+		}
+	};
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "stdafx.h"
+#include "SendKey.h"
+#include "Clock.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Sits between the mouse movement logic and SendKey. Moves with a zero delta on both axes are dropped,
+	/// and the deltas of moves produced within the coalesce window of the first pending move are summed and
+	/// sent as one event when the window ends. A window of zero sends every non-zero move immediately.
+	/// Used by a single thread, only the counters are safe to read from another thread.
+	/// </summary>
+	class MouseMoveCoalescer
+	{
+	public:
+		using ClockType = std::chrono::steady_clock;
+		/// <summary>
+		/// Counters, may be shared by several coalescers in sequence to accumulate totals.
+		/// </summary>
+		struct Counters
+		{
+			//zero delta moves dropped
+			std::atomic<std::uint64_t> suppressed{ 0 };
+			//moves folded into an already pending move
+			std::atomic<std::uint64_t> merged{ 0 };
+			//move events sent
+			std::atomic<std::uint64_t> sent{ 0 };
+		};
+	private:
+		Utilities::SendKey m_keySend;
+		const std::chrono::microseconds m_window;
+		Counters &m_counters;
+		int m_pendingX = 0;
+		int m_pendingY = 0;
+		bool m_hasPending = false;
+		ClockType::time_point m_pendingSince;
+	public:
+		/// <param name="window">coalesce window, negative values are treated as zero</param>
+		/// <param name="counters">counters to add to, must outlive the coalescer</param>
+		MouseMoveCoalescer(const std::chrono::microseconds window, Counters &counters)
+			: m_window(std::max(window, std::chrono::microseconds(0))), m_counters(counters) { }
+		MouseMoveCoalescer(const MouseMoveCoalescer& other) = delete;
+		MouseMoveCoalescer(MouseMoveCoalescer&& other) = delete;
+		MouseMoveCoalescer& operator=(const MouseMoveCoalescer& other) = delete;
+		MouseMoveCoalescer& operator=(MouseMoveCoalescer&& other) = delete;
+		/// <summary>
+		/// Dtor sends any pending move.
+		/// </summary>
+		~MouseMoveCoalescer()
+		{
+			Flush();
+		}
+		/// <summary>
+		/// Adds a move, it is dropped if both deltas are zero, merged if a move is pending, and sent
+		/// if the window has ended.
+		/// </summary>
+		/// <param name="x">number of pixels in X</param>
+		/// <param name="y">number of pixels in Y</param>
+		void AddMove(const int x, const int y)
+		{
+			if (x == 0 && y == 0)
+			{
+				m_counters.suppressed.fetch_add(1, std::memory_order_relaxed);
+				Poll();
+				return;
+			}
+			if (m_hasPending)
+			{
+				m_pendingX += x;
+				m_pendingY += y;
+				m_counters.merged.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				m_pendingX = x;
+				m_pendingY = y;
+				m_hasPending = true;
+				m_pendingSince = Utilities::Clock::Get().Now();
+			}
+			Poll();
+		}
+		/// <summary>
+		/// Sends the pending move if its window has ended, to be called on every loop iteration.
+		/// </summary>
+		void Poll()
+		{
+			if (m_hasPending && (Utilities::Clock::Get().Now() - m_pendingSince) >= m_window)
+				Flush();
+		}
+		/// <summary>
+		/// Sends the pending move now, if there is one.
+		/// </summary>
+		void Flush()
+		{
+			if (!m_hasPending)
+				return;
+			m_hasPending = false;
+			//opposite moves inside the window can cancel out
+			if (m_pendingX == 0 && m_pendingY == 0)
+				return;
+			m_keySend.SendMouseMove(m_pendingX, m_pendingY);
+			m_counters.sent.fetch_add(1, std::memory_order_relaxed);
+		}
+		bool HasPending() const
+		{
+			return m_hasPending;
+		}
+		/// <summary>
+		/// Returns when the window of the pending move ends, only meaningful while HasPending() is true.
+		/// </summary>
+		ClockType::time_point GetFlushDeadline() const
+		{
+			return m_pendingSince + m_window;
+		}
+	};
+}
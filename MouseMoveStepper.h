@@ -0,0 +1,209 @@
+#pragma once
+#include "stdafx.h"
+#include "XInputBoostMouse.h"
+#include "DeadlineQueue.h"
+#include "MouseFrameAccumulator.h"
+#include "MouseStep.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Sends the mouse moves of an XInputBoostMouse in ExecutionMode::REACTOR as tasks of a DeadlineQueue,
+	/// doing the work of the XInputBoostMouse worker thread and its MouseMoveThread on the reactor loop.
+	/// Each axis is a task rescheduled by its own delay after every move, so the loop sleeps between moves instead of spinning.
+	/// Moves go through a MouseMoveCoalescer as they do in the threaded mode, its flush is a task as well.
+	/// With a mouse frame rate set, one FRAME task at the fixed rate replaces the axis tasks, see MouseFrameAccumulator.
+	/// The intervals between the moves are recorded to the MoveTimingStats of the mouse, as the MouseMoveThread does.
+	/// </summary>
+	class MouseMoveStepper
+	{
+	public:
+		using TimePoint = DeadlineQueue::TimePoint;
+		/// <summary>
+		/// Task ids used by the stepper, offset by the first task id given to the ctor.
+		/// </summary>
+		enum Task : size_t
+		{
+			MOVE_X,
+			MOVE_Y,
+			FLUSH,
+			FRAME,
+			TASK_COUNT
+		};
+	private:
+		XInputBoostMouse &m_mouse;
+		const size_t m_firstTask;
+		std::uint64_t m_settingsVersion;
+		MouseMap m_stickMap;
+		std::optional<ThumbstickToDelay> m_xAxis;
+		std::optional<ThumbstickToDelay> m_yAxis;
+		std::optional<MouseMoveCoalescer> m_coalescer;
+		//set in the fixed frame rate mode
+		std::optional<MouseFrameAccumulator> m_frames;
+		TimePoint m_nextFrame{};
+		MoveIntervalRecorder m_xInterval;
+		MoveIntervalRecorder m_yInterval;
+		MoveIntervalRecorder m_frameInterval;
+		size_t m_xDelay = 1;
+		size_t m_yDelay = 1;
+		bool m_isXPositive = false;
+		bool m_isYPositive = false;
+		bool m_isXMoving = false;
+		bool m_isYMoving = false;
+	public:
+		/// <param name="mouse">mouse to read settings and thumbstick values from, must outlive the stepper</param>
+		/// <param name="firstTask">queue task id of MOVE_X, the stepper uses TASK_COUNT ids from there</param>
+		MouseMoveStepper(XInputBoostMouse &mouse, const size_t firstTask)
+			: m_mouse(mouse), m_firstTask(firstTask), m_settingsVersion(mouse.GetSettingsVersion()), m_stickMap(MouseMap::NEITHER_STICK),
+			m_xInterval(mouse.GetMoveTiming().x), m_yInterval(mouse.GetMoveTiming().y), m_frameInterval(mouse.GetMoveTiming().frame)
+		{
+			Rebuild();
+		}
+		MouseMoveStepper(const MouseMoveStepper& other) = delete;
+		MouseMoveStepper(MouseMoveStepper&& other) = delete;
+		MouseMoveStepper& operator=(const MouseMoveStepper& other) = delete;
+		MouseMoveStepper& operator=(MouseMoveStepper&& other) = delete;
+		~MouseMoveStepper() = default;
+		/// <summary>
+		/// Called after each processed state, recomputes the axis delays from the thumbstick and
+		/// schedules or cancels the axis tasks as the axes start and stop moving.
+		/// </summary>
+		void Update(const TimePoint now, DeadlineQueue &queue)
+		{
+			if (m_mouse.GetSettingsVersion() != m_settingsVersion)
+			{
+				m_settingsVersion = m_mouse.GetSettingsVersion();
+				Rebuild();
+			}
+			if (m_stickMap == MouseMap::NEITHER_STICK)
+			{
+				m_isXMoving = false;
+				m_isYMoving = false;
+			}
+			else
+			{
+				const auto [tx, ty] = m_mouse.GetStickValues();
+				m_xDelay = m_xAxis->GetDelayFromThumbstickValue(tx, ty);
+				m_yDelay = m_yAxis->GetDelayFromThumbstickValue(tx, ty);
+				m_isXPositive = tx > 0;
+				m_isYPositive = ty > 0;
+				m_isXMoving = m_xAxis->DoesAxisRequireMoveAlt(tx, ty);
+				m_isYMoving = m_yAxis->DoesAxisRequireMoveAlt(tx, ty);
+			}
+			if (m_frames)
+			{
+				queue.Cancel(m_firstTask + MOVE_X);
+				queue.Cancel(m_firstTask + MOVE_Y);
+				UpdateFrameTask(now, queue);
+				return;
+			}
+			queue.Cancel(m_firstTask + FRAME);
+			UpdateAxisTask(MOVE_X, m_isXMoving, now, queue);
+			UpdateAxisTask(MOVE_Y, m_isYMoving, now, queue);
+		}
+		/// <summary>
+		/// Runs a task popped from the queue if it belongs to the stepper.
+		/// </summary>
+		/// <returns>false if the task id is not one of the stepper's</returns>
+		bool RunTask(const size_t task, const TimePoint now, DeadlineQueue &queue)
+		{
+			if (task < m_firstTask || task >= m_firstTask + TASK_COUNT)
+				return false;
+			switch (task - m_firstTask)
+			{
+			case MOVE_X:
+				m_coalescer->AddMove(MouseStep::Pixels(m_isXPositive, false), 0);
+				m_xInterval.OnMove(now, std::chrono::microseconds(m_xDelay));
+				queue.Schedule(m_firstTask + MOVE_X, now + std::chrono::microseconds(m_xDelay));
+				break;
+			case MOVE_Y:
+				m_coalescer->AddMove(0, MouseStep::Pixels(m_isYPositive, true));
+				m_yInterval.OnMove(now, std::chrono::microseconds(m_yDelay));
+				queue.Schedule(m_firstTask + MOVE_Y, now + std::chrono::microseconds(m_yDelay));
+				break;
+			case FRAME:
+				RunFrame(now, queue);
+				break;
+			default:
+				m_coalescer->Poll();
+				break;
+			}
+			if (m_coalescer->HasPending() && !queue.IsScheduled(m_firstTask + FLUSH))
+				queue.Schedule(m_firstTask + FLUSH, m_coalescer->GetFlushDeadline());
+			return true;
+		}
+		/// <summary>
+		/// True if an axis is moving, the loop then waits precisely for the move deadlines.
+		/// </summary>
+		bool IsMoving() const
+		{
+			return m_isXMoving || m_isYMoving;
+		}
+	private:
+		/// <summary>
+		/// Rebuilds the per axis delay mapping and the coalescer from the current mouse settings,
+		/// any pending move is sent first.
+		/// </summary>
+		void Rebuild()
+		{
+			const std::shared_ptr<const ConfigSnapshot> config = m_mouse.GetConfig();
+			m_stickMap = config->stickMap;
+			m_xAxis.reset();
+			m_yAxis.reset();
+			m_xAxis.emplace(config->sensitivity, config->player, m_stickMap, true);
+			m_yAxis.emplace(config->sensitivity, config->player, m_stickMap, false);
+			m_coalescer.reset();
+			m_coalescer.emplace(std::chrono::microseconds(config->coalesceMicros), m_mouse.GetMoveCounters());
+			m_frames.reset();
+			m_xInterval.OnStop();
+			m_yInterval.OnStop();
+			m_frameInterval.OnStop();
+			if (config->mouseFrameRate > 0)
+				m_frames.emplace(config->mouseFrameRate);
+		}
+		void UpdateAxisTask(const Task axis, const bool isMoving, const TimePoint now, DeadlineQueue &queue)
+		{
+			const size_t task = m_firstTask + axis;
+			if (!isMoving)
+			{
+				queue.Cancel(task);
+				(axis == MOVE_X ? m_xInterval : m_yInterval).OnStop();
+			}
+			else if (!queue.IsScheduled(task))
+				queue.Schedule(task, now);
+		}
+		/// <summary>
+		/// Starts the frames when an axis starts moving, the first one at once, and stops them when none is.
+		/// </summary>
+		void UpdateFrameTask(const TimePoint now, DeadlineQueue &queue)
+		{
+			const size_t task = m_firstTask + FRAME;
+			if (!IsMoving())
+			{
+				queue.Cancel(task);
+				m_frames->Reset();
+				m_frameInterval.OnStop();
+			}
+			else if (!queue.IsScheduled(task))
+			{
+				m_nextFrame = now;
+				queue.Schedule(task, now);
+			}
+		}
+		/// <summary>
+		/// Sends the move of one frame at once and schedules the next frame one period after this one was due,
+		/// a frame missed by more than a period is dropped rather than sent late in a burst.
+		/// </summary>
+		void RunFrame(const TimePoint now, DeadlineQueue &queue)
+		{
+			m_frameInterval.OnMove(now, m_frames->GetFramePeriod());
+			const auto [dx, dy] = m_frames->Step(m_xDelay, m_isXMoving, m_isXPositive, m_yDelay, m_isYMoving, m_isYPositive);
+			m_coalescer->AddMove(dx, dy);
+			m_coalescer->Flush();
+			m_nextFrame += m_frames->GetFramePeriod();
+			if (m_nextFrame <= now)
+				m_nextFrame = now + m_frames->GetFramePeriod();
+			queue.Schedule(m_firstTask + FRAME, m_nextFrame);
+		}
+	};
+}
@@ -1,13 +1,23 @@
 #pragma once
 #include "CPPThreadRunner.h"
 #include "SendKey.h"
+#include "MouseMoveCoalescer.h"
 #include "DelayManager.h"
+#include "DelayHighPrecision.h"
+#include "MouseFrameAccumulator.h"
+#include "MoveTimingStats.h"
+#include "MouseStep.h"
 
 namespace sds
 {
 	/// <summary>
 	/// A singular thread responsible for sending mouse movements using
 	///	two different axis delay values being updated while running.
+	/// Moves are sent through a MouseMoveCoalescer, so loop iterations where neither axis timer fired send nothing.
+	/// Between iterations the thread sleeps until the next axis move or flush is due, spinning only the calibrated
+	/// margin of TimerSettings before it, and sleeps XinSettings::MOUSE_IDLE_WAKE_MICRO at a time while no axis moves.
+	/// With a frame rate set the axis timers are replaced by fixed rate frames, each sending at most one move.
+	/// The actual interval between the moves of an axis, or between frames, is recorded against the one requested.
 	/// </summary>
 	class MouseMoveThread : public CPPThreadRunner<int>
 	{
@@ -17,15 +27,29 @@ namespace sds
 		std::atomic<bool> m_isYMoving;
 		std::atomic<bool> m_isXPositive;
 		std::atomic<bool> m_isYPositive;
+		const std::chrono::microseconds m_coalesceWindow;
+		const int m_frameRate;
+		MouseMoveCoalescer::Counters &m_moveCounters;
+		MoveTimingStats &m_moveTiming;
 	protected:
 	void workThread() override
 	{
 		this->isThreadRunning = true;
 		using namespace std::chrono;
-		Utilities::SendKey keySend;
-		DelayManager xTime(XinSettings::MICROSECONDS_MAX);
-		DelayManager yTime(XinSettings::MICROSECONDS_MAX);
-		//A loop with no delay, that checks each delay value
+		Utilities::Clock &clock = Utilities::Clock::Get();
+		const microseconds idlePeriod(XinSettings::MOUSE_IDLE_WAKE_MICRO);
+		MouseMoveCoalescer coalescer(m_coalesceWindow, m_moveCounters);
+		if (m_frameRate > 0)
+		{
+			frameLoop(clock, idlePeriod, coalescer);
+			this->isThreadRunning = false;
+			return;
+		}
+		DelayManager xTime(XinSettings::MICROSECONDS_MAX, clock);
+		DelayManager yTime(XinSettings::MICROSECONDS_MAX, clock);
+		MoveIntervalRecorder xInterval(m_moveTiming.x);
+		MoveIntervalRecorder yInterval(m_moveTiming.y);
+		//A loop that waits for the earliest axis timepoint, checks each delay value
 		//against a timepoint, and performs the move for that axis if it beyond the timepoint
 		//and in that way, will perform the single pixel move with two different variable time delays.
 		bool isXM = false;
@@ -44,24 +68,91 @@ namespace sds
 				int yVal = 0;
 				if(isXPast && m_isXMoving)
 				{
-					xVal = (isXPos ? XinSettings::PIXELS_MAGNITUDE : (-XinSettings::PIXELS_MAGNITUDE));
+					xVal = MouseStep::Pixels(isXPos, false);
 					xTime.Reset(xDelay);
+					xInterval.OnMove(clock.Now(), microseconds(xDelay));
 				}
 				if (isYPast && m_isYMoving)
 				{
-					yVal = (isYPos ? -XinSettings::PIXELS_MAGNITUDE : (XinSettings::PIXELS_MAGNITUDE)); // y is inverted
+					yVal = MouseStep::Pixels(isYPos, true);
 					yTime.Reset(yDelay);
+					yInterval.OnMove(clock.Now(), microseconds(yDelay));
 				}
-				keySend.SendMouseMove(xVal, yVal);
+				coalescer.AddMove(xVal, yVal);
+			}
+			else
+			{
+				coalescer.Poll();
 			}
 			isXM = m_isXMoving;
 			isYM = m_isYMoving;
-			std::this_thread::yield();
+			if (!isXM)
+				xInterval.OnStop();
+			if (!isYM)
+				yInterval.OnStop();
+			const Utilities::Clock::TimePoint now = clock.Now();
+			if (!isXM && !isYM && !coalescer.HasPending())
+			{
+				clock.SleepUntil(now + idlePeriod);
+				continue;
+			}
+			//bounded by the idle period, so a change of state is seen
+			Utilities::Clock::TimePoint wakeAt = now + idlePeriod;
+			if (isXM)
+				wakeAt = std::min(wakeAt, xTime.GetDeadline());
+			if (isYM)
+				wakeAt = std::min(wakeAt, yTime.GetDeadline());
+			if (coalescer.HasPending())
+				wakeAt = std::min(wakeAt, coalescer.GetFlushDeadline());
+			Utilities::DelayHighPrecision::SleepUntil(wakeAt, clock);
 		}
 		this->isThreadRunning = false;
 	}
+	/// <summary>
+	/// The fixed frame rate loop, each frame sends the whole pixels the axes covered in it and carries the rest.
+	/// The next frame is due one period after the last was, a frame missed by more than a period is dropped
+	/// rather than sent late in a burst, so at most m_frameRate moves are sent per second.
+	/// </summary>
+	void frameLoop(Utilities::Clock &clock, const std::chrono::microseconds idlePeriod, MouseMoveCoalescer &coalescer)
+	{
+		MouseFrameAccumulator frames(m_frameRate);
+		const std::chrono::nanoseconds period = frames.GetFramePeriod();
+		MoveIntervalRecorder frameInterval(m_moveTiming.frame);
+		Utilities::Clock::TimePoint nextFrame = clock.Now();
+		while (!this->isStopRequested)
+		{
+			const bool isXM = m_isXMoving;
+			const bool isYM = m_isYMoving;
+			if (!isXM && !isYM)
+			{
+				frames.Reset();
+				frameInterval.OnStop();
+				clock.SleepUntil(clock.Now() + idlePeriod);
+				nextFrame = clock.Now();
+				continue;
+			}
+			frameInterval.OnMove(clock.Now(), period);
+			const auto [dx, dy] = frames.Step(m_xDelay, isXM, m_isXPositive, m_yDelay, isYM, m_isYPositive);
+			coalescer.AddMove(dx, dy);
+			coalescer.Flush();
+			nextFrame += period;
+			const Utilities::Clock::TimePoint now = clock.Now();
+			if (nextFrame <= now)
+				nextFrame = now + period;
+			Utilities::DelayHighPrecision::SleepUntil(nextFrame, clock);
+		}
+	}
 	public:
-		MouseMoveThread() : CPPThreadRunner<int>(), m_xDelay(1), m_yDelay(1), m_isXMoving(false), m_isYMoving(false), m_isXPositive(false), m_isYPositive(false)
+		/// <summary>
+		/// Ctor, starts the thread.
+		/// </summary>
+		/// <param name="coalesceWindow">window within which move deltas are merged, see MouseMoveCoalescer</param>
+		/// <param name="frameRate">fixed output frames per second, 0 to move each axis on its own delay timer</param>
+		/// <param name="moveCounters">counters for the moves suppressed, merged and sent, must outlive the thread</param>
+		/// <param name="moveTiming">timing the intervals between the moves are recorded to, must outlive the thread</param>
+		MouseMoveThread(const std::chrono::microseconds coalesceWindow, const int frameRate, MouseMoveCoalescer::Counters &moveCounters, MoveTimingStats &moveTiming)
+			: CPPThreadRunner<int>(ThreadPolicy::ForMouseMove()), m_xDelay(1), m_yDelay(1), m_isXMoving(false), m_isYMoving(false), m_isXPositive(false), m_isYPositive(false),
+			m_coalesceWindow(coalesceWindow), m_frameRate(frameRate), m_moveCounters(moveCounters), m_moveTiming(moveTiming)
 		{
 			this->startThread();
 		}
@@ -0,0 +1,29 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	/// <summary>
+	/// The step rules of the mouse axes, shared by every mover: a thumbstick pushed positive on X moves right,
+	/// pushed positive on Y moves up the screen, which is a negative screen Y. Each move of an axis is
+	/// XinSettings::PIXELS_MAGNITUDE pixels in that direction.
+	/// </summary>
+	namespace MouseStep
+	{
+		/// <summary>
+		/// Returns true if the screen delta of the axis is positive for the thumbstick direction, y is inverted.
+		/// </summary>
+		constexpr bool IsScreenPositive(const bool isThumbPositive, const bool isYAxis)
+		{
+			return isThumbPositive != isYAxis;
+		}
+		/// <summary>
+		/// Screen delta of one move of the axis.
+		/// </summary>
+		constexpr int Pixels(const bool isThumbPositive, const bool isYAxis)
+		{
+			return IsScreenPositive(isThumbPositive, isYAxis) ? XinSettings::PIXELS_MAGNITUDE : -XinSettings::PIXELS_MAGNITUDE;
+		}
+		static_assert(Pixels(true, false) > 0 && Pixels(true, true) < 0);
+	}
+}
@@ -0,0 +1,201 @@
+#pragma once
+#include "stdafx.h"
+#include "Clock.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Totals of a MoveTimingHistogram at one point in time, the error is the actual interval between two moves
+	/// less the interval requested, the axis delay of ThumbstickToDelay or the frame period.
+	/// </summary>
+	struct MoveTimingSummary
+	{
+		std::uint64_t moves = 0;
+		//moves later than XinSettings::MOUSE_MOVE_MISS_MICRO
+		std::uint64_t missed = 0;
+		std::chrono::nanoseconds meanRequested{ 0 };
+		std::chrono::nanoseconds meanError{ 0 };
+		std::chrono::nanoseconds p99Error{ 0 };
+		std::chrono::nanoseconds maxError{ 0 };
+
+		std::string ToString() const
+		{
+			using std::chrono::duration;
+			auto toMicros = [](const std::chrono::nanoseconds d) { return std::to_string(duration<double, std::micro>(d).count()); };
+			return "moves: " + std::to_string(moves) + " missed: " + std::to_string(missed) + " requested us: " + toMicros(meanRequested)
+				+ " error us mean: " + toMicros(meanError) + " p99: " + toMicros(p99Error) + " max: " + toMicros(maxError);
+		}
+	};
+
+	/// <summary>
+	/// Histogram of the lateness of the moves of one axis, written by the one thread sending the moves and read by any.
+	/// The buckets are log-linear, exact below 32 ns and within 1/32 of the value above it, so a percentile costs
+	/// one pass over the buckets and a record a few relaxed atomic adds, no allocation or lock.
+	/// An early move, possible only after a delay change, counts into the mean error and the lowest bucket.
+	/// </summary>
+	class MoveTimingHistogram
+	{
+		static constexpr int SubBucketBits = 5;
+		static constexpr std::uint64_t SubBuckets = 1ull << SubBucketBits;
+		//errors from 2^(MaxExponent + 1) ns, about two minutes, count in the last bucket
+		static constexpr int MaxExponent = 36;
+		static constexpr size_t BucketCount = SubBuckets * (MaxExponent - SubBucketBits + 2);
+		std::array<std::atomic<std::uint64_t>, BucketCount> m_buckets{};
+		std::atomic<std::uint64_t> m_moves{ 0 };
+		std::atomic<std::uint64_t> m_missed{ 0 };
+		std::atomic<std::int64_t> m_requestedSumNanos{ 0 };
+		std::atomic<std::int64_t> m_errorSumNanos{ 0 };
+		std::atomic<std::int64_t> m_maxErrorNanos{ 0 };
+	public:
+		MoveTimingHistogram() = default;
+		MoveTimingHistogram(const MoveTimingHistogram& other) = delete;
+		MoveTimingHistogram(MoveTimingHistogram&& other) = delete;
+		MoveTimingHistogram& operator=(const MoveTimingHistogram& other) = delete;
+		MoveTimingHistogram& operator=(MoveTimingHistogram&& other) = delete;
+		~MoveTimingHistogram() = default;
+		/// <summary>
+		/// Records the interval between two moves, from the single thread sending them.
+		/// </summary>
+		/// <param name="requested">interval the move was scheduled for</param>
+		/// <param name="actual">interval measured between the moves</param>
+		void Record(const std::chrono::nanoseconds requested, const std::chrono::nanoseconds actual)
+		{
+			const std::int64_t error = (actual - requested).count();
+			m_buckets[BucketOf(static_cast<std::uint64_t>(std::max<std::int64_t>(error, 0)))].fetch_add(1, std::memory_order_relaxed);
+			m_requestedSumNanos.fetch_add(requested.count(), std::memory_order_relaxed);
+			m_errorSumNanos.fetch_add(error, std::memory_order_relaxed);
+			if (error > m_maxErrorNanos.load(std::memory_order_relaxed))
+				m_maxErrorNanos.store(error, std::memory_order_relaxed);
+			if (error > std::chrono::nanoseconds(std::chrono::microseconds(XinSettings::MOUSE_MOVE_MISS_MICRO)).count())
+				m_missed.fetch_add(1, std::memory_order_relaxed);
+			m_moves.fetch_add(1, std::memory_order_relaxed);
+		}
+		/// <summary>
+		/// Error at or below which the fraction of the moves lies, the upper bound of its bucket.
+		/// </summary>
+		/// <param name="fraction">0.0 to 1.0, 0.99 for the p99</param>
+		std::chrono::nanoseconds Percentile(const double fraction) const
+		{
+			std::array<std::uint64_t, BucketCount> counts;
+			std::uint64_t total = 0;
+			for (size_t i = 0; i < BucketCount; i++)
+			{
+				counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+				total += counts[i];
+			}
+			if (total == 0)
+				return std::chrono::nanoseconds::zero();
+			//in parts per million, so 0.99 of 100 moves is the 99th and not rounded up to the 100th
+			const std::uint64_t ppm = static_cast<std::uint64_t>(std::llround(std::clamp(fraction, 0.0, 1.0) * 1e6));
+			const std::uint64_t rank = std::max<std::uint64_t>(1, (total * ppm + 999'999) / 1'000'000);
+			std::uint64_t seen = 0;
+			for (size_t i = 0; i < BucketCount; i++)
+			{
+				seen += counts[i];
+				if (seen >= rank)
+					return std::chrono::nanoseconds(static_cast<std::int64_t>(BucketUpper(i)));
+			}
+			return std::chrono::nanoseconds(static_cast<std::int64_t>(BucketUpper(BucketCount - 1)));
+		}
+		MoveTimingSummary Summarize() const
+		{
+			MoveTimingSummary summary;
+			summary.moves = m_moves.load(std::memory_order_relaxed);
+			summary.missed = m_missed.load(std::memory_order_relaxed);
+			if (summary.moves == 0)
+				return summary;
+			const std::int64_t moves = static_cast<std::int64_t>(summary.moves);
+			summary.meanRequested = std::chrono::nanoseconds(m_requestedSumNanos.load(std::memory_order_relaxed) / moves);
+			summary.meanError = std::chrono::nanoseconds(m_errorSumNanos.load(std::memory_order_relaxed) / moves);
+			summary.p99Error = Percentile(0.99);
+			summary.maxError = std::chrono::nanoseconds(m_maxErrorNanos.load(std::memory_order_relaxed));
+			return summary;
+		}
+		/// <summary>
+		/// Clears the histogram, a move recorded during the reset may be partly kept.
+		/// </summary>
+		void Reset()
+		{
+			for (std::atomic<std::uint64_t> &bucket : m_buckets)
+				bucket.store(0, std::memory_order_relaxed);
+			m_moves.store(0, std::memory_order_relaxed);
+			m_missed.store(0, std::memory_order_relaxed);
+			m_requestedSumNanos.store(0, std::memory_order_relaxed);
+			m_errorSumNanos.store(0, std::memory_order_relaxed);
+			m_maxErrorNanos.store(0, std::memory_order_relaxed);
+		}
+	private:
+		static size_t BucketOf(std::uint64_t nanos)
+		{
+			if (nanos < SubBuckets)
+				return static_cast<size_t>(nanos);
+			nanos = std::min<std::uint64_t>(nanos, (1ull << (MaxExponent + 1)) - 1);
+			const int exponent = static_cast<int>(std::bit_width(nanos)) - 1;
+			const std::uint64_t sub = (nanos >> (exponent - SubBucketBits)) - SubBuckets;
+			return static_cast<size_t>(SubBuckets * (exponent - SubBucketBits + 1) + sub);
+		}
+		static std::uint64_t BucketUpper(const size_t bucket)
+		{
+			if (bucket < SubBuckets)
+				return bucket;
+			const int exponent = static_cast<int>(bucket / SubBuckets) - 1 + SubBucketBits;
+			const std::uint64_t sub = bucket % SubBuckets + SubBuckets;
+			return ((sub + 1) << (exponent - SubBucketBits)) - 1;
+		}
+	};
+
+	/// <summary>
+	/// Records the intervals between the moves of one axis into a histogram, held by the thread sending the moves.
+	/// </summary>
+	class MoveIntervalRecorder
+	{
+		MoveTimingHistogram &m_histogram;
+		Utilities::Clock::TimePoint m_lastMove{};
+		bool m_hasLastMove = false;
+		std::chrono::nanoseconds m_requested{ 0 };
+	public:
+		explicit MoveIntervalRecorder(MoveTimingHistogram &histogram) : m_histogram(histogram) { }
+		/// <summary>
+		/// Called for each move, records the interval since the last one if the axis has not stopped in between.
+		/// </summary>
+		/// <param name="now">time of the move</param>
+		/// <param name="nextRequested">interval requested until the next move</param>
+		void OnMove(const Utilities::Clock::TimePoint now, const std::chrono::nanoseconds nextRequested)
+		{
+			if (m_hasLastMove)
+				m_histogram.Record(m_requested, now - m_lastMove);
+			m_lastMove = now;
+			m_hasLastMove = true;
+			m_requested = nextRequested;
+		}
+		/// <summary>
+		/// Called when the axis stops, the next move starts a new series.
+		/// </summary>
+		void OnStop()
+		{
+			m_hasLastMove = false;
+		}
+	};
+
+	/// <summary>
+	/// Inter-move timing of the mouse, per axis for the variable delay timers and per frame for the fixed frame rate.
+	/// Only the intervals of an axis moving without a stop are recorded, the first move after a start has no interval.
+	/// </summary>
+	struct MoveTimingStats
+	{
+		MoveTimingHistogram x;
+		MoveTimingHistogram y;
+		MoveTimingHistogram frame;
+
+		std::string ToString() const
+		{
+			return "x " + x.Summarize().ToString() + ", y " + y.Summarize().ToString() + ", frame " + frame.Summarize().ToString();
+		}
+		void Reset()
+		{
+			x.Reset();
+			y.Reset();
+			frame.Reset();
+		}
+	};
+}
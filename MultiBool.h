@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 namespace sds
 {
@@ -11,7 +12,7 @@ namespace sds
 		/// C++11 style "enum class" that adds type safety and strong scoping.
 		/// used by MultiBool as a type of finite state machine helper to keep track of the current state
 		/// </summary>
-		enum class BUTTONSTATE
+		enum class BUTTONSTATE : std::uint8_t
 		{
 			STATE_ONE,
 			STATE_TWO,
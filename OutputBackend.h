@@ -0,0 +1,111 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Interface for the destination of the INPUT records built by SendKey.
+		/// Each call to SendFrame() is one frame of output, a backend delivers it as a single batch, in order.
+		/// The count a backend returns is always of the leading records of the frame, OutputRetryQueue resends the rest,
+		/// so a backend must not deliver a record after one it did not deliver.
+		/// The base class counts frames and INPUT records and times each call, so the injection cost of
+		/// different backends can be compared.
+		/// Implementations must be thread safe, the mapper and the mouse thread both send output.
+		/// </summary>
+		class OutputBackend
+		{
+			std::atomic<std::uint64_t> m_frameCount{ 0 };
+			std::atomic<std::uint64_t> m_inputCount{ 0 };
+			std::atomic<std::uint64_t> m_failedCount{ 0 };
+			std::atomic<std::uint64_t> m_skippedCount{ 0 };
+			std::atomic<std::uint64_t> m_sendNanoseconds{ 0 };
+		protected:
+			/// <summary>
+			/// Delivers one frame of INPUT records, in order.
+			/// A record the backend has no translation for is skipped and counts as delivered, report it with CountSkipped(),
+			/// as retrying it would only hold up the records behind it.
+			/// </summary>
+			/// <returns>number of leading INPUT records delivered, the records from that index on were not</returns>
+			virtual size_t SendFrameImpl(const INPUT *inputs, size_t count) = 0;
+			/// <summary>
+			/// Counts records skipped by SendFrameImpl() for having no translation.
+			/// </summary>
+			void CountSkipped(const size_t count)
+			{
+				m_skippedCount.fetch_add(count, std::memory_order_relaxed);
+			}
+		public:
+			OutputBackend() = default;
+			OutputBackend(const OutputBackend& other) = delete;
+			OutputBackend(OutputBackend&& other) = delete;
+			OutputBackend& operator=(const OutputBackend& other) = delete;
+			OutputBackend& operator=(OutputBackend&& other) = delete;
+			virtual ~OutputBackend() = default;
+			/// <summary>
+			/// Short name of the backend, for reports.
+			/// </summary>
+			virtual std::string GetName() const = 0;
+			/// <summary>
+			/// Sends an array of INPUT records as one frame.
+			/// </summary>
+			/// <param name="inputs">Pointer to first element of INPUT array.</param>
+			/// <param name="count">Number of elements in the array to send.</param>
+			/// <returns>number of leading INPUT records delivered, less than count on failure</returns>
+			size_t SendFrame(const INPUT *inputs, const size_t count)
+			{
+				const auto startTime = std::chrono::steady_clock::now();
+				const size_t numSent = SendFrameImpl(inputs, count);
+				const auto elapsed = std::chrono::steady_clock::now() - startTime;
+				m_sendNanoseconds.fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), std::memory_order_relaxed);
+				m_frameCount.fetch_add(1, std::memory_order_relaxed);
+				m_inputCount.fetch_add(numSent, std::memory_order_relaxed);
+				if (numSent != count)
+					m_failedCount.fetch_add(count - numSent, std::memory_order_relaxed);
+				return numSent;
+			}
+			std::uint64_t GetFrameCount() const
+			{
+				return m_frameCount.load(std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Returns the number of INPUT records delivered.
+			/// </summary>
+			std::uint64_t GetInputCount() const
+			{
+				return m_inputCount.load(std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Returns the number of INPUT records the backend failed to deliver.
+			/// </summary>
+			std::uint64_t GetFailedCount() const
+			{
+				return m_failedCount.load(std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Returns the number of INPUT records skipped as the backend has no translation for them, counted as delivered.
+			/// </summary>
+			std::uint64_t GetSkippedCount() const
+			{
+				return m_skippedCount.load(std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Returns the mean time spent in SendFrame(), in nanoseconds.
+			/// </summary>
+			double GetAverageFrameNanoseconds() const
+			{
+				const std::uint64_t frames = GetFrameCount();
+				return frames == 0 ? 0.0 : static_cast<double>(m_sendNanoseconds.load(std::memory_order_relaxed)) / static_cast<double>(frames);
+			}
+			void ResetStats()
+			{
+				m_frameCount.store(0, std::memory_order_relaxed);
+				m_inputCount.store(0, std::memory_order_relaxed);
+				m_failedCount.store(0, std::memory_order_relaxed);
+				m_skippedCount.store(0, std::memory_order_relaxed);
+				m_sendNanoseconds.store(0, std::memory_order_relaxed);
+			}
+		};
+	}
+}
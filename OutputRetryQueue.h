@@ -0,0 +1,233 @@
+#pragma once
+#include "stdafx.h"
+#include "OutputBackend.h"
+#include "RuntimeCounters.h"
+#include "FlightRecorder.h"
+#include "Clock.h"
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Bounded queue of the INPUT records an OutputBackend did not insert, SendInput inserts none when UIPI blocks
+		/// injection and only part of a frame when the input queue is full. The tail that was not inserted is queued
+		/// and retried under an exponential backoff, and while anything is queued new output is queued behind it,
+		/// so a key-up is never delivered before the key-down sent ahead of it.
+		/// Sending with nothing queued costs one atomic load on top of the backend call.
+		/// When the queue is full the oldest mouse moves are dropped first, as losing one does not leave a key stuck,
+		/// then the presses being queued are refused. A release is never dropped, so the queue may exceed its bound by releases.
+		/// </summary>
+		class OutputRetryQueue
+		{
+		public:
+			using ClockType = std::chrono::steady_clock;
+		private:
+			mutable std::mutex m_mutex;
+			std::vector<INPUT> m_pending;
+			std::atomic<bool> m_hasPending{ false };
+			ClockType::time_point m_nextRetry;
+			ClockType::duration m_backoff = std::chrono::microseconds(XinSettings::OUTPUT_RETRY_BACKOFF_MIN_MICRO);
+			size_t m_failedRetries = 0;
+		public:
+			OutputRetryQueue() = default;
+			OutputRetryQueue(const OutputRetryQueue& other) = delete;
+			OutputRetryQueue(OutputRetryQueue&& other) = delete;
+			OutputRetryQueue& operator=(const OutputRetryQueue& other) = delete;
+			OutputRetryQueue& operator=(OutputRetryQueue&& other) = delete;
+			~OutputRetryQueue() = default;
+			/// <summary>
+			/// The process wide queue used by SendKey.
+			/// </summary>
+			static OutputRetryQueue& Get()
+			{
+				static OutputRetryQueue queue;
+				return queue;
+			}
+			/// <summary>
+			/// Sends a frame, queueing the records the backend does not insert.
+			/// </summary>
+			/// <returns>number of the records of this frame inserted now</returns>
+			size_t Send(OutputBackend &backend, const INPUT *inputs, const size_t count)
+			{
+				if (!m_hasPending.load(std::memory_order_acquire))
+				{
+					const size_t numInserted = backend.SendFrame(inputs, count);
+					if (numInserted == count)
+						return numInserted;
+					std::lock_guard<std::mutex> l1(m_mutex);
+					Enqueue(inputs + numInserted, count - numInserted);
+					ScheduleRetry(Clock::Get().Now());
+					return numInserted;
+				}
+				std::lock_guard<std::mutex> l1(m_mutex);
+				const size_t queuedBefore = m_pending.size();
+				Enqueue(inputs, count);
+				//behind the records already queued, which go first once the backoff is over
+				const ClockType::time_point now = Clock::Get().Now();
+				if (now < m_nextRetry)
+					return 0;
+				const size_t numInserted = SendPending(backend, now);
+				return numInserted > queuedBefore ? std::min(numInserted - queuedBefore, count) : 0;
+			}
+			/// <summary>
+			/// Retries the queued records if the backoff is over, called regularly by the poller.
+			/// </summary>
+			void Retry(OutputBackend &backend)
+			{
+				if (!m_hasPending.load(std::memory_order_acquire))
+					return;
+				std::lock_guard<std::mutex> l1(m_mutex);
+				const ClockType::time_point now = Clock::Get().Now();
+				if (!m_pending.empty() && now >= m_nextRetry)
+					SendPending(backend, now);
+			}
+			/// <summary>
+			/// Retries until every queued record is inserted or the timeout passes, sleeping for the backoff in between.
+			/// Used to be sure the key-ups of a "release all held keys" are delivered.
+			/// </summary>
+			/// <returns>true if the queue was emptied</returns>
+			bool Flush(OutputBackend &backend, const ClockType::duration timeout)
+			{
+				const ClockType::time_point deadline = Clock::Get().Now() + timeout;
+				for (;;)
+				{
+					ClockType::time_point nextRetry;
+					{
+						std::lock_guard<std::mutex> l1(m_mutex);
+						if (m_pending.empty())
+							return true;
+						const ClockType::time_point now = Clock::Get().Now();
+						if (now >= m_nextRetry)
+							SendPending(backend, now);
+						if (m_pending.empty())
+							return true;
+						nextRetry = m_nextRetry;
+					}
+					if (nextRetry >= deadline)
+					{
+						XErrorLogger::LogError("Error in sds::Utilities::OutputRetryQueue::Flush(), "
+							+ std::to_string(GetPendingCount()) + " input records not delivered before the timeout.");
+						return false;
+					}
+					Clock::Get().SleepUntil(nextRetry);
+				}
+			}
+			size_t GetPendingCount() const
+			{
+				std::lock_guard<std::mutex> l1(m_mutex);
+				return m_pending.size();
+			}
+			/// <summary>
+			/// Drops the queued records, for tests.
+			/// </summary>
+			void Clear()
+			{
+				std::lock_guard<std::mutex> l1(m_mutex);
+				m_pending.clear();
+				m_failedRetries = 0;
+				m_backoff = std::chrono::microseconds(XinSettings::OUTPUT_RETRY_BACKOFF_MIN_MICRO);
+				m_hasPending.store(false, std::memory_order_release);
+			}
+		private:
+			/// <summary>
+			/// Sends the queued records as one frame and removes those inserted. Called with the mutex held.
+			/// </summary>
+			/// <returns>number of records inserted</returns>
+			size_t SendPending(OutputBackend &backend, const ClockType::time_point now)
+			{
+				RuntimeCounters::Get().Add(RuntimeCounters::Counter::SEND_INPUT_RETRIES);
+				const size_t numInserted = backend.SendFrame(m_pending.data(), m_pending.size());
+				m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(numInserted));
+				if (m_pending.empty())
+				{
+					m_failedRetries = 0;
+					m_backoff = std::chrono::microseconds(XinSettings::OUTPUT_RETRY_BACKOFF_MIN_MICRO);
+					m_hasPending.store(false, std::memory_order_release);
+					return numInserted;
+				}
+				//progress resets the backoff, a retry inserting nothing doubles it
+				if (numInserted > 0)
+				{
+					m_failedRetries = 0;
+					m_backoff = std::chrono::microseconds(XinSettings::OUTPUT_RETRY_BACKOFF_MIN_MICRO);
+				}
+				else if (++m_failedRetries == XinSettings::OUTPUT_RETRY_PERSISTENT)
+				{
+					RuntimeCounters::Get().Add(RuntimeCounters::Counter::SEND_INPUT_PERSISTENT_FAILURES);
+					XErrorLogger::LogError("Error in sds::Utilities::OutputRetryQueue, the " + backend.GetName() + " backend has inserted nothing for "
+						+ std::to_string(m_failedRetries) + " retries, input injection may be blocked.");
+				}
+				ScheduleRetry(now);
+				return numInserted;
+			}
+			/// <summary>
+			/// Sets the time of the next retry and doubles the backoff up to its maximum. Called with the mutex held.
+			/// </summary>
+			void ScheduleRetry(const ClockType::time_point now)
+			{
+				m_nextRetry = now + m_backoff;
+				m_backoff = std::min<ClockType::duration>(m_backoff * 2, std::chrono::microseconds(XinSettings::OUTPUT_RETRY_BACKOFF_MAX_MICRO));
+			}
+			/// <summary>
+			/// Appends records to the queue, making room by dropping the oldest mouse moves, then refusing the presses
+			/// of the new records. A drop is an error, counted and reported with a flight recorder dump. Called with the mutex held.
+			/// </summary>
+			void Enqueue(const INPUT *inputs, const size_t count)
+			{
+				const auto isMoveInput = [](const INPUT &inp) { return inp.type == INPUT_MOUSE && (inp.mi.dwFlags & MOUSEEVENTF_MOVE) != 0; };
+				const size_t oldMoves = static_cast<size_t>(std::count_if(m_pending.begin(), m_pending.end(), isMoveInput));
+				m_pending.insert(m_pending.end(), inputs, inputs + count);
+				size_t excess = m_pending.size() > XinSettings::OUTPUT_RETRY_QUEUE_MAX ? m_pending.size() - XinSettings::OUTPUT_RETRY_QUEUE_MAX : 0;
+				const size_t sizeBefore = m_pending.size();
+				size_t newCount = count;
+				if (excess > 0)
+				{
+					const auto isMove = [&excess, &isMoveInput](const INPUT &inp)
+					{
+						const bool drop = excess > 0 && isMoveInput(inp);
+						if (drop)
+							excess--;
+						return drop;
+					};
+					m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), isMove), m_pending.end());
+					//the moves dropped past the old ones were new records
+					const size_t movesDropped = sizeBefore - m_pending.size();
+					newCount -= movesDropped > oldMoves ? movesDropped - oldMoves : 0;
+				}
+				if (excess > 0)
+				{
+					//a press is refused, newest first, a release never is, so no key is left held down
+					const auto isPress = [&excess](const INPUT &inp)
+					{
+						const bool drop = excess > 0 && !IsRelease(inp);
+						if (drop)
+							excess--;
+						return drop;
+					};
+					const auto newLast = m_pending.rbegin() + static_cast<std::ptrdiff_t>(newCount);
+					const auto kept = std::remove_if(m_pending.rbegin(), newLast, isPress);
+					m_pending.erase(newLast.base(), kept.base());
+				}
+				const size_t dropped = sizeBefore - m_pending.size();
+				if (dropped > 0)
+				{
+					RuntimeCounters::Get().Add(RuntimeCounters::Counter::OUTPUT_DROPPED, dropped);
+					RuntimeCounters::Get().Add(RuntimeCounters::Counter::SEND_INPUT_ERRORS);
+					FlightRecorder::Get().DumpOnError();
+				}
+				m_hasPending.store(!m_pending.empty(), std::memory_order_release);
+			}
+			/// <summary>
+			/// True for a key-up or a mouse button up, the records that must not be lost.
+			/// </summary>
+			static bool IsRelease(const INPUT &inp)
+			{
+				if (inp.type == INPUT_KEYBOARD)
+					return (inp.ki.dwFlags & KEYEVENTF_KEYUP) != 0;
+				return inp.type == INPUT_MOUSE
+					&& (inp.mi.dwFlags & (MOUSEEVENTF_LEFTUP | MOUSEEVENTF_RIGHTUP | MOUSEEVENTF_MIDDLEUP | MOUSEEVENTF_XUP)) != 0;
+			}
+		};
+	}
+}
@@ -0,0 +1,319 @@
+#pragma once
+#include "stdafx.h"
+#ifdef _WIN32
+#include <sddl.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "advapi32.lib")
+#endif
+#else
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sds
+{
+	/// <summary>
+	/// Source of profile switches, polled by the InputPoller before each controller state is processed.
+	/// Implementations must not block, PollSelection() runs on the polling thread.
+	/// </summary>
+	class ProfileSelector
+	{
+	public:
+		ProfileSelector() = default;
+		ProfileSelector(const ProfileSelector& other) = delete;
+		ProfileSelector(ProfileSelector&& other) = delete;
+		ProfileSelector& operator=(const ProfileSelector& other) = delete;
+		ProfileSelector& operator=(ProfileSelector&& other) = delete;
+		virtual ~ProfileSelector() = default;
+		/// <summary>
+		/// Returns the id of a profile selected since the last call, or nothing.
+		/// </summary>
+		virtual std::optional<size_t> PollSelection() = 0;
+		virtual std::string GetName() const = 0;
+	};
+
+	/// <summary>
+	/// ProfileSelector driven from code, Select() may be called from any thread.
+	/// </summary>
+	class ApiProfileSelector : public ProfileSelector
+	{
+		static constexpr size_t NoSelection = std::numeric_limits<size_t>::max();
+		std::atomic<size_t> m_selected{ NoSelection };
+	public:
+		/// <summary>
+		/// Selects a profile, a selection not yet polled is replaced.
+		/// </summary>
+		void Select(const size_t id)
+		{
+			m_selected.store(id, std::memory_order_release);
+		}
+		std::optional<size_t> PollSelection() override
+		{
+			const size_t id = m_selected.exchange(NoSelection, std::memory_order_acq_rel);
+			if (id == NoSelection)
+				return {};
+			return id;
+		}
+		std::string GetName() const override
+		{
+			return "api";
+		}
+	};
+
+	/// <summary>
+	/// ProfileSelector reading profile ids written as decimal text, one per line, to local IPC.
+	/// A non-blocking named pipe on Windows and a FIFO on Linux, so a hotkey tool, script or overlay
+	/// can switch profiles with no window or console attached. Send() is the client side.
+	/// </summary>
+	class PipeProfileSelector : public ProfileSelector
+	{
+		//longest line kept, a longer one is dropped
+		static constexpr size_t LineMax = 32;
+		std::string m_pipeName;
+		std::string m_pending;
+#ifdef _WIN32
+		HANDLE m_pipe = INVALID_HANDLE_VALUE;
+#else
+		int m_fd = -1;
+#endif
+	public:
+		PipeProfileSelector() = default;
+		PipeProfileSelector(const PipeProfileSelector& other) = delete;
+		PipeProfileSelector(PipeProfileSelector&& other) = delete;
+		PipeProfileSelector& operator=(const PipeProfileSelector& other) = delete;
+		PipeProfileSelector& operator=(PipeProfileSelector&& other) = delete;
+		~PipeProfileSelector() override
+		{
+			Close();
+		}
+		/// <summary>
+		/// Name of the pipe when none is given, XinSettings::PROFILE_PIPE_NAME. On Linux the FIFO of that name
+		/// in XDG_RUNTIME_DIR, a directory only the user can write to, or in /tmp if it is not set.
+		/// </summary>
+		static std::string DefaultPipeName()
+		{
+#ifdef _WIN32
+			return XinSettings::PROFILE_PIPE_NAME;
+#else
+			const char *runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+			const std::string dir = runtimeDir != nullptr && runtimeDir[0] != '\0' ? runtimeDir : "/tmp";
+			return dir + "/" + XinSettings::PROFILE_PIPE_NAME;
+#endif
+		}
+		/// <summary>
+		/// Creates the pipe, one already open is closed first. Only the current user can write to it:
+		/// on Windows the pipe has a DACL granting that user alone and fails if another process created the name first,
+		/// on Linux an existing FIFO is used only if it is a FIFO owned by the user and not writable by others.
+		/// </summary>
+		/// <param name="pipeName">name of the pipe, DefaultPipeName() by default</param>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] std::string Open(const std::string &pipeName = DefaultPipeName())
+		{
+			Close();
+			auto errText = [&pipeName](const std::string &s)
+			{
+				return "Error in sds::PipeProfileSelector::Open(), " + s + ": " + pipeName;
+			};
+#ifdef _WIN32
+			PSECURITY_DESCRIPTOR descriptor = nullptr;
+			const std::string descriptorErr = MakeUserOnlyDescriptor(descriptor);
+			if (!descriptorErr.empty())
+				return errText(descriptorErr);
+			SECURITY_ATTRIBUTES attributes{ sizeof(SECURITY_ATTRIBUTES), descriptor, FALSE };
+			m_pipe = CreateNamedPipeA(pipeName.c_str(), PIPE_ACCESS_INBOUND | FILE_FLAG_FIRST_PIPE_INSTANCE,
+				PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_NOWAIT | PIPE_REJECT_REMOTE_CLIENTS, 1, 0, 256, 0, &attributes);
+			const DWORD createError = GetLastError();
+			LocalFree(descriptor);
+			if (m_pipe == INVALID_HANDLE_VALUE)
+				return errText("failed to create the named pipe, error " + std::to_string(createError));
+#else
+			if (mkfifo(pipeName.c_str(), 0600) != 0 && errno != EEXIST)
+				return errText("failed to create the fifo, error " + std::to_string(errno));
+			//non-blocking, so opening does not wait for a writer and reading does not wait for data
+			m_fd = open(pipeName.c_str(), O_RDONLY | O_NONBLOCK | O_NOFOLLOW | O_CLOEXEC);
+			if (m_fd < 0)
+				return errText("failed to open the fifo, error " + std::to_string(errno));
+			//the name may have existed before, planted by another user, so the opened file is checked and not the path
+			struct stat info {};
+			if (fstat(m_fd, &info) != 0)
+			{
+				const int statError = errno;
+				Close();
+				return errText("failed to stat the fifo, error " + std::to_string(statError));
+			}
+			if (!S_ISFIFO(info.st_mode) || info.st_uid != geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+			{
+				Close();
+				return errText("not a fifo owned by and only writable by the current user");
+			}
+#endif
+			m_pipeName = pipeName;
+			return "";
+		}
+		void Close()
+		{
+#ifdef _WIN32
+			if (m_pipe != INVALID_HANDLE_VALUE)
+				CloseHandle(m_pipe);
+			m_pipe = INVALID_HANDLE_VALUE;
+#else
+			if (m_fd >= 0)
+				close(m_fd);
+			m_fd = -1;
+#endif
+			m_pending.clear();
+		}
+		bool IsOpen() const
+		{
+#ifdef _WIN32
+			return m_pipe != INVALID_HANDLE_VALUE;
+#else
+			return m_fd >= 0;
+#endif
+		}
+		/// <summary>
+		/// Reads what has been written to the pipe, the last valid id of the complete lines read is returned.
+		/// </summary>
+		std::optional<size_t> PollSelection() override
+		{
+			std::optional<size_t> selected;
+			if (!IsOpen())
+				return selected;
+			std::array<char, 256> buffer{};
+			for (;;)
+			{
+				const long long bytesRead = ReadSome(buffer.data(), buffer.size());
+				if (bytesRead <= 0)
+					break;
+				for (long long i = 0; i < bytesRead; i++)
+				{
+					const char c = buffer[static_cast<size_t>(i)];
+					if (c != '\n')
+					{
+						if (m_pending.size() <= LineMax)
+							m_pending.push_back(c);
+						continue;
+					}
+					if (const std::optional<size_t> id = ParseId(m_pending); id.has_value())
+						selected = id;
+					else
+						Utilities::XErrorLogger::LogError("Error in sds::PipeProfileSelector::PollSelection(), bad profile id: " + m_pending.substr(0, LineMax));
+					m_pending.clear();
+				}
+			}
+			return selected;
+		}
+		std::string GetName() const override
+		{
+			return "pipe " + m_pipeName;
+		}
+		/// <summary>
+		/// Client side, writes a profile id to the pipe of a running PipeProfileSelector.
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		[[nodiscard]] static std::string Send(const size_t id, const std::string &pipeName = DefaultPipeName())
+		{
+			const std::string line = std::to_string(id) + "\n";
+			auto errText = [&pipeName](const std::string &s)
+			{
+				return "Error in sds::PipeProfileSelector::Send(), " + s + ": " + pipeName;
+			};
+#ifdef _WIN32
+			HANDLE pipe = CreateFileA(pipeName.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (pipe == INVALID_HANDLE_VALUE)
+				return errText("failed to open the named pipe, error " + std::to_string(GetLastError()));
+			DWORD written = 0;
+			const BOOL isWritten = WriteFile(pipe, line.data(), static_cast<DWORD>(line.size()), &written, nullptr);
+			CloseHandle(pipe);
+			if (!isWritten || written != line.size())
+				return errText("failed to write the profile id");
+#else
+			//fails rather than blocks if no selector has the fifo open
+			const int fd = open(pipeName.c_str(), O_WRONLY | O_NONBLOCK);
+			if (fd < 0)
+				return errText("failed to open the fifo, error " + std::to_string(errno));
+			const ssize_t written = write(fd, line.data(), line.size());
+			close(fd);
+			if (written != static_cast<ssize_t>(line.size()))
+				return errText("failed to write the profile id");
+#endif
+			return "";
+		}
+	private:
+#ifdef _WIN32
+		/// <summary>
+		/// Builds a security descriptor whose DACL grants the user of the process full access and no one else any,
+		/// to be freed with LocalFree().
+		/// </summary>
+		/// <returns>error message, empty string on success</returns>
+		static std::string MakeUserOnlyDescriptor(PSECURITY_DESCRIPTOR &descriptorOut)
+		{
+			HANDLE token = nullptr;
+			if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token))
+				return "failed to open the process token, error " + std::to_string(GetLastError());
+			DWORD size = 0;
+			GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+			std::vector<BYTE> user(size);
+			const BOOL isRead = size > 0 && GetTokenInformation(token, TokenUser, user.data(), size, &size);
+			const DWORD readError = GetLastError();
+			CloseHandle(token);
+			if (!isRead)
+				return "failed to read the process user, error " + std::to_string(readError);
+			LPSTR sid = nullptr;
+			if (!ConvertSidToStringSidA(reinterpret_cast<const TOKEN_USER *>(user.data())->User.Sid, &sid))
+				return "failed to format the user sid, error " + std::to_string(GetLastError());
+			//protected, so no entries are inherited, with one allow entry for the user
+			const std::string sddl = std::string("D:P(A;;GA;;;") + sid + ")";
+			LocalFree(sid);
+			if (!ConvertStringSecurityDescriptorToSecurityDescriptorA(sddl.c_str(), SDDL_REVISION_1, &descriptorOut, nullptr))
+				return "failed to build the security descriptor, error " + std::to_string(GetLastError());
+			return "";
+		}
+#endif
+		/// <summary>
+		/// Reads without blocking.
+		/// </summary>
+		/// <returns>bytes read, 0 if there is nothing to read</returns>
+		long long ReadSome(char *buffer, const size_t size)
+		{
+#ifdef _WIN32
+			//a client is accepted by polling ConnectNamedPipe, which fails with ERROR_PIPE_CONNECTED once one is,
+			//or with ERROR_NO_DATA if it has already written and closed its end, what it wrote is still read
+			if (!ConnectNamedPipe(m_pipe, nullptr))
+			{
+				const DWORD connectError = GetLastError();
+				if (connectError != ERROR_PIPE_CONNECTED && connectError != ERROR_NO_DATA)
+					return 0;
+			}
+			DWORD bytesRead = 0;
+			if (!ReadFile(m_pipe, buffer, static_cast<DWORD>(size), &bytesRead, nullptr))
+			{
+				//the client closed its end and all it wrote is read, listen for the next one, a line it did not end is dropped
+				if (GetLastError() == ERROR_BROKEN_PIPE)
+				{
+					DisconnectNamedPipe(m_pipe);
+					m_pending.clear();
+				}
+				return 0;
+			}
+			return bytesRead;
+#else
+			//0 with no writer attached, -1 with EAGAIN with a writer and nothing written
+			const ssize_t bytesRead = read(m_fd, buffer, size);
+			return bytesRead > 0 ? bytesRead : 0;
+#endif
+		}
+		static std::optional<size_t> ParseId(std::string_view text)
+		{
+			if (!text.empty() && text.back() == '\r')
+				text.remove_suffix(1);
+			size_t id = 0;
+			const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), id);
+			if (text.empty() || ec != std::errc() || ptr != text.data() + text.size())
+				return {};
+			return id;
+		}
+	};
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Radial and scaled-radial thumbstick deadzone logic, used for the DeadzoneMode values other than AXIAL.
+	/// The stick magnitude is compared squared in integer math, and the scaled-radial rescale factor is looked up
+	/// in a table built once in the constructor, so no sqrt or floating point math is done per frame.
+	/// </summary>
+	class RadialDeadzone
+	{
+	public:
+		//Table Shift is the right shift applied to a squared magnitude to get the rescale table index.
+		static constexpr int TABLE_SHIFT = 16;
+		//Scale One is the fixed point representation of a rescale factor of 1.0
+		static constexpr int SCALE_ONE = 1 << 15;
+		//Magnitude Squared Max is the largest squared magnitude a pair of SHORT thumbstick values can have.
+		static constexpr long long MAGNITUDE_SQUARED_MAX = 2LL * XinSettings::SMin * XinSettings::SMin;
+		//Table Size is the number of entries in the rescale table.
+		static constexpr size_t TABLE_SIZE = static_cast<size_t>(MAGNITUDE_SQUARED_MAX >> TABLE_SHIFT) + 1;
+		//Sector Num and Sector Den are tan(67.5 degrees) as a fraction, used for the 8-way direction sectors.
+		static constexpr long long SECTOR_NUM = 2414;
+		static constexpr long long SECTOR_DEN = 1000;
+	private:
+		DeadzoneMode m_mode;
+		int m_radius;
+		long long m_radiusSquared;
+		std::vector<std::uint16_t> m_scaleTable;
+	public:
+		/// <summary>
+		/// Ctor, the rescale table is only built for DeadzoneMode::SCALED_RADIAL
+		/// </summary>
+		/// <param name="mode">DeadzoneMode enum</param>
+		/// <param name="radius">deadzone radius, replaced with XinSettings::DEADZONE_DEFAULT if out of range</param>
+		RadialDeadzone(const DeadzoneMode mode, int radius) : m_mode(mode)
+		{
+			if (!XinSettings::IsValidDeadzoneValue(radius))
+				radius = XinSettings::DEADZONE_DEFAULT;
+			m_radius = radius;
+			m_radiusSquared = static_cast<long long>(radius) * radius;
+			if (m_mode == DeadzoneMode::SCALED_RADIAL)
+				BuildScaleTable();
+		}
+		/// <summary>
+		/// Radial deadzones use a single radius per stick, this is the larger of the two axis deadzones
+		/// in the PlayerInfo so the stick is never more sensitive than configured.
+		/// </summary>
+		static int GetRadiusFromPlayer(const PlayerInfo &player, const bool isLeftStick)
+		{
+			const int xDz = isLeftStick ? player.left_x_dz : player.right_x_dz;
+			const int yDz = isLeftStick ? player.left_y_dz : player.right_y_dz;
+			return std::max(xDz, yDz);
+		}
+		DeadzoneMode GetMode() const
+		{
+			return m_mode;
+		}
+		/// <summary>
+		/// Returns true for the radial modes, false for DeadzoneMode::AXIAL
+		/// </summary>
+		bool IsRadial() const
+		{
+			return m_mode != DeadzoneMode::AXIAL;
+		}
+		int GetRadius() const
+		{
+			return m_radius;
+		}
+		static constexpr long long MagnitudeSquared(const int x, const int y)
+		{
+			return static_cast<long long>(x) * x + static_cast<long long>(y) * y;
+		}
+		/// <summary>
+		/// Returns true if the thumbstick position is outside of the deadzone radius.
+		/// </summary>
+		bool IsBeyondDeadzone(const int x, const int y) const
+		{
+			return MagnitudeSquared(x, y) > m_radiusSquared;
+		}
+		/// <summary>
+		/// Applies the deadzone to a thumbstick position.
+		/// Inside the radius the result is (0,0), outside it is unchanged for RADIAL,
+		/// and for SCALED_RADIAL the magnitude is rescaled to run from 0 at the radius to SMax at full deflection.
+		/// </summary>
+		/// <returns>pair of x,y thumbstick values with the deadzone applied</returns>
+		[[nodiscard]] std::pair<int, int> Apply(const int x, const int y) const
+		{
+			const long long magSquared = MagnitudeSquared(x, y);
+			if (magSquared <= m_radiusSquared)
+				return { 0, 0 };
+			if (m_mode != DeadzoneMode::SCALED_RADIAL)
+				return { x, y };
+			const int factor = m_scaleTable[static_cast<size_t>(magSquared >> TABLE_SHIFT)];
+			return { ScaleComponent(x, factor), ScaleComponent(y, factor) };
+		}
+		/// <summary>
+		/// Returns true if the stick is within the 8-way sector for a direction, meaning the diagonals
+		/// report both of their directions and the near-cardinal positions report only one.
+		/// </summary>
+		/// <param name="towardDirection">axis value signed so that positive points toward the tested direction</param>
+		/// <param name="otherAxis">value of the other axis</param>
+		static bool IsWithinSector(const int towardDirection, const int otherAxis)
+		{
+			if (towardDirection <= 0)
+				return false;
+			return std::abs(static_cast<long long>(otherAxis)) * SECTOR_DEN < static_cast<long long>(towardDirection) * SECTOR_NUM;
+		}
+	private:
+		static int ScaleComponent(const int value, const int factor)
+		{
+			const int scaled = (value * factor) / SCALE_ONE;
+			return std::clamp(scaled, static_cast<int>(XinSettings::SMin), static_cast<int>(XinSettings::SMax));
+		}
+		/// <summary>
+		/// Each entry holds the fixed point factor for the midpoint of the squared magnitude range it covers,
+		/// the factor is (rescaled magnitude / magnitude) and never exceeds 1.0
+		/// </summary>
+		void BuildScaleTable()
+		{
+			const double smax = XinSettings::SMax;
+			const double radius = m_radius;
+			m_scaleTable.resize(TABLE_SIZE);
+			for (size_t i = 0; i < TABLE_SIZE; ++i)
+			{
+				const long long midpoint = (static_cast<long long>(i) << TABLE_SHIFT) + (1LL << (TABLE_SHIFT - 1));
+				const double magnitude = std::sqrt(static_cast<double>(midpoint));
+				double factor = 0.0;
+				if (magnitude > radius)
+				{
+					const double rescaled = std::min(((magnitude - radius) / (smax - radius)) * smax, smax);
+					factor = std::clamp(rescaled / magnitude, 0.0, 1.0);
+				}
+				m_scaleTable[i] = static_cast<std::uint16_t>(factor * SCALE_ONE);
+			}
+		}
+	};
+}
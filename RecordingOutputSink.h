@@ -0,0 +1,77 @@
+#pragma once
+#include "stdafx.h"
+#include "FlightRecorder.h"
+#include "OutputBackend.h"
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// In-memory OutputBackend that keeps every INPUT record it is sent.
+		/// Set with SendKey::SetOutputBackend() to capture output headless, used by the trace replay harness
+		/// and tests. Thread safe, the mapper and the mouse thread both write to it.
+		/// </summary>
+		class RecordingOutputSink : public OutputBackend
+		{
+			mutable std::mutex m_eventsMutex;
+			std::vector<INPUT> m_events;
+		protected:
+			size_t SendFrameImpl(const INPUT *inputs, const size_t count) override
+			{
+				std::lock_guard<std::mutex> l1(m_eventsMutex);
+				m_events.insert(m_events.end(), inputs, inputs + count);
+				return count;
+			}
+		public:
+			std::string GetName() const override
+			{
+				return "record";
+			}
+			/// <summary>
+			/// Returns a copy of the recorded INPUT records, in the order they were sent.
+			/// </summary>
+			[[nodiscard]] std::vector<INPUT> GetEvents() const
+			{
+				std::lock_guard<std::mutex> l1(m_eventsMutex);
+				return m_events;
+			}
+			size_t GetCount() const
+			{
+				std::lock_guard<std::mutex> l1(m_eventsMutex);
+				return m_events.size();
+			}
+			void Clear()
+			{
+				std::lock_guard<std::mutex> l1(m_eventsMutex);
+				m_events.clear();
+			}
+			/// <summary>
+			/// Returns the recorded events as lines in the FlightRecorder format without timestamps,
+			/// "KEY vk scancode flags" or "MOUSE dx dy flags"
+			/// </summary>
+			[[nodiscard]] std::vector<std::string> GetLines() const
+			{
+				std::vector<std::string> lines;
+				for (const INPUT &inp : GetEvents())
+					lines.push_back(FlightRecorder::FormatInput(inp));
+				return lines;
+			}
+			/// <summary>
+			/// Writes the lines from GetLines() to a file, for use as a golden output file.
+			/// </summary>
+			/// <returns>A std::string containing an error message if there is an error, empty string otherwise.</returns>
+			[[nodiscard]] std::string WriteToFile(const std::string &fileName) const
+			{
+				std::ofstream outFile(fileName, std::ios::out | std::ios::trunc);
+				if (!outFile)
+					return "Error in sds::Utilities::RecordingOutputSink::WriteToFile(), failed to open file: " + fileName;
+				for (const std::string &line : GetLines())
+					outFile << line << '\n';
+				if (!outFile)
+					return "Error in sds::Utilities::RecordingOutputSink::WriteToFile(), failed writing file: " + fileName;
+				return "";
+			}
+		};
+	}
+}
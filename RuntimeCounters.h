@@ -0,0 +1,126 @@
+#pragma once
+#include "stdafx.h"
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Totals of the runtime counters at one point in time.
+		/// </summary>
+		struct RuntimeStats
+		{
+			std::uint64_t polls = 0;
+			std::uint64_t pollFailures = 0;
+			std::uint64_t frames = 0;
+			std::uint64_t keysSent = 0;
+			std::uint64_t mouseMovesSent = 0;
+			std::uint64_t sendInputCalls = 0;
+			std::uint64_t sendInputQueued = 0;
+			std::uint64_t sendInputErrors = 0;
+			std::uint64_t sendInputRetries = 0;
+			std::uint64_t sendInputPersistentFailures = 0;
+			std::uint64_t outputDropped = 0;
+
+			std::string ToString() const
+			{
+				return "polls: " + std::to_string(polls) + " poll failures: " + std::to_string(pollFailures)
+					+ " frames: " + std::to_string(frames) + " keys sent: " + std::to_string(keysSent)
+					+ " mouse moves sent: " + std::to_string(mouseMovesSent) + " SendInput calls: " + std::to_string(sendInputCalls)
+					+ " queued for retry: " + std::to_string(sendInputQueued)
+					+ " SendInput errors: " + std::to_string(sendInputErrors) + " retries: " + std::to_string(sendInputRetries)
+					+ " persistent failures: " + std::to_string(sendInputPersistentFailures) + " dropped: " + std::to_string(outputDropped);
+			}
+		};
+
+		/// <summary>
+		/// Counters bumped by the hot paths: the poller, the mapper and the output.
+		/// Each thread adds to a shard of its own, on its own cache line, so the threads never write the same line.
+		/// A shard is shared only if more than COUNTER_SHARDS threads count, which is why the adds are still atomic,
+		/// but a relaxed add on a line no other thread writes never waits for the line to move between cores.
+		/// Snapshot() sums the shards, so a read may see one thread's counts slightly ahead of another's.
+		/// </summary>
+		class RuntimeCounters
+		{
+		public:
+			enum class Counter : size_t
+			{
+				POLLS,
+				POLL_FAILURES,
+				FRAMES,
+				KEYS_SENT,
+				MOUSE_MOVES_SENT,
+				SEND_INPUT_CALLS,
+				//frames the backend did not insert in full, the rest is queued for retry
+				SEND_INPUT_QUEUED,
+				//queue overflows that dropped output
+				SEND_INPUT_ERRORS,
+				SEND_INPUT_RETRIES,
+				SEND_INPUT_PERSISTENT_FAILURES,
+				OUTPUT_DROPPED,
+				COUNTER_COUNT
+			};
+		private:
+			static constexpr size_t CounterCount = static_cast<size_t>(Counter::COUNTER_COUNT);
+			struct alignas(XinSettings::CACHE_LINE_SIZE) Shard
+			{
+				std::array<std::atomic<std::uint64_t>, CounterCount> values{};
+			};
+			std::unique_ptr<Shard[]> m_shards;
+		public:
+			RuntimeCounters() : m_shards(std::make_unique<Shard[]>(XinSettings::COUNTER_SHARDS)) { }
+			RuntimeCounters(const RuntimeCounters& other) = delete;
+			RuntimeCounters(RuntimeCounters&& other) = delete;
+			RuntimeCounters& operator=(const RuntimeCounters& other) = delete;
+			RuntimeCounters& operator=(RuntimeCounters&& other) = delete;
+			~RuntimeCounters() = default;
+			/// <summary>
+			/// The process wide counters used by InputPoller and SendKey.
+			/// </summary>
+			static RuntimeCounters& Get()
+			{
+				static RuntimeCounters counters;
+				return counters;
+			}
+			void Add(const Counter counter, const std::uint64_t amount = 1)
+			{
+				m_shards[GetThreadShard()].values[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Sums the shards.
+			/// </summary>
+			RuntimeStats Snapshot() const
+			{
+				std::array<std::uint64_t, CounterCount> totals{};
+				for (size_t s = 0; s < XinSettings::COUNTER_SHARDS; s++)
+				{
+					for (size_t c = 0; c < CounterCount; c++)
+						totals[c] += m_shards[s].values[c].load(std::memory_order_relaxed);
+				}
+				RuntimeStats stats;
+				stats.polls = totals[static_cast<size_t>(Counter::POLLS)];
+				stats.pollFailures = totals[static_cast<size_t>(Counter::POLL_FAILURES)];
+				stats.frames = totals[static_cast<size_t>(Counter::FRAMES)];
+				stats.keysSent = totals[static_cast<size_t>(Counter::KEYS_SENT)];
+				stats.mouseMovesSent = totals[static_cast<size_t>(Counter::MOUSE_MOVES_SENT)];
+				stats.sendInputCalls = totals[static_cast<size_t>(Counter::SEND_INPUT_CALLS)];
+				stats.sendInputQueued = totals[static_cast<size_t>(Counter::SEND_INPUT_QUEUED)];
+				stats.sendInputErrors = totals[static_cast<size_t>(Counter::SEND_INPUT_ERRORS)];
+				stats.sendInputRetries = totals[static_cast<size_t>(Counter::SEND_INPUT_RETRIES)];
+				stats.sendInputPersistentFailures = totals[static_cast<size_t>(Counter::SEND_INPUT_PERSISTENT_FAILURES)];
+				stats.outputDropped = totals[static_cast<size_t>(Counter::OUTPUT_DROPPED)];
+				return stats;
+			}
+		private:
+			/// <summary>
+			/// Shards are handed out to threads round robin, on a thread's first count.
+			/// </summary>
+			static size_t GetThreadShard()
+			{
+				static std::atomic<size_t> nextShard{ 0 };
+				thread_local const size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % XinSettings::COUNTER_SHARDS;
+				return shard;
+			}
+		};
+	}
+}
@@ -1,5 +1,11 @@
 #pragma once
 #include "stdafx.h"
+#include "FlightRecorder.h"
+#include "RuntimeCounters.h"
+#include "OutputBackend.h"
+#include "OutputRetryQueue.h"
+#include "Win32OutputBackend.h"
+#include "UinputOutputBackend.h"
 
 namespace sds
 {
@@ -8,6 +14,8 @@ namespace sds
 		/// <summary>
 		/// Utility class for simulating input via Windows API.
 		/// SendInput is used primarily for simulating keyboard and mouse input.
+		/// The INPUT records built here are delivered by an OutputBackend, SendInput on Windows and uinput on Linux
+		/// unless another backend is set with SetOutputBackend().
 		/// The class is extremely re-usable code.
 		/// </summary>
 		class SendKey
@@ -15,6 +23,8 @@ namespace sds
 			INPUT m_keyInput = {};
 			INPUT m_mouseClickInput = {};
 			INPUT m_mouseMoveInput = {};
+			//Process wide, when set all SendKey output goes to this backend instead of the platform backend.
+			inline static std::atomic<OutputBackend*> s_outputBackend{ nullptr };
 		public:
 			/// <summary>
 			/// Default Constructor
@@ -36,6 +46,39 @@ namespace sds
 			SendKey& operator=(SendKey&& other) = delete;
 			~SendKey() = default;
 			/// <summary>
+			/// Redirects the output of every SendKey instance to another OutputBackend,
+			/// pass nullptr to restore the platform backend. The backend must outlive its use.
+			/// </summary>
+			/// <param name="backend">pointer to an OutputBackend, or nullptr</param>
+			static void SetOutputBackend(OutputBackend *backend)
+			{
+				s_outputBackend.store(backend, std::memory_order_release);
+			}
+			/// <summary>
+			/// Returns the OutputBackend currently receiving all SendKey output.
+			/// </summary>
+			static OutputBackend &GetOutputBackend()
+			{
+				OutputBackend *backend = s_outputBackend.load(std::memory_order_acquire);
+				return backend != nullptr ? *backend : GetPlatformBackend();
+			}
+			/// <summary>
+			/// Retries the output not yet inserted by the backend, if its backoff is over. Cheap when nothing is queued.
+			/// </summary>
+			static void RetryPendingOutput()
+			{
+				OutputRetryQueue::Get().Retry(GetOutputBackend());
+			}
+			/// <summary>
+			/// Waits for the output not yet inserted by the backend to be delivered, retrying it.
+			/// Called after releasing all held keys, so the key-ups are not left queued.
+			/// </summary>
+			/// <returns>true if everything queued was delivered before the timeout</returns>
+			static bool FlushOutput(const std::chrono::milliseconds timeout = std::chrono::milliseconds(XinSettings::OUTPUT_FLUSH_TIMEOUT_MILLI))
+			{
+				return OutputRetryQueue::Get().Flush(GetOutputBackend(), timeout);
+			}
+			/// <summary>
 			/// Sends mouse movement specified by X and Y number of pixels to move.
 			/// </summary>
 			/// <param name="x">number of pixels in X</param>
@@ -128,6 +171,54 @@ namespace sds
 				}
 			}
 			/// <summary>
+			/// Builds the INPUT record Send(vk, down) would send without sending it, so a sequence of input can be
+			/// built ahead of time. Mouse buttons are mouse click input, anything else is keyboard input.
+			/// </summary>
+			/// <param name="vk"> is the Virtual Keycode of the keystroke or mouse button</param>
+			/// <param name="down"> is a boolean denoting if the event is KEYDOWN or KEYUP</param>
+			[[nodiscard]] INPUT BuildInput(const int vk, const bool down) const
+			{
+				INPUT i = {};
+				memset(&i, 0, sizeof(INPUT));
+				DWORD mouseFlags = 0;
+				if (GetScanCode(vk) == 0)
+				{
+					switch (vk)
+					{
+					case VK_LBUTTON:
+						mouseFlags = down ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;
+						break;
+					case VK_RBUTTON:
+						mouseFlags = down ? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP;
+						break;
+					case VK_MBUTTON:
+						mouseFlags = down ? MOUSEEVENTF_MIDDLEDOWN : MOUSEEVENTF_MIDDLEUP;
+						break;
+					case VK_XBUTTON1:
+					case VK_XBUTTON2:
+						mouseFlags = down ? MOUSEEVENTF_XDOWN : MOUSEEVENTF_XUP;
+						break;
+					default:
+						break;
+					}
+				}
+				if (mouseFlags != 0)
+				{
+					i.type = INPUT_MOUSE;
+					i.mi.dwFlags = mouseFlags;
+					i.mi.dwExtraInfo = GetMessageExtraInfo();
+				}
+				else
+				{
+					//no mouse button, sent as a key
+					i.type = INPUT_KEYBOARD;
+					i.ki.dwFlags = (down ? 0 : KEYEVENTF_KEYUP);
+					i.ki.wVk = static_cast<WORD>(vk);
+					i.ki.dwExtraInfo = GetMessageExtraInfo();
+				}
+				return i;
+			}
+			/// <summary>
 			/// Sends a whole string of printable keyboard characters at a time, keydown or keyup.
 			/// </summary>
 			/// <param name="str"> a string of input to be sent</param>
@@ -203,12 +294,59 @@ namespace sds
 			/// <summary>
 			/// One member function calls SendInput with the eventual built INPUT struct.
 			///	This is useful for debugging or re-routing the output for logging/testing of a real-time system.
+			/// Each INPUT is recorded in the FlightRecorder, and the recorder is dumped if the backend fails to deliver them all.
+			/// The INPUT array is delivered as one frame by the current OutputBackend, and counted in the RuntimeCounters.
+			/// Records the backend does not insert are queued in the OutputRetryQueue and retried.
 			/// </summary>
 			/// <param name="inp">Pointer to first element of INPUT array.</param>
 			/// <param name="numSent">Number of elements in the array to send.</param>
-			void CallSendInput(INPUT* inp, size_t numSent) const
+			void CallSendInput(const INPUT* inp, size_t numSent) const
+			{
+				FlightRecorder::Get().RecordInput(inp, numSent);
+				const size_t numInserted = OutputRetryQueue::Get().Send(GetOutputBackend(), inp, numSent);
+				CountInputs(inp, numSent, numInserted);
+			}
+		private:
+			/// <summary>
+			/// Counts a frame in the RuntimeCounters, mouse button INPUTs count as keys.
+			/// A frame not inserted in full is queued for retry, only records dropped from the queue are errors.
+			/// </summary>
+			static void CountInputs(const INPUT *inp, const size_t numSent, const size_t numInserted)
 			{
-				SendInput(static_cast<UINT>(numSent), inp, sizeof(INPUT));
+				std::uint64_t moves = 0;
+				for (size_t i = 0; i < numSent; i++)
+				{
+					if (inp[i].type == INPUT_MOUSE && (inp[i].mi.dwFlags & MOUSEEVENTF_MOVE) != 0)
+						moves++;
+				}
+				RuntimeCounters &counters = RuntimeCounters::Get();
+				counters.Add(RuntimeCounters::Counter::SEND_INPUT_CALLS);
+				if (moves > 0)
+					counters.Add(RuntimeCounters::Counter::MOUSE_MOVES_SENT, moves);
+				if (numSent > moves)
+					counters.Add(RuntimeCounters::Counter::KEYS_SENT, numSent - moves);
+				if (numInserted != numSent)
+					counters.Add(RuntimeCounters::Counter::SEND_INPUT_QUEUED);
+			}
+			/// <summary>
+			/// The process wide backend for the platform, on Linux the uinput device is created on first use.
+			/// </summary>
+			static OutputBackend &GetPlatformBackend()
+			{
+#ifdef _WIN32
+				static Win32OutputBackend backend;
+#else
+				static UinputOutputBackend backend;
+				static const bool isOpened = []()
+				{
+					const std::string err = backend.Open();
+					if (!err.empty())
+						XErrorLogger::LogError(err);
+					return err.empty();
+				}();
+				(void)isOpened;
+#endif
+				return backend;
 			}
 		};
 	}
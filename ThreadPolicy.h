@@ -0,0 +1,212 @@
+#pragma once
+#include "stdafx.h"
+
+#ifdef _WIN32
+#include <avrt.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "avrt.lib")
+#endif
+#else
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace sds
+{
+	/// <summary>
+	/// Scheduling priority for a worker thread, mapped to the platform priority levels.
+	/// On Linux the raised levels use a lower nice value, and TIME_CRITICAL asks for SCHED_FIFO.
+	/// </summary>
+	enum class ThreadPriority : int
+	{
+		NORMAL,
+		ABOVE_NORMAL,
+		HIGHEST,
+		TIME_CRITICAL
+	};
+
+	/// <summary>
+	/// Placement and priority settings for a CPPThreadRunner worker thread, applied by the thread to itself
+	/// when it starts. Every setting is optional, and a setting the process lacks the privileges for is skipped.
+	/// </summary>
+	struct ThreadPolicy
+	{
+		//Thread name shown in debuggers and profilers, Linux truncates it to 15 characters. Empty for no name.
+		std::string name;
+		ThreadPriority priority = ThreadPriority::NORMAL;
+		//Bit mask of the CPUs the thread may run on, 0 leaves the affinity unchanged.
+		std::uint64_t affinityMask = 0;
+		//Windows MMCSS task name such as "Games" or "Pro Audio", empty for no registration. Ignored on Linux.
+		std::string mmcssTask;
+
+		/// <summary>
+		/// Policy for the InputPoller thread.
+		/// </summary>
+		static ThreadPolicy ForPoller()
+		{
+			return { "xnm-poller", ThreadPriority::ABOVE_NORMAL, 0, "" };
+		}
+		/// <summary>
+		/// Policy for the XInputBoostMouse thread.
+		/// </summary>
+		static ThreadPolicy ForMouse()
+		{
+			return { "xnm-mouse", ThreadPriority::ABOVE_NORMAL, 0, "" };
+		}
+		/// <summary>
+		/// Policy for the MouseMoveThread, the mouse timing depends on it being woken on time.
+		/// </summary>
+		static ThreadPolicy ForMouseMove()
+		{
+			return { "xnm-mousemove", ThreadPriority::HIGHEST, 0, "Games" };
+		}
+		/// <summary>
+		/// Policy for the MacroPlayer thread, macro steps are timed to below a millisecond.
+		/// </summary>
+		static ThreadPolicy ForMacro()
+		{
+			return { "xnm-macro", ThreadPriority::HIGHEST, 0, "Games" };
+		}
+	};
+
+	/// <summary>
+	/// Applies a ThreadPolicy to the calling thread for the lifetime of the object,
+	/// the MMCSS registration is reverted by the destructor.
+	/// Failures do not stop the remaining settings from being applied, they are reported by GetError().
+	/// </summary>
+	class ThreadPolicyScope
+	{
+		std::string m_error;
+#ifdef _WIN32
+		HANDLE m_mmcssHandle = nullptr;
+#endif
+	public:
+		explicit ThreadPolicyScope(const ThreadPolicy &policy)
+		{
+			if (!policy.name.empty())
+				AddError(ApplyName(policy.name));
+			if (policy.priority != ThreadPriority::NORMAL)
+				AddError(ApplyPriority(policy.priority));
+			if (policy.affinityMask != 0)
+				AddError(ApplyAffinity(policy.affinityMask));
+#ifdef _WIN32
+			if (!policy.mmcssTask.empty())
+			{
+				const std::wstring task(policy.mmcssTask.begin(), policy.mmcssTask.end());
+				DWORD taskIndex = 0;
+				m_mmcssHandle = AvSetMmThreadCharacteristicsW(task.c_str(), &taskIndex);
+				if (m_mmcssHandle == nullptr)
+					AddError("MMCSS registration failed, error " + std::to_string(GetLastError()));
+			}
+#endif
+		}
+		ThreadPolicyScope(const ThreadPolicyScope& other) = delete;
+		ThreadPolicyScope(ThreadPolicyScope&& other) = delete;
+		ThreadPolicyScope& operator=(const ThreadPolicyScope& other) = delete;
+		ThreadPolicyScope& operator=(ThreadPolicyScope&& other) = delete;
+		~ThreadPolicyScope()
+		{
+#ifdef _WIN32
+			if (m_mmcssHandle != nullptr)
+				AvRevertMmThreadCharacteristics(m_mmcssHandle);
+#endif
+		}
+		/// <summary>
+		/// Returns a description of the settings that could not be applied, empty string if all were applied.
+		/// </summary>
+		[[nodiscard]] std::string GetError() const
+		{
+			return m_error;
+		}
+		/// <summary>
+		/// True for the first call in the process only, a policy refused on an unprivileged or non-Windows host
+		/// is refused for every thread and is reported once.
+		/// </summary>
+		static bool IsFirstFailure()
+		{
+			static std::atomic<bool> isReported{ false };
+			return !isReported.exchange(true, std::memory_order_relaxed);
+		}
+	private:
+		void AddError(const std::string &err)
+		{
+			if (err.empty())
+				return;
+			m_error += (m_error.empty() ? "" : "; ") + err;
+		}
+#ifdef _WIN32
+		static std::string ApplyName(const std::string &name)
+		{
+			const std::wstring wideName(name.begin(), name.end());
+			if (FAILED(SetThreadDescription(GetCurrentThread(), wideName.c_str())))
+				return "SetThreadDescription failed";
+			return "";
+		}
+		static std::string ApplyPriority(const ThreadPriority priority)
+		{
+			int value = THREAD_PRIORITY_NORMAL;
+			switch (priority)
+			{
+			case ThreadPriority::ABOVE_NORMAL: value = THREAD_PRIORITY_ABOVE_NORMAL; break;
+			case ThreadPriority::HIGHEST: value = THREAD_PRIORITY_HIGHEST; break;
+			case ThreadPriority::TIME_CRITICAL: value = THREAD_PRIORITY_TIME_CRITICAL; break;
+			default: break;
+			}
+			if (!SetThreadPriority(GetCurrentThread(), value))
+				return "SetThreadPriority failed, error " + std::to_string(GetLastError());
+			return "";
+		}
+		static std::string ApplyAffinity(const std::uint64_t mask)
+		{
+			if (SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(mask)) == 0)
+				return "SetThreadAffinityMask failed, error " + std::to_string(GetLastError());
+			return "";
+		}
+#else
+		static std::string ApplyName(const std::string &name)
+		{
+			const int err = pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+			if (err != 0)
+				return std::string("pthread_setname_np failed: ") + std::strerror(err);
+			return "";
+		}
+		static std::string ApplyPriority(const ThreadPriority priority)
+		{
+			std::string err;
+			if (priority == ThreadPriority::TIME_CRITICAL)
+			{
+				sched_param param = {};
+				param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+				const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+				if (result == 0)
+					return "";
+				//fall back to the lowest nice value allowed
+				err = std::string("SCHED_FIFO refused: ") + std::strerror(result);
+			}
+			const int niceValue = priority == ThreadPriority::ABOVE_NORMAL ? -5 : -10;
+			//on Linux the nice value set for a thread id applies to that thread only
+			if (setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), niceValue) != 0)
+				err += (err.empty() ? "" : ", ") + std::string("setpriority refused: ") + std::strerror(errno);
+			return err;
+		}
+		static std::string ApplyAffinity(const std::uint64_t mask)
+		{
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			for (int i = 0; i < 64 && i < CPU_SETSIZE; i++)
+			{
+				if (mask & (std::uint64_t{ 1 } << i))
+					CPU_SET(i, &cpus);
+			}
+			const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+			if (err != 0)
+				return std::string("pthread_setaffinity_np failed: ") + std::strerror(err);
+			return "";
+		}
+#endif
+	};
+}
@@ -2,6 +2,7 @@
 #include "stdafx.h"
 #include "SensitivityMap.h"
 #include "MapFunctions.h"
+#include "RadialDeadzone.h"
 
 namespace sds
 {
@@ -21,6 +22,8 @@ namespace sds
 		SensitivityMap m_sensMapper;
 		std::map<int, int> m_sharedSensitivityMap;
 		const bool m_isX;
+		//Used instead of the per-axis deadzones when the PlayerInfo deadzone mode is radial.
+		RadialDeadzone m_radialDeadzone;
 		//Used to make some assertions about the settings values this class depends upon.
 		static void AssertSettings()
 		{
@@ -80,7 +83,7 @@ namespace sds
 			if (!IsInMap<int, int>(val, m_sharedSensitivityMap, rval))
 			{
 				//this should not happen, but in case it does I want a plain string telling me it did.
-				Utilities::XErrorLogger::LogError("Exception in ThumbstickToDelay::GetDelayFromThumbstickValue(int,bool): " + BAD_DELAY_MSG);
+				Utilities::XErrorLogger::LogFormat<Utilities::LogSeverity::SEVERITY_ERROR>("Exception in ThumbstickToDelay::GetDelayFromThumbstickValue(int,bool): {}", BAD_DELAY_MSG);
 				return 1;
 			}
 
@@ -109,6 +112,12 @@ namespace sds
 					|| ToFloat(val) < -ToFloat(GetDeadzoneCurrent(isX)));
 			return move;
 		}
+		//Returns true if the axis value left after applying the radial deadzone is large enough to move.
+		bool DoesAxisRequireMoveRadial(const int x, const int y) const
+		{
+			const auto [rx, ry] = m_radialDeadzone.Apply(x, y);
+			return std::abs(m_isX ? rx : ry) > XinSettings::RADIAL_AXIS_MIN;
+		}
 		//Returns the dz for the axis, or the alternate if the dz is already activated.
 		int GetDeadzoneActivated(const bool isX) const
 		{
@@ -130,7 +139,10 @@ namespace sds
 		/// <param name="player">PlayerInfo struct full of deadzone information</param>
 		/// <param name="whichStick">MouseMap enum denoting which thumbstick</param>
 		///	<param name="isX">is it for the X axis?</param>
-		ThumbstickToDelay(const int sensitivity, const PlayerInfo &player, MouseMap whichStick, const bool isX) : m_altDeadzoneMultiplier(XinSettings::ALT_DEADZONE_MULT_DEFAULT), m_isX(isX)
+		ThumbstickToDelay(const int sensitivity, const PlayerInfo &player, MouseMap whichStick, const bool isX)
+			: m_altDeadzoneMultiplier(XinSettings::ALT_DEADZONE_MULT_DEFAULT),
+			m_isX(isX),
+			m_radialDeadzone(player.deadzone_mode, RadialDeadzone::GetRadiusFromPlayer(player, whichStick == MouseMap::LEFT_STICK))
 		{
 			AssertSettings();
 			//error checking mousemap stick setting
@@ -173,6 +185,8 @@ namespace sds
 		/// </summary>
 		bool DoesAxisRequireMove(const int x, const int y)
 		{
+			if (m_radialDeadzone.IsRadial())
+				return DoesAxisRequireMoveRadial(x, y);
 			const bool xMove = IsBeyondDeadzone(x, true);
 			const bool yMove = IsBeyondDeadzone(y, false);
 			if (!xMove && !yMove)
@@ -187,9 +201,12 @@ namespace sds
 		}
 		/// <summary>
 		/// Determines if m_isX axis requires move based on alt deadzone if dz is activated.
+		/// The alt deadzone is not used with a radial deadzone mode, as the diagonals are already handled.
 		/// </summary>
 		bool DoesAxisRequireMoveAlt(const int x, const int y)
 		{
+			if (m_radialDeadzone.IsRadial())
+				return DoesAxisRequireMoveRadial(x, y);
 			if (!m_isDeadzoneActivated)
 			{
 				const bool xMove = IsBeyondDeadzone(x, true);
@@ -213,10 +230,20 @@ namespace sds
 		size_t GetDelayFromThumbstickValue(int x, int y) const
 		{
 			using namespace Utilities::MapFunctions;
-			const int xdz = GetDeadzoneActivated(true);
-			const int ydz = GetDeadzoneActivated(false);
-			x = GetRangedThumbstickValue(x, xdz);
-			y = GetRangedThumbstickValue(y, ydz);
+			if (m_radialDeadzone.IsRadial())
+			{
+				//deadzone is already removed from the values
+				const auto [rx, ry] = m_radialDeadzone.Apply(x, y);
+				x = GetRangedThumbstickValue(rx, XinSettings::DEADZONE_MIN);
+				y = GetRangedThumbstickValue(ry, XinSettings::DEADZONE_MIN);
+			}
+			else
+			{
+				const int xdz = GetDeadzoneActivated(true);
+				const int ydz = GetDeadzoneActivated(false);
+				x = GetRangedThumbstickValue(x, xdz);
+				y = GetRangedThumbstickValue(y, ydz);
+			}
 			//The transformation function applied to consider the value of both axes in the calculation.
 			auto TransformSensitivityValue = [](const int x, const int y, const bool isX)
 			{
@@ -241,7 +268,7 @@ namespace sds
 			if (!Utilities::MapFunctions::IsInMap<int, int>(keyValue, m_sharedSensitivityMap, rval))
 			{
 				//this should not happen, but in case it does I want a plain string telling me it did.
-				Utilities::XErrorLogger::LogError("Exception in ThumbstickToDelay::GetDelayFromThumbstickValue(int,int,bool): " + BAD_DELAY_MSG);
+				Utilities::XErrorLogger::LogFormat<Utilities::LogSeverity::SEVERITY_ERROR>("Exception in ThumbstickToDelay::GetDelayFromThumbstickValue(int,int,bool): {}", BAD_DELAY_MSG);
 				return 1;
 			}
 			if(rval >= XinSettings::MICROSECONDS_MIN && rval <= XinSettings::MICROSECONDS_MAX)
@@ -250,7 +277,7 @@ namespace sds
 			}
 			else
 			{
-				Utilities::XErrorLogger::LogError("ThumbstickToDelay::GetDelayFromThumbstickValue(): Failed to acquire mapped value with key: " + (std::to_string(keyValue)));
+				Utilities::XErrorLogger::LogFormat<Utilities::LogSeverity::SEVERITY_ERROR>("ThumbstickToDelay::GetDelayFromThumbstickValue(): Failed to acquire mapped value with key: {}", keyValue);
 				return XinSettings::MICROSECONDS_MAX;
 			}
 		}
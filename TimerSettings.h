@@ -0,0 +1,146 @@
+#pragma once
+#include "stdafx.h"
+#include "Clock.h"
+
+#ifdef _WIN32
+#include <timeapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "winmm.lib")
+#endif
+#endif
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// Measured sleep and wake-up behaviour of the host, the lateness is the time a sleep ended past its deadline.
+		/// </summary>
+		struct TimerCalibration
+		{
+			int samples = 0;
+			std::chrono::nanoseconds medianLateness{ 0 };
+			std::chrono::nanoseconds p99Lateness{ 0 };
+			std::chrono::nanoseconds maxLateness{ 0 };
+			//spin margin chosen from the measurement
+			std::chrono::nanoseconds spinMargin{ 0 };
+			//true if a finer system timer period was requested and granted
+			bool isHighResolution = false;
+
+			std::string ToString() const
+			{
+				using std::chrono::duration_cast;
+				using std::chrono::microseconds;
+				return "timer samples: " + std::to_string(samples) + " lateness us median: " + std::to_string(duration_cast<microseconds>(medianLateness).count())
+					+ " p99: " + std::to_string(duration_cast<microseconds>(p99Lateness).count()) + " max: " + std::to_string(duration_cast<microseconds>(maxLateness).count())
+					+ " spin margin us: " + std::to_string(duration_cast<microseconds>(spinMargin).count()) + (isHighResolution ? " high resolution" : "");
+			}
+		};
+
+		/// <summary>
+		/// Runtime timing settings of the host, the spin margin a precise wait sleeps short of its deadline by,
+		/// see DelayHighPrecision::SleepUntil(). A wait shorter than the margin is spun for, a longer one sleeps first.
+		/// The margin is XinSettings::SLEEP_SPIN_MARGIN_MICRO until Calibrate() measures the timer, at startup.
+		/// </summary>
+		class TimerSettings
+		{
+			std::atomic<std::int64_t> m_spinMarginNanos;
+			mutable std::mutex m_calibrationMutex;
+			TimerCalibration m_calibration;
+			bool m_isPeriodRequested = false;
+			TimerSettings() : m_spinMarginNanos(std::chrono::nanoseconds(std::chrono::microseconds(XinSettings::SLEEP_SPIN_MARGIN_MICRO)).count()) { }
+		public:
+			TimerSettings(const TimerSettings& other) = delete;
+			TimerSettings(TimerSettings&& other) = delete;
+			TimerSettings& operator=(const TimerSettings& other) = delete;
+			TimerSettings& operator=(TimerSettings&& other) = delete;
+			~TimerSettings()
+			{
+#ifdef _WIN32
+				if (m_isPeriodRequested)
+					timeEndPeriod(1);
+#endif
+			}
+			static TimerSettings& Get()
+			{
+				static TimerSettings settings;
+				return settings;
+			}
+			Clock::Duration GetSpinMargin() const
+			{
+				return std::chrono::nanoseconds(m_spinMarginNanos.load(std::memory_order_relaxed));
+			}
+			void SetSpinMargin(const Clock::Duration margin)
+			{
+				const std::int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(margin).count();
+				m_spinMarginNanos.store(std::clamp<std::int64_t>(nanos, 0, MaxMarginNanos()), std::memory_order_relaxed);
+			}
+			/// <summary>
+			/// Measures the lateness of short sleeps on the steady clock, and sets the spin margin to the 99th percentile,
+			/// so a precise wait wakes from its sleep before the deadline 99 times out of 100. The margin is bounded by
+			/// XinSettings::TIMER_SPIN_MARGIN_MEDIANS times the median, but not below XinSettings::SLEEP_SPIN_MARGIN_MICRO,
+			/// and by XinSettings::TIMER_SPIN_MARGIN_MAX_MICRO, so a few outliers or a coarse timer do not make every wait a spin.
+			/// Blocks for about samples * XinSettings::TIMER_CALIBRATION_SLEEP_MICRO plus the lateness.
+			/// </summary>
+			/// <param name="samples">number of sleeps measured</param>
+			/// <param name="requestHighResolution">asks for a 1 ms system timer period first, on Windows, held until exit</param>
+			/// <returns>the measurement</returns>
+			TimerCalibration Calibrate(const int samples = XinSettings::TIMER_CALIBRATION_SAMPLES, [[maybe_unused]] const bool requestHighResolution = false)
+			{
+				using namespace std::chrono;
+				std::lock_guard<std::mutex> l1(m_calibrationMutex);
+#ifdef _WIN32
+				if (requestHighResolution && !m_isPeriodRequested)
+					m_isPeriodRequested = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+				Clock &clock = Clock::GetSteady();
+				std::vector<nanoseconds> lateness;
+				lateness.reserve(static_cast<size_t>(std::max(samples, 1)));
+				for (int i = 0; i < std::max(samples, 1); i++)
+				{
+					const Clock::TimePoint deadline = clock.Now() + microseconds(XinSettings::TIMER_CALIBRATION_SLEEP_MICRO);
+					clock.SleepUntil(deadline);
+					lateness.push_back(std::max(nanoseconds::zero(), duration_cast<nanoseconds>(clock.Now() - deadline)));
+				}
+				std::sort(lateness.begin(), lateness.end());
+				TimerCalibration result;
+				result.samples = static_cast<int>(lateness.size());
+				result.medianLateness = lateness[lateness.size() / 2];
+				result.p99Lateness = Percentile(lateness, 0.99);
+				result.maxLateness = lateness.back();
+				result.isHighResolution = m_isPeriodRequested;
+				const nanoseconds medianBound = std::max<nanoseconds>(result.medianLateness * XinSettings::TIMER_SPIN_MARGIN_MEDIANS,
+					microseconds(XinSettings::SLEEP_SPIN_MARGIN_MICRO));
+				SetSpinMargin(std::min({ result.p99Lateness, medianBound, nanoseconds(microseconds(XinSettings::TIMER_SPIN_MARGIN_MAX_MICRO)) }));
+				result.spinMargin = GetSpinMargin();
+				m_calibration = result;
+				return result;
+			}
+			/// <summary>
+			/// The last calibration, samples is 0 if the timer has not been calibrated.
+			/// </summary>
+			TimerCalibration GetCalibration() const
+			{
+				std::lock_guard<std::mutex> l1(m_calibrationMutex);
+				return m_calibration;
+			}
+		private:
+			/// <summary>
+			/// Percentile of the sorted samples, interpolated between the two samples around its rank,
+			/// so the p99 of 100 samples is not simply the largest one.
+			/// </summary>
+			static std::chrono::nanoseconds Percentile(const std::vector<std::chrono::nanoseconds> &sorted, const double fraction)
+			{
+				const double rank = fraction * static_cast<double>(sorted.size() - 1);
+				const size_t below = static_cast<size_t>(rank);
+				const size_t above = std::min(below + 1, sorted.size() - 1);
+				const double weight = rank - static_cast<double>(below);
+				return sorted[below] + std::chrono::nanoseconds(std::llround(weight * static_cast<double>((sorted[above] - sorted[below]).count())));
+			}
+			static constexpr std::int64_t MaxMarginNanos()
+			{
+				return std::chrono::nanoseconds(std::chrono::microseconds(XinSettings::MICROSECONDS_MAX)).count();
+			}
+		};
+	}
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include "stdafx.h"
+#include "GamepadUser.h"
+#include "OutputBackend.h"
+#include "RecordingOutputSink.h"
+#include "Clock.h"
+
+namespace sds
+{
+	/// <summary>
+	/// Drives a GamepadUser from a recorded controller trace, sending the output to a chosen OutputBackend,
+	/// a RecordingOutputSink to capture it. The trace is the FlightRecorder dump format, only the STATE lines are used.
+	/// Replays at 1x, Nx or unthrottled speed and reports frames processed per second, output events produced and
+	/// the backend send cost, and captured output can be compared against a golden output file.
+	/// Note the mouse pipeline still runs on its own threads in real time, so mouse move output depends on
+	/// replay speed; compare with mouse moves ignored for an exact regression test at other than 1x.
+	/// The pacing follows the process wide Utilities::Clock, with a ManualClock and the REACTOR mode a paced replay
+	/// runs in simulated time, hours of trace in the time taken to process the frames.
+	/// </summary>
+	class TraceReplay
+	{
+	public:
+		//Speed value to replay as fast as the pipeline can process the frames.
+		static constexpr double UNTHROTTLED = 0.0;
+		/// <summary>
+		/// One recorded controller state and the time it was polled.
+		/// </summary>
+		struct TraceFrame
+		{
+			std::uint64_t timestampUs;
+			XINPUT_STATE state;
+		};
+		/// <summary>
+		/// Configuration applied to the GamepadUser before replaying.
+		/// </summary>
+		struct ReplayConfig
+		{
+			MapInformation mapInfo;
+			MouseMap mouseStick = MouseMap::RIGHT_STICK;
+			int mouseSensitivity = XinSettings::SENSITIVITY_DEFAULT;
+			PlayerInfo player;
+			//REACTOR keeps the keys and mouse off their own threads, for a replay on a ManualClock
+			ExecutionMode mode = ExecutionMode::THREADED;
+		};
+		struct ReplayResult
+		{
+			size_t framesProcessed = 0;
+			size_t outputEvents = 0;
+			size_t outputFailures = 0;
+			//mean time spent in OutputBackend::SendFrame()
+			double averageSendNanoseconds = 0.0;
+			std::chrono::nanoseconds elapsed{ 0 };
+			double FramesPerSecond() const
+			{
+				const double seconds = std::chrono::duration<double>(elapsed).count();
+				return seconds > 0.0 ? static_cast<double>(framesProcessed) / seconds : 0.0;
+			}
+		};
+		struct GoldenDiff
+		{
+			size_t expectedCount = 0;
+			size_t actualCount = 0;
+			size_t mismatchCount = 0;
+			//index of the first differing line, only meaningful if mismatchCount is not 0
+			size_t firstMismatchIndex = 0;
+			std::string firstExpected;
+			std::string firstActual;
+			bool IsMatch() const
+			{
+				return mismatchCount == 0;
+			}
+		};
+	private:
+		ReplayConfig m_config;
+		Utilities::OutputBackend &m_backend;
+	public:
+		TraceReplay(const ReplayConfig &config, Utilities::OutputBackend &backend) : m_config(config), m_backend(backend) { }
+		TraceReplay(const TraceReplay& other) = delete;
+		TraceReplay(TraceReplay&& other) = delete;
+		TraceReplay& operator=(const TraceReplay& other) = delete;
+		TraceReplay& operator=(TraceReplay&& other) = delete;
+		~TraceReplay() = default;
+		/// <summary>
+		/// Replays the frames through a freshly configured GamepadUser with SendKey output redirected to the backend.
+		/// The backend stats are reset first, a RecordingOutputSink is not cleared.
+		/// A zeroed state is processed after the last frame so held keys are released, and the GamepadUser
+		/// is destroyed before the redirect is removed so no output escapes to SendInput.
+		/// </summary>
+		/// <param name="frames">controller trace, in timestamp order</param>
+		/// <param name="speed">replay speed multiplier, or UNTHROTTLED</param>
+		/// <param name="errorOut">set to an error message if the configuration is rejected</param>
+		/// <returns>frames processed, output events produced and elapsed time</returns>
+		ReplayResult Replay(const std::vector<TraceFrame> &frames, const double speed, std::string &errorOut)
+		{
+			using namespace std::chrono;
+			ReplayResult result;
+			m_backend.ResetStats();
+			Utilities::SendKey::SetOutputBackend(&m_backend);
+			{
+				GamepadUser user(m_config.player, m_config.mode);
+				errorOut = ConfigureUser(user);
+				if (errorOut.empty())
+				{
+					Utilities::Clock &clock = Utilities::Clock::Get();
+					const Utilities::Clock::TimePoint startTime = clock.Now();
+					const std::uint64_t firstUs = frames.empty() ? 0 : frames.front().timestampUs;
+					for (const TraceFrame &frame : frames)
+					{
+						if (speed > UNTHROTTLED)
+						{
+							const auto offset = duration<double, std::micro>(static_cast<double>(frame.timestampUs - firstUs) / speed);
+							clock.SleepUntil(startTime + duration_cast<Utilities::Clock::Duration>(offset));
+						}
+						user.poller.ProcessState(frame.state);
+						result.framesProcessed++;
+					}
+					result.elapsed = duration_cast<nanoseconds>(clock.Now() - startTime);
+					XINPUT_STATE released = {};
+					user.poller.ProcessState(released);
+				}
+			}
+			Utilities::SendKey::SetOutputBackend(nullptr);
+			result.outputEvents = static_cast<size_t>(m_backend.GetInputCount());
+			result.outputFailures = static_cast<size_t>(m_backend.GetFailedCount());
+			result.averageSendNanoseconds = m_backend.GetAverageFrameNanoseconds();
+			return result;
+		}
+		/// <summary>
+		/// Parses a FlightRecorder STATE line, "microseconds STATE packet buttons ltrigger rtrigger lx ly rx ry"
+		/// </summary>
+		/// <returns>true if the line is a well formed STATE line</returns>
+		static bool ParseTraceLine(const std::string &line, TraceFrame &frameOut)
+		{
+			std::stringstream ss(line);
+			std::string kind;
+			unsigned long packet = 0;
+			unsigned int buttons = 0, lt = 0, rt = 0;
+			int lx = 0, ly = 0, rx = 0, ry = 0;
+			ss >> frameOut.timestampUs >> kind >> packet >> buttons >> lt >> rt >> lx >> ly >> rx >> ry;
+			if (!ss || kind != "STATE")
+				return false;
+			if (!XinSettings::IsValidThumbstickValue(lx) || !XinSettings::IsValidThumbstickValue(ly)
+				|| !XinSettings::IsValidThumbstickValue(rx) || !XinSettings::IsValidThumbstickValue(ry)
+				|| buttons > std::numeric_limits<WORD>::max() || lt > std::numeric_limits<BYTE>::max() || rt > std::numeric_limits<BYTE>::max())
+				return false;
+			frameOut.state = {};
+			frameOut.state.dwPacketNumber = static_cast<DWORD>(packet);
+			frameOut.state.Gamepad.wButtons = static_cast<WORD>(buttons);
+			frameOut.state.Gamepad.bLeftTrigger = static_cast<BYTE>(lt);
+			frameOut.state.Gamepad.bRightTrigger = static_cast<BYTE>(rt);
+			frameOut.state.Gamepad.sThumbLX = static_cast<SHORT>(lx);
+			frameOut.state.Gamepad.sThumbLY = static_cast<SHORT>(ly);
+			frameOut.state.Gamepad.sThumbRX = static_cast<SHORT>(rx);
+			frameOut.state.Gamepad.sThumbRY = static_cast<SHORT>(ry);
+			return true;
+		}
+		/// <summary>
+		/// Reads the STATE lines of a FlightRecorder dump, other lines are skipped.
+		/// </summary>
+		/// <returns>A std::string containing an error message if there is an error, empty string otherwise.</returns>
+		[[nodiscard]] static std::string ReadTrace(const std::string &fileName, std::vector<TraceFrame> &framesOut)
+		{
+			std::ifstream inFile(fileName);
+			if (!inFile)
+				return "Error in sds::TraceReplay::ReadTrace(), failed to open file: " + fileName;
+			framesOut.clear();
+			std::string line;
+			TraceFrame frame = {};
+			while (std::getline(inFile, line))
+			{
+				if (ParseTraceLine(line, frame))
+					framesOut.push_back(frame);
+			}
+			return "";
+		}
+		/// <summary>
+		/// Reads a golden output file as written by RecordingOutputSink::WriteToFile(), empty lines are skipped.
+		/// </summary>
+		/// <returns>A std::string containing an error message if there is an error, empty string otherwise.</returns>
+		[[nodiscard]] static std::string ReadGolden(const std::string &fileName, std::vector<std::string> &linesOut)
+		{
+			std::ifstream inFile(fileName);
+			if (!inFile)
+				return "Error in sds::TraceReplay::ReadGolden(), failed to open file: " + fileName;
+			linesOut.clear();
+			std::string line;
+			while (std::getline(inFile, line))
+			{
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+				if (!line.empty())
+					linesOut.push_back(line);
+			}
+			return "";
+		}
+		/// <summary>
+		/// Compares output lines line by line.
+		/// </summary>
+		/// <param name="expected">golden output lines</param>
+		/// <param name="actual">captured output lines</param>
+		/// <param name="ignoreMouseMoves">drop MOUSEEVENTF_MOVE lines from both before comparing</param>
+		[[nodiscard]] static GoldenDiff Compare(std::vector<std::string> expected, std::vector<std::string> actual, const bool ignoreMouseMoves)
+		{
+			if (ignoreMouseMoves)
+			{
+				std::erase_if(expected, IsMouseMoveLine);
+				std::erase_if(actual, IsMouseMoveLine);
+			}
+			GoldenDiff diff;
+			diff.expectedCount = expected.size();
+			diff.actualCount = actual.size();
+			const size_t longest = std::max(expected.size(), actual.size());
+			for (size_t i = 0; i < longest; i++)
+			{
+				const std::string e = i < expected.size() ? expected[i] : "";
+				const std::string a = i < actual.size() ? actual[i] : "";
+				if (e == a)
+					continue;
+				if (diff.mismatchCount == 0)
+				{
+					diff.firstMismatchIndex = i;
+					diff.firstExpected = e;
+					diff.firstActual = a;
+				}
+				diff.mismatchCount++;
+			}
+			return diff;
+		}
+		/// <summary>
+		/// Returns true for a "MOUSE dx dy flags" line with the MOUSEEVENTF_MOVE flag.
+		/// </summary>
+		static bool IsMouseMoveLine(const std::string &line)
+		{
+			std::stringstream ss(line);
+			std::string kind;
+			long dx = 0, dy = 0;
+			unsigned long flags = 0;
+			ss >> kind >> dx >> dy >> flags;
+			return ss && kind == "MOUSE" && (flags & MOUSEEVENTF_MOVE);
+		}
+	private:
+		std::string ConfigureUser(GamepadUser &user) const
+		{
+			if (!m_config.mapInfo.empty())
+			{
+				const std::string err = user.mapper.SetMapInfo(m_config.mapInfo);
+				if (!err.empty())
+					return err;
+			}
+			const std::string err = user.mouse.SetSensitivity(m_config.mouseSensitivity);
+			if (!err.empty())
+				return err;
+			user.mouse.EnableProcessing(m_config.mouseStick);
+			return "";
+		}
+	};
+}
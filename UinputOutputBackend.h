@@ -0,0 +1,223 @@
+#pragma once
+#include "stdafx.h"
+#include "OutputBackend.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/uinput.h>
+
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// OutputBackend for Linux, creates a uinput virtual keyboard and mouse and translates the INPUT records
+		/// to EV_KEY and EV_REL events. Each frame is written with a single write() call ending with one SYN_REPORT.
+		/// Needs write access to /dev/uinput, Open() must succeed before any output is delivered.
+		/// </summary>
+		class UinputOutputBackend : public OutputBackend
+		{
+		public:
+			static constexpr char DEVICE_PATH[] = "/dev/uinput";
+			static constexpr char DEVICE_NAME[] = "Xinmapper virtual input";
+			//Frame Reserve is the number of input_event records the batch buffer is sized for up front.
+			static constexpr size_t FRAME_RESERVE = 64;
+		private:
+			//Virtual keycode to evdev key code, 0 for no mapping. US layout.
+			static constexpr std::array<std::uint16_t, 256> VK_TO_KEY = []()
+			{
+				std::array<std::uint16_t, 256> t{};
+				t[VK_BACK] = KEY_BACKSPACE; t[VK_TAB] = KEY_TAB; t[VK_RETURN] = KEY_ENTER;
+				t[VK_SHIFT] = KEY_LEFTSHIFT; t[VK_CONTROL] = KEY_LEFTCTRL; t[VK_MENU] = KEY_LEFTALT;
+				t[VK_PAUSE] = KEY_PAUSE; t[VK_CAPITAL] = KEY_CAPSLOCK; t[VK_ESCAPE] = KEY_ESC; t[VK_SPACE] = KEY_SPACE;
+				t[VK_PRIOR] = KEY_PAGEUP; t[VK_NEXT] = KEY_PAGEDOWN; t[VK_END] = KEY_END; t[VK_HOME] = KEY_HOME;
+				t[VK_LEFT] = KEY_LEFT; t[VK_UP] = KEY_UP; t[VK_RIGHT] = KEY_RIGHT; t[VK_DOWN] = KEY_DOWN;
+				t[VK_SNAPSHOT] = KEY_SYSRQ; t[VK_INSERT] = KEY_INSERT; t[VK_DELETE] = KEY_DELETE;
+				constexpr std::uint16_t digits[] = { KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9 };
+				for (int i = 0; i < 10; i++)
+					t['0' + i] = digits[i];
+				constexpr std::uint16_t letters[] = { KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M,
+					KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z };
+				for (int i = 0; i < 26; i++)
+					t['A' + i] = letters[i];
+				t[VK_LWIN] = KEY_LEFTMETA; t[VK_RWIN] = KEY_RIGHTMETA; t[VK_APPS] = KEY_COMPOSE;
+				constexpr std::uint16_t numpad[] = { KEY_KP0, KEY_KP1, KEY_KP2, KEY_KP3, KEY_KP4, KEY_KP5, KEY_KP6, KEY_KP7, KEY_KP8, KEY_KP9 };
+				for (int i = 0; i < 10; i++)
+					t[VK_NUMPAD0 + i] = numpad[i];
+				t[VK_MULTIPLY] = KEY_KPASTERISK; t[VK_ADD] = KEY_KPPLUS; t[VK_SUBTRACT] = KEY_KPMINUS;
+				t[VK_DECIMAL] = KEY_KPDOT; t[VK_DIVIDE] = KEY_KPSLASH;
+				constexpr std::uint16_t functionKeys[] = { KEY_F1, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12 };
+				for (int i = 0; i < 12; i++)
+					t[VK_F1 + i] = functionKeys[i];
+				t[VK_NUMLOCK] = KEY_NUMLOCK; t[VK_SCROLL] = KEY_SCROLLLOCK;
+				t[VK_LSHIFT] = KEY_LEFTSHIFT; t[VK_RSHIFT] = KEY_RIGHTSHIFT; t[VK_LCONTROL] = KEY_LEFTCTRL;
+				t[VK_RCONTROL] = KEY_RIGHTCTRL; t[VK_LMENU] = KEY_LEFTALT; t[VK_RMENU] = KEY_RIGHTALT;
+				t[VK_OEM_1] = KEY_SEMICOLON; t[VK_OEM_PLUS] = KEY_EQUAL; t[VK_OEM_COMMA] = KEY_COMMA; t[VK_OEM_MINUS] = KEY_MINUS;
+				t[VK_OEM_PERIOD] = KEY_DOT; t[VK_OEM_2] = KEY_SLASH; t[VK_OEM_3] = KEY_GRAVE; t[VK_OEM_4] = KEY_LEFTBRACE;
+				t[VK_OEM_5] = KEY_BACKSLASH; t[VK_OEM_6] = KEY_RIGHTBRACE; t[VK_OEM_7] = KEY_APOSTROPHE;
+				return t;
+			}();
+			static constexpr std::array<std::uint16_t, 5> MOUSE_BUTTONS = { BTN_LEFT, BTN_RIGHT, BTN_MIDDLE, BTN_SIDE, BTN_EXTRA };
+			std::mutex m_writeMutex;
+			std::vector<input_event> m_batch;
+			//number of events in the batch after each record of the frame
+			std::vector<size_t> m_recordEnds;
+			int m_fd = -1;
+		public:
+			UinputOutputBackend()
+			{
+				m_batch.reserve(FRAME_RESERVE);
+				m_recordEnds.reserve(FRAME_RESERVE);
+			}
+			~UinputOutputBackend() override
+			{
+				Close();
+			}
+			std::string GetName() const override
+			{
+				return "uinput";
+			}
+			/// <summary>
+			/// Creates the virtual device.
+			/// </summary>
+			/// <returns>A std::string containing an error message if there is an error, empty string otherwise.</returns>
+			[[nodiscard]] std::string Open()
+			{
+				std::lock_guard<std::mutex> l1(m_writeMutex);
+				auto errText = [](const std::string &s)
+				{
+					return "Error in sds::Utilities::UinputOutputBackend::Open(), " + s + ": " + std::strerror(errno);
+				};
+				if (m_fd >= 0)
+					return "";
+				const int fd = open(DEVICE_PATH, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+				if (fd < 0)
+					return errText(std::string("failed to open ") + DEVICE_PATH);
+				bool isGood = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0 && ioctl(fd, UI_SET_EVBIT, EV_REL) == 0 && ioctl(fd, UI_SET_EVBIT, EV_SYN) == 0
+					&& ioctl(fd, UI_SET_RELBIT, REL_X) == 0 && ioctl(fd, UI_SET_RELBIT, REL_Y) == 0;
+				for (const std::uint16_t key : VK_TO_KEY)
+				{
+					if (key != 0)
+						isGood = isGood && ioctl(fd, UI_SET_KEYBIT, key) == 0;
+				}
+				for (const std::uint16_t button : MOUSE_BUTTONS)
+					isGood = isGood && ioctl(fd, UI_SET_KEYBIT, button) == 0;
+				uinput_setup setup = {};
+				setup.id.bustype = BUS_VIRTUAL;
+				std::strncpy(setup.name, DEVICE_NAME, UINPUT_MAX_NAME_SIZE - 1);
+				isGood = isGood && ioctl(fd, UI_DEV_SETUP, &setup) == 0 && ioctl(fd, UI_DEV_CREATE) == 0;
+				if (!isGood)
+				{
+					const std::string err = errText("failed to create the virtual device");
+					close(fd);
+					return err;
+				}
+				m_fd = fd;
+				return "";
+			}
+			bool IsOpen() const
+			{
+				return m_fd >= 0;
+			}
+			/// <summary>
+			/// Destroys the virtual device, the kernel releases any keys still held.
+			/// </summary>
+			void Close()
+			{
+				std::lock_guard<std::mutex> l1(m_writeMutex);
+				if (m_fd < 0)
+					return;
+				ioctl(m_fd, UI_DEV_DESTROY);
+				close(m_fd);
+				m_fd = -1;
+			}
+			/// <summary>
+			/// Returns the evdev key code for a virtual keycode, 0 if there is none.
+			/// </summary>
+			static std::uint16_t GetKeyFromVk(const int vk)
+			{
+				if (vk < 0 || vk >= static_cast<int>(VK_TO_KEY.size()))
+					return 0;
+				return VK_TO_KEY[static_cast<size_t>(vk)];
+			}
+		protected:
+			size_t SendFrameImpl(const INPUT *inputs, const size_t count) override
+			{
+				std::lock_guard<std::mutex> l1(m_writeMutex);
+				if (m_fd < 0)
+					return 0;
+				m_batch.clear();
+				m_recordEnds.clear();
+				for (size_t i = 0; i < count; i++)
+				{
+					//a key with no evdev code is skipped, retrying it would hold up every record queued behind it
+					if (!AppendEvents(inputs[i]))
+					{
+						CountSkipped(1);
+						XErrorLogger::LogFormat<LogSeverity::SEVERITY_WARNING>("sds::Utilities::UinputOutputBackend, no evdev key for virtual keycode {}, skipped.", inputs[i].ki.wVk);
+					}
+					m_recordEnds.push_back(m_batch.size());
+				}
+				if (m_batch.empty())
+					return count;
+				AppendEvent(EV_SYN, SYN_REPORT, 0);
+				const size_t byteCount = m_batch.size() * sizeof(input_event);
+				const ssize_t written = write(m_fd, m_batch.data(), byteCount);
+				if (written == static_cast<ssize_t>(byteCount))
+					return count;
+				if (written <= 0)
+					return 0;
+				//a short write delivered the records whose events were all written
+				const size_t eventsWritten = static_cast<size_t>(written) / sizeof(input_event);
+				return static_cast<size_t>(std::upper_bound(m_recordEnds.begin(), m_recordEnds.end(), eventsWritten) - m_recordEnds.begin());
+			}
+		private:
+			void AppendEvent(const std::uint16_t type, const std::uint16_t code, const std::int32_t value)
+			{
+				input_event ev = {};
+				ev.type = type;
+				ev.code = code;
+				ev.value = value;
+				m_batch.push_back(ev);
+			}
+			/// <summary>
+			/// Appends the events for one INPUT record to the batch.
+			/// </summary>
+			/// <returns>false if the INPUT has no translation</returns>
+			bool AppendEvents(const INPUT &inp)
+			{
+				if (inp.type == INPUT_KEYBOARD)
+				{
+					const std::uint16_t key = GetKeyFromVk(inp.ki.wVk);
+					if (key == 0)
+						return false;
+					AppendEvent(EV_KEY, key, (inp.ki.dwFlags & KEYEVENTF_KEYUP) ? 0 : 1);
+					return true;
+				}
+				const DWORD flags = inp.mi.dwFlags;
+				if (flags & MOUSEEVENTF_MOVE)
+				{
+					if (inp.mi.dx != 0)
+						AppendEvent(EV_REL, REL_X, inp.mi.dx);
+					if (inp.mi.dy != 0)
+						AppendEvent(EV_REL, REL_Y, inp.mi.dy);
+				}
+				const std::uint16_t xButton = (inp.mi.mouseData & XBUTTON2) ? BTN_EXTRA : BTN_SIDE;
+				if (flags & MOUSEEVENTF_LEFTDOWN) AppendEvent(EV_KEY, BTN_LEFT, 1);
+				if (flags & MOUSEEVENTF_LEFTUP) AppendEvent(EV_KEY, BTN_LEFT, 0);
+				if (flags & MOUSEEVENTF_RIGHTDOWN) AppendEvent(EV_KEY, BTN_RIGHT, 1);
+				if (flags & MOUSEEVENTF_RIGHTUP) AppendEvent(EV_KEY, BTN_RIGHT, 0);
+				if (flags & MOUSEEVENTF_MIDDLEDOWN) AppendEvent(EV_KEY, BTN_MIDDLE, 1);
+				if (flags & MOUSEEVENTF_MIDDLEUP) AppendEvent(EV_KEY, BTN_MIDDLE, 0);
+				if (flags & MOUSEEVENTF_XDOWN) AppendEvent(EV_KEY, xButton, 1);
+				if (flags & MOUSEEVENTF_XUP) AppendEvent(EV_KEY, xButton, 0);
+				return true;
+			}
+		};
+	}
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#include "stdafx.h"
+#include "OutputBackend.h"
+
+#ifdef _WIN32
+namespace sds
+{
+	namespace Utilities
+	{
+		/// <summary>
+		/// OutputBackend that injects the INPUT records with the Win32 SendInput function, one call per frame.
+		/// </summary>
+		class Win32OutputBackend : public OutputBackend
+		{
+		protected:
+			size_t SendFrameImpl(const INPUT *inputs, const size_t count) override
+			{
+				//SendInput does not modify the array, it is declared as taking a non-const pointer.
+				return SendInput(static_cast<UINT>(count), const_cast<INPUT*>(inputs), sizeof(INPUT));
+			}
+		public:
+			std::string GetName() const override
+			{
+				return "win32";
+			}
+		};
+	}
+}
+#endif
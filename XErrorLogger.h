@@ -1,5 +1,6 @@
 #pragma once
 #include "stdafx.h"
+#include "AsyncLogger.h"
 
 namespace sds
 {
@@ -8,16 +9,61 @@ namespace sds
 		namespace XErrorLogger
 		{
 			/// <summary>
-			/// One function called to log errors, to "cerr" at the moment.
+			/// One function called to log errors, queued to the AsyncLogger and written to "cerr" by its flush thread,
+			/// so it does not block and may be called from the worker loops. Rate limited per call site.
 			///	Can be disabled easily or redirected here.
 			/// </summary>
 			/// <param name="s"></param>
 			template<std::convertible_to<std::string_view> T>
-			inline void LogError(T s)
+			inline void LogError(const T &s, const std::source_location location = std::source_location::current())
 			{
-				std::cerr << s << std::endl;
+				AsyncLogger::Get().Log(LogSeverity::SEVERITY_ERROR, s, location);
+			}
+			/// <summary>
+			/// Logs a message with the given severity, see LogError().
+			/// </summary>
+			template<std::convertible_to<std::string_view> T>
+			inline void Log(const LogSeverity severity, const T &s, const std::source_location location = std::source_location::current())
+			{
+				AsyncLogger::Get().Log(severity, s, location);
+			}
+
+			/// <summary>
+			/// True if LogFormat() statements of the severity are compiled in, see XinSettings::LOG_COMPILED_MIN_SEVERITY.
+			/// </summary>
+			template<LogSeverity Severity>
+			constexpr bool IsCompiledIn()
+			{
+				return static_cast<int>(Severity) >= XinSettings::LOG_COMPILED_MIN_SEVERITY;
+			}
+			/// <summary>
+			/// A std::format string checked at compile time, with the call site it is written at.
+			/// </summary>
+			template<typename... Args>
+			struct FormatAt
+			{
+				std::format_string<Args...> format;
+				std::source_location location;
+				template<std::convertible_to<std::string_view> T>
+				consteval FormatAt(const T &s, const std::source_location loc = std::source_location::current()) : format(s), location(loc) { }
+			};
+			/// <summary>
+			/// Logs a std::format message. A statement below the compiled minimum severity compiles to nothing, and the
+			/// arguments are only formatted, straight into the log ring, if the message passes the runtime minimum severity
+			/// and the rate limit. Pass the values themselves, an argument built as a string is built even if nothing is logged.
+			/// </summary>
+			/// <example>LogFormat&lt;LogSeverity::SEVERITY_ERROR&gt;("Failed to acquire mapped value with key: {}", keyValue);</example>
+			template<LogSeverity Severity, typename... Args>
+			inline void LogFormat([[maybe_unused]] const FormatAt<std::type_identity_t<Args>...> fmt, [[maybe_unused]] Args&&... args)
+			{
+				if constexpr (IsCompiledIn<Severity>())
+				{
+					AsyncLogger::Get().LogWith(Severity, fmt.location, [&](char *out, const size_t capacity)
+						{
+							return static_cast<size_t>(std::format_to_n(out, static_cast<std::ptrdiff_t>(capacity), fmt.format, std::forward<Args>(args)...).size);
+						});
+				}
 			}
 		}
 	}
 }
-
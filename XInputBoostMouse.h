@@ -10,8 +10,10 @@ and finally update GamepadUser.
 #pragma once
 #include "stdafx.h"
 #include "CPPThreadRunner.h"
+#include "ConfigSnapshot.h"
 #include "MouseMoveThread.h"
 #include "ThumbstickToDelay.h"
+#include "Clock.h"
 
 namespace sds
 {
@@ -22,36 +24,50 @@ namespace sds
 	/// This class starts a running thread that is used only to process the XINPUT_STATE structure
 	/// and use those values to determine if it should move the mouse cursor, and if so how much.
 	/// Another thread calls ProcessState(XINPUT_STATE) to update the internal XINPUT_STATE struct.
+	/// In ExecutionMode::REACTOR the thread is never started, the settings and thumbstick values are read by
+	/// a MouseMoveStepper running on the reactor loop instead.
+	/// The settings are published to a ConfigStore, its own or one shared with the rest of a GamepadUser.
 	/// It also has public functions for getting and setting the sensitivity.
 	/// </summary>
 	class XInputBoostMouse : public CPPThreadRunner<int>
 	{
 	private:
-		std::atomic<MouseMap> m_stickMapInfo;
+		//set when the mouse publishes to a store of its own
+		std::unique_ptr<ConfigStore> m_ownedConfig;
+		ConfigStore &m_config;
 		std::atomic<SHORT> m_threadX, m_threadY;
-		std::atomic<int> m_mouseSensitivity;
-		sds::PlayerInfo m_localPlayerInfo;
+		MouseMoveCoalescer::Counters m_moveCounters;
+		MoveTimingStats m_moveTiming;
+		const ExecutionMode m_mode;
 	public:
 		/// <summary>
 		/// Ctor for default configuration
 		/// </summary>
-		XInputBoostMouse()
-			: CPPThreadRunner(),
-			m_stickMapInfo(MouseMap::NEITHER_STICK),
-			m_mouseSensitivity(XinSettings::SENSITIVITY_DEFAULT)
+		/// <param name="mode">REACTOR if the moves are driven by a MouseMoveStepper instead of the worker thread</param>
+		explicit XInputBoostMouse(const ExecutionMode mode = ExecutionMode::THREADED)
+			: XInputBoostMouse(sds::PlayerInfo{}, mode)
+		{
+		}
+		/// <summary>
+		/// Ctor allows setting a custom PlayerInfo
+		/// </summary>
+		XInputBoostMouse(const sds::PlayerInfo &player, const ExecutionMode mode = ExecutionMode::THREADED)
+			: CPPThreadRunner(ThreadPolicy::ForMouse()),
+			m_ownedConfig(std::make_unique<ConfigStore>(ConfigSnapshot{ player })),
+			m_config(*m_ownedConfig),
+			m_mode(mode)
 		{
 			m_threadX = 0;
 			m_threadY = 0;
 		}
 		/// <summary>
-		/// Ctor allows setting a custom PlayerInfo
+		/// Ctor for a mouse publishing its settings to a shared ConfigStore, which must outlive it.
 		/// </summary>
-		XInputBoostMouse(const sds::PlayerInfo &player)
-			: CPPThreadRunner(),
-			m_stickMapInfo(MouseMap::NEITHER_STICK),
-			m_mouseSensitivity(XinSettings::SENSITIVITY_DEFAULT)
+		XInputBoostMouse(ConfigStore &config, const ExecutionMode mode = ExecutionMode::THREADED)
+			: CPPThreadRunner(ThreadPolicy::ForMouse()),
+			m_config(config),
+			m_mode(mode)
 		{
-			m_localPlayerInfo = player;
 			m_threadX = 0;
 			m_threadY = 0;
 		}
@@ -74,16 +90,21 @@ namespace sds
 		/// <param name="info"> a MouseMap enum</param>
 		void EnableProcessing(const MouseMap info)
 		{
+			if (m_mode == ExecutionMode::REACTOR)
+			{
+				SetStickMap(info);
+				return;
+			}
 			if(this->isThreadRunning && !this->isStopRequested)
 			{
 				this->stopThread();
-				m_stickMapInfo = info;
+				SetStickMap(info);
 				this->startThread();
 			}
 			else if(this->isStopRequested)
 			{
 				this->stopThread();
-				m_stickMapInfo = info;
+				SetStickMap(info);
 				this->startThread();
 			}
 		}
@@ -92,12 +113,13 @@ namespace sds
 		/// Will start the workThread running if required.
 		/// </summary>
 		/// <param name="state"> an XINPUT_STATE </param>
-		void ProcessState(const XINPUT_STATE &state)
+		/// <param name="config"> the configuration snapshot taken for the frame </param>
+		void ProcessState(const XINPUT_STATE &state, const ConfigSnapshot &config)
 		{
-			if(m_stickMapInfo == MouseMap::NEITHER_STICK)
+			if(config.stickMap == MouseMap::NEITHER_STICK)
 				return;
 			int tsx, tsy;
-			if(m_stickMapInfo == MouseMap::RIGHT_STICK)
+			if(config.stickMap == MouseMap::RIGHT_STICK)
 			{
 				tsx = state.Gamepad.sThumbRX;
 				tsy = state.Gamepad.sThumbRY;
@@ -110,7 +132,7 @@ namespace sds
 			//Give worker thread new values.
 			m_threadX = static_cast<SHORT>(tsx);
 			m_threadY = static_cast<SHORT>(tsy);
-			if(!this->isThreadRunning)
+			if(m_mode == ExecutionMode::THREADED && !this->isThreadRunning)
 				this->startThread();
 		}
 		/// <summary>
@@ -125,9 +147,10 @@ namespace sds
 			{
 				return "Error in sds::XInputBoostMouse::SetSensitivity(), int new_sens out of range.";
 			}
-			m_mouseSensitivity = new_sens;
-			this->stopThread();
-			this->startThread();
+			const std::string err = m_config.Update([new_sens](ConfigSnapshot &c) { c.sensitivity = new_sens; });
+			if (!err.empty())
+				return err;
+			RestartWorker();
 			return "";
 		}
 		/// <summary>
@@ -136,9 +159,160 @@ namespace sds
 		/// <returns></returns>
 		int GetSensitivity() const
 		{
-			return m_mouseSensitivity;
+			return m_config.Acquire()->sensitivity;
+		}
+		/// <summary>
+		/// Setter for the window in microseconds within which mouse move deltas are merged into one event,
+		/// blocks while work thread stops and restarts. Zero sends each move as it is produced.
+		/// </summary>
+		/// <returns> returns a std::string containing an error message
+		/// if there is an error, empty string otherwise. </returns>
+		std::string SetCoalesceWindow(const int micros)
+		{
+			if (!XinSettings::IsValidCoalesceValue(micros))
+			{
+				return "Error in sds::XInputBoostMouse::SetCoalesceWindow(), int micros out of range.";
+			}
+			const std::string err = m_config.Update([micros](ConfigSnapshot &c) { c.coalesceMicros = micros; });
+			if (!err.empty())
+				return err;
+			RestartWorker();
+			return "";
+		}
+		int GetCoalesceWindow() const
+		{
+			return m_config.Acquire()->coalesceMicros;
+		}
+		/// <summary>
+		/// Setter for the fixed mouse output frame rate in frames per second, blocks while work thread stops and restarts.
+		/// Each frame sends at most one move, see MouseFrameAccumulator. Zero moves each axis on its own delay timer.
+		/// </summary>
+		/// <returns> returns a std::string containing an error message
+		/// if there is an error, empty string otherwise. </returns>
+		std::string SetFrameRate(const int hz)
+		{
+			if (!XinSettings::IsValidFrameRateValue(hz))
+			{
+				return "Error in sds::XInputBoostMouse::SetFrameRate(), int hz out of range.";
+			}
+			const std::string err = m_config.Update([hz](ConfigSnapshot &c) { c.mouseFrameRate = hz; });
+			if (!err.empty())
+				return err;
+			RestartWorker();
+			return "";
+		}
+		int GetFrameRate() const
+		{
+			return m_config.Acquire()->mouseFrameRate;
+		}
+		/// <summary>
+		/// Sets the sensitivity, the coalesce window and the stick of the mouse as one published change,
+		/// so no reader sees a mix of the old and new settings. A running worker thread picks the change up on its next pass.
+		/// </summary>
+		/// <returns> returns a std::string containing an error message
+		/// if there is an error, empty string otherwise. </returns>
+		std::string ApplySettings(const int sensitivity, const int coalesceMicros, const MouseMap stickMap)
+		{
+			if (sensitivity < XinSettings::SENSITIVITY_MIN || sensitivity > XinSettings::SENSITIVITY_MAX)
+			{
+				return "Error in sds::XInputBoostMouse::ApplySettings(), int sensitivity out of range.";
+			}
+			if (!XinSettings::IsValidCoalesceValue(coalesceMicros))
+			{
+				return "Error in sds::XInputBoostMouse::ApplySettings(), int coalesceMicros out of range.";
+			}
+			return m_config.Update([sensitivity, coalesceMicros, stickMap](ConfigSnapshot &c)
+				{
+					c.sensitivity = sensitivity;
+					c.coalesceMicros = coalesceMicros;
+					c.stickMap = stickMap;
+				});
+		}
+		/// <summary>
+		/// Counts of the mouse moves suppressed, merged and sent, accumulated over the life of the object.
+		/// </summary>
+		const MouseMoveCoalescer::Counters &GetMoveCounters() const
+		{
+			return m_moveCounters;
+		}
+		/// <summary>
+		/// Counters to add to when the moves are sent outside the worker thread, by a MouseMoveStepper.
+		/// </summary>
+		MouseMoveCoalescer::Counters &GetMoveCounters()
+		{
+			return m_moveCounters;
+		}
+		/// <summary>
+		/// Requested versus actual intervals between the mouse moves, accumulated over the life of the object.
+		/// </summary>
+		const MoveTimingStats &GetMoveTiming() const
+		{
+			return m_moveTiming;
+		}
+		/// <summary>
+		/// Timing to record to when the moves are sent outside the worker thread, by a MouseMoveStepper.
+		/// </summary>
+		MoveTimingStats &GetMoveTiming()
+		{
+			return m_moveTiming;
+		}
+		ExecutionMode GetExecutionMode() const
+		{
+			return m_mode;
+		}
+		MouseMap GetStickMap() const
+		{
+			return m_config.Acquire()->stickMap;
+		}
+		PlayerInfo GetPlayerInfo() const
+		{
+			return m_config.Acquire()->player;
+		}
+		/// <summary>
+		/// Returns the current configuration snapshot, read the settings of a frame from one snapshot.
+		/// </summary>
+		std::shared_ptr<const ConfigSnapshot> GetConfig() const
+		{
+			return m_config.Acquire();
+		}
+		/// <summary>
+		/// The store the settings are published to.
+		/// </summary>
+		ConfigStore &GetConfigStore() const
+		{
+			return m_config;
+		}
+		/// <summary>
+		/// Returns the values of the mouse thumbstick from the last processed state.
+		/// </summary>
+		std::pair<SHORT, SHORT> GetStickValues() const
+		{
+			return { m_threadX, m_threadY };
+		}
+		/// <summary>
+		/// Changes whenever a setting changes, so a MouseMoveStepper knows to rebuild.
+		/// </summary>
+		std::uint64_t GetSettingsVersion() const
+		{
+			return m_config.GetVersion();
 		}
 	private:
+		void SetStickMap(const MouseMap info)
+		{
+			const std::string err = m_config.Update([info](ConfigSnapshot &c) { c.stickMap = info; });
+			if (!err.empty())
+				Utilities::XErrorLogger::LogError(err);
+		}
+		/// <summary>
+		/// Restarts the worker thread so it picks up changed settings, in REACTOR mode the new settings version is enough.
+		/// </summary>
+		void RestartWorker()
+		{
+			if (m_mode == ExecutionMode::REACTOR)
+				return;
+			this->stopThread();
+			this->startThread();
+		}
 		/// <summary>
 		/// Worker thread, private visibility, gets updated data from ProcessState() function to use.
 		/// Accesses the std::atomic m_threadX and m_threadY members.
@@ -146,23 +320,46 @@ namespace sds
 		void workThread() override
 		{
 			this->isThreadRunning = true;
-			ThumbstickToDelay xThread(this->GetSensitivity(), m_localPlayerInfo, m_stickMapInfo, true);
-			ThumbstickToDelay yThread(this->GetSensitivity(), m_localPlayerInfo, m_stickMapInfo, false);
-			MouseMoveThread mover;
+			//the version is read before the snapshot, so a change published in between only causes an extra rebuild
+			std::uint64_t version = m_config.GetVersion();
+			std::shared_ptr<const ConfigSnapshot> config = m_config.Acquire();
+			std::optional<ThumbstickToDelay> xThread;
+			std::optional<ThumbstickToDelay> yThread;
+			std::optional<MouseMoveThread> mover;
+			xThread.emplace(config->sensitivity, config->player, config->stickMap, true);
+			yThread.emplace(config->sensitivity, config->player, config->stickMap, false);
+			mover.emplace(std::chrono::microseconds(config->coalesceMicros), config->mouseFrameRate, m_moveCounters, m_moveTiming);
 			//thread main loop
 			while (!isStopRequested)
 			{
+				//settings published since the last pass, by this mouse or another writer of a shared store
+				if (m_config.GetVersion() != version)
+				{
+					version = m_config.GetVersion();
+					const std::shared_ptr<const ConfigSnapshot> changed = m_config.Acquire();
+					xThread.reset();
+					yThread.reset();
+					xThread.emplace(changed->sensitivity, changed->player, changed->stickMap, true);
+					yThread.emplace(changed->sensitivity, changed->player, changed->stickMap, false);
+					//the mover thread takes its window and frame rate at construction, replaced only when they change
+					if (changed->coalesceMicros != config->coalesceMicros || changed->mouseFrameRate != config->mouseFrameRate)
+					{
+						mover.reset();
+						mover.emplace(std::chrono::microseconds(changed->coalesceMicros), changed->mouseFrameRate, m_moveCounters, m_moveTiming);
+					}
+					config = changed;
+				}
 				//store the returned delay from axisthread for each axis
 				//then pass the delays on to MouseMoveThread, along with some information like
 				//is X or Y negative, and if the axis is moving
 				const SHORT tx = m_threadX;
 				const SHORT ty = m_threadY;
-				const size_t xDelay = xThread.GetDelayFromThumbstickValue(tx, ty);
-				const size_t yDelay = yThread.GetDelayFromThumbstickValue(tx, ty);
+				const size_t xDelay = xThread->GetDelayFromThumbstickValue(tx, ty);
+				const size_t yDelay = yThread->GetDelayFromThumbstickValue(tx, ty);
 				const bool ixp = tx > 0;
 				const bool iyp = ty > 0;
-				mover.UpdateState(xDelay, yDelay, ixp, iyp, xThread.DoesAxisRequireMoveAlt(tx, ty), yThread.DoesAxisRequireMoveAlt(tx, ty));
-				std::this_thread::sleep_for(std::chrono::milliseconds(XinSettings::THREAD_DELAY_POLLER));
+				mover->UpdateState(xDelay, yDelay, ixp, iyp, xThread->DoesAxisRequireMoveAlt(tx, ty), yThread->DoesAxisRequireMoveAlt(tx, ty));
+				Utilities::Clock::Get().SleepFor(std::chrono::milliseconds(XinSettings::THREAD_DELAY_POLLER));
 			}
 			//mark thread status as not running.
 			isThreadRunning = false;
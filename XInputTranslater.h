@@ -5,6 +5,7 @@ an XINPUT_STATE for consumption by the rest of the code.
 #pragma once
 #include "stdafx.h"
 #include "ButtonStateDown.h"
+#include "ConfigSnapshot.h"
 
 namespace sds
 {
@@ -18,11 +19,13 @@ namespace sds
 	/// </summary>
 	class XInputTranslater
 	{
-		//Utility class with functions that test button/thumbstick/trigger for depressed or "down" status
-		ButtonStateDown m_bsd;
+		//Utility class with functions that test button/thumbstick/trigger for depressed or "down" status,
+		//built from the deadzones of the configuration snapshot with version m_configVersion
+		std::optional<ButtonStateDown> m_bsd;
+		std::uint64_t m_configVersion = 0;
 	public:
-		XInputTranslater() = default;
-		XInputTranslater(const sds::PlayerInfo &player) : m_bsd(player)	{ }
+		XInputTranslater() : XInputTranslater(sds::PlayerInfo{}) { }
+		XInputTranslater(const sds::PlayerInfo &player) { m_bsd.emplace(player); }
 		XInputTranslater(const XInputTranslater& other) = delete;
 		XInputTranslater(XInputTranslater&& other) = delete;
 		XInputTranslater& operator=(const XInputTranslater& other) = delete;
@@ -33,65 +36,51 @@ namespace sds
 		/// of the controller, as in what buttons are depressed, what values the thumbsticks are at.
 		/// </summary>
 		/// <param name="state">state obj retrieved from XInputGetState()</param>
+		/// <param name="config">the configuration snapshot taken for the frame, a new version rebuilds the deadzone tests</param>
 		/// <returns>ActionDetails string with the information of which buttons are depressed, 
 		/// which thumbsticks and their direction values. Whitespace delimited.
 		/// This might look like: "X B LTRIGGER RTRIGGER LTHUMB:UP RTHUMB:DOWN"</returns>
-		[[nodiscard]] ActionDetails ProcessState(const XINPUT_STATE &state) const
+		[[nodiscard]] ActionDetails ProcessState(const XINPUT_STATE &state, const ConfigSnapshot &config)
 		{
+			if (config.version != m_configVersion)
+			{
+				m_bsd.emplace(config.player);
+				m_configVersion = config.version;
+			}
+			const ButtonStateDown &bsd = *m_bsd;
 			ActionDetails details;
 			//Buttons
-			for(auto it = sds::sdsActionDescriptors.xin_buttons.cbegin(); it != sds::sdsActionDescriptors.xin_buttons.cend(); ++it)
+			for (const auto &[token, mask] : sds::sdsActionDescriptors.xin_buttons)
 			{
-				if( m_bsd.ButtonDown(state,it->first ) ) 
+				if( bsd.ButtonDown(state, token) )
 				{
-					details += it->first + sds::sdsActionDescriptors.delimiter;
+					details += token;
+					details += sds::sdsActionDescriptors.delimiter;
 				}
 			}
 			//Triggers
-			if( m_bsd.TriggerDown(state,sds::sdsActionDescriptors.lTrigger) )
-			{
-				details += sds::sdsActionDescriptors.lTrigger + sds::sdsActionDescriptors.delimiter;
-			}
-			if( m_bsd.TriggerDown(state,sds::sdsActionDescriptors.rTrigger) )
-			{
-				details += sds::sdsActionDescriptors.rTrigger + sds::sdsActionDescriptors.delimiter;
-			}
-			//Thumbsticks
-			std::string thumb = sds::sdsActionDescriptors.lThumb + sds::sdsActionDescriptors.moreInfo;
-			//lThumb
-			if( m_bsd.ThumbstickDown(state,thumb + sds::sdsActionDescriptors.up) )
-			{
-				details += thumb + sds::sdsActionDescriptors.up + sds::sdsActionDescriptors.delimiter;
-			}
-			if( m_bsd.ThumbstickDown(state,thumb + sds::sdsActionDescriptors.down) )
-			{
-				details += thumb + sds::sdsActionDescriptors.down + sds::sdsActionDescriptors.delimiter;
-			}
-			if( m_bsd.ThumbstickDown(state, thumb + sds::sdsActionDescriptors.left) )
-			{
-				details += thumb + sds::sdsActionDescriptors.left + sds::sdsActionDescriptors.delimiter;
-			}
-			if( m_bsd.ThumbstickDown(state, thumb + sds::sdsActionDescriptors.right) )
-			{
-				details += thumb + sds::sdsActionDescriptors.right + sds::sdsActionDescriptors.delimiter;
-			}
-			//rThumb
-			thumb = sds::sdsActionDescriptors.rThumb + sds::sdsActionDescriptors.moreInfo;
-			if( m_bsd.ThumbstickDown(state,thumb + sds::sdsActionDescriptors.up) )
+			for (const std::string_view trigger : { sds::sdsActionDescriptors.lTrigger, sds::sdsActionDescriptors.rTrigger })
 			{
-				details += thumb + sds::sdsActionDescriptors.up + sds::sdsActionDescriptors.delimiter;
-			}
-			if( m_bsd.ThumbstickDown(state,thumb + sds::sdsActionDescriptors.down) )
-			{
-				details += thumb + sds::sdsActionDescriptors.down + sds::sdsActionDescriptors.delimiter;
-			}
-			if( m_bsd.ThumbstickDown(state, thumb + sds::sdsActionDescriptors.left) )
-			{
-				details += thumb + sds::sdsActionDescriptors.left + sds::sdsActionDescriptors.delimiter;
+				if( bsd.TriggerDown(state, trigger) )
+				{
+					details += trigger;
+					details += sds::sdsActionDescriptors.delimiter;
+				}
 			}
-			if( m_bsd.ThumbstickDown(state, thumb + sds::sdsActionDescriptors.right) )
+			//Thumbsticks, lThumb then rThumb
+			for (const std::string_view thumbstick : { sds::sdsActionDescriptors.lThumb, sds::sdsActionDescriptors.rThumb })
 			{
-				details += thumb + sds::sdsActionDescriptors.right + sds::sdsActionDescriptors.delimiter;
+				for (const std::string_view direction : { sds::sdsActionDescriptors.up, sds::sdsActionDescriptors.down, sds::sdsActionDescriptors.left, sds::sdsActionDescriptors.right })
+				{
+					std::string thumb(thumbstick);
+					thumb += sds::sdsActionDescriptors.moreInfo;
+					thumb += direction;
+					if( bsd.ThumbstickDown(state, thumb) )
+					{
+						details += thumb;
+						details += sds::sdsActionDescriptors.delimiter;
+					}
+				}
 			}
 			return details;
 		}
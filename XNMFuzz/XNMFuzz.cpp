@@ -0,0 +1,39 @@
+// XNMFuzz.cpp : libFuzzer target for the MapInformation parser, built with /fsanitize=fuzzer (clang: -fsanitize=fuzzer).
+//Run with a directory of maps as the corpus, e.g. XNMFuzz.exe corpus\ -max_len=4096
+#include "..\stdafx.h"
+#include "..\Mapper.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, const size_t size)
+{
+	using namespace sds;
+	const std::string_view map(reinterpret_cast<const char *>(data), size);
+	std::vector<MapParser::Token> tokens;
+	MapParser::Position errorAt;
+	const std::string err = MapParser::Parse(map, tokens, errorAt);
+	if (!err.empty())
+	{
+		//the position of an error is always inside the map, or just past its end
+		if (errorAt.column == 0 || errorAt.column > map.size() + 1 || errorAt.tokenIndex != tokens.size())
+			std::abort();
+		return 0;
+	}
+	//the tokens view the map, in order, with four non-empty fields
+	const char *previousEnd = map.data();
+	for (const MapParser::Token &token : tokens)
+	{
+		if (token.text.data() < previousEnd || token.text.data() + token.text.size() > map.data() + map.size())
+			std::abort();
+		if (token.column != static_cast<size_t>(token.text.data() - map.data()) + 1)
+			std::abort();
+		if (token.control.empty() || token.info.empty() || token.simType.empty() || token.value.empty())
+			std::abort();
+		previousEnd = token.text.data() + token.text.size();
+	}
+	//a map the parser accepts is only rejected by the chord and macro checks made after parsing
+	static Mapper mapper;
+	const bool hasChordOrMacro = std::any_of(tokens.begin(), tokens.end(),
+		[](const MapParser::Token &t) { return t.isChord || t.simType == sdsActionDescriptors.macro; });
+	if (!mapper.SetMapInfo(std::string(map)).empty() && !hasChordOrMacro)
+		std::abort();
+	return 0;
+}
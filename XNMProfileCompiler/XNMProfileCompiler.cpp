@@ -0,0 +1,32 @@
+// XNMProfileCompiler.cpp : Compiles text profiles into the binary format loaded by sds::CompiledProfile.
+//The text format is described in CompiledProfile.h
+#include "..\stdafx.h"
+#include "..\CompiledProfile.h"
+
+int main(int argc, char* argv[])
+{
+	using namespace sds;
+	auto errInfo = [](const std::string e, const int retVal)
+	{
+		std::cerr << e << std::endl;
+		return retVal;
+	};
+	const std::string usage = "Usage: XNMProfileCompiler <text profile> <compiled profile> [<text profile> <compiled profile> ...]";
+	if (argc < 3 || (argc % 2) == 0)
+		return errInfo(usage, 1);
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const std::string textFile = argv[i];
+		const std::string binaryFile = argv[i + 1];
+		std::string err = CompiledProfile::CompileFile(textFile, binaryFile);
+		if (!err.empty())
+			return errInfo("Failed to compile " + textFile + "\n" + err, 2);
+		//load it back the way the app does, so a profile that is written is known to load
+		CompiledProfile profile;
+		err = profile.Load(binaryFile);
+		if (!err.empty())
+			return errInfo("Failed to load " + binaryFile + "\n" + err, 3);
+		std::cout << textFile << " -> " << binaryFile << ", bindings: " << profile.GetBindingCount() << std::endl;
+	}
+	return 0;
+}
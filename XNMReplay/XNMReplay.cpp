@@ -0,0 +1,107 @@
+// XNMReplay.cpp : Replays a recorded controller trace through GamepadUser without sending any real input.
+//The trace file is a flight recorder dump, see sds::Utilities::FlightRecorder::DumpToFile()
+#include "..\stdafx.h"
+#include "..\TraceReplay.h"
+#include "..\CountingOutputBackend.h"
+
+int main(int argc, char* argv[])
+{
+	using namespace sds;
+	auto errInfo = [](const std::string e, const int retVal)
+	{
+		std::cerr << e << std::endl;
+		return retVal;
+	};
+	const std::string usage = "Usage: XNMReplay <trace file> [-speed N | -unthrottled] [-backend record|null|platform] [-golden file] [-write-golden file] [-ignore-mouse-moves]";
+	if (argc < 2)
+		return errInfo(usage, 1);
+	const std::string traceFile = argv[1];
+	double speed = 1.0;
+	std::string goldenFile;
+	std::string writeGoldenFile;
+	bool ignoreMouseMoves = false;
+	std::string backendName = "record";
+	for (int i = 2; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = (i + 1) < argc;
+		if (arg == "-speed" && hasValue)
+			speed = std::atof(argv[++i]);
+		else if (arg == "-unthrottled")
+			speed = TraceReplay::UNTHROTTLED;
+		else if (arg == "-golden" && hasValue)
+			goldenFile = argv[++i];
+		else if (arg == "-write-golden" && hasValue)
+			writeGoldenFile = argv[++i];
+		else if (arg == "-backend" && hasValue)
+			backendName = argv[++i];
+		else if (arg == "-ignore-mouse-moves")
+			ignoreMouseMoves = true;
+		else
+			return errInfo(usage, 1);
+	}
+	if (speed < 0.0)
+		return errInfo("Speed must not be negative.", 1);
+	if (backendName != "record" && backendName != "null" && backendName != "platform")
+		return errInfo(usage, 1);
+	if (backendName != "record" && !(goldenFile.empty() && writeGoldenFile.empty()))
+		return errInfo("Golden output needs the record backend.", 1);
+
+	std::vector<TraceReplay::TraceFrame> frames;
+	std::string err = TraceReplay::ReadTrace(traceFile, frames);
+	if (!err.empty())
+		return errInfo(err, 2);
+
+	//Same configuration as Xinmapper_2022.cpp
+	TraceReplay::ReplayConfig config;
+	config.mapInfo = "LTHUMB:LEFT:NORM:a LTHUMB:RIGHT:NORM:d LTHUMB:UP:NORM:w LTHUMB:DOWN:NORM:s X:NONE:NORM:r A:NONE:NORM:VK32 Y:NONE:NORM:VK164 B:NONE:NORM:VK160";
+	config.mapInfo += " LSHOULDER:NONE:NORM:v RSHOULDER:NONE:NORM:Q LTHUMB:NONE:NORM:c RTHUMB:NONE:NORM:e START:NONE:NORM:VK27 BACK:NONE:NORM:VK8 LTRIGGER:NONE:NORM:VK2";
+	config.mapInfo += " RTRIGGER:NONE:NORM:VK1 DPAD:UP:NORM:VK33 DPAD:LEFT:NORM:VK37 dpad:down:norm:vk32 DPAD:RIGHT:NORM:VK39";
+	config.mouseStick = MouseMap::RIGHT_STICK;
+	config.mouseSensitivity = 65;
+
+	Utilities::RecordingOutputSink sink;
+	Utilities::CountingOutputBackend nullBackend;
+	Utilities::OutputBackend *backend = &sink;
+	if (backendName == "null")
+		backend = &nullBackend;
+	else if (backendName == "platform")
+		backend = &Utilities::SendKey::GetOutputBackend();
+	TraceReplay replay(config, *backend);
+	const TraceReplay::ReplayResult result = replay.Replay(frames, speed, err);
+	if (!err.empty())
+		return errInfo(err, 2);
+
+	std::cout << "Frames processed: " << result.framesProcessed << std::endl;
+	std::cout << "Elapsed: " << std::chrono::duration<double, std::milli>(result.elapsed).count() << " ms" << std::endl;
+	std::cout << "Frames per second: " << result.FramesPerSecond() << std::endl;
+	std::cout << "Output backend: " << backend->GetName() << std::endl;
+	std::cout << "Output events: " << result.outputEvents << " Failed: " << result.outputFailures << std::endl;
+	std::cout << "Average send time: " << result.averageSendNanoseconds << " ns" << std::endl;
+
+	if (!writeGoldenFile.empty())
+	{
+		err = sink.WriteToFile(writeGoldenFile);
+		if (!err.empty())
+			return errInfo(err, 2);
+		std::cout << "Golden output written to: " << writeGoldenFile << std::endl;
+	}
+	if (!goldenFile.empty())
+	{
+		std::vector<std::string> expected;
+		err = TraceReplay::ReadGolden(goldenFile, expected);
+		if (!err.empty())
+			return errInfo(err, 2);
+		const TraceReplay::GoldenDiff diff = TraceReplay::Compare(expected, sink.GetLines(), ignoreMouseMoves);
+		std::cout << "Golden lines: " << diff.expectedCount << " Actual lines: " << diff.actualCount << std::endl;
+		if (!diff.IsMatch())
+		{
+			std::cout << "Mismatched lines: " << diff.mismatchCount << std::endl;
+			std::cout << "First mismatch at line " << (diff.firstMismatchIndex + 1)
+				<< "\n expected: " << diff.firstExpected << "\n actual:   " << diff.firstActual << std::endl;
+			return 3;
+		}
+		std::cout << "Output matches golden." << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\ActionDescriptors.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestActionDescriptors)
+	{
+		static std::string ToLower(const std::string_view s)
+		{
+			std::string lower(s);
+			std::for_each(lower.begin(), lower.end(), [](char &c) { c = static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+			return lower;
+		}
+	public:
+		TEST_METHOD(TestKeywordLookup)
+		{
+			Logger::WriteMessage("Begin TestKeywordLookup()");
+			using sds::Keyword;
+			using sds::KeywordField;
+			namespace KeywordTable = sds::KeywordTable;
+			//every keyword finds itself in any case, and is in the field list it belongs to
+			for (size_t i = 0; i < KeywordTable::KEYWORD_COUNT; i++)
+			{
+				const Keyword keyword = static_cast<Keyword>(i);
+				const std::string_view text = KeywordTable::GetText(keyword);
+				Assert::IsTrue(KeywordTable::Find(text) == keyword);
+				Assert::IsTrue(KeywordTable::Find(ToLower(text)) == keyword);
+				const KeywordField field = KeywordTable::GetField(keyword);
+				Assert::IsTrue(sds::ActionDescriptors::FindKeyword(field, ToLower(text)) == text);
+				Assert::IsTrue(sds::ActionDescriptors::FindKeyword(field == KeywordField::CONTROL ? KeywordField::SIM_TYPE : KeywordField::CONTROL, text).empty());
+			}
+			const sds::ActionDescriptors &ad = sds::sdsActionDescriptors;
+			Assert::IsTrue(std::ranges::all_of(ad.FirstFieldValidKeywords, [](const std::string_view k) { return KeywordTable::GetField(KeywordTable::Find(k)) == KeywordField::CONTROL; }));
+			Assert::IsTrue(std::ranges::all_of(ad.SecondFieldValidKeywords, [](const std::string_view k) { return KeywordTable::GetField(KeywordTable::Find(k)) == KeywordField::DIRECTION; }));
+			Assert::IsTrue(std::ranges::all_of(ad.ThirdFieldValidKeywords, [](const std::string_view k) { return KeywordTable::GetField(KeywordTable::Find(k)) == KeywordField::SIM_TYPE; }));
+			//near misses are not keywords
+			for (const std::string_view s : { "", "L", "LTHUMBS", "THUMB", "VK", "VK65", "NORMAL", "DPAD:UP", "LTHUMB ", "M4CRO" })
+				Assert::IsTrue(KeywordTable::Find(s) == Keyword::UNKNOWN);
+			std::string fixed;
+			Assert::IsTrue(ad.IsFirstFieldKeyword("lShoulder", fixed));
+			Assert::IsTrue(fixed == "LSHOULDER");
+			Assert::IsFalse(ad.IsSecondFieldKeyword("lShoulder", fixed));
+			Assert::IsTrue(fixed == "LSHOULDER");
+			Assert::AreEqual(XINPUT_GAMEPAD_DPAD_UP, ad.GetButtonMask("DPAD:UP"));
+			Assert::AreEqual(0, ad.GetButtonMask("LTRIGGER"));
+			Logger::WriteMessage("End TestKeywordLookup()");
+		}
+		TEST_METHOD(TestKeywordLookupCost)
+		{
+			Logger::WriteMessage("Begin TestKeywordLookupCost()");
+			using namespace std::chrono;
+			constexpr int Repeats = 200000;
+			//the words of a map, the last of each field list is the worst case for a search of the list
+			const std::array<std::string, 8> words = { "a", "Rtrigger", "back", "BACK", "none", "macro", "LTHUMBS", "q" };
+			const std::vector<std::string> firstField(sds::sdsActionDescriptors.FirstFieldValidKeywords.begin(), sds::sdsActionDescriptors.FirstFieldValidKeywords.end());
+			size_t found = 0;
+			const auto linearStart = steady_clock::now();
+			for (int i = 0; i < Repeats; i++)
+			{
+				const std::string &word = words[i % words.size()];
+				found += std::find_if(firstField.cbegin(), firstField.cend(), [&word](const std::string &k) { return sds::ActionDescriptors::IsKeywordNoCase(word, k); }) != firstField.cend();
+			}
+			const double linearNanos = duration<double, std::nano>(steady_clock::now() - linearStart).count() / Repeats;
+			const auto hashStart = steady_clock::now();
+			for (int i = 0; i < Repeats; i++)
+				found += !sds::ActionDescriptors::FindKeyword(sds::KeywordField::CONTROL, words[i % words.size()]).empty();
+			const double hashNanos = duration<double, std::nano>(steady_clock::now() - hashStart).count() / Repeats;
+			Assert::AreEqual(static_cast<size_t>(Repeats), found);
+			const std::string msg = "ns per first field keyword lookup, linear search: " + std::to_string(linearNanos) + " perfect hash: " + std::to_string(hashNanos)
+				+ " (hash seed " + std::to_string(sds::KeywordTable::SEED) + ")";
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestKeywordLookupCost()");
+		}
+	};
+}
@@ -0,0 +1,252 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\AsyncLogger.h"
+#include "..\ThumbstickToDelay.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	/// <summary>
+	/// A LogFormat() argument counting the times it is formatted.
+	/// </summary>
+	struct FormatCounted
+	{
+		int *formats;
+	};
+}
+
+template<>
+struct std::formatter<XNMTest::FormatCounted> : std::formatter<std::string_view>
+{
+	template<typename FormatContext>
+	auto format(const XNMTest::FormatCounted &arg, FormatContext &ctx) const
+	{
+		(*arg.formats)++;
+		return std::formatter<std::string_view>::format("counted", ctx);
+	}
+};
+
+namespace XNMTest
+{
+	TEST_CLASS(TestAsyncLogger)
+	{
+		/// <summary>
+		/// Replaces the console sink of a logger with another for the life of the guard, so a failed assert
+		/// does not leave the process wide logger writing to a destroyed sink.
+		/// </summary>
+		class SinkSwap
+		{
+			sds::Utilities::AsyncLogger &m_logger;
+			sds::Utilities::LogSink &m_sink;
+		public:
+			SinkSwap(sds::Utilities::AsyncLogger &logger, sds::Utilities::LogSink &sink) : m_logger(logger), m_sink(sink)
+			{
+				m_logger.RemoveSink(m_logger.GetConsoleSink());
+				m_logger.AddSink(&m_sink);
+			}
+			SinkSwap(const SinkSwap& other) = delete;
+			SinkSwap(SinkSwap&& other) = delete;
+			SinkSwap& operator=(const SinkSwap& other) = delete;
+			SinkSwap& operator=(SinkSwap&& other) = delete;
+			~SinkSwap()
+			{
+				m_logger.Flush();
+				m_logger.RemoveSink(&m_sink);
+				m_logger.AddSink(m_logger.GetConsoleSink());
+			}
+		};
+	public:
+		TEST_METHOD(TestSinksAndSeverity)
+		{
+			Logger::WriteMessage("Begin TestSinksAndSeverity()");
+			using sds::Utilities::LogSeverity;
+			const std::string fileName = "xnm_async_logger_test.txt";
+			std::remove(fileName.c_str());
+			sds::Utilities::MemoryLogSink memory;
+			sds::Utilities::FileLogSink file;
+			Assert::IsTrue(file.Open(fileName).empty());
+			{
+				sds::Utilities::AsyncLogger logger;
+				logger.RemoveSink(logger.GetConsoleSink());
+				logger.AddSink(&memory);
+				logger.AddSink(&file);
+				Assert::IsFalse(logger.Log(LogSeverity::SEVERITY_DEBUG, "hidden"));
+				Assert::IsTrue(logger.Log(LogSeverity::SEVERITY_INFO, "info"));
+				Assert::IsTrue(logger.Log(LogSeverity::SEVERITY_WARNING, "warning"));
+				Assert::IsTrue(logger.Log(LogSeverity::SEVERITY_ERROR, std::string(1000, 'e')));
+				logger.SetMinSeverity(LogSeverity::SEVERITY_DEBUG);
+				Assert::IsTrue(logger.Log(LogSeverity::SEVERITY_DEBUG, "shown"));
+				logger.Flush();
+				const std::vector<sds::Utilities::LogRecord> records = memory.GetRecords();
+				Assert::AreEqual(size_t{ 4 }, records.size());
+				Assert::IsTrue(records[0].Format() == "[INFO] info");
+				Assert::IsTrue(records[1].Format() == "[WARNING] warning");
+				Assert::AreEqual(sds::XinSettings::LOG_MESSAGE_MAX, records[2].GetText().size());
+				Assert::IsTrue(records[3].Format() == "[DEBUG] shown");
+				//the records still queued are written by the dtor
+				Assert::IsTrue(logger.Log(LogSeverity::SEVERITY_INFO, "last"));
+			}
+			Assert::AreEqual(size_t{ 5 }, memory.GetRecords().size());
+			std::ifstream inFile(fileName);
+			std::vector<std::string> lines;
+			for (std::string line; std::getline(inFile, line); )
+				lines.push_back(line);
+			inFile.close();
+			std::remove(fileName.c_str());
+			Assert::AreEqual(size_t{ 5 }, lines.size());
+			Assert::IsTrue(lines[1] == "[WARNING] warning");
+			Assert::IsTrue(lines[4] == "[INFO] last");
+			Logger::WriteMessage("End TestSinksAndSeverity()");
+		}
+		TEST_METHOD(TestRateLimit)
+		{
+			Logger::WriteMessage("Begin TestRateLimit()");
+			using namespace std::chrono;
+			using sds::Utilities::LogSeverity;
+			constexpr int Repeats = 100000;
+			sds::Utilities::MemoryLogSink memory;
+			sds::Utilities::AsyncLogger logger;
+			logger.RemoveSink(logger.GetConsoleSink());
+			logger.AddSink(&memory);
+			//one call site logging from a hot loop
+			const auto logFromLoop = [&logger](const int i)
+			{
+				return logger.Log(LogSeverity::SEVERITY_ERROR, "bad value " + std::to_string(i));
+			};
+			const auto start = steady_clock::now();
+			for (int i = 0; i < Repeats; i++)
+				logFromLoop(i);
+			const double nanosPerCall = duration<double, std::nano>(steady_clock::now() - start).count() / Repeats;
+			//another call site is not limited by it
+			Assert::IsTrue(logger.Log(LogSeverity::SEVERITY_ERROR, "other site"));
+			logger.Flush();
+			std::vector<sds::Utilities::LogRecord> records = memory.GetRecords();
+			Assert::AreEqual(static_cast<size_t>(sds::XinSettings::LOG_RATE_LIMIT_PER_SITE) + 1, records.size());
+			Assert::IsTrue(records.back().GetText() == "other site");
+			Assert::AreEqual(std::uint64_t{ Repeats - sds::XinSettings::LOG_RATE_LIMIT_PER_SITE }, logger.GetStats().suppressed);
+			//the next window lets the site log again, with the count of the messages suppressed
+			std::this_thread::sleep_for(milliseconds(sds::XinSettings::LOG_RATE_WINDOW_MILLI + 50));
+			Assert::IsTrue(logFromLoop(Repeats));
+			logger.Flush();
+			records = memory.GetRecords();
+			Assert::AreEqual(static_cast<std::uint32_t>(Repeats - sds::XinSettings::LOG_RATE_LIMIT_PER_SITE), records.back().suppressed);
+			Logger::WriteMessage(records.back().Format().c_str());
+			const std::string msg = "ns per rate limited log call: " + std::to_string(nanosPerCall);
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestRateLimit()");
+		}
+		TEST_METHOD(TestManyProducers)
+		{
+			Logger::WriteMessage("Begin TestManyProducers()");
+			using sds::Utilities::LogSeverity;
+			using namespace std::chrono;
+			constexpr int ThreadCount = 4;
+			constexpr int PerThread = 20000;
+			//together the threads log a quarter of the ring per burst, the ring is half full after two unless the flush thread woke
+			constexpr int BurstSize = static_cast<int>(sds::XinSettings::LOG_RING_CAPACITY) / (4 * ThreadCount);
+			sds::Utilities::MemoryLogSink memory;
+			sds::Utilities::AsyncLogger logger;
+			logger.RemoveSink(logger.GetConsoleSink());
+			logger.AddSink(&memory);
+			logger.SetRateLimit(0);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < ThreadCount; t++)
+			{
+				threads.emplace_back([&logger, t]()
+					{
+						for (int i = 0; i < PerThread; i++)
+						{
+							logger.Log(LogSeverity::SEVERITY_INFO, std::to_string(t) + " " + std::to_string(i));
+							if ((i + 1) % BurstSize == 0)
+								std::this_thread::sleep_for(milliseconds(1));
+						}
+					});
+			}
+			for (std::thread &t : threads)
+				t.join();
+			logger.Flush();
+			//every message is written or counted as dropped, and each thread's are written in order
+			const std::vector<sds::Utilities::LogRecord> records = memory.GetRecords();
+			const sds::Utilities::AsyncLogger::Stats stats = logger.GetStats();
+			Assert::AreEqual(std::uint64_t{ ThreadCount * PerThread }, records.size() + stats.dropped);
+			Assert::AreEqual(static_cast<std::uint64_t>(records.size()), stats.logged);
+			std::array<int, ThreadCount> lastIndex;
+			lastIndex.fill(-1);
+			for (const sds::Utilities::LogRecord &record : records)
+			{
+				std::istringstream fields{ std::string(record.GetText()) };
+				int t = 0;
+				int i = 0;
+				fields >> t >> i;
+				Assert::IsTrue(t >= 0 && t < ThreadCount);
+				Assert::IsTrue(i > lastIndex[t]);
+				lastIndex[t] = i;
+			}
+			const std::string msg = "Written: " + std::to_string(records.size()) + " dropped: " + std::to_string(stats.dropped);
+			Logger::WriteMessage(msg.c_str());
+			//the bursts are drained well before the flush interval, so few are dropped
+			Assert::IsTrue(stats.dropped * 10 <= std::uint64_t{ ThreadCount * PerThread });
+			Logger::WriteMessage("End TestManyProducers()");
+		}
+		TEST_METHOD(TestLazyFormat)
+		{
+			Logger::WriteMessage("Begin TestLazyFormat()");
+			using namespace std::chrono;
+			using sds::Utilities::LogSeverity;
+			namespace XErrorLogger = sds::Utilities::XErrorLogger;
+			constexpr int Repeats = 1000000;
+			//a message not logged is never written
+			sds::Utilities::AsyncLogger local;
+			local.RemoveSink(local.GetConsoleSink());
+			local.SetMinSeverity(LogSeverity::SEVERITY_WARNING);
+			int writes = 0;
+			const auto countingWriter = [&writes](char *, size_t) { writes++; return size_t{ 0 }; };
+			Assert::IsFalse(local.LogWith(LogSeverity::SEVERITY_INFO, std::source_location::current(), countingWriter));
+			Assert::AreEqual(0, writes);
+			Assert::IsTrue(local.LogWith(LogSeverity::SEVERITY_WARNING, std::source_location::current(), countingWriter));
+			Assert::AreEqual(1, writes);
+			//formatted into the ring of the process wide logger
+			sds::Utilities::AsyncLogger &logger = sds::Utilities::AsyncLogger::Get();
+			sds::Utilities::MemoryLogSink memory;
+			const SinkSwap swap(logger, memory);
+			XErrorLogger::LogFormat<LogSeverity::SEVERITY_ERROR>("key {} of {}", 42, "map");
+			//an argument is formatted only if its message is logged
+			int formats = 0;
+			const FormatCounted counted{ &formats };
+			XErrorLogger::LogFormat<LogSeverity::SEVERITY_DEBUG>("value: {}", counted);
+			Assert::AreEqual(0, formats);
+			XErrorLogger::LogFormat<LogSeverity::SEVERITY_ERROR>("value: {}", counted);
+			Assert::AreEqual(1, formats);
+			logger.Flush();
+			const std::vector<sds::Utilities::LogRecord> records = memory.GetRecords();
+			Assert::AreEqual(size_t{ 2 }, records.size());
+			Assert::IsTrue(records[0].GetText() == "key 42 of map");
+			Assert::IsTrue(records[1].GetText() == "value: counted");
+			//cost of a debug statement, a string built eagerly for a disabled message against a lazy one, reported only
+			std::uint64_t sum = 0;
+			auto timeLoop = [](const auto &body)
+			{
+				const auto start = steady_clock::now();
+				for (int i = 0; i < Repeats; i++)
+					body(i);
+				return duration<double, std::nano>(steady_clock::now() - start).count() / Repeats;
+			};
+			const double eagerNanos = timeLoop([&logger](const int i) { logger.Log(LogSeverity::SEVERITY_DEBUG, "value: " + std::to_string(i)); });
+			const double lazyNanos = timeLoop([](const int i) { XErrorLogger::LogFormat<LogSeverity::SEVERITY_DEBUG>("value: {}", i); });
+			//the hot path logging on error only
+			sds::PlayerInfo pl;
+			const sds::ThumbstickToDelay delay(sds::XinSettings::SENSITIVITY_DEFAULT, pl, sds::MouseMap::RIGHT_STICK, true);
+			const double delayNanos = timeLoop([&delay, &sum](const int i) { sum += delay.GetDelayFromThumbstickValue(i % 32767, i % 16384); });
+			logger.Flush();
+			Assert::AreEqual(size_t{ 2 }, memory.GetRecords().size());
+			const std::string msg = "ns per disabled debug statement, eager string: " + std::to_string(eagerNanos) + " lazy format: " + std::to_string(lazyNanos)
+				+ (XErrorLogger::IsCompiledIn<LogSeverity::SEVERITY_DEBUG>() ? " (compiled in)" : " (compiled out)")
+				+ ", ns per GetDelayFromThumbstickValue(): " + std::to_string(delayNanos) + " " + std::to_string(sum % 10);
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestLazyFormat()");
+		}
+	};
+}
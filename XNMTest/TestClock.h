@@ -0,0 +1,202 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\Clock.h"
+#include "..\DelayManager.h"
+#include "..\DelayHighPrecision.h"
+#include "..\GamepadUser.h"
+#include "..\OutputBackend.h"
+#include "..\TraceReplay.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	/// <summary>
+	/// OutputBackend that keeps each record it receives with the process wide Clock time it was sent at.
+	/// </summary>
+	class ClockStampBackend : public sds::Utilities::OutputBackend
+	{
+	public:
+		struct Stamped
+		{
+			sds::Utilities::Clock::TimePoint at;
+			INPUT input;
+		};
+	private:
+		mutable std::mutex m_mutex;
+		std::vector<Stamped> m_records;
+	protected:
+		size_t SendFrameImpl(const INPUT *inputs, const size_t count) override
+		{
+			const sds::Utilities::Clock::TimePoint now = sds::Utilities::Clock::Get().Now();
+			std::lock_guard<std::mutex> l1(m_mutex);
+			for (size_t i = 0; i < count; i++)
+				m_records.push_back({ now, inputs[i] });
+			return count;
+		}
+	public:
+		std::string GetName() const override
+		{
+			return "clockstamp";
+		}
+		[[nodiscard]] std::vector<Stamped> GetRecords() const
+		{
+			std::lock_guard<std::mutex> l1(m_mutex);
+			return m_records;
+		}
+	};
+
+	TEST_CLASS(TestClock)
+	{
+	public:
+		TEST_METHOD(TestManualClock)
+		{
+			Logger::WriteMessage("Begin TestManualClock()");
+			using namespace std::chrono;
+			using sds::Utilities::Clock;
+			sds::Utilities::ManualClock clock;
+			const Clock::TimePoint start = clock.Now();
+			//a DelayManager on the clock fires only once the time has passed its duration
+			sds::DelayManager delay(1000, clock);
+			clock.Advance(microseconds(1000));
+			Assert::IsFalse(delay());
+			clock.Advance(microseconds(1));
+			Assert::IsTrue(delay());
+			Assert::IsTrue(delay.HasFired());
+			delay.Reset(500);
+			Assert::IsFalse(delay.HasFired());
+			//sleeping and spinning fast-forward it by exactly the delay, the past is never returned to
+			clock.SleepFor(milliseconds(5));
+			sds::Utilities::DelayHighPrecision::SleepFor(microseconds(250), clock);
+			Assert::IsTrue(clock.Now() - start == microseconds(6251));
+			clock.AdvanceTo(start);
+			clock.SleepUntil(start + milliseconds(1));
+			Assert::IsTrue(clock.Now() - start == microseconds(6251));
+			Assert::IsTrue(delay());
+			//the process wide clock is the steady clock unless replaced
+			Assert::IsTrue(&Clock::Get() == &Clock::GetSteady());
+			Clock::SetClock(&clock);
+			Assert::IsTrue(&Clock::Get() == &clock);
+			Assert::IsTrue(sds::DelayManager(0)() == false);
+			Clock::SetClock(nullptr);
+			Assert::IsTrue(&Clock::Get() == &Clock::GetSteady());
+			Logger::WriteMessage("End TestManualClock()");
+		}
+		TEST_METHOD(TestSimulatedReactor)
+		{
+			Logger::WriteMessage("Begin TestSimulatedReactor()");
+			using namespace std::chrono;
+			using sds::Utilities::Clock;
+			//a minute of the stick and A held, the time of every key and mouse move checked exactly
+			sds::Utilities::ManualClock clock;
+			ClockStampBackend backend;
+			Clock::SetClock(&clock);
+			sds::Utilities::SendKey::SetOutputBackend(&backend);
+			const Clock::TimePoint start = clock.Now();
+			std::atomic<bool> isPastEnd{ false };
+			size_t moveDelay = 0;
+			milliseconds heldFor(60000);
+			const auto wallStart = steady_clock::now();
+			{
+				sds::GamepadUser user(sds::ExecutionMode::REACTOR);
+				Assert::IsTrue(user.mapper.SetMapInfo("A:NONE:NORM:VK32").empty());
+				Assert::IsTrue(user.mouse.SetSensitivity(65).empty());
+				Assert::IsTrue(user.mouse.SetCoalesceWindow(0).empty());
+				user.mouse.EnableProcessing(sds::MouseMap::RIGHT_STICK);
+				const std::shared_ptr<const sds::ConfigSnapshot> config = user.mouse.GetConfig();
+				const sds::ThumbstickToDelay xAxis(config->sensitivity, config->player, config->stickMap, true);
+				moveDelay = xAxis.GetDelayFromThumbstickValue(std::numeric_limits<SHORT>::max(), 0);
+				//released on a poll that is not also the time of a move
+				while (duration_cast<microseconds>(heldFor).count() % static_cast<long long>(moveDelay) == 0)
+					heldFor += milliseconds(1);
+				user.poller.SetStateSource([&](DWORD, XINPUT_STATE *state)
+					{
+						memset(state, 0, sizeof(XINPUT_STATE));
+						const Clock::TimePoint now = clock.Now();
+						if (now - start < heldFor)
+						{
+							state->Gamepad.wButtons = XINPUT_GAMEPAD_A;
+							state->Gamepad.sThumbRX = std::numeric_limits<SHORT>::max();
+						}
+						else if (now - start > heldFor + milliseconds(10))
+						{
+							isPastEnd = true;
+						}
+						return static_cast<DWORD>(ERROR_SUCCESS);
+					});
+				Assert::IsTrue(user.poller.Start());
+				while (!isPastEnd)
+					std::this_thread::sleep_for(milliseconds(1));
+				user.poller.Stop();
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Clock::SetClock(nullptr);
+			const double wallMillis = duration<double, std::milli>(steady_clock::now() - wallStart).count();
+			std::vector<Clock::TimePoint> keyTimes;
+			std::vector<Clock::TimePoint> moveTimes;
+			for (const ClockStampBackend::Stamped &r : backend.GetRecords())
+				(r.input.type == INPUT_KEYBOARD ? keyTimes : moveTimes).push_back(r.at);
+			Assert::AreEqual(size_t{ 2 }, keyTimes.size());
+			Assert::IsTrue(keyTimes[0] == start);
+			Assert::IsTrue(keyTimes[1] == start + heldFor);
+			const long long heldMicros = duration_cast<microseconds>(heldFor).count();
+			const size_t expectedMoves = static_cast<size_t>(heldMicros / static_cast<long long>(moveDelay) + 1);
+			Assert::AreEqual(expectedMoves, moveTimes.size());
+			for (size_t i = 0; i < moveTimes.size(); i++)
+				Assert::IsTrue(moveTimes[i] == start + microseconds(moveDelay * i));
+			const std::string msg = "Simulated " + std::to_string(heldFor.count()) + " ms of reactor mode in " + std::to_string(wallMillis)
+				+ " ms, moves: " + std::to_string(moveTimes.size()) + " every " + std::to_string(moveDelay) + " us";
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestSimulatedReactor()");
+		}
+		TEST_METHOD(TestSimulatedReplay)
+		{
+			Logger::WriteMessage("Begin TestSimulatedReplay()");
+			using namespace std::chrono;
+			using sds::Utilities::Clock;
+			//two hours of trace, A pressed for half of each second, replayed at 1x in simulated time
+			constexpr std::uint64_t FrameMicros = 250000;
+			constexpr std::uint64_t TraceMicros = 2ull * 60 * 60 * 1000000;
+			std::vector<sds::TraceReplay::TraceFrame> frames;
+			for (std::uint64_t t = 0; t < TraceMicros; t += FrameMicros)
+			{
+				sds::TraceReplay::TraceFrame frame{ t, {} };
+				frame.state.dwPacketNumber = static_cast<DWORD>(frames.size());
+				frame.state.Gamepad.wButtons = (t % 1000000) < 500000 ? XINPUT_GAMEPAD_A : 0;
+				frames.push_back(frame);
+			}
+			frames.push_back({ TraceMicros, {} });
+			sds::TraceReplay::ReplayConfig config;
+			config.mapInfo = "A:NONE:NORM:VK32";
+			config.mouseStick = sds::MouseMap::NEITHER_STICK;
+			config.mode = sds::ExecutionMode::REACTOR;
+			sds::Utilities::ManualClock clock;
+			ClockStampBackend backend;
+			Clock::SetClock(&clock);
+			const Clock::TimePoint start = clock.Now();
+			sds::TraceReplay replay(config, backend);
+			std::string err;
+			const auto wallStart = steady_clock::now();
+			const sds::TraceReplay::ReplayResult result = replay.Replay(frames, 1.0, err);
+			const double wallMillis = duration<double, std::milli>(steady_clock::now() - wallStart).count();
+			Clock::SetClock(nullptr);
+			Assert::IsTrue(err.empty());
+			Assert::AreEqual(frames.size(), result.framesProcessed);
+			Assert::IsTrue(result.elapsed == microseconds(TraceMicros));
+			//a key down at the start of each second and a key up half a second later
+			const std::vector<ClockStampBackend::Stamped> records = backend.GetRecords();
+			Assert::AreEqual(static_cast<size_t>(TraceMicros / 1000000 * 2), records.size());
+			for (size_t i = 0; i < records.size(); i++)
+			{
+				const bool isUp = (records[i].input.ki.dwFlags & KEYEVENTF_KEYUP) != 0;
+				Assert::AreEqual(i % 2 == 1, isUp);
+				Assert::IsTrue(records[i].at == start + microseconds(i * 500000));
+			}
+			const std::string msg = "Replayed " + std::to_string(TraceMicros / 1000000) + " s of trace at 1x in " + std::to_string(wallMillis) + " ms";
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestSimulatedReplay()");
+		}
+	};
+}
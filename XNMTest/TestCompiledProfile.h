@@ -0,0 +1,149 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\CompiledProfile.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestCompiledProfile)
+	{
+		const std::string ProfileText = "# test profile\nsensitivity=65\nmouse_stick=right\ndeadzone_mode=RADIAL\nright_x_dz=9000\n"
+			"LTHUMB:LEFT:NORM:a LTHUMB:RIGHT:NORM:d A:NONE:NORM:VK32\nLSHOULDER+!B:NONE:NORM:x X:NONE:MACRO:q,~30,e\n";
+		/// <summary>
+		/// Returns a profile with "count" bindings, the chords and keys cycle through the controls.
+		/// </summary>
+		static std::string BuildLargeProfile(const size_t count)
+		{
+			const std::vector<std::string> controls = { "A", "B", "X", "Y", "LSHOULDER", "RSHOULDER", "START", "BACK", "LTRIGGER", "RTRIGGER" };
+			std::string text = "sensitivity=50\nmouse_stick=RIGHT\n";
+			for (size_t i = 0; i < count; i++)
+			{
+				const std::string &first = controls[i % controls.size()];
+				const std::string &second = controls[(i / controls.size() + i + 1) % controls.size()];
+				text += (i % 2 == 0 ? first : first + "+" + second) + ":NONE:NORM:VK" + std::to_string(65 + i % 26) + "\n";
+			}
+			return text;
+		}
+	public:
+		TEST_METHOD(TestRoundTrip)
+		{
+			Logger::WriteMessage("Begin TestRoundTrip()");
+			std::vector<char> data;
+			Assert::IsTrue(sds::CompiledProfile::Compile(ProfileText, data).empty());
+			sds::CompiledProfile profile;
+			Assert::IsTrue(profile.LoadFromMemory(data).empty());
+			Assert::AreEqual(size_t{ 5 }, profile.GetBindingCount());
+			Assert::AreEqual(65, profile.GetSettings().sensitivity);
+			Assert::AreEqual(static_cast<int>(sds::MouseMap::RIGHT_STICK), profile.GetSettings().mouseStick);
+			sds::PlayerInfo player;
+			Assert::IsTrue(profile.ApplyTo(player).empty());
+			Assert::AreEqual(9000, player.right_x_dz);
+			Assert::IsTrue(player.deadzone_mode == sds::DeadzoneMode::RADIAL);
+			//the mouse settings are published as one change
+			sds::XInputBoostMouse mouse(sds::ExecutionMode::REACTOR);
+			const std::uint64_t version = mouse.GetSettingsVersion();
+			Assert::IsTrue(profile.ApplyTo(mouse).empty());
+			Assert::IsTrue(mouse.GetSettingsVersion() == version + 1);
+			Assert::AreEqual(65, mouse.GetSensitivity());
+			Assert::IsTrue(mouse.GetStickMap() == sds::MouseMap::RIGHT_STICK);
+			//the loaded bindings are the ones SetMapInfo compiles
+			sds::Mapper parsed;
+			sds::Mapper loaded;
+			Assert::IsTrue(parsed.SetMapInfo(profile.GetMapInfo()).empty());
+			Assert::IsTrue(profile.ApplyTo(loaded).empty());
+			const auto expected = parsed.GetBindings();
+			const auto actual = loaded.GetBindings();
+			Assert::AreEqual(expected.size(), actual.size());
+			for (size_t i = 0; i < expected.size(); i++)
+			{
+				Assert::IsTrue(expected[i].control == actual[i].control && expected[i].info == actual[i].info);
+				Assert::IsTrue(expected[i].simType == actual[i].simType && expected[i].value == actual[i].value);
+				Assert::IsTrue(expected[i].required == actual[i].required && expected[i].excluded == actual[i].excluded);
+			}
+			//and through a mapped file
+			const std::string fileName = "xnm_test_profile.bin";
+			{
+				std::ofstream outFile(fileName, std::ios::binary | std::ios::trunc);
+				outFile.write(data.data(), static_cast<std::streamsize>(data.size()));
+			}
+			sds::CompiledProfile mapped;
+			Assert::IsTrue(mapped.Load(fileName).empty());
+			Assert::AreEqual(size_t{ 5 }, mapped.GetBindingCount());
+			Assert::IsFalse(mapped.Load("xnm_missing_profile.bin").empty());
+			Assert::IsFalse(mapped.IsLoaded());
+			std::remove(fileName.c_str());
+			Logger::WriteMessage("End TestRoundTrip()");
+		}
+		TEST_METHOD(TestRejectsBadProfiles)
+		{
+			Logger::WriteMessage("Begin TestRejectsBadProfiles()");
+			std::vector<char> data;
+			Assert::IsFalse(sds::CompiledProfile::Compile("sensitivity=500\nA:NONE:NORM:a", data).empty());
+			Assert::IsFalse(sds::CompiledProfile::Compile("mouse_stick=UP\nA:NONE:NORM:a", data).empty());
+			Assert::IsFalse(sds::CompiledProfile::Compile("colour=red\nA:NONE:NORM:a", data).empty());
+			Assert::IsFalse(sds::CompiledProfile::Compile("A:NONE:NORM:zz", data).empty());
+			Assert::IsTrue(sds::CompiledProfile::Compile(ProfileText, data).empty());
+			sds::CompiledProfile profile;
+			//truncated, corrupt, and from another version
+			Assert::IsFalse(profile.LoadFromMemory(std::vector<char>(data.begin(), data.end() - 1)).empty());
+			std::vector<char> corrupt = data;
+			corrupt.back() ^= 0x20;
+			Assert::IsFalse(profile.LoadFromMemory(corrupt).empty());
+			std::vector<char> otherVersion = data;
+			otherVersion[4]++;
+			Assert::IsFalse(profile.LoadFromMemory(otherVersion).empty());
+			Assert::IsFalse(profile.LoadFromMemory(std::vector<char>(8)).empty());
+			Assert::IsFalse(profile.IsLoaded());
+			//nothing is applied from an unloaded profile
+			sds::PlayerInfo player;
+			const int rightXDeadzone = player.right_x_dz;
+			Assert::IsFalse(profile.ApplyTo(player).empty());
+			Assert::AreEqual(rightXDeadzone, player.right_x_dz);
+			Logger::WriteMessage("End TestRejectsBadProfiles()");
+		}
+		TEST_METHOD(TestStartupCost)
+		{
+			Logger::WriteMessage("Begin TestStartupCost()");
+			using namespace std::chrono;
+			constexpr int Iterations = 50;
+			const std::string text = BuildLargeProfile(300);
+			const std::string fileName = "xnm_test_large_profile.bin";
+			std::vector<char> data;
+			Assert::IsTrue(sds::CompiledProfile::Compile(text, data).empty());
+			{
+				std::ofstream outFile(fileName, std::ios::binary | std::ios::trunc);
+				outFile.write(data.data(), static_cast<std::streamsize>(data.size()));
+			}
+			//the text path parses the profile and the MapInformation string
+			const auto textStart = steady_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				sds::MapInformation map;
+				sds::CompiledProfile::Settings settings;
+				Assert::IsTrue(sds::CompiledProfile::ParseText(text, map, settings).empty());
+				sds::Mapper mp;
+				Assert::IsTrue(mp.SetMapInfo(map).empty());
+			}
+			const double textMicros = duration<double, std::micro>(steady_clock::now() - textStart).count() / Iterations;
+			//the binary path maps the file, validates it and copies the bindings into the Mapper
+			const auto binaryStart = steady_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				sds::CompiledProfile profile;
+				Assert::IsTrue(profile.Load(fileName).empty());
+				sds::Mapper mp;
+				Assert::IsTrue(profile.ApplyTo(mp).empty());
+			}
+			const double binaryMicros = duration<double, std::micro>(steady_clock::now() - binaryStart).count() / Iterations;
+			std::remove(fileName.c_str());
+			const std::string msg = "300 binding profile load, text: " + std::to_string(textMicros) + " us, compiled: "
+				+ std::to_string(binaryMicros) + " us, compiled size: " + std::to_string(data.size()) + " bytes";
+			Logger::WriteMessage(msg.c_str());
+			Assert::IsTrue(binaryMicros < textMicros);
+			Logger::WriteMessage("End TestStartupCost()");
+		}
+	};
+}
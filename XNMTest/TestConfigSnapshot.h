@@ -0,0 +1,163 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\ConfigSnapshot.h"
+#include "..\GamepadUser.h"
+#include "..\RecordingOutputSink.h"
+#include "..\CountingOutputBackend.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestConfigSnapshot)
+	{
+		/// <summary>
+		/// A snapshot with every deadzone and the sensitivity derived from one value, so a mix of two is detectable.
+		/// </summary>
+		static sds::ConfigSnapshot MakeUniform(const int value)
+		{
+			sds::ConfigSnapshot snapshot;
+			sds::PlayerInfo &p = snapshot.player;
+			p.left_x_dz = p.left_y_dz = p.right_x_dz = p.right_y_dz = value * 100;
+			p.left_trigger_dz = p.right_trigger_dz = value;
+			snapshot.sensitivity = value;
+			return snapshot;
+		}
+		static bool IsUniform(const sds::ConfigSnapshot &snapshot)
+		{
+			const sds::PlayerInfo &p = snapshot.player;
+			const int value = snapshot.sensitivity;
+			return p.left_x_dz == value * 100 && p.left_y_dz == value * 100 && p.right_x_dz == value * 100 && p.right_y_dz == value * 100
+				&& p.left_trigger_dz == value && p.right_trigger_dz == value;
+		}
+	public:
+		TEST_METHOD(TestPublishAndValidate)
+		{
+			Logger::WriteMessage("Begin TestPublishAndValidate()");
+			sds::ConfigStore store;
+			const std::shared_ptr<const sds::ConfigSnapshot> first = store.Acquire();
+			Assert::AreEqual(std::uint64_t{ 1 }, first->version);
+			Assert::IsTrue(first->Validate().empty());
+			//an invalid snapshot is not published
+			Assert::IsFalse(store.Update([](sds::ConfigSnapshot &c) { c.sensitivity = 0; }).empty());
+			Assert::IsFalse(store.Update([](sds::ConfigSnapshot &c) { c.player.left_trigger_dz = 256; }).empty());
+			Assert::IsFalse(store.Update([](sds::ConfigSnapshot &c) { c.player.player_id = sds::XinSettings::PLAYER_COUNT; }).empty());
+			Assert::AreEqual(std::uint64_t{ 1 }, store.GetVersion());
+			//a valid one replaces the current one as a whole, a snapshot held is unchanged
+			Assert::IsTrue(store.Update([](sds::ConfigSnapshot &c) { c.sensitivity = 50; c.player.right_x_dz = 9000; }).empty());
+			Assert::AreEqual(std::uint64_t{ 2 }, store.GetVersion());
+			Assert::AreEqual(50, store.Acquire()->sensitivity);
+			Assert::AreEqual(9000, store.Acquire()->player.right_x_dz);
+			Assert::AreEqual(sds::XinSettings::SENSITIVITY_DEFAULT, first->sensitivity);
+			//a store given an invalid initial snapshot starts from the defaults
+			sds::ConfigSnapshot bad;
+			bad.coalesceMicros = -1;
+			const sds::ConfigStore defaulted(bad);
+			Assert::AreEqual(sds::XinSettings::MOUSE_COALESCE_MICRO, defaulted.Acquire()->coalesceMicros);
+			Logger::WriteMessage("End TestPublishAndValidate()");
+		}
+		TEST_METHOD(TestNoTornReads)
+		{
+			Logger::WriteMessage("Begin TestNoTornReads()");
+			using namespace std::chrono;
+			constexpr int ReaderCount = 2;
+			constexpr int Publishes = 20000;
+			sds::ConfigStore store(MakeUniform(10));
+			std::atomic<bool> isDone{ false };
+			std::atomic<std::uint64_t> reads{ 0 };
+			std::atomic<std::uint64_t> torn{ 0 };
+			std::vector<std::thread> readers;
+			for (int r = 0; r < ReaderCount; r++)
+			{
+				readers.emplace_back([&]()
+					{
+						std::uint64_t lastVersion = 0;
+						while (!isDone)
+						{
+							const std::shared_ptr<const sds::ConfigSnapshot> config = store.Acquire();
+							if (!IsUniform(*config) || config->version < lastVersion)
+								torn++;
+							lastVersion = config->version;
+							reads++;
+						}
+					});
+			}
+			const auto start = steady_clock::now();
+			for (int i = 0; i < Publishes; i++)
+				Assert::IsTrue(store.Publish(MakeUniform(10 + i % 2 * 20)).empty());
+			const double nanosPerPublish = duration<double, std::nano>(steady_clock::now() - start).count() / Publishes;
+			isDone = true;
+			for (std::thread &t : readers)
+				t.join();
+			Assert::AreEqual(std::uint64_t{ 0 }, torn.load());
+			Assert::AreEqual(std::uint64_t{ Publishes + 1 }, store.GetVersion());
+			//cost of taking the snapshot of a frame
+			constexpr int Acquires = 1000000;
+			std::uint64_t sum = 0;
+			const auto acquireStart = steady_clock::now();
+			for (int i = 0; i < Acquires; i++)
+				sum += store.Acquire()->player.left_trigger_dz;
+			const double nanosPerAcquire = duration<double, std::nano>(steady_clock::now() - acquireStart).count() / Acquires;
+			const std::string msg = "Reads during publishing: " + std::to_string(reads.load()) + " ns per publish: " + std::to_string(nanosPerPublish)
+				+ " ns per acquire: " + std::to_string(nanosPerAcquire) + " " + std::to_string(sum % 10);
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestNoTornReads()");
+		}
+		TEST_METHOD(TestGamepadUserShares)
+		{
+			Logger::WriteMessage("Begin TestGamepadUserShares()");
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			{
+				sds::PlayerInfo player;
+				player.player_id = 2;
+				sds::GamepadUser user(player);
+				//the poller polls the player of the configuration
+				DWORD polledId = 0;
+				user.poller.SetStateSource([&polledId](const DWORD id, XINPUT_STATE *) { polledId = id; return static_cast<DWORD>(ERROR_SUCCESS); });
+				Assert::IsTrue(user.poller.IsControllerConnected());
+				Assert::AreEqual(static_cast<DWORD>(2), polledId);
+				Assert::IsTrue(user.mapper.SetMapInfo("LTRIGGER:NONE:NORM:VK65").empty());
+				XINPUT_STATE state = {};
+				state.Gamepad.bLeftTrigger = 100;
+				//a trigger deadzone and a mouse setting published together, seen by the translater and the mouse
+				Assert::IsTrue(user.mouse.GetConfigStore().Update([](sds::ConfigSnapshot &c) { c.player.left_trigger_dz = 200; c.sensitivity = 50; }).empty());
+				user.poller.ProcessState(state);
+				Assert::AreEqual(size_t{ 0 }, sink.GetEvents().size());
+				Assert::AreEqual(50, user.mouse.GetSensitivity());
+				Assert::IsTrue(user.mouse.GetConfigStore().Update([](sds::ConfigSnapshot &c) { c.player.left_trigger_dz = 50; }).empty());
+				user.poller.ProcessState(state);
+				Assert::AreEqual(size_t{ 1 }, sink.GetEvents().size());
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Assert::AreEqual(size_t{ 2 }, sink.GetEvents().size());
+			Logger::WriteMessage("End TestGamepadUserShares()");
+		}
+		TEST_METHOD(TestThreadedMouseReloads)
+		{
+			Logger::WriteMessage("Begin TestThreadedMouseReloads()");
+			using namespace std::chrono;
+			sds::Utilities::CountingOutputBackend backend;
+			sds::Utilities::SendKey::SetOutputBackend(&backend);
+			{
+				sds::GamepadUser user(sds::ExecutionMode::THREADED);
+				Assert::IsTrue(user.mouse.ApplySettings(65, 0, sds::MouseMap::RIGHT_STICK).empty());
+				XINPUT_STATE state = {};
+				state.Gamepad.sThumbRX = 20000;
+				user.mouse.ProcessState(state, *user.mouse.GetConfig());
+				std::this_thread::sleep_for(milliseconds(100));
+				Assert::IsTrue(backend.GetMouseMoveCount() > 0);
+				//a deadzone past the stick published to the store, without a setter of the mouse, stops the running worker's moves
+				Assert::IsTrue(user.mouse.GetConfigStore().Update([](sds::ConfigSnapshot &c) { c.player.right_x_dz = 30000; c.player.right_y_dz = 30000; }).empty());
+				std::this_thread::sleep_for(milliseconds(100));
+				const std::uint64_t stoppedAt = backend.GetMouseMoveCount();
+				std::this_thread::sleep_for(milliseconds(100));
+				Assert::AreEqual(stoppedAt, backend.GetMouseMoveCount());
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Logger::WriteMessage("End TestThreadedMouseReloads()");
+		}
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\CoroutinePipeline.h"
+#include "..\CountingOutputBackend.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestCoroutinePipeline)
+	{
+		static sds::PipelineTask Sleeper(sds::CoroutineScheduler &scheduler, std::vector<int> &order, const int id, const std::chrono::milliseconds delay)
+		{
+			co_await scheduler.SleepFor(delay);
+			order.push_back(id);
+			//parked until the stop request wakes it
+			while (!scheduler.IsStopRequested())
+				co_await scheduler.SleepFor(std::chrono::hours(1));
+			order.push_back(-id);
+		}
+		static sds::PipelineTask Stopper(sds::CoroutineScheduler &scheduler, const std::chrono::milliseconds delay)
+		{
+			co_await scheduler.SleepFor(delay);
+			scheduler.RequestStop();
+		}
+	public:
+		TEST_METHOD(TestSchedulerOrder)
+		{
+			Logger::WriteMessage("Begin TestSchedulerOrder()");
+			using namespace std::chrono;
+			std::vector<int> order;
+			sds::CoroutineScheduler scheduler;
+			scheduler.Spawn(Sleeper(scheduler, order, 2, milliseconds(20)));
+			scheduler.Spawn(Sleeper(scheduler, order, 1, milliseconds(5)));
+			scheduler.Spawn(Stopper(scheduler, milliseconds(40)));
+			Assert::AreEqual(size_t{ 3 }, scheduler.GetTaskCount());
+			scheduler.Run();
+			Assert::AreEqual(size_t{ 0 }, scheduler.GetTaskCount());
+			//woken by the stop in deadline order
+			const std::vector<int> expected = { 1, 2, -1, -2 };
+			Assert::IsTrue(order == expected);
+			Logger::WriteMessage("End TestSchedulerOrder()");
+		}
+		TEST_METHOD(TestManyPipelinesOneThread)
+		{
+			Logger::WriteMessage("Begin TestManyPipelinesOneThread()");
+			using namespace std::chrono;
+			constexpr int UserCount = 8;
+			sds::Utilities::CountingOutputBackend backend;
+			sds::Utilities::SendKey::SetOutputBackend(&backend);
+			//A and the right stick held to the right
+			const auto source = [](DWORD, XINPUT_STATE *state)
+			{
+				memset(state, 0, sizeof(XINPUT_STATE));
+				state->Gamepad.wButtons = XINPUT_GAMEPAD_A;
+				state->Gamepad.sThumbRX = std::numeric_limits<SHORT>::max();
+				return static_cast<DWORD>(ERROR_SUCCESS);
+			};
+			std::vector<std::unique_ptr<sds::GamepadUser>> users;
+			std::vector<std::unique_ptr<sds::CoroutinePipeline>> pipelines;
+			sds::CoroutineScheduler scheduler;
+			for (int i = 0; i < UserCount; i++)
+			{
+				users.push_back(std::make_unique<sds::GamepadUser>(sds::ExecutionMode::REACTOR));
+				Assert::IsTrue(users.back()->mapper.SetMapInfo("A:NONE:NORM:VK32").empty());
+				users.back()->mouse.EnableProcessing(sds::MouseMap::RIGHT_STICK);
+				pipelines.push_back(std::make_unique<sds::CoroutinePipeline>(scheduler, *users.back(), source));
+				pipelines.back()->Spawn();
+			}
+			const auto wallStart = steady_clock::now();
+			std::thread runner([&scheduler] { scheduler.Run(); });
+			std::this_thread::sleep_for(milliseconds(500));
+			scheduler.RequestStop();
+			runner.join();
+			const double wallMs = duration<double, std::milli>(steady_clock::now() - wallStart).count();
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			for (const auto &user : users)
+				Assert::IsTrue(user->mouse.GetMoveCounters().sent.load() > 0);
+			//each user pressed and released A once
+			Assert::AreEqual(static_cast<std::uint64_t>(UserCount * 2), backend.GetKeyCount());
+			const std::string msg = std::to_string(UserCount) + " pipelines on one thread for " + std::to_string(wallMs)
+				+ " ms, mouse moves sent: " + std::to_string(backend.GetMouseMoveCount());
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestManyPipelinesOneThread()");
+		}
+	};
+}
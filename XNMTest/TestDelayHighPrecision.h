@@ -0,0 +1,114 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\DelayHighPrecision.h"
+#include "..\TimerSettings.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestDelayHighPrecision)
+	{
+		//Process CPU time used so far, in seconds.
+		static double ProcessCpuSeconds()
+		{
+#ifdef _WIN32
+			FILETIME creation, exitTime, kernel, user;
+			GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user);
+			auto toSeconds = [](const FILETIME &ft) { return ((static_cast<std::uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 1e7; };
+			return toSeconds(kernel) + toSeconds(user);
+#else
+			return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+		}
+		struct WaitStats
+		{
+			double meanErrorMicros = 0.0;
+			double maxErrorMicros = 0.0;
+			double minErrorMicros = 0.0;
+			double cpuPercent = 0.0;
+		};
+		/// <summary>
+		/// Runs a wait of the delay a number of times, the error is the wake-up time past the requested end.
+		/// </summary>
+		template<typename Wait>
+		static WaitStats Measure(const std::chrono::microseconds delay, const int repeats, Wait wait)
+		{
+			using namespace std::chrono;
+			WaitStats stats;
+			stats.minErrorMicros = std::numeric_limits<double>::max();
+			const double cpuStart = ProcessCpuSeconds();
+			const auto wallStart = steady_clock::now();
+			for (int i = 0; i < repeats; i++)
+			{
+				const auto start = steady_clock::now();
+				wait(delay);
+				const double error = duration<double, std::micro>(steady_clock::now() - (start + delay)).count();
+				stats.meanErrorMicros += error / repeats;
+				stats.maxErrorMicros = std::max(stats.maxErrorMicros, error);
+				stats.minErrorMicros = std::min(stats.minErrorMicros, error);
+			}
+			stats.cpuPercent = 100.0 * (ProcessCpuSeconds() - cpuStart) / duration<double>(steady_clock::now() - wallStart).count();
+			return stats;
+		}
+	public:
+		TEST_METHOD(TestHybridVersusSpin)
+		{
+			Logger::WriteMessage("Begin TestHybridVersusSpin()");
+			using namespace std::chrono;
+			namespace Delay = sds::Utilities::DelayHighPrecision;
+			const std::array<int, 7> delays = { 100, 250, 500, 1000, 2000, 5000, 20000 };
+			for (const int micros : delays)
+			{
+				const microseconds delay(micros);
+				//about a tenth of a second of waiting per delay
+				const int repeats = std::max(5, 100000 / micros);
+				const WaitStats spin = Measure(delay, repeats, [](const microseconds d) { Delay::SpinFor(d); });
+				const WaitStats hybrid = Measure(delay, repeats, [](const microseconds d) { Delay::SleepFor(d); });
+				//neither ends early
+				Assert::IsTrue(spin.minErrorMicros >= 0.0);
+				Assert::IsTrue(hybrid.minErrorMicros >= 0.0);
+				//a wait well past the spin margin is mostly asleep
+				if (micros >= 10 * sds::XinSettings::SLEEP_SPIN_MARGIN_MICRO)
+					Assert::IsTrue(hybrid.cpuPercent < spin.cpuPercent / 2);
+				const std::string msg = std::to_string(micros) + " us, spin error mean " + std::to_string(spin.meanErrorMicros) + " max " + std::to_string(spin.maxErrorMicros)
+					+ " us cpu " + std::to_string(spin.cpuPercent) + "%, hybrid error mean " + std::to_string(hybrid.meanErrorMicros)
+					+ " max " + std::to_string(hybrid.maxErrorMicros) + " us cpu " + std::to_string(hybrid.cpuPercent) + "%";
+				Logger::WriteMessage(msg.c_str());
+			}
+			Logger::WriteMessage("End TestHybridVersusSpin()");
+		}
+		TEST_METHOD(TestTimerCalibration)
+		{
+			Logger::WriteMessage("Begin TestTimerCalibration()");
+			using namespace std::chrono;
+			using sds::Utilities::TimerSettings;
+			TimerSettings &settings = TimerSettings::Get();
+			const sds::Utilities::TimerCalibration calibration = settings.Calibrate(50);
+			Assert::AreEqual(50, calibration.samples);
+			Assert::IsTrue(calibration.medianLateness <= calibration.p99Lateness && calibration.p99Lateness <= calibration.maxLateness);
+			Assert::IsTrue(settings.GetSpinMargin() == calibration.spinMargin);
+			//the margin covers the p99 up to a few medians and the cap, never more
+			Assert::IsTrue(calibration.spinMargin <= calibration.p99Lateness);
+			Assert::IsTrue(calibration.spinMargin <= microseconds(sds::XinSettings::TIMER_SPIN_MARGIN_MAX_MICRO));
+			Assert::IsTrue(calibration.spinMargin <= std::max<nanoseconds>(calibration.medianLateness * sds::XinSettings::TIMER_SPIN_MARGIN_MEDIANS,
+				microseconds(sds::XinSettings::SLEEP_SPIN_MARGIN_MICRO)));
+			Assert::AreEqual(50, settings.GetCalibration().samples);
+			//the margin is kept within the range of the mouse delays
+			settings.SetSpinMargin(-microseconds(1));
+			Assert::IsTrue(settings.GetSpinMargin() == sds::Utilities::Clock::Duration::zero());
+			settings.SetSpinMargin(seconds(1));
+			Assert::IsTrue(settings.GetSpinMargin() == microseconds(sds::XinSettings::MICROSECONDS_MAX));
+			settings.SetSpinMargin(calibration.spinMargin);
+			//a wait on the calibrated margin does not end early
+			const WaitStats hybrid = Measure(microseconds(2000), 50, [](const microseconds d) { sds::Utilities::DelayHighPrecision::SleepFor(d); });
+			Assert::IsTrue(hybrid.minErrorMicros >= 0.0);
+			const std::string msg = calibration.ToString() + ", 2000 us wait error mean " + std::to_string(hybrid.meanErrorMicros)
+				+ " max " + std::to_string(hybrid.maxErrorMicros) + " us cpu " + std::to_string(hybrid.cpuPercent) + "%";
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestTimerCalibration()");
+		}
+	};
+}
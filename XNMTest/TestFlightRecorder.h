@@ -0,0 +1,77 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\FlightRecorder.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestFlightRecorder)
+	{
+		static XINPUT_STATE MakeState(const DWORD packet)
+		{
+			XINPUT_STATE state = {};
+			state.dwPacketNumber = packet;
+			state.Gamepad.sThumbRX = static_cast<SHORT>(packet);
+			return state;
+		}
+	public:
+		TEST_METHOD(TestRecordAndWrap)
+		{
+			Logger::WriteMessage("Begin TestRecordAndWrap()");
+			constexpr size_t Capacity = 64;
+			sds::Utilities::FlightRecorder recorder(Capacity);
+			//partially filled
+			for (DWORD i = 0; i < 10; i++)
+				recorder.RecordState(MakeState(i));
+			auto events = recorder.Snapshot(std::chrono::hours(1));
+			Assert::AreEqual(size_t{ 10 }, events.size());
+			Assert::AreEqual(DWORD{ 0 }, events.front().state.dwPacketNumber);
+			//wrapped, only the newest Capacity events remain, oldest first
+			for (DWORD i = 10; i < 1000; i++)
+				recorder.RecordState(MakeState(i));
+			INPUT inp = {};
+			inp.type = INPUT_MOUSE;
+			inp.mi.dx = 5;
+			recorder.RecordInput(&inp, 1);
+			events = recorder.Snapshot(std::chrono::hours(1));
+			Assert::AreEqual(Capacity, events.size());
+			Assert::AreEqual(DWORD{ 1000 - Capacity + 1 }, events.front().state.dwPacketNumber);
+			Assert::IsTrue(events.back().type == sds::Utilities::FlightRecorder::EventType::OUTPUT_INPUT);
+			Assert::AreEqual(LONG{ 5 }, events.back().input.mi.dx);
+			for (size_t i = 1; i < events.size(); i++)
+				Assert::IsTrue(events[i - 1].timestampNs <= events[i].timestampNs);
+			//disabled recorder records nothing
+			recorder.SetEnabled(false);
+			const auto countBefore = recorder.GetEventCount();
+			recorder.RecordState(MakeState(0));
+			Assert::AreEqual(countBefore, recorder.GetEventCount());
+			Logger::WriteMessage("End TestRecordAndWrap()");
+		}
+		TEST_METHOD(TestRecordOverhead)
+		{
+			Logger::WriteMessage("Begin TestRecordOverhead()");
+			constexpr int EventsPerThread = 200000;
+			sds::Utilities::FlightRecorder recorder;
+			auto producer = [&recorder]()
+			{
+				for (int i = 0; i < EventsPerThread; i++)
+					recorder.RecordState(MakeState(static_cast<DWORD>(i)));
+			};
+			const auto start = std::chrono::steady_clock::now();
+			std::thread t1(producer);
+			std::thread t2(producer);
+			t1.join();
+			t2.join();
+			const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+			const auto perEvent = elapsed.count() / EventsPerThread;
+			const std::string msg = "Nanoseconds per event (per thread): " + std::to_string(perEvent);
+			Logger::WriteMessage(msg.c_str());
+			Assert::AreEqual(static_cast<std::uint64_t>(EventsPerThread * 2), recorder.GetEventCount());
+			Assert::IsTrue(perEvent < 1000);
+			Logger::WriteMessage("End TestRecordOverhead()");
+		}
+	};
+}
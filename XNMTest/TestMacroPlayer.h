@@ -0,0 +1,210 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\Mapper.h"
+#include "..\MacroPlayer.h"
+#include "..\RecordingOutputSink.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestMacroPlayer)
+	{
+		static bool IsKey(const INPUT &inp, const WORD vk, const bool down)
+		{
+			return inp.type == INPUT_KEYBOARD && inp.ki.wVk == vk && ((inp.ki.dwFlags & KEYEVENTF_KEYUP) == 0) == down;
+		}
+	public:
+		TEST_METHOD(TestMacroCompile)
+		{
+			Logger::WriteMessage("Begin TestMacroCompile()");
+			using namespace std::chrono;
+			sds::MacroSequence macro;
+			Assert::IsTrue(sds::MacroSequence::Compile("q,~30,e", macro).empty());
+			Assert::AreEqual(size_t{ 2 }, macro.frames.size());
+			Assert::AreEqual(size_t{ 2 }, macro.frames[1].count);
+			Assert::IsTrue(macro.frames[1].offset == milliseconds(30));
+			//the held shift is released after the trailing wait, or by the release records of the frame sent last on cancel
+			Assert::IsTrue(sds::MacroSequence::Compile("+VK16,~10,a,~0.5", macro).empty());
+			Assert::AreEqual(size_t{ 3 }, macro.frames.size());
+			Assert::AreEqual(size_t{ 1 }, macro.frames[0].releaseCount);
+			Assert::IsTrue(IsKey(macro.releases[macro.frames[0].releaseFirst], VK_SHIFT, false));
+			Assert::AreEqual(size_t{ 2 }, macro.frames[1].count);
+			Assert::AreEqual(size_t{ 1 }, macro.frames[1].releaseCount);
+			Assert::AreEqual(size_t{ 1 }, macro.frames[2].count);
+			Assert::AreEqual(size_t{ 0 }, macro.frames[2].releaseCount);
+			Assert::IsTrue(macro.GetDuration() == microseconds(10500));
+			Assert::IsTrue(IsKey(macro.inputs.back(), VK_SHIFT, false));
+			const std::vector<std::string> badMacros = { "", "q,", ",q", "~30", "q,~0", "q,~abc", "q,~30x", "q,zz", "VK999", "q,~99999", "-q", "-q,~10,-VK13" };
+			for (const std::string &bad : badMacros)
+				Assert::IsFalse(sds::MacroSequence::Compile(bad, macro).empty());
+			Logger::WriteMessage("End TestMacroCompile()");
+		}
+		TEST_METHOD(TestMacroTiming)
+		{
+			Logger::WriteMessage("Begin TestMacroTiming()");
+			using namespace std::chrono;
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			std::vector<sds::MacroSequence> macros(1);
+			Assert::IsTrue(sds::MacroSequence::Compile("a,~5,b,~10,c,~0.5,d,~20,e,~2.5,f", macros[0]).empty());
+			sds::MacroPlayer player;
+			player.SetMacros(std::move(macros));
+			constexpr int Runs = 10;
+			for (int i = 0; i < Runs; i++)
+			{
+				player.Trigger(0);
+				std::this_thread::sleep_for(milliseconds(60));
+			}
+			player.Stop();
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			const sds::MacroPlayer::Counters &counters = player.GetCounters();
+			Assert::AreEqual(static_cast<std::uint64_t>(Runs * 6), counters.framesSent.load());
+			Assert::AreEqual(static_cast<size_t>(Runs * 12), sink.GetCount());
+			const double meanLateness = static_cast<double>(counters.totalLatenessMicro.load()) / static_cast<double>(counters.framesSent.load());
+			const std::string msg = "Macro frame lateness mean: " + std::to_string(meanLateness)
+				+ " us, max: " + std::to_string(counters.maxLatenessMicro.load()) + " us";
+			Logger::WriteMessage(msg.c_str());
+			Assert::IsTrue(meanLateness < 1000.0);
+			Logger::WriteMessage("End TestMacroTiming()");
+		}
+		TEST_METHOD(TestTriggerDuringWait)
+		{
+			Logger::WriteMessage("Begin TestTriggerDuringWait()");
+			using namespace std::chrono;
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			std::vector<sds::MacroSequence> macros(2);
+			Assert::IsTrue(sds::MacroSequence::Compile("VK65,~3000,VK66", macros[0]).empty());
+			Assert::IsTrue(sds::MacroSequence::Compile("VK67", macros[1]).empty());
+			sds::MacroPlayer player;
+			player.SetMacros(std::move(macros));
+			//a macro triggered while another waits plays at once, not when the wait is over
+			player.Trigger(0);
+			std::this_thread::sleep_for(milliseconds(50));
+			const steady_clock::time_point triggered = steady_clock::now();
+			player.Trigger(1);
+			while (sink.GetCount() < 4 && steady_clock::now() - triggered < seconds(1))
+				std::this_thread::sleep_for(milliseconds(1));
+			const steady_clock::duration elapsed = steady_clock::now() - triggered;
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 4 }, events.size());
+			Assert::IsTrue(IsKey(events[2], 'C', true));
+			Assert::IsTrue(IsKey(events[3], 'C', false));
+			Assert::IsTrue(elapsed < milliseconds(500));
+			//cancelled, the first macro never sends its second frame
+			player.Cancel(0);
+			player.Stop();
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Assert::AreEqual(size_t{ 4 }, sink.GetCount());
+			const std::string msg = "Second macro played after " + std::to_string(duration_cast<microseconds>(elapsed).count()) + " us";
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestTriggerDuringWait()");
+		}
+		TEST_METHOD(TestSwitchMacroSets)
+		{
+			Logger::WriteMessage("Begin TestSwitchMacroSets()");
+			using namespace std::chrono;
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			auto compileSet = [](const std::string &macro)
+			{
+				std::vector<sds::MacroSequence> macros(1);
+				Assert::IsTrue(sds::MacroSequence::Compile(macro, macros[0]).empty());
+				return std::make_shared<sds::MacroPlayer::MacroSet>(std::move(macros));
+			};
+			const std::shared_ptr<sds::MacroPlayer::MacroSet> first = compileSet("+VK65,~3000,VK66");
+			const std::shared_ptr<sds::MacroPlayer::MacroSet> second = compileSet("VK67");
+			sds::MacroPlayer player;
+			player.SetMacros(first);
+			player.Trigger(0);
+			while (sink.GetCount() < 1)
+				std::this_thread::sleep_for(milliseconds(1));
+			//the player takes up the new set while running, the key held by the first is released before the second plays
+			const steady_clock::time_point switched = steady_clock::now();
+			player.SetMacros(second);
+			player.Trigger(0);
+			while (sink.GetCount() < 4 && steady_clock::now() - switched < seconds(1))
+				std::this_thread::sleep_for(milliseconds(1));
+			Assert::IsTrue(steady_clock::now() - switched < milliseconds(500));
+			//switched back, the first set does not resume
+			player.SetMacros(first);
+			std::this_thread::sleep_for(milliseconds(20));
+			player.Stop();
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 4 }, events.size());
+			Assert::IsTrue(IsKey(events[0], 'A', true));
+			Assert::IsTrue(IsKey(events[1], 'A', false));
+			Assert::IsTrue(IsKey(events[2], 'C', true));
+			Assert::IsTrue(IsKey(events[3], 'C', false));
+			Logger::WriteMessage("End TestSwitchMacroSets()");
+		}
+		TEST_METHOD(TestMacroRestart)
+		{
+			Logger::WriteMessage("Begin TestMacroRestart()");
+			using namespace std::chrono;
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			sds::Mapper mp;
+			Assert::IsTrue(mp.SetMapInfo("A:NONE:MACRO:+VK65,~50,VK66 B:NONE:NORM:VK67").empty());
+			mp.ProcessActionDetails("A");
+			std::this_thread::sleep_for(milliseconds(10));
+			//held the binding does not restart it, pressed again it does
+			mp.ProcessActionDetails("A");
+			mp.ProcessActionDetails("");
+			mp.ProcessActionDetails("A B");
+			mp.ProcessActionDetails("");
+			std::this_thread::sleep_for(milliseconds(100));
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			const std::vector<INPUT> events = sink.GetEvents();
+			//C is sent on the poll thread, the macro on the player thread, so only the macro keys are compared
+			std::vector<INPUT> macroEvents;
+			std::copy_if(events.begin(), events.end(), std::back_inserter(macroEvents), [](const INPUT &inp) { return inp.ki.wVk != 'C'; });
+			Assert::AreEqual(size_t{ 2 }, events.size() - macroEvents.size());
+			Assert::AreEqual(size_t{ 6 }, macroEvents.size());
+			Assert::IsTrue(IsKey(macroEvents[0], 'A', true));
+			Assert::IsTrue(IsKey(macroEvents[1], 'A', false));
+			Assert::IsTrue(IsKey(macroEvents[2], 'A', true));
+			Assert::IsTrue(IsKey(macroEvents[3], 'B', true));
+			Assert::IsTrue(IsKey(macroEvents[4], 'B', false));
+			Assert::IsTrue(IsKey(macroEvents[5], 'A', false));
+			Assert::AreEqual(std::uint64_t{ 1 }, mp.GetMacroCounters().restarts.load());
+			Logger::WriteMessage("End TestMacroRestart()");
+		}
+		TEST_METHOD(TestMacroProfiles)
+		{
+			Logger::WriteMessage("Begin TestMacroProfiles()");
+			using namespace std::chrono;
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			{
+				//one player plays the macros of whichever profile is active
+				sds::Mapper mp;
+				Assert::IsTrue(mp.SetMapInfo("A:NONE:MACRO:VK65").empty());
+				size_t id = 0;
+				Assert::IsTrue(mp.AddProfile("A:NONE:MACRO:VK66", id).empty());
+				for (const size_t profile : { size_t{ 0 }, id, size_t{ 0 } })
+				{
+					Assert::IsTrue(mp.ActivateProfile(profile).empty());
+					mp.ProcessActionDetails("");
+					mp.ProcessActionDetails("A");
+					std::this_thread::sleep_for(milliseconds(50));
+				}
+				Assert::AreEqual(std::uint64_t{ 3 }, mp.GetMacroCounters().framesSent.load());
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 6 }, events.size());
+			const std::array<WORD, 3> keys = { 'A', 'B', 'A' };
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				Assert::IsTrue(IsKey(events[2 * i], keys[i], true));
+				Assert::IsTrue(IsKey(events[2 * i + 1], keys[i], false));
+			}
+			Logger::WriteMessage("End TestMacroProfiles()");
+		}
+	};
+}
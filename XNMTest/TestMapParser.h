@@ -0,0 +1,148 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\Mapper.h"
+#include "..\MapParser.h"
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestMapParser)
+	{
+		/// <summary>
+		/// Returns a map of at least "minSize" characters, cycling through the controls, keys and simulation types.
+		/// </summary>
+		static std::string BuildLargeMap(const size_t minSize)
+		{
+			const std::vector<std::string> controls = { "A", "B", "X", "Y", "LSHOULDER", "RSHOULDER", "START", "BACK", "LTRIGGER", "RTRIGGER" };
+			const std::vector<std::string> simTypes = { "NORM", "toggle", "Rapid" };
+			std::string map;
+			for (size_t i = 0; map.size() < minSize; i++)
+			{
+				map += controls[i % controls.size()] + (i % 3 == 0 ? ":NONE:" : ":none:") + simTypes[i % simTypes.size()]
+					+ (i % 2 == 0 ? ":VK" + std::to_string(i % 256) : ":" + std::string(1, static_cast<char>('a' + i % 26))) + " ";
+			}
+			return map;
+		}
+		static void AssertErrorAt(const std::string &map, const size_t tokenIndex, const size_t column)
+		{
+			std::vector<sds::MapParser::Token> tokens;
+			sds::MapParser::Position errorAt;
+			const std::string err = sds::MapParser::Parse(map, tokens, errorAt);
+			const std::wstring msg(map.begin(), map.end());
+			Assert::IsFalse(err.empty(), msg.c_str());
+			Assert::AreEqual(tokenIndex, errorAt.tokenIndex, msg.c_str());
+			Assert::AreEqual(column, errorAt.column, msg.c_str());
+		}
+	public:
+		TEST_METHOD(TestParsePositions)
+		{
+			Logger::WriteMessage("Begin TestParsePositions()");
+			std::vector<sds::MapParser::Token> tokens;
+			sds::MapParser::Position errorAt;
+			const std::string map = " lthumb:left:norm:a\tDPAD:UP:Toggle:vk033\nLSHOULDER+!b:none:NORM:VK13 X:NONE:MACRO:q,~30,e";
+			Assert::IsTrue(sds::MapParser::Parse(map, tokens, errorAt).empty());
+			Assert::AreEqual(size_t{ 4 }, tokens.size());
+			Assert::IsTrue(tokens[0].control == "LTHUMB" && tokens[0].info == "LEFT" && tokens[0].simType == "NORM" && tokens[0].value == "a");
+			Assert::AreEqual(size_t{ 2 }, tokens[0].column);
+			Assert::AreEqual(-1, tokens[0].virtualKey);
+			Assert::AreEqual(33, tokens[1].virtualKey);
+			Assert::IsTrue(tokens[2].isChord && tokens[2].control == "LSHOULDER+!b");
+			Assert::IsTrue(tokens[3].simType == "MACRO" && tokens[3].value == "q,~30,e");
+			//the column of the field at fault
+			AssertErrorAt("A:NONE:NORM:a DPAD:DWN:NORM:x", 1, 20);
+			AssertErrorAt("A:NONE:NORM:vk256", 0, 13);
+			AssertErrorAt("A:NONE:NORM:VK12x", 0, 13);
+			AssertErrorAt("A:NONE:NORM:vk33333333333333333333", 0, 13);
+			AssertErrorAt("A:NONE:NORM", 0, 12);
+			AssertErrorAt("A::NORM:a", 0, 3);
+			AssertErrorAt("A:NONE:NORM:a:b", 0, 15);
+			AssertErrorAt("A:NONE:NORM:a A+B:UP:NORM:a", 1, 19);
+			AssertErrorAt("  \r\n", 0, 5);
+			AssertErrorAt("", 0, 1);
+			//errors found after parsing name the token too
+			sds::Mapper mp;
+			const std::string err = mp.SetMapInfo("A:NONE:NORM:a A+Q:NONE:NORM:b");
+			Assert::IsTrue(err.find("Token 1 at column 15") != std::string::npos);
+			Logger::WriteMessage("End TestParsePositions()");
+		}
+		TEST_METHOD(TestParseFuzz)
+		{
+			Logger::WriteMessage("Begin TestParseFuzz()");
+			//mutated maps never take the parser outside the map, and an error is always reported inside it
+			std::mt19937 engine(38);
+			const std::vector<std::string> seeds = { "LTHUMB:LEFT:NORM:a LTHUMB:RIGHT:NORM:d A:NONE:NORM:VK32",
+				"LSHOULDER+!B:NONE:NORM:x X:NONE:MACRO:q,~30,e", "dpad:up:toggle:vk255\tB:NONE:RAPID:c\n" };
+			const std::string alphabet = ":+!-~, \t\nVKvk0123456789ABNORMTOGLEDPAUXYZ";
+			std::vector<sds::MapParser::Token> tokens;
+			size_t accepted = 0;
+			for (int n = 0; n < 20000; n++)
+			{
+				std::string map = seeds[engine() % seeds.size()];
+				const int mutations = 1 + static_cast<int>(engine() % 6);
+				for (int k = 0; k < mutations; k++)
+				{
+					const size_t at = map.empty() ? 0 : engine() % map.size();
+					switch (engine() % 3)
+					{
+					case 0:
+						if (!map.empty())
+							map.erase(at, 1 + engine() % 3);
+						break;
+					case 1:
+						map.insert(at, 1, alphabet[engine() % alphabet.size()]);
+						break;
+					default:
+						if (!map.empty())
+							map[at] = static_cast<char>(engine() % 256);
+						break;
+					}
+				}
+				sds::MapParser::Position errorAt;
+				if (sds::MapParser::Parse(map, tokens, errorAt).empty())
+				{
+					accepted++;
+					for (const sds::MapParser::Token &token : tokens)
+						Assert::IsTrue(token.text.data() >= map.data() && token.text.data() + token.text.size() <= map.data() + map.size());
+				}
+				else
+				{
+					Assert::IsTrue(errorAt.column >= 1 && errorAt.column <= map.size() + 1);
+					Assert::AreEqual(tokens.size(), errorAt.tokenIndex);
+				}
+			}
+			const std::string msg = "Mutated maps accepted: " + std::to_string(accepted) + " of 20000";
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestParseFuzz()");
+		}
+		TEST_METHOD(TestParseThroughput)
+		{
+			Logger::WriteMessage("Begin TestParseThroughput()");
+			using namespace std::chrono;
+			constexpr int Iterations = 200;
+			for (const size_t size : { size_t{ 4096 }, size_t{ 16384 }, size_t{ 65536 } })
+			{
+				const std::string map = BuildLargeMap(size);
+				std::vector<sds::MapParser::Token> tokens;
+				sds::MapParser::Position errorAt;
+				const auto parseStart = steady_clock::now();
+				for (int i = 0; i < Iterations; i++)
+					Assert::IsTrue(sds::MapParser::Parse(map, tokens, errorAt).empty());
+				const double parseSeconds = duration<double>(steady_clock::now() - parseStart).count() / Iterations;
+				sds::Mapper mp;
+				const auto setStart = steady_clock::now();
+				for (int i = 0; i < Iterations / 10; i++)
+					Assert::IsTrue(mp.SetMapInfo(map).empty());
+				const double setSeconds = duration<double>(steady_clock::now() - setStart).count() / (Iterations / 10);
+				const std::string msg = std::to_string(map.size()) + " byte map, " + std::to_string(tokens.size()) + " tokens, parse: "
+					+ std::to_string(map.size() / parseSeconds / 1e6) + " MB/s, SetMapInfo: " + std::to_string(setSeconds * 1e6) + " us";
+				Logger::WriteMessage(msg.c_str());
+				Assert::IsTrue(parseSeconds < setSeconds);
+			}
+			Logger::WriteMessage("End TestParseThroughput()");
+		}
+	};
+}
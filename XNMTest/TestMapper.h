@@ -5,6 +5,8 @@
 #include "..\Mapper.h"
 #include "..\SendKey.h"
 #include "..\ActionDescriptors.h"
+#include "..\RecordingOutputSink.h"
+#include "..\CountingOutputBackend.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -84,6 +86,105 @@ namespace XNMTest
 
 			Logger::WriteMessage("End TestSetMapInfo()");
 		}
+		TEST_METHOD(TestChordBindings)
+		{
+			Logger::WriteMessage("Begin TestChordBindings()");
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			sds::Mapper mp;
+			Assert::IsTrue(mp.SetMapInfo("LSHOULDER:NONE:NORM:VK86 A:NONE:NORM:VK32 lshoulder+a:NONE:NORM:VK13 LSHOULDER+A+DPAD-UP:NONE:NORM:VK9 B+!X:NONE:NORM:VK66").empty());
+			//returns the virtual keycodes sent, negative for a key up
+			auto takeKeys = [&sink]()
+			{
+				std::vector<int> keys;
+				for (const INPUT &inp : sink.GetEvents())
+					keys.push_back((inp.ki.dwFlags & KEYEVENTF_KEYUP) ? -inp.ki.wVk : inp.ki.wVk);
+				sink.Clear();
+				return keys;
+			};
+			//the chord suppresses both of its single bindings
+			mp.ProcessActionDetails("LSHOULDER A ");
+			Assert::IsTrue(takeKeys() == std::vector<int>{ 13 });
+			//the larger chord suppresses the smaller one
+			mp.ProcessActionDetails("LSHOULDER A DPAD:UP ");
+			Assert::IsTrue(takeKeys() == std::vector<int>{ -13, 9 });
+			mp.ProcessActionDetails("A ");
+			Assert::IsTrue(takeKeys() == std::vector<int>{ 32, -9 });
+			//an excluded control stops the chord
+			mp.ProcessActionDetails("B ");
+			Assert::IsTrue(takeKeys() == std::vector<int>{ -32, 66 });
+			mp.ProcessActionDetails("B X ");
+			Assert::IsTrue(takeKeys() == std::vector<int>{ -66 });
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			//malformed chords
+			Assert::IsFalse(mp.SetMapInfo("LSHOULDER+Q:NONE:NORM:a").empty());
+			Assert::IsFalse(mp.SetMapInfo("LSHOULDER+A:UP:NORM:a").empty());
+			Assert::IsFalse(mp.SetMapInfo("A+!A:NONE:NORM:a").empty());
+			Assert::IsFalse(mp.SetMapInfo("!A+!B:NONE:NORM:a").empty());
+			Assert::IsFalse(mp.SetMapInfo("A+DPAD:NONE:NORM:a").empty());
+			Assert::IsFalse(mp.SetMapInfo("A+:NONE:NORM:a").empty());
+			Logger::WriteMessage("End TestChordBindings()");
+		}
+		TEST_METHOD(TestSimTypes)
+		{
+			Logger::WriteMessage("Begin TestSimTypes()");
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			sds::Mapper mp;
+			Assert::IsTrue(mp.SetMapInfo("A:NONE:toggle:vk65 B:NONE:RAPID:VK66 X:NONE:NORM:q").empty());
+			//the strings are kept for GetBindings(), as compiled
+			const std::vector<sds::Mapper::BindingRecord> records = mp.GetBindings();
+			Assert::AreEqual(size_t{ 3 }, records.size());
+			Assert::IsTrue(records[0].simType == "TOGGLE" && records[0].value == "VK65");
+			Assert::IsTrue(records[2].control == "X" && records[2].info == "NONE" && records[2].value == "q");
+			mp.ProcessActionDetails("A B X ");
+			mp.ProcessActionDetails("");
+			mp.ProcessActionDetails("A ");
+			mp.ProcessActionDetails("");
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			std::vector<int> keys;
+			for (const INPUT &inp : sink.GetEvents())
+				keys.push_back((inp.ki.dwFlags & KEYEVENTF_KEYUP) ? -inp.ki.wVk : inp.ki.wVk);
+			const int q = static_cast<WORD>(VkKeyScanExA('q', GetKeyboardLayout(0)));
+			Assert::IsTrue(keys == std::vector<int>{ 65, 66, -66, q, -q, -65 });
+			Logger::WriteMessage("End TestSimTypes()");
+		}
+		TEST_METHOD(TestChordMatchCost)
+		{
+			Logger::WriteMessage("Begin TestChordMatchCost()");
+			using namespace std::chrono;
+			const std::vector<std::string> buttons = { "A", "B", "X", "Y", "LSHOULDER", "RSHOULDER", "START", "BACK", "LTHUMB", "RTHUMB",
+				"LTRIGGER", "RTRIGGER", "DPAD-UP", "DPAD-DOWN", "DPAD-LEFT", "DPAD-RIGHT" };
+			//every pair, then every triple, of the buttons
+			std::vector<std::string> chords;
+			for (size_t i = 0; i < buttons.size(); i++)
+				for (size_t j = i + 1; j < buttons.size(); j++)
+					chords.push_back(buttons[i] + "+" + buttons[j]);
+			for (size_t i = 0; i < buttons.size(); i++)
+				for (size_t j = i + 1; j < buttons.size(); j++)
+					for (size_t k = j + 1; k < buttons.size(); k++)
+						chords.push_back(buttons[i] + "+" + buttons[j] + "+" + buttons[k]);
+			sds::Utilities::CountingOutputBackend counter;
+			sds::Utilities::SendKey::SetOutputBackend(&counter);
+			constexpr int FrameCount = 20000;
+			for (const size_t chordCount : { size_t{ 10 }, size_t{ 100 }, size_t{ 500 } })
+			{
+				sds::MapInformation map = "A:NONE:NORM:VK32 B:NONE:NORM:VK66";
+				for (size_t i = 0; i < chordCount; i++)
+					map += " " + chords[i] + ":NONE:NORM:VK" + std::to_string(65 + i % 26);
+				sds::Mapper mp;
+				Assert::IsTrue(mp.SetMapInfo(map).empty());
+				const auto start = steady_clock::now();
+				for (int i = 0; i < FrameCount; i++)
+					mp.ProcessActionDetails((i & 1) ? "A X LTHUMB:UP " : "B ");
+				const double ns = duration<double, std::nano>(steady_clock::now() - start).count() / FrameCount;
+				const std::string msg = std::to_string(chordCount) + " chords, ns per frame: " + std::to_string(ns)
+					+ " ns per binding: " + std::to_string(ns / static_cast<double>(chordCount + 2));
+				Logger::WriteMessage(msg.c_str());
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Logger::WriteMessage("End TestChordMatchCost()");
+		}
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\MouseFrameAccumulator.h"
+#include "..\GamepadUser.h"
+#include "TestClock.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestMouseFrames)
+	{
+	public:
+		TEST_METHOD(TestFrameAccumulator)
+		{
+			Logger::WriteMessage("Begin TestFrameAccumulator()");
+			using namespace std::chrono;
+			//a second of frames at 1000 Hz moves as far as the delay timer, 1000000 / 873 pixels
+			sds::MouseFrameAccumulator frames(1000);
+			Assert::IsTrue(frames.GetFramePeriod() == microseconds(1000));
+			int totalX = 0;
+			int totalY = 0;
+			for (int i = 0; i < 1000; i++)
+			{
+				const auto [dx, dy] = frames.Step(873, true, true, 873, true, true);
+				//one or two pixels a frame, y inverted
+				Assert::IsTrue(dx >= 1 && dx <= 2);
+				Assert::AreEqual(-dx, dy);
+				totalX += dx;
+				totalY += dy;
+			}
+			Assert::IsTrue(std::abs(totalX - 1000000 / 873) <= 1);
+			Assert::AreEqual(-totalX, totalY);
+			//a slow axis moves on some frames only, and not at all while stopped
+			frames.Reset();
+			int slowX = 0;
+			for (int i = 0; i < 1000; i++)
+			{
+				const auto [dx, dy] = frames.Step(10000, true, false, 10000, false, true);
+				Assert::IsTrue(dx == 0 || dx == -1);
+				Assert::AreEqual(0, dy);
+				slowX += dx;
+			}
+			Assert::IsTrue(std::abs(slowX + 100) <= 1);
+			//the carried fraction is dropped on a stop and on a change of direction
+			sds::MouseFrameAccumulator carry(1000);
+			Assert::AreEqual(0, carry.Step(1500, true, true, 1, false, false).first);
+			Assert::AreEqual(0, carry.Step(1500, false, true, 1, false, false).first);
+			Assert::AreEqual(0, carry.Step(1500, true, true, 1, false, false).first);
+			Assert::AreEqual(0, carry.Step(1500, true, false, 1, false, false).first);
+			Assert::AreEqual(-1, carry.Step(1500, true, false, 1, false, false).first);
+			//500 Hz covers twice the distance per frame
+			sds::MouseFrameAccumulator half(500);
+			Assert::IsTrue(half.GetFramePeriod() == microseconds(2000));
+			Assert::AreEqual(2, half.Step(1000, true, true, 1, false, false).first);
+			Logger::WriteMessage("End TestFrameAccumulator()");
+		}
+		TEST_METHOD(TestSimulatedFrames)
+		{
+			Logger::WriteMessage("Begin TestSimulatedFrames()");
+			using namespace std::chrono;
+			using sds::Utilities::Clock;
+			//a minute of the stick held at 300 frames per second, every move sent on a frame
+			//no frame is due at the time of a poll, so the order of the two does not matter
+			constexpr int FrameRate = 300;
+			constexpr nanoseconds FramePeriod(1000000000 / FrameRate);
+			const milliseconds heldFor(60001);
+			//the release is seen by the first poll after it
+			const milliseconds pollPeriod(sds::XinSettings::THREAD_DELAY_POLLER);
+			const milliseconds releasedAt = (heldFor + pollPeriod - milliseconds(1)) / pollPeriod * pollPeriod;
+			sds::Utilities::ManualClock clock;
+			ClockStampBackend backend;
+			Clock::SetClock(&clock);
+			sds::Utilities::SendKey::SetOutputBackend(&backend);
+			const Clock::TimePoint start = clock.Now();
+			std::atomic<bool> isPastEnd{ false };
+			size_t moveDelay = 0;
+			{
+				sds::GamepadUser user(sds::ExecutionMode::REACTOR);
+				Assert::IsTrue(user.mouse.SetSensitivity(65).empty());
+				Assert::IsTrue(user.mouse.SetCoalesceWindow(0).empty());
+				Assert::IsFalse(user.mouse.SetFrameRate(sds::XinSettings::MOUSE_FRAME_RATE_MAX + 1).empty());
+				Assert::IsTrue(user.mouse.SetFrameRate(FrameRate).empty());
+				Assert::AreEqual(FrameRate, user.mouse.GetFrameRate());
+				user.mouse.EnableProcessing(sds::MouseMap::RIGHT_STICK);
+				const std::shared_ptr<const sds::ConfigSnapshot> config = user.mouse.GetConfig();
+				const sds::ThumbstickToDelay xAxis(config->sensitivity, config->player, config->stickMap, true);
+				moveDelay = xAxis.GetDelayFromThumbstickValue(std::numeric_limits<SHORT>::max(), 0);
+				user.poller.SetStateSource([&](DWORD, XINPUT_STATE *state)
+					{
+						memset(state, 0, sizeof(XINPUT_STATE));
+						const Clock::TimePoint now = clock.Now();
+						if (now - start < heldFor)
+							state->Gamepad.sThumbRX = std::numeric_limits<SHORT>::max();
+						else if (now - start > heldFor + milliseconds(10))
+							isPastEnd = true;
+						return static_cast<DWORD>(ERROR_SUCCESS);
+					});
+				Assert::IsTrue(user.poller.Start());
+				while (!isPastEnd)
+					std::this_thread::sleep_for(milliseconds(1));
+				user.poller.Stop();
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Clock::SetClock(nullptr);
+			const std::vector<ClockStampBackend::Stamped> records = backend.GetRecords();
+			const long long frameCount = (nanoseconds(releasedAt).count() - 1) / FramePeriod.count() + 1;
+			//at most one move per frame, each on a frame
+			Assert::IsTrue(!records.empty() && static_cast<long long>(records.size()) <= frameCount);
+			long long totalX = 0;
+			for (const ClockStampBackend::Stamped &r : records)
+			{
+				Assert::IsTrue(r.input.type == INPUT_MOUSE);
+				Assert::IsTrue((r.at - start) % FramePeriod == nanoseconds::zero());
+				Assert::IsTrue(r.at - start < releasedAt);
+				Assert::AreEqual(0L, static_cast<long>(r.input.mi.dy));
+				totalX += r.input.mi.dx;
+			}
+			//as far as the delay timer moves over the frames
+			const long long expectedX = frameCount * FramePeriod.count() / (static_cast<long long>(moveDelay) * 1000);
+			Assert::IsTrue(std::abs(totalX - expectedX) <= 1);
+			const std::string msg = "Frames: " + std::to_string(frameCount) + " moves: " + std::to_string(records.size()) + " pixels: " + std::to_string(totalX)
+				+ " expected: " + std::to_string(expectedX) + " delay " + std::to_string(moveDelay) + " us";
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestSimulatedFrames()");
+		}
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\MouseMoveCoalescer.h"
+#include "..\RecordingOutputSink.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestMouseMoveCoalescer)
+	{
+	public:
+		TEST_METHOD(TestSuppressAndMerge)
+		{
+			Logger::WriteMessage("Begin TestSuppressAndMerge()");
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			sds::MouseMoveCoalescer::Counters counters;
+			{
+				//zero window, non-zero moves are sent as they are added
+				sds::MouseMoveCoalescer coalescer(std::chrono::microseconds(0), counters);
+				coalescer.AddMove(0, 0);
+				coalescer.AddMove(1, 0);
+				coalescer.AddMove(0, 0);
+				coalescer.AddMove(0, -1);
+				Assert::IsFalse(coalescer.HasPending());
+			}
+			Assert::AreEqual(std::uint64_t{ 2 }, counters.suppressed.load());
+			Assert::AreEqual(std::uint64_t{ 0 }, counters.merged.load());
+			Assert::AreEqual(std::uint64_t{ 2 }, counters.sent.load());
+			Assert::AreEqual(size_t{ 2 }, sink.GetCount());
+			{
+				//window that never ends in the test, moves are summed until flushed
+				sds::MouseMoveCoalescer coalescer(std::chrono::hours(1), counters);
+				coalescer.AddMove(1, 0);
+				coalescer.AddMove(1, -1);
+				coalescer.AddMove(0, 0);
+				coalescer.AddMove(1, -1);
+				coalescer.Poll();
+				Assert::IsTrue(coalescer.HasPending());
+				Assert::AreEqual(size_t{ 2 }, sink.GetCount());
+				coalescer.Flush();
+				//opposite moves cancel, nothing is sent
+				coalescer.AddMove(1, 0);
+				coalescer.AddMove(-1, 0);
+				coalescer.Flush();
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Assert::AreEqual(std::uint64_t{ 3 }, counters.suppressed.load());
+			Assert::AreEqual(std::uint64_t{ 3 }, counters.merged.load());
+			Assert::AreEqual(std::uint64_t{ 3 }, counters.sent.load());
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 3 }, events.size());
+			Assert::AreEqual(LONG{ 3 }, events.back().mi.dx);
+			Assert::AreEqual(LONG{ -2 }, events.back().mi.dy);
+			Logger::WriteMessage("End TestSuppressAndMerge()");
+		}
+		TEST_METHOD(TestWindowElapses)
+		{
+			Logger::WriteMessage("Begin TestWindowElapses()");
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			sds::MouseMoveCoalescer::Counters counters;
+			const std::chrono::microseconds window(1000);
+			sds::MouseMoveCoalescer coalescer(window, counters);
+			coalescer.AddMove(1, 1);
+			coalescer.AddMove(1, 1);
+			std::this_thread::sleep_for(window * 2);
+			coalescer.Poll();
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Assert::IsFalse(coalescer.HasPending());
+			Assert::AreEqual(size_t{ 1 }, sink.GetCount());
+			Assert::AreEqual(LONG{ 2 }, sink.GetEvents().front().mi.dx);
+			Logger::WriteMessage("End TestWindowElapses()");
+		}
+	};
+}
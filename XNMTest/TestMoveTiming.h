@@ -0,0 +1,157 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\MoveTimingStats.h"
+#include "..\GamepadUser.h"
+#include "..\CountingOutputBackend.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestMoveTiming)
+	{
+		/// <summary>
+		/// Holds the right stick fully diagonal for the duration with a GamepadUser in the mode, and returns its move timing.
+		/// </summary>
+		static void RunStick(const sds::ExecutionMode mode, const std::chrono::milliseconds heldFor, const std::function<void(const sds::MoveTimingStats&)> &check)
+		{
+			using namespace std::chrono;
+			using sds::Utilities::Clock;
+			sds::Utilities::CountingOutputBackend backend;
+			sds::Utilities::SendKey::SetOutputBackend(&backend);
+			{
+				sds::GamepadUser user(mode);
+				Assert::IsTrue(user.mouse.SetSensitivity(65).empty());
+				Assert::IsTrue(user.mouse.SetCoalesceWindow(0).empty());
+				user.mouse.EnableProcessing(sds::MouseMap::RIGHT_STICK);
+				const Clock::TimePoint start = Clock::Get().Now();
+				std::atomic<bool> isPastEnd{ false };
+				user.poller.SetStateSource([&](DWORD, XINPUT_STATE *state)
+					{
+						memset(state, 0, sizeof(XINPUT_STATE));
+						if (Clock::Get().Now() - start < heldFor)
+						{
+							state->Gamepad.sThumbRX = std::numeric_limits<SHORT>::max();
+							state->Gamepad.sThumbRY = std::numeric_limits<SHORT>::max();
+						}
+						else
+						{
+							isPastEnd = true;
+						}
+						return static_cast<DWORD>(ERROR_SUCCESS);
+					});
+				Assert::IsTrue(user.poller.Start());
+				while (!isPastEnd)
+					std::this_thread::sleep_for(milliseconds(1));
+				user.poller.Stop();
+				check(user.mouse.GetMoveTiming());
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+		}
+	public:
+		TEST_METHOD(TestTimingHistogram)
+		{
+			Logger::WriteMessage("Begin TestTimingHistogram()");
+			using namespace std::chrono;
+			sds::MoveTimingHistogram histogram;
+			Assert::IsTrue(histogram.Summarize().moves == 0);
+			Assert::IsTrue(histogram.Percentile(0.99) == nanoseconds::zero());
+			//98 moves on time, one 10 us late and one 1 ms late
+			for (int i = 0; i < 98; i++)
+				histogram.Record(microseconds(1000), microseconds(1000));
+			histogram.Record(microseconds(1000), microseconds(1010));
+			histogram.Record(microseconds(1000), microseconds(2000));
+			sds::MoveTimingSummary summary = histogram.Summarize();
+			Assert::IsTrue(summary.moves == 100);
+			Assert::IsTrue(summary.missed == 1);
+			Assert::IsTrue(summary.meanRequested == microseconds(1000));
+			Assert::IsTrue(summary.meanError == nanoseconds(10100));
+			Assert::IsTrue(summary.maxError == microseconds(1000));
+			Assert::IsTrue(histogram.Percentile(0.98) == nanoseconds::zero());
+			//a percentile is the upper bound of its bucket, within 1/32 of the value
+			const nanoseconds p99 = summary.p99Error;
+			Assert::IsTrue(p99 >= microseconds(10) && p99 <= microseconds(10) + nanoseconds(microseconds(10)) / 32);
+			const nanoseconds p100 = histogram.Percentile(1.0);
+			Assert::IsTrue(p100 >= microseconds(1000) && p100 <= microseconds(1000) + nanoseconds(microseconds(1000)) / 32);
+			//an early move counts as on time in the buckets, and lowers the mean
+			histogram.Reset();
+			histogram.Record(microseconds(1000), microseconds(900));
+			histogram.Record(microseconds(1000), microseconds(1100));
+			summary = histogram.Summarize();
+			Assert::IsTrue(summary.meanError == nanoseconds::zero());
+			Assert::IsTrue(histogram.Percentile(0.5) == nanoseconds::zero());
+			Assert::IsTrue(summary.missed == 0);
+			//errors past the last bucket land in it
+			histogram.Record(microseconds(1), hours(1));
+			Assert::IsTrue(histogram.Percentile(1.0) > seconds(100));
+			Logger::WriteMessage("End TestTimingHistogram()");
+		}
+		TEST_METHOD(TestSimulatedTiming)
+		{
+			Logger::WriteMessage("Begin TestSimulatedTiming()");
+			using namespace std::chrono;
+			using sds::Utilities::Clock;
+			//on the simulated clock every move is sent exactly on its deadline
+			sds::Utilities::ManualClock clock;
+			Clock::SetClock(&clock);
+			RunStick(sds::ExecutionMode::REACTOR, milliseconds(10000), [](const sds::MoveTimingStats &timing)
+				{
+					for (const sds::MoveTimingHistogram *axis : { &timing.x, &timing.y })
+					{
+						const sds::MoveTimingSummary summary = axis->Summarize();
+						Assert::IsTrue(summary.moves > 1000);
+						Assert::IsTrue(summary.missed == 0);
+						Assert::IsTrue(summary.meanError == nanoseconds::zero());
+						Assert::IsTrue(summary.p99Error == nanoseconds::zero());
+						Assert::IsTrue(summary.maxError == nanoseconds::zero());
+					}
+					Assert::IsTrue(timing.frame.Summarize().moves == 0);
+					Logger::WriteMessage(timing.ToString().c_str());
+				});
+			Clock::SetClock(nullptr);
+			Logger::WriteMessage("End TestSimulatedTiming()");
+		}
+		TEST_METHOD(TestTimingUnderLoad)
+		{
+			Logger::WriteMessage("Begin TestTimingUnderLoad()");
+			using namespace std::chrono;
+			//the threaded mouse for a second with no load, then next to one spinning thread, which leaves the other cores free
+			for (const size_t loadThreads : { size_t{ 0 }, size_t{ 1 } })
+			{
+				std::atomic<bool> isLoadStopped{ false };
+				std::vector<std::thread> load;
+				for (size_t i = 0; i < loadThreads; i++)
+				{
+					load.emplace_back([&isLoadStopped]()
+						{
+							volatile std::uint64_t sink = 0;
+							while (!isLoadStopped.load(std::memory_order_relaxed))
+								sink = sink + 1;
+						});
+				}
+				RunStick(sds::ExecutionMode::THREADED, milliseconds(1000), [loadThreads](const sds::MoveTimingStats &timing)
+					{
+						const sds::MoveTimingSummary summary = timing.x.Summarize();
+						Assert::IsTrue(summary.missed <= summary.moves);
+						Assert::IsTrue(summary.p99Error <= summary.maxError + summary.maxError / 32);
+						if (loadThreads == 0)
+						{
+							//unloaded, the mouse keeps to at least half its rate and is late by less than an interval on average,
+							//a wait overshooting by a timer tick or a whole interval fails both, the tail of a busy host fails neither
+							Assert::IsTrue(summary.meanRequested > nanoseconds::zero());
+							Assert::IsTrue(summary.moves * 2 >= static_cast<std::uint64_t>(nanoseconds(milliseconds(1000)) / summary.meanRequested));
+							Assert::IsTrue(summary.meanError < summary.meanRequested);
+						}
+						const std::string msg = std::to_string(loadThreads) + " load threads, " + timing.ToString();
+						Logger::WriteMessage(msg.c_str());
+					});
+				isLoadStopped = true;
+				for (std::thread &t : load)
+					t.join();
+			}
+			Logger::WriteMessage("End TestTimingUnderLoad()");
+		}
+	};
+}
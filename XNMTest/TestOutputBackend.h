@@ -0,0 +1,63 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\SendKey.h"
+#include "..\CountingOutputBackend.h"
+#include "..\RecordingOutputSink.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestOutputBackend)
+	{
+	public:
+		TEST_METHOD(TestSendKeyRouting)
+		{
+			Logger::WriteMessage("Begin TestSendKeyRouting()");
+			sds::Utilities::CountingOutputBackend counter;
+			sds::Utilities::SendKey::SetOutputBackend(&counter);
+			Assert::IsTrue(&sds::Utilities::SendKey::GetOutputBackend() == &counter);
+			sds::Utilities::SendKey sender;
+			sender.Send(VK_ESCAPE, true);
+			sender.Send(VK_ESCAPE, false);
+			sender.Send(VK_LBUTTON, true);
+			sender.Send(VK_LBUTTON, false);
+			sender.SendMouseMove(3, -4);
+			sender.SendMouseMove({ {1,1}, {2,2}, {3,3} });
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Assert::IsTrue(&sds::Utilities::SendKey::GetOutputBackend() != &counter);
+			Assert::AreEqual(std::uint64_t{ 2 }, counter.GetKeyCount());
+			Assert::AreEqual(std::uint64_t{ 2 }, counter.GetMouseButtonCount());
+			Assert::AreEqual(std::uint64_t{ 4 }, counter.GetMouseMoveCount());
+			//the vector of mouse moves is a single frame
+			Assert::AreEqual(std::uint64_t{ 6 }, counter.GetFrameCount());
+			Assert::AreEqual(std::uint64_t{ 8 }, counter.GetInputCount());
+			Assert::AreEqual(std::uint64_t{ 0 }, counter.GetFailedCount());
+			counter.ResetStats();
+			Assert::AreEqual(std::uint64_t{ 0 }, counter.GetFrameCount());
+			Logger::WriteMessage("End TestSendKeyRouting()");
+		}
+		TEST_METHOD(TestBackendSendCost)
+		{
+			Logger::WriteMessage("Begin TestBackendSendCost()");
+			constexpr int FrameCount = 100000;
+			sds::Utilities::CountingOutputBackend counter;
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey sender;
+			for (sds::Utilities::OutputBackend *backend : std::initializer_list<sds::Utilities::OutputBackend*>{ &counter, &sink })
+			{
+				sds::Utilities::SendKey::SetOutputBackend(backend);
+				for (int i = 0; i < FrameCount; i++)
+					sender.SendMouseMove(1, 1);
+				sds::Utilities::SendKey::SetOutputBackend(nullptr);
+				Assert::AreEqual(static_cast<std::uint64_t>(FrameCount), backend->GetFrameCount());
+				const std::string msg = backend->GetName() + " backend average ns per frame: " + std::to_string(backend->GetAverageFrameNanoseconds());
+				Logger::WriteMessage(msg.c_str());
+			}
+			Assert::AreEqual(static_cast<size_t>(FrameCount), sink.GetCount());
+			Logger::WriteMessage("End TestBackendSendCost()");
+		}
+	};
+}
@@ -0,0 +1,278 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\GamepadUser.h"
+#include "..\OutputRetryQueue.h"
+#include "..\RecordingOutputSink.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestOutputRetry)
+	{
+		/// <summary>
+		/// RecordingOutputSink that inserts nothing for a number of calls, and at most a number of records per frame.
+		/// A rejected key is refused once wherever it is in the frame, the records ahead of it are inserted.
+		/// </summary>
+		class FlakyOutputSink : public sds::Utilities::RecordingOutputSink
+		{
+			std::atomic<size_t> m_failCalls{ 0 };
+			std::atomic<size_t> m_frameLimit{ std::numeric_limits<size_t>::max() };
+			std::atomic<WORD> m_rejectedVk{ 0 };
+		protected:
+			size_t SendFrameImpl(const INPUT *inputs, const size_t count) override
+			{
+				if (m_failCalls.load() > 0)
+				{
+					m_failCalls--;
+					return 0;
+				}
+				size_t limit = std::min(count, m_frameLimit.load());
+				const WORD rejected = m_rejectedVk.load();
+				const INPUT *found = std::find_if(inputs, inputs + limit, [rejected](const INPUT &inp) { return rejected != 0 && inp.type == INPUT_KEYBOARD && inp.ki.wVk == rejected; });
+				if (found != inputs + limit)
+				{
+					m_rejectedVk = 0;
+					limit = static_cast<size_t>(found - inputs);
+				}
+				return RecordingOutputSink::SendFrameImpl(inputs, limit);
+			}
+		public:
+			std::string GetName() const override
+			{
+				return "flaky";
+			}
+			void FailCalls(const size_t calls)
+			{
+				m_failCalls = calls;
+			}
+			void SetFrameLimit(const size_t limit)
+			{
+				m_frameLimit = limit;
+			}
+			void RejectOnce(const WORD vk)
+			{
+				m_rejectedVk = vk;
+			}
+		};
+		static INPUT MakeKey(const WORD vk, const bool down)
+		{
+			INPUT inp = {};
+			inp.type = INPUT_KEYBOARD;
+			inp.ki.wVk = vk;
+			inp.ki.dwFlags = down ? 0 : KEYEVENTF_KEYUP;
+			return inp;
+		}
+		static INPUT MakeMove(const LONG dx)
+		{
+			INPUT inp = {};
+			inp.type = INPUT_MOUSE;
+			inp.mi.dx = dx;
+			inp.mi.dwFlags = MOUSEEVENTF_MOVE;
+			return inp;
+		}
+		static bool IsKey(const INPUT &inp, const WORD vk, const bool down)
+		{
+			return inp.type == INPUT_KEYBOARD && inp.ki.wVk == vk && ((inp.ki.dwFlags & KEYEVENTF_KEYUP) == 0) == down;
+		}
+	public:
+		TEST_METHOD(TestRetryKeepsOrder)
+		{
+			Logger::WriteMessage("Begin TestRetryKeepsOrder()");
+			using namespace std::chrono;
+			using sds::Utilities::RuntimeCounters;
+			sds::Utilities::OutputRetryQueue &queue = sds::Utilities::OutputRetryQueue::Get();
+			queue.Clear();
+			FlakyOutputSink sink;
+			//a failed key-down, the key-up sent after it waits behind it
+			sink.FailCalls(1);
+			const INPUT downA = MakeKey('A', true);
+			const INPUT upA = MakeKey('A', false);
+			Assert::AreEqual(size_t{ 0 }, queue.Send(sink, &downA, 1));
+			Assert::AreEqual(size_t{ 0 }, queue.Send(sink, &upA, 1));
+			Assert::AreEqual(size_t{ 2 }, queue.GetPendingCount());
+			Assert::IsTrue(queue.Flush(sink, seconds(1)));
+			//a frame inserted in part, the tail is queued
+			sink.SetFrameLimit(1);
+			const std::array<INPUT, 3> frame = { MakeKey('B', true), MakeKey('C', true), MakeKey('D', true) };
+			Assert::AreEqual(size_t{ 1 }, queue.Send(sink, frame.data(), frame.size()));
+			Assert::AreEqual(size_t{ 2 }, queue.GetPendingCount());
+			Assert::IsTrue(queue.Flush(sink, seconds(1)));
+			sink.SetFrameLimit(std::numeric_limits<size_t>::max());
+			//a backend inserting nothing for a while is reported once
+			const std::uint64_t persistentBefore = RuntimeCounters::Get().Snapshot().sendInputPersistentFailures;
+			sink.FailCalls(sds::XinSettings::OUTPUT_RETRY_PERSISTENT + 1);
+			const INPUT downE = MakeKey('E', true);
+			queue.Send(sink, &downE, 1);
+			Assert::IsTrue(queue.Flush(sink, seconds(1)));
+			Assert::AreEqual(persistentBefore + 1, RuntimeCounters::Get().Snapshot().sendInputPersistentFailures);
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 6 }, events.size());
+			Assert::IsTrue(IsKey(events[0], 'A', true));
+			Assert::IsTrue(IsKey(events[1], 'A', false));
+			Assert::IsTrue(IsKey(events[2], 'B', true));
+			Assert::IsTrue(IsKey(events[3], 'C', true));
+			Assert::IsTrue(IsKey(events[4], 'D', true));
+			Assert::IsTrue(IsKey(events[5], 'E', true));
+			queue.Clear();
+			Logger::WriteMessage("End TestRetryKeepsOrder()");
+		}
+		TEST_METHOD(TestRejectInFrame)
+		{
+			Logger::WriteMessage("Begin TestRejectInFrame()");
+			using namespace std::chrono;
+			sds::Utilities::OutputRetryQueue &queue = sds::Utilities::OutputRetryQueue::Get();
+			queue.Clear();
+			FlakyOutputSink sink;
+			//a record refused in the middle of a frame, the records ahead of it are not sent again
+			sink.RejectOnce('B');
+			const std::array<INPUT, 3> frame = { MakeKey('A', true), MakeKey('B', true), MakeKey('C', true) };
+			Assert::AreEqual(size_t{ 1 }, queue.Send(sink, frame.data(), frame.size()));
+			Assert::AreEqual(size_t{ 2 }, queue.GetPendingCount());
+			//the key-up sent after it waits behind the refused record, and is delivered once it is
+			const INPUT upA = MakeKey('A', false);
+			queue.Send(sink, &upA, 1);
+			Assert::IsTrue(queue.Flush(sink, seconds(1)));
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 4 }, events.size());
+			Assert::IsTrue(IsKey(events[0], 'A', true));
+			Assert::IsTrue(IsKey(events[1], 'B', true));
+			Assert::IsTrue(IsKey(events[2], 'C', true));
+			Assert::IsTrue(IsKey(events[3], 'A', false));
+			Assert::AreEqual(sink.GetInputCount(), std::uint64_t{ events.size() });
+			queue.Clear();
+			Logger::WriteMessage("End TestRejectInFrame()");
+		}
+		TEST_METHOD(TestOverflowDropsMovesFirst)
+		{
+			Logger::WriteMessage("Begin TestOverflowDropsMovesFirst()");
+			using namespace std::chrono;
+			using sds::Utilities::RuntimeCounters;
+			constexpr size_t KeyCount = 10;
+			constexpr size_t Excess = 15;
+			sds::Utilities::OutputRetryQueue &queue = sds::Utilities::OutputRetryQueue::Get();
+			queue.Clear();
+			FlakyOutputSink sink;
+			sink.FailCalls(std::numeric_limits<size_t>::max());
+			const std::uint64_t droppedBefore = RuntimeCounters::Get().Snapshot().outputDropped;
+			for (size_t i = 0; i < KeyCount; i++)
+			{
+				const INPUT down = MakeKey(static_cast<WORD>('A' + i), true);
+				queue.Send(sink, &down, 1);
+			}
+			for (size_t i = 0; i < sds::XinSettings::OUTPUT_RETRY_QUEUE_MAX + Excess - 2 * KeyCount; i++)
+			{
+				const INPUT move = MakeMove(static_cast<LONG>(i));
+				queue.Send(sink, &move, 1);
+			}
+			for (size_t i = 0; i < KeyCount; i++)
+			{
+				const INPUT up = MakeKey(static_cast<WORD>('A' + i), false);
+				queue.Send(sink, &up, 1);
+			}
+			Assert::AreEqual(sds::XinSettings::OUTPUT_RETRY_QUEUE_MAX, queue.GetPendingCount());
+			Assert::AreEqual(droppedBefore + Excess, RuntimeCounters::Get().Snapshot().outputDropped);
+			//every key survives, the oldest moves were dropped
+			sink.FailCalls(0);
+			Assert::IsTrue(queue.Flush(sink, seconds(1)));
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(sds::XinSettings::OUTPUT_RETRY_QUEUE_MAX, events.size());
+			for (size_t i = 0; i < KeyCount; i++)
+			{
+				Assert::IsTrue(IsKey(events[i], static_cast<WORD>('A' + i), true));
+				Assert::IsTrue(IsKey(events[events.size() - KeyCount + i], static_cast<WORD>('A' + i), false));
+			}
+			Assert::AreEqual(static_cast<LONG>(Excess), events[KeyCount].mi.dx);
+			queue.Clear();
+			Logger::WriteMessage("End TestOverflowDropsMovesFirst()");
+		}
+		TEST_METHOD(TestOverflowKeepsReleases)
+		{
+			Logger::WriteMessage("Begin TestOverflowKeepsReleases()");
+			using namespace std::chrono;
+			using sds::Utilities::RuntimeCounters;
+			constexpr size_t Extra = 5;
+			sds::Utilities::OutputRetryQueue &queue = sds::Utilities::OutputRetryQueue::Get();
+			queue.Clear();
+			FlakyOutputSink sink;
+			sink.FailCalls(std::numeric_limits<size_t>::max());
+			//a full queue of presses, the newest presses are refused and every release is kept
+			for (size_t i = 0; i < sds::XinSettings::OUTPUT_RETRY_QUEUE_MAX; i++)
+			{
+				const INPUT down = MakeKey(static_cast<WORD>('A' + i % 26), true);
+				queue.Send(sink, &down, 1);
+			}
+			const sds::Utilities::RuntimeStats before = RuntimeCounters::Get().Snapshot();
+			for (size_t i = 0; i < Extra; i++)
+			{
+				const INPUT down = MakeKey('0', true);
+				queue.Send(sink, &down, 1);
+			}
+			Assert::AreEqual(sds::XinSettings::OUTPUT_RETRY_QUEUE_MAX, queue.GetPendingCount());
+			for (size_t i = 0; i < Extra; i++)
+			{
+				const INPUT up = MakeKey(static_cast<WORD>('A' + i), false);
+				queue.Send(sink, &up, 1);
+			}
+			Assert::AreEqual(sds::XinSettings::OUTPUT_RETRY_QUEUE_MAX + Extra, queue.GetPendingCount());
+			const sds::Utilities::RuntimeStats after = RuntimeCounters::Get().Snapshot();
+			Assert::AreEqual(std::uint64_t{ Extra }, after.outputDropped - before.outputDropped);
+			Assert::AreEqual(std::uint64_t{ Extra }, after.sendInputErrors - before.sendInputErrors);
+			sink.FailCalls(0);
+			Assert::IsTrue(queue.Flush(sink, seconds(1)));
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(sds::XinSettings::OUTPUT_RETRY_QUEUE_MAX + Extra, events.size());
+			Assert::IsTrue(std::none_of(events.begin(), events.end(), [](const INPUT &inp) { return inp.ki.wVk == '0'; }));
+			for (size_t i = 0; i < Extra; i++)
+				Assert::IsTrue(IsKey(events[events.size() - Extra + i], static_cast<WORD>('A' + i), false));
+			queue.Clear();
+			Logger::WriteMessage("End TestOverflowKeepsReleases()");
+		}
+		TEST_METHOD(TestQueuedIsNotError)
+		{
+			Logger::WriteMessage("Begin TestQueuedIsNotError()");
+			using namespace std::chrono;
+			using sds::Utilities::RuntimeCounters;
+			sds::Utilities::OutputRetryQueue::Get().Clear();
+			FlakyOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			//a frame refused once is queued for retry and delivered, which is not an error
+			const sds::Utilities::RuntimeStats before = RuntimeCounters::Get().Snapshot();
+			sink.FailCalls(1);
+			sds::Utilities::SendKey sender;
+			sender.Send(VK_ESCAPE, true);
+			Assert::IsTrue(sds::Utilities::SendKey::FlushOutput());
+			const sds::Utilities::RuntimeStats after = RuntimeCounters::Get().Snapshot();
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Assert::AreEqual(std::uint64_t{ 1 }, after.sendInputQueued - before.sendInputQueued);
+			Assert::AreEqual(std::uint64_t{ 0 }, after.sendInputErrors - before.sendInputErrors);
+			Assert::AreEqual(size_t{ 1 }, sink.GetEvents().size());
+			Logger::WriteMessage("End TestQueuedIsNotError()");
+		}
+		TEST_METHOD(TestReleaseOnExit)
+		{
+			Logger::WriteMessage("Begin TestReleaseOnExit()");
+			sds::Utilities::OutputRetryQueue::Get().Clear();
+			FlakyOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			{
+				sds::GamepadUser user;
+				Assert::IsTrue(user.mapper.SetMapInfo("A:NONE:NORM:VK65").empty());
+				XINPUT_STATE state = {};
+				state.Gamepad.wButtons = XINPUT_GAMEPAD_A;
+				user.poller.ProcessState(state);
+				//the key-up sent on exit is refused a few times, and still delivered
+				sink.FailCalls(3);
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Assert::AreEqual(size_t{ 0 }, sds::Utilities::OutputRetryQueue::Get().GetPendingCount());
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 2 }, events.size());
+			Assert::IsTrue(IsKey(events[0], 'A', true));
+			Assert::IsTrue(IsKey(events[1], 'A', false));
+			Logger::WriteMessage("End TestReleaseOnExit()");
+		}
+	};
+}
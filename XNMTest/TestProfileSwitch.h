@@ -0,0 +1,170 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\GamepadUser.h"
+#include "..\ProfileSelector.h"
+#include "..\RecordingOutputSink.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestProfileSwitch)
+	{
+		/// <summary>
+		/// ProfileSelector returning a scripted selection for each poll.
+		/// </summary>
+		class ScriptedProfileSelector : public sds::ProfileSelector
+		{
+			std::vector<std::optional<size_t>> m_script;
+			size_t m_next = 0;
+		public:
+			explicit ScriptedProfileSelector(std::vector<std::optional<size_t>> script) : m_script(std::move(script)) { }
+			std::optional<size_t> PollSelection() override
+			{
+				return m_next < m_script.size() ? m_script[m_next++] : std::optional<size_t>();
+			}
+			std::string GetName() const override
+			{
+				return "scripted";
+			}
+		};
+		static bool IsKey(const INPUT &inp, const WORD vk, const bool down)
+		{
+			return inp.type == INPUT_KEYBOARD && inp.ki.wVk == vk && ((inp.ki.dwFlags & KEYEVENTF_KEYUP) == 0) == down;
+		}
+	public:
+		TEST_METHOD(TestSwitchReleasesHeldKeys)
+		{
+			Logger::WriteMessage("Begin TestSwitchReleasesHeldKeys()");
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			sds::Mapper mp;
+			Assert::IsTrue(mp.SetMapInfo("A:NONE:NORM:VK65 B:NONE:TOGGLE:VK66").empty());
+			size_t id = 0;
+			Assert::IsTrue(mp.AddProfile("A:NONE:NORM:VK67", id).empty());
+			Assert::AreEqual(size_t{ 1 }, id);
+			Assert::AreEqual(size_t{ 2 }, mp.GetProfileCount());
+			Assert::IsFalse(mp.ActivateProfile(2).empty());
+			Assert::IsFalse(mp.AddProfile("A:NONE:NORM:zz", id).empty());
+			//A held, B toggled on and released
+			mp.ProcessActionDetails("A B");
+			mp.ProcessActionDetails("A");
+			Assert::IsTrue(mp.ActivateProfile(1).empty());
+			Assert::AreEqual(size_t{ 0 }, mp.GetActiveProfile());
+			mp.ProcessActionDetails("A");
+			Assert::AreEqual(size_t{ 1 }, mp.GetActiveProfile());
+			Assert::IsTrue(mp.GetMapInfo() == "A:NONE:NORM:VK67");
+			//and back, the first profile starts from released
+			Assert::IsTrue(mp.ActivateProfile(0).empty());
+			mp.ProcessActionDetails("A");
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			const std::vector<INPUT> events = sink.GetEvents();
+			Assert::AreEqual(size_t{ 7 }, events.size());
+			Assert::IsTrue(IsKey(events[0], 'A', true));
+			Assert::IsTrue(IsKey(events[1], 'B', true));
+			Assert::IsTrue(IsKey(events[2], 'A', false));
+			Assert::IsTrue(IsKey(events[3], 'B', false));
+			Assert::IsTrue(IsKey(events[4], 'C', true));
+			Assert::IsTrue(IsKey(events[5], 'C', false));
+			Assert::IsTrue(IsKey(events[6], 'A', true));
+			Logger::WriteMessage("End TestSwitchReleasesHeldKeys()");
+		}
+		TEST_METHOD(TestSwitchCost)
+		{
+			Logger::WriteMessage("Begin TestSwitchCost()");
+			using namespace std::chrono;
+			constexpr size_t ProfileCount = 8;
+			constexpr int Iterations = 200;
+			const std::vector<std::string> controls = { "A", "B", "X", "Y", "LSHOULDER", "RSHOULDER", "START", "BACK", "LTRIGGER", "RTRIGGER" };
+			std::vector<std::string> maps;
+			for (size_t p = 0; p < ProfileCount; p++)
+			{
+				std::string map;
+				for (size_t i = 0; i < 100; i++)
+					map += controls[i % controls.size()] + "+" + controls[(i / controls.size() + i + 1) % controls.size()]
+						+ ":NONE:NORM:VK" + std::to_string(65 + (i + p) % 26) + " ";
+				maps.push_back(map);
+			}
+			sds::Mapper mp;
+			Assert::IsTrue(mp.SetMapInfo(maps[0]).empty());
+			for (size_t p = 1; p < ProfileCount; p++)
+			{
+				size_t id = 0;
+				Assert::IsTrue(mp.AddProfile(maps[p], id).empty());
+			}
+			//switching is an index store seen by the next processed state
+			const auto switchStart = steady_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				Assert::IsTrue(mp.ActivateProfile(static_cast<size_t>(i) % ProfileCount).empty());
+				mp.ProcessActionDetails("");
+			}
+			const double switchMicros = duration<double, std::micro>(steady_clock::now() - switchStart).count() / Iterations;
+			//reloading parses and validates the map
+			const auto reloadStart = steady_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				Assert::IsTrue(mp.SetMapInfo(maps[static_cast<size_t>(i) % ProfileCount]).empty());
+				mp.ProcessActionDetails("");
+			}
+			const double reloadMicros = duration<double, std::micro>(steady_clock::now() - reloadStart).count() / Iterations;
+			const std::string msg = "100 binding profile, switch: " + std::to_string(switchMicros) + " us, SetMapInfo: " + std::to_string(reloadMicros) + " us";
+			Logger::WriteMessage(msg.c_str());
+			Assert::IsTrue(switchMicros < reloadMicros);
+			Logger::WriteMessage("End TestSwitchCost()");
+		}
+		TEST_METHOD(TestSelectors)
+		{
+			Logger::WriteMessage("Begin TestSelectors()");
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			{
+				sds::GamepadUser user;
+				Assert::IsTrue(user.mapper.SetMapInfo("A:NONE:NORM:VK65").empty());
+				size_t id = 0;
+				Assert::IsTrue(user.mapper.AddProfile("A:NONE:NORM:VK66", id).empty());
+				//an id out of range is logged and ignored
+				ScriptedProfileSelector scripted({ {}, 1, 7, {} });
+				user.poller.SetProfileSelector(&scripted);
+				XINPUT_STATE state = {};
+				state.Gamepad.wButtons = XINPUT_GAMEPAD_A;
+				user.poller.ProcessState(state);
+				user.poller.ProcessState(state);
+				user.poller.ProcessState(state);
+				Assert::AreEqual(size_t{ 1 }, user.mapper.GetActiveProfile());
+				sds::ApiProfileSelector api;
+				user.poller.SetProfileSelector(&api);
+				Assert::IsFalse(api.PollSelection().has_value());
+				api.Select(0);
+				user.poller.ProcessState(state);
+				Assert::AreEqual(size_t{ 0 }, user.mapper.GetActiveProfile());
+				user.poller.SetProfileSelector(nullptr);
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			const std::vector<INPUT> events = sink.GetEvents();
+			//A is released when the user is destroyed
+			Assert::AreEqual(size_t{ 6 }, events.size());
+			Assert::IsTrue(IsKey(events[0], 'A', true));
+			Assert::IsTrue(IsKey(events[1], 'A', false));
+			Assert::IsTrue(IsKey(events[2], 'B', true));
+			Assert::IsTrue(IsKey(events[3], 'B', false));
+			Assert::IsTrue(IsKey(events[4], 'A', true));
+			Assert::IsTrue(IsKey(events[5], 'A', false));
+			//an id written to the pipe by another process
+			const std::string pipeName = sds::PipeProfileSelector::DefaultPipeName() + "-test";
+			sds::PipeProfileSelector pipe;
+			Assert::IsTrue(pipe.Open(pipeName).empty());
+			Assert::IsFalse(pipe.PollSelection().has_value());
+			Assert::IsTrue(sds::PipeProfileSelector::Send(3, pipeName).empty());
+			Assert::AreEqual(size_t{ 3 }, pipe.PollSelection().value_or(0));
+			Assert::IsFalse(pipe.PollSelection().has_value());
+			pipe.Close();
+#ifndef _WIN32
+			std::remove(pipeName.c_str());
+#endif
+			Logger::WriteMessage("End TestSelectors()");
+		}
+	};
+}
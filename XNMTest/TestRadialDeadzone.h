@@ -0,0 +1,87 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "TemplatesForTest.h"
+#include "..\stdafx.h"
+#include "..\RadialDeadzone.h"
+#include "..\ButtonStateDown.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestRadialDeadzone)
+	{
+		const int DefaultDeadzone = XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE;
+
+		inline static constexpr const short SMax = std::numeric_limits<SHORT>::max();
+		inline static constexpr const short SMin = std::numeric_limits<SHORT>::min();
+
+		TEST_METHOD(TestApply)
+		{
+			using namespace TemplatesForTest;
+			const std::wstring TestName = L"TestApply()";
+			Logger::WriteMessage(std::wstring(L"Begin " + TestName).c_str());
+
+			const sds::RadialDeadzone radial(sds::DeadzoneMode::RADIAL, DefaultDeadzone);
+			const sds::RadialDeadzone scaled(sds::DeadzoneMode::SCALED_RADIAL, DefaultDeadzone);
+			auto testValues = [](const sds::RadialDeadzone &dz, const int x, const int y, const int compX, const int compY, const int within = 2)
+			{
+				const auto [rx, ry] = dz.Apply(x, y);
+				std::wstring msg = L"Tested: X" + std::to_wstring(x) + L" Y:" + std::to_wstring(y);
+				msg += L" Result: " + std::to_wstring(rx) + L"," + std::to_wstring(ry);
+				Assert::IsTrue(IsWithin(rx, compX, within) && IsWithin(ry, compY, within), msg.c_str());
+			};
+			//inside the radius, including a diagonal that is outside of a square deadzone's corner test
+			const int diag = (DefaultDeadzone * 7) / 10;
+			testValues(radial, diag, diag, 0, 0);
+			testValues(scaled, -diag, diag, 0, 0);
+			//radial leaves values outside the radius unchanged
+			testValues(radial, DefaultDeadzone + 10, 0, DefaultDeadzone + 10, 0);
+			testValues(radial, SMin, SMax, SMin, SMax);
+			//scaled radial starts at zero just past the radius and reaches full range at the edge
+			testValues(scaled, DefaultDeadzone + 1, 0, 0, 0, 10);
+			testValues(scaled, SMax, 0, SMax, 0, 10);
+			testValues(scaled, 0, SMin, 0, SMin, 10);
+			const int half = DefaultDeadzone + ((SMax - DefaultDeadzone) / 2);
+			testValues(scaled, half, 0, SMax / 2, 0, 100);
+			//full diagonal is clamped to the full magnitude, direction preserved
+			const int diagMax = static_cast<int>(SMax / std::sqrt(2.0));
+			testValues(scaled, SMax, SMax, diagMax, diagMax, 10);
+			Logger::WriteMessage(std::wstring(L"End " + TestName).c_str());
+		}
+
+		TEST_METHOD(TestThumbstickDownRadial)
+		{
+			const std::wstring TestName = L"TestThumbstickDownRadial()";
+			Logger::WriteMessage(std::wstring(L"Begin " + TestName).c_str());
+			sds::PlayerInfo pl;
+			pl.deadzone_mode = sds::DeadzoneMode::SCALED_RADIAL;
+			const sds::ButtonStateDown bsd(pl);
+			auto testValues = [&bsd](const SHORT x, const SHORT y, const std::array<bool,4> &expected)
+			{
+				XINPUT_STATE state = {};
+				state.Gamepad.sThumbLX = x;
+				state.Gamepad.sThumbLY = y;
+				const std::array<std::string, 4> tokens = { "LTHUMB:LEFT", "LTHUMB:RIGHT", "LTHUMB:UP", "LTHUMB:DOWN" };
+				for (size_t i = 0; i < tokens.size(); i++)
+				{
+					std::wstring msg = L"Tested: X" + std::to_wstring(x) + L" Y:" + std::to_wstring(y) + L" token index: " + std::to_wstring(i);
+					Assert::AreEqual(expected[i], bsd.ThumbstickDown(state, tokens[i]), msg.c_str());
+				}
+			};
+			//centered and inside the radius
+			testValues(0, 0, { false,false,false,false });
+			testValues(5000, 5000, { false,false,false,false });
+			//cardinal directions
+			testValues(SMin, 0, { true,false,false,false });
+			testValues(SMax, 1000, { false,true,false,false });
+			testValues(2000, SMax, { false,false,true,false });
+			testValues(0, SMin, { false,false,false,true });
+			//diagonals report both directions
+			testValues(-20000, 20000, { true,false,true,false });
+			testValues(20000, -20000, { false,true,false,true });
+			Logger::WriteMessage(std::wstring(L"End " + TestName).c_str());
+		}
+	};
+}
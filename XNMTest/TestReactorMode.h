@@ -0,0 +1,158 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\GamepadUser.h"
+#include "..\DeadlineQueue.h"
+#include "..\OutputBackend.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	/// <summary>
+	/// OutputBackend that keeps the time of the first key and first mouse move it receives, and counts the moves.
+	/// </summary>
+	class FirstOutputBackend : public sds::Utilities::OutputBackend
+	{
+	public:
+		using ClockType = std::chrono::steady_clock;
+	private:
+		std::atomic<ClockType::rep> m_firstKey{ 0 };
+		std::atomic<ClockType::rep> m_firstMove{ 0 };
+		std::atomic<std::uint64_t> m_moveCount{ 0 };
+	protected:
+		size_t SendFrameImpl(const INPUT *inputs, const size_t count) override
+		{
+			const ClockType::rep now = ClockType::now().time_since_epoch().count();
+			for (size_t i = 0; i < count; i++)
+			{
+				ClockType::rep none = 0;
+				if (inputs[i].type == INPUT_KEYBOARD)
+				{
+					m_firstKey.compare_exchange_strong(none, now);
+				}
+				else if (inputs[i].mi.dwFlags & MOUSEEVENTF_MOVE)
+				{
+					m_firstMove.compare_exchange_strong(none, now);
+					m_moveCount.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			return count;
+		}
+	public:
+		std::string GetName() const override
+		{
+			return "first";
+		}
+		/// <summary>
+		/// Returns microseconds from "since" to the first key, or -1 if no key was sent.
+		/// </summary>
+		double KeyLatency(const ClockType::time_point since) const
+		{
+			return Latency(m_firstKey, since);
+		}
+		double MoveLatency(const ClockType::time_point since) const
+		{
+			return Latency(m_firstMove, since);
+		}
+		std::uint64_t GetMoveCount() const
+		{
+			return m_moveCount;
+		}
+	private:
+		static double Latency(const std::atomic<ClockType::rep> &first, const ClockType::time_point since)
+		{
+			if (first == 0)
+				return -1.0;
+			const ClockType::time_point at{ ClockType::duration(first.load()) };
+			return std::chrono::duration<double, std::micro>(at - since).count();
+		}
+	};
+
+	TEST_CLASS(TestReactorMode)
+	{
+		//Process CPU time used so far, in seconds.
+		static double ProcessCpuSeconds()
+		{
+#ifdef _WIN32
+			FILETIME creation, exitTime, kernel, user;
+			GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user);
+			auto toSeconds = [](const FILETIME &ft) { return ((static_cast<std::uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 1e7; };
+			return toSeconds(kernel) + toSeconds(user);
+#else
+			return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+		}
+	public:
+		TEST_METHOD(TestDeadlineQueue)
+		{
+			Logger::WriteMessage("Begin TestDeadlineQueue()");
+			using namespace std::chrono;
+			sds::DeadlineQueue queue(3);
+			const sds::DeadlineQueue::TimePoint t0 = sds::DeadlineQueue::ClockType::now();
+			Assert::IsTrue(queue.NextDue() == sds::DeadlineQueue::TimePoint::max());
+			queue.Schedule(0, t0 + milliseconds(3));
+			queue.Schedule(1, t0 + milliseconds(1));
+			queue.Schedule(2, t0 + milliseconds(2));
+			//replacing a deadline and cancelling leave stale entries that must be skipped
+			queue.Schedule(0, t0 + milliseconds(4));
+			queue.Cancel(2);
+			Assert::IsFalse(queue.IsScheduled(2));
+			Assert::IsTrue(queue.NextDue() == t0 + milliseconds(1));
+			Assert::IsFalse(queue.PopDue(t0).has_value());
+			Assert::AreEqual(size_t{ 1 }, queue.PopDue(t0 + milliseconds(10)).value());
+			Assert::AreEqual(size_t{ 0 }, queue.PopDue(t0 + milliseconds(10)).value());
+			Assert::IsFalse(queue.PopDue(t0 + milliseconds(10)).has_value());
+			Assert::IsFalse(queue.IsScheduled(0));
+			Logger::WriteMessage("End TestDeadlineQueue()");
+		}
+		TEST_METHOD(TestReactorVsThreaded)
+		{
+			Logger::WriteMessage("Begin TestReactorVsThreaded()");
+			using namespace std::chrono;
+			const std::vector<std::pair<std::string, sds::ExecutionMode>> modes = {
+				{ "threaded", sds::ExecutionMode::THREADED },
+				{ "reactor", sds::ExecutionMode::REACTOR } };
+			for (const auto &[label, mode] : modes)
+			{
+				FirstOutputBackend backend;
+				sds::Utilities::SendKey::SetOutputBackend(&backend);
+				const FirstOutputBackend::ClockType::time_point pressAt = FirstOutputBackend::ClockType::now() + milliseconds(200);
+				{
+					sds::GamepadUser user(mode);
+					Assert::IsTrue(user.mapper.SetMapInfo("A:NONE:NORM:VK32").empty());
+					Assert::IsTrue(user.mouse.SetSensitivity(65).empty());
+					user.mouse.EnableProcessing(sds::MouseMap::RIGHT_STICK);
+					//A and the right stick held to the right from pressAt on
+					user.poller.SetStateSource([pressAt](DWORD, XINPUT_STATE *state)
+						{
+							memset(state, 0, sizeof(XINPUT_STATE));
+							if (FirstOutputBackend::ClockType::now() >= pressAt)
+							{
+								state->Gamepad.wButtons = XINPUT_GAMEPAD_A;
+								state->Gamepad.sThumbRX = std::numeric_limits<SHORT>::max();
+							}
+							return static_cast<DWORD>(ERROR_SUCCESS);
+						});
+					const double cpuStart = ProcessCpuSeconds();
+					const auto wallStart = steady_clock::now();
+					Assert::IsTrue(user.poller.Start());
+					std::this_thread::sleep_for(milliseconds(1200));
+					user.poller.Stop();
+					const double cpuPercent = 100.0 * (ProcessCpuSeconds() - cpuStart) / duration<double>(steady_clock::now() - wallStart).count();
+					const std::string msg = label + " mode, key latency us: " + std::to_string(backend.KeyLatency(pressAt))
+						+ " mouse latency us: " + std::to_string(backend.MoveLatency(pressAt))
+						+ " moves sent: " + std::to_string(backend.GetMoveCount())
+						+ " process cpu %: " + std::to_string(cpuPercent);
+					Logger::WriteMessage(msg.c_str());
+				}
+				sds::Utilities::SendKey::SetOutputBackend(nullptr);
+				Assert::IsTrue(backend.KeyLatency(pressAt) >= 0.0);
+				Assert::IsTrue(backend.MoveLatency(pressAt) >= 0.0);
+				Assert::IsTrue(backend.GetMoveCount() > 0);
+			}
+			Logger::WriteMessage("End TestReactorVsThreaded()");
+		}
+	};
+}
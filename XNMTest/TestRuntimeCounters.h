@@ -0,0 +1,93 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\GamepadUser.h"
+#include "..\RuntimeCounters.h"
+#include "..\RecordingOutputSink.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestRuntimeCounters)
+	{
+	public:
+		TEST_METHOD(TestPipelineCounts)
+		{
+			Logger::WriteMessage("Begin TestPipelineCounts()");
+			using namespace std::chrono;
+			sds::Utilities::RecordingOutputSink sink;
+			sds::Utilities::SendKey::SetOutputBackend(&sink);
+			{
+				sds::GamepadUser user;
+				Assert::IsTrue(user.mapper.SetMapInfo("A:NONE:NORM:VK65").empty());
+				const sds::Utilities::RuntimeStats before = user.GetStats();
+				XINPUT_STATE state = {};
+				state.Gamepad.wButtons = XINPUT_GAMEPAD_A;
+				user.poller.ProcessState(state);
+				user.poller.ProcessState(state);
+				state.Gamepad.wButtons = 0;
+				user.poller.ProcessState(state);
+				const sds::Utilities::RuntimeStats after = user.GetStats();
+				Assert::AreEqual(std::uint64_t{ 3 }, after.frames - before.frames);
+				Assert::AreEqual(std::uint64_t{ 2 }, after.keysSent - before.keysSent);
+				Assert::AreEqual(std::uint64_t{ 2 }, after.sendInputCalls - before.sendInputCalls);
+				Assert::AreEqual(std::uint64_t{ 0 }, after.sendInputErrors - before.sendInputErrors);
+				//every other poll fails
+				std::atomic<int> calls{ 0 };
+				user.poller.SetStateSource([&calls](DWORD, XINPUT_STATE *s)
+					{
+						memset(s, 0, sizeof(XINPUT_STATE));
+						return static_cast<DWORD>(calls.fetch_add(1) % 2 == 0 ? ERROR_SUCCESS : ERROR_DEVICE_NOT_CONNECTED);
+					});
+				Assert::IsTrue(user.poller.Start());
+				std::this_thread::sleep_for(milliseconds(100));
+				user.poller.Stop();
+				const sds::Utilities::RuntimeStats polled = user.GetStats();
+				Assert::AreEqual(static_cast<std::uint64_t>(calls.load()), polled.polls - after.polls);
+				Assert::AreEqual(static_cast<std::uint64_t>(calls.load() / 2), polled.pollFailures - after.pollFailures);
+				Assert::AreEqual(polled.polls - after.polls - (polled.pollFailures - after.pollFailures), polled.frames - after.frames);
+				Logger::WriteMessage(("Stats " + polled.ToString()).c_str());
+			}
+			sds::Utilities::SendKey::SetOutputBackend(nullptr);
+			Logger::WriteMessage("End TestPipelineCounts()");
+		}
+		TEST_METHOD(TestShardedCounting)
+		{
+			Logger::WriteMessage("Begin TestShardedCounting()");
+			using namespace std::chrono;
+			using sds::Utilities::RuntimeCounters;
+			constexpr int ThreadCount = 4;
+			constexpr int Adds = 1000000;
+			auto runThreads = [](const std::function<void()> &work)
+			{
+				const auto start = steady_clock::now();
+				std::vector<std::thread> threads;
+				for (int t = 0; t < ThreadCount; t++)
+					threads.emplace_back(work);
+				for (std::thread &t : threads)
+					t.join();
+				return duration<double, std::nano>(steady_clock::now() - start).count() / (static_cast<double>(ThreadCount) * Adds);
+			};
+			RuntimeCounters counters;
+			const double shardedNanos = runThreads([&counters]()
+				{
+					for (int i = 0; i < Adds; i++)
+						counters.Add(RuntimeCounters::Counter::FRAMES);
+				});
+			Assert::AreEqual(static_cast<std::uint64_t>(ThreadCount) * Adds, counters.Snapshot().frames);
+			//one counter written by every thread, for comparison
+			std::atomic<std::uint64_t> shared{ 0 };
+			const double sharedNanos = runThreads([&shared]()
+				{
+					for (int i = 0; i < Adds; i++)
+						shared.fetch_add(1, std::memory_order_relaxed);
+				});
+			Assert::AreEqual(static_cast<std::uint64_t>(ThreadCount) * Adds, shared.load());
+			const std::string msg = "ns per add, per-thread shards: " + std::to_string(shardedNanos) + " one shared counter: " + std::to_string(sharedNanos);
+			Logger::WriteMessage(msg.c_str());
+			Logger::WriteMessage("End TestShardedCounting()");
+		}
+	};
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\CPPThreadRunner.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	/// <summary>
+	/// Worker that wakes on a fixed period and records how late each wake up was, in microseconds.
+	/// </summary>
+	class WakeLatenessRunner : public sds::CPPThreadRunner<int>
+	{
+		const std::chrono::microseconds m_period;
+		const int m_wakeCount;
+		std::vector<double> m_lateness;
+	protected:
+		void workThread() override
+		{
+			using namespace std::chrono;
+			auto deadline = steady_clock::now() + m_period;
+			for (int i = 0; i < m_wakeCount && !isStopRequested; i++)
+			{
+				std::this_thread::sleep_until(deadline);
+				m_lateness.push_back(duration<double, std::micro>(steady_clock::now() - deadline).count());
+				deadline += m_period;
+			}
+			isThreadRunning = false;
+		}
+	public:
+		WakeLatenessRunner(const sds::ThreadPolicy &policy, const std::chrono::microseconds period, const int wakeCount)
+			: CPPThreadRunner<int>(policy), m_period(period), m_wakeCount(wakeCount)
+		{
+			m_lateness.reserve(wakeCount);
+		}
+		~WakeLatenessRunner() override
+		{
+			stopThread();
+		}
+		/// <summary>
+		/// Runs the thread to completion and returns the lateness of each wake up.
+		/// </summary>
+		std::vector<double> Run()
+		{
+			m_lateness.clear();
+			startThread();
+			while (isThreadRunning)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			stopThread();
+			return m_lateness;
+		}
+	};
+
+	TEST_CLASS(TestThreadPolicy)
+	{
+	public:
+		TEST_METHOD(TestPolicyFallsBack)
+		{
+			Logger::WriteMessage("Begin TestPolicyFallsBack()");
+			//asks for more than an unprivileged process may have, the thread must still run
+			sds::ThreadPolicy policy = sds::ThreadPolicy::ForMouseMove();
+			policy.priority = sds::ThreadPriority::TIME_CRITICAL;
+			policy.affinityMask = 1;
+			WakeLatenessRunner runner(policy, std::chrono::microseconds(500), 10);
+			Assert::AreEqual(size_t{ 10 }, runner.Run().size());
+			const std::string msg = "Policy error: \"" + runner.GetThreadPolicyError() + "\"";
+			Logger::WriteMessage(msg.c_str());
+			//the default policy has nothing that can fail
+			WakeLatenessRunner plain(sds::ThreadPolicy{}, std::chrono::microseconds(500), 10);
+			Assert::AreEqual(size_t{ 10 }, plain.Run().size());
+			Assert::IsTrue(plain.GetThreadPolicyError().empty());
+			Logger::WriteMessage("End TestPolicyFallsBack()");
+		}
+		TEST_METHOD(TestWakeJitter)
+		{
+			Logger::WriteMessage("Begin TestWakeJitter()");
+			constexpr int WakeCount = 2000;
+			const std::vector<std::pair<std::string, sds::ThreadPolicy>> policies = {
+				{ "default", sds::ThreadPolicy{} },
+				{ "mousemove", sds::ThreadPolicy::ForMouseMove() } };
+			for (const auto &[label, policy] : policies)
+			{
+				WakeLatenessRunner runner(policy, std::chrono::microseconds(1000), WakeCount);
+				std::vector<double> lateness = runner.Run();
+				Assert::AreEqual(static_cast<size_t>(WakeCount), lateness.size());
+				std::sort(lateness.begin(), lateness.end());
+				double sum = 0.0;
+				for (const double l : lateness)
+					sum += l;
+				const std::string msg = label + " policy wake lateness us, mean: " + std::to_string(sum / WakeCount)
+					+ " p99: " + std::to_string(lateness[WakeCount * 99 / 100])
+					+ " max: " + std::to_string(lateness.back());
+				Logger::WriteMessage(msg.c_str());
+			}
+			Logger::WriteMessage("End TestWakeJitter()");
+		}
+	};
+}
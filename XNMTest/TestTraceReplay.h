@@ -0,0 +1,111 @@
+#pragma once
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "..\stdafx.h"
+#include "..\TraceReplay.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace XNMTest
+{
+	TEST_CLASS(TestTraceReplay)
+	{
+		static sds::TraceReplay::ReplayConfig MakeConfig()
+		{
+			sds::TraceReplay::ReplayConfig config;
+			config.mapInfo = "A:NONE:NORM:VK32 X:NONE:NORM:r LTHUMB:UP:NORM:w";
+			config.mouseStick = sds::MouseMap::NEITHER_STICK;
+			return config;
+		}
+	public:
+		TEST_METHOD(TestParseTraceLine)
+		{
+			Logger::WriteMessage("Begin TestParseTraceLine()");
+			sds::TraceReplay::TraceFrame frame = {};
+			XINPUT_STATE state = {};
+			state.dwPacketNumber = 42;
+			state.Gamepad.wButtons = XINPUT_GAMEPAD_A | XINPUT_GAMEPAD_X;
+			state.Gamepad.bRightTrigger = 255;
+			state.Gamepad.sThumbLX = -32768;
+			state.Gamepad.sThumbRY = 32767;
+			const std::string line = "1234 " + sds::Utilities::FlightRecorder::FormatState(state);
+			Assert::IsTrue(sds::TraceReplay::ParseTraceLine(line, frame));
+			Assert::AreEqual(std::uint64_t{ 1234 }, frame.timestampUs);
+			Assert::AreEqual(DWORD{ 42 }, frame.state.dwPacketNumber);
+			Assert::AreEqual(state.Gamepad.wButtons, frame.state.Gamepad.wButtons);
+			Assert::AreEqual(BYTE{ 255 }, frame.state.Gamepad.bRightTrigger);
+			Assert::AreEqual(SHORT{ -32768 }, frame.state.Gamepad.sThumbLX);
+			Assert::AreEqual(SHORT{ 32767 }, frame.state.Gamepad.sThumbRY);
+			Assert::IsFalse(sds::TraceReplay::ParseTraceLine("# comment", frame));
+			Assert::IsFalse(sds::TraceReplay::ParseTraceLine("1234 KEY 32 57 8", frame));
+			Assert::IsFalse(sds::TraceReplay::ParseTraceLine("1234 STATE 1 0 0 0 0 0 0 40000", frame));
+			Logger::WriteMessage("End TestParseTraceLine()");
+		}
+		TEST_METHOD(TestReplayAndCompare)
+		{
+			Logger::WriteMessage("Begin TestReplayAndCompare()");
+			std::vector<sds::TraceReplay::TraceFrame> frames;
+			std::uint64_t timeUs = 0;
+			auto addFrames = [&frames, &timeUs](const WORD buttons, const SHORT ly, const int count)
+			{
+				for (int i = 0; i < count; i++)
+				{
+					sds::TraceReplay::TraceFrame frame = {};
+					frame.timestampUs = timeUs;
+					frame.state.dwPacketNumber = static_cast<DWORD>(frames.size());
+					frame.state.Gamepad.wButtons = buttons;
+					frame.state.Gamepad.sThumbLY = ly;
+					frames.push_back(frame);
+					timeUs += sds::XinSettings::THREAD_DELAY_POLLER * 1000;
+				}
+			};
+			addFrames(0, 0, 5);
+			addFrames(XINPUT_GAMEPAD_A, 0, 20);
+			addFrames(XINPUT_GAMEPAD_A | XINPUT_GAMEPAD_X, sds::XinSettings::SMax, 20);
+			addFrames(0, 0, 5);
+			//X and the thumbstick are still held at the end, they are released by the replay
+			addFrames(XINPUT_GAMEPAD_X, sds::XinSettings::SMax, 5);
+
+			sds::Utilities::RecordingOutputSink sink;
+			sds::TraceReplay replay(MakeConfig(), sink);
+			std::string err;
+			const auto result = replay.Replay(frames, sds::TraceReplay::UNTHROTTLED, err);
+			Assert::IsTrue(err.empty());
+			Assert::AreEqual(frames.size(), result.framesProcessed);
+			Assert::AreEqual(sink.GetCount(), result.outputEvents);
+			Assert::IsTrue(result.outputEvents > 0);
+			//every key pressed was released
+			std::map<WORD, int> keyDownCount;
+			for (const INPUT &inp : sink.GetEvents())
+			{
+				if (inp.type == INPUT_KEYBOARD)
+					keyDownCount[inp.ki.wVk] += (inp.ki.dwFlags & KEYEVENTF_KEYUP) ? -1 : 1;
+			}
+			for (const auto &[vk, count] : keyDownCount)
+				Assert::AreEqual(0, count);
+			const std::vector<std::string> firstRun = sink.GetLines();
+			Logger::WriteMessage(("Unthrottled frames per second: " + std::to_string(result.FramesPerSecond())).c_str());
+
+			//a second run is identical, and a changed golden is reported at the first differing line
+			sink.Clear();
+			const auto secondResult = replay.Replay(frames, sds::TraceReplay::UNTHROTTLED, err);
+			Assert::IsTrue(err.empty());
+			Assert::AreEqual(result.outputEvents, secondResult.outputEvents);
+			auto diff = sds::TraceReplay::Compare(firstRun, sink.GetLines(), true);
+			Assert::IsTrue(diff.IsMatch());
+			std::vector<std::string> changed = firstRun;
+			changed.back() = "KEY 0 0 0";
+			diff = sds::TraceReplay::Compare(changed, sink.GetLines(), true);
+			Assert::IsFalse(diff.IsMatch());
+			Assert::AreEqual(changed.size() - 1, diff.firstMismatchIndex);
+			Assert::AreEqual(size_t{ 1 }, diff.mismatchCount);
+
+			//mouse moves are ignored only when asked
+			std::vector<std::string> withMouse = firstRun;
+			withMouse.push_back("MOUSE 3 -2 " + std::to_string(MOUSEEVENTF_MOVE));
+			Assert::IsTrue(sds::TraceReplay::Compare(withMouse, firstRun, true).IsMatch());
+			Assert::IsFalse(sds::TraceReplay::Compare(withMouse, firstRun, false).IsMatch());
+			Logger::WriteMessage("End TestReplayAndCompare()");
+		}
+	};
+}
@@ -6,6 +6,27 @@
 #include "TestThumbstickToMovement.h"
 #include "TestThumbstickToDelay.h"
 #include "TestSensitivityMap.h"
+#include "TestRadialDeadzone.h"
+#include "TestFlightRecorder.h"
+#include "TestTraceReplay.h"
+#include "TestOutputBackend.h"
+#include "TestMouseMoveCoalescer.h"
+#include "TestThreadPolicy.h"
+#include "TestReactorMode.h"
+#include "TestCoroutinePipeline.h"
+#include "TestMacroPlayer.h"
+#include "TestCompiledProfile.h"
+#include "TestProfileSwitch.h"
+#include "TestMapParser.h"
+#include "TestRuntimeCounters.h"
+#include "TestOutputRetry.h"
+#include "TestAsyncLogger.h"
+#include "TestActionDescriptors.h"
+#include "TestConfigSnapshot.h"
+#include "TestClock.h"
+#include "TestDelayHighPrecision.h"
+#include "TestMouseFrames.h"
+#include "TestMoveTiming.h"
 #include "BuildRandomStrings.h"
 #include <string>
 #include <vector>
@@ -25,7 +46,7 @@ namespace XNMTest
 		//List of tokens in an "ActionDetails"
 		std::vector<std::string> testTokens;
 		//Internal copy of the action descriptors map, mapping string tokens to int value representation of XINPUT defines
-		const std::map<const std::string, int> testMap = sds::sdsActionDescriptors.xin_buttons;
+		const std::map<const std::string, int> testMap{ sds::sdsActionDescriptors.xin_buttons.cbegin(), sds::sdsActionDescriptors.xin_buttons.cend() };
 		//mt19937 is a standard mersenne_twister_engine
 		std::mt19937 mersenneEngine;
 		BuildRandomStrings rsb;
@@ -41,11 +62,11 @@ namespace XNMTest
 			mersenneEngine.seed(rd());
 
 			std::vector<std::string> initVector;
-			auto fillVector = [&initVector](const std::vector<std::string> &currentVec)
+			auto fillVector = [&initVector](const auto &currentVec)
 			{
-				auto addTokens = [&initVector](const std::string &currentString)
+				auto addTokens = [&initVector](const std::string_view currentString)
 				{
-					initVector.push_back(currentString);
+					initVector.emplace_back(currentString);
 				};
 				std::for_each(currentVec.cbegin(), currentVec.cend(), addTokens);
 			};
@@ -53,7 +74,7 @@ namespace XNMTest
 			fillVector(sds::sdsActionDescriptors.FirstFieldValidKeywords);
 			fillVector(sds::sdsActionDescriptors.SecondFieldValidKeywords);
 			fillVector(sds::sdsActionDescriptors.ThirdFieldValidKeywords);
-			initVector.push_back(sds::sdsActionDescriptors.vk);
+			initVector.emplace_back(sds::sdsActionDescriptors.vk);
 
 			testTokens = initVector;
 		}
@@ -187,7 +208,7 @@ namespace XNMTest
 			Assert::IsTrue(sds::sdsActionDescriptors.delimiter > 0);
 			Assert::IsTrue(sds::sdsActionDescriptors.moreInfo > 0);
 
-			//Test std::map<string,int> for size > 0
+			//Test xin_buttons for size > 0
 			Assert::IsFalse(sds::sdsActionDescriptors.xin_buttons.empty());
 			Logger::WriteMessage("End TestActionDescriptorsInit()");
 		}
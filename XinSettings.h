@@ -42,6 +42,9 @@ namespace sds
 		constexpr static const int DEADZONE_MAX = std::numeric_limits<SHORT>::max() - 1;
 		//Deadzone Default is the default deadzone value for a thumbstick.
 		constexpr static const int DEADZONE_DEFAULT = XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE;
+		//Radial Axis Min is the value an axis must exceed after a radial deadzone is applied for the mouse to move on that axis,
+		//one percent of the thumbstick range.
+		constexpr static const int RADIAL_AXIS_MIN = SMax / SENSITIVITY_MAX;
 		//Move Thread Sleep Micro is the delay in microseconds for the XInputBoostMouse work thread loop
 		//the value determines how often the axis threads are told to process a new state (pair of x,y values).
 		constexpr static const int MOVE_THREAD_SLEEP_MICRO = 6000;
@@ -57,6 +60,92 @@ namespace sds
 		constexpr static const size_t PLATFORM_MICROSECONDS_MIN = 1000;
 		//Milliseconds Delay Keyrepeat is the time delay a button has been depressed before sending repeat keystroke signals.
 		constexpr static const int MILLISECONDS_DELAY_KEYREPEAT = 200;
+		//Mouse Coalesce Micro is the default window in microseconds within which mouse move deltas are merged into one event,
+		//zero sends each move as it is produced. Coalescing changes the timing of the mouse output, so it is off unless
+		//a profile or the configuration sets a window.
+		constexpr static const int MOUSE_COALESCE_MICRO = 0;
+		//Player Count is the number of controllers XInput reports, player ids are 0 to PLAYER_COUNT - 1.
+		constexpr static const int PLAYER_COUNT = 4;
+		//Flight Recorder Capacity is the number of events held by the flight recorder ring buffer, must be a power of two.
+		constexpr static const size_t FLIGHT_RECORDER_CAPACITY = 1 << 15;
+		//Flight Recorder Seconds is the default number of seconds of recorded events written by a dump.
+		constexpr static const int FLIGHT_RECORDER_SECONDS = 10;
+		//Flight Recorder Dump File is the file the flight recorder is written to when an error is detected.
+		constexpr static const char FLIGHT_RECORDER_DUMP_FILE[] = "xinmapper_flight_recorder.txt";
+		//Macro Steps Max is the maximum number of steps in one macro binding.
+		constexpr static const size_t MACRO_STEPS_MAX = 256;
+		//Macro Wait Max Milli is the longest wait in milliseconds allowed for one macro step.
+		constexpr static const int MACRO_WAIT_MAX_MILLI = 10000;
+		//Macro Spin Micro is the time in microseconds before a macro frame is due that the macro player
+		//stops sleeping and spins, so frames are sent with sub-millisecond accuracy.
+		constexpr static const int MACRO_SPIN_MICRO = 2 * static_cast<int>(PLATFORM_MICROSECONDS_MIN);
+		//Sleep Spin Margin Micro is the time in microseconds before a precise wait ends that it stops sleeping
+		//on the platform timer and spins, it covers the late wake-up of the timer until TimerSettings::Calibrate() measures it.
+		constexpr static const int SLEEP_SPIN_MARGIN_MICRO = 200;
+		//Mouse Idle Wake Micro is the longest time in microseconds the mouse move thread sleeps between checks of the
+		//axis state, it bounds the delay before a move starts.
+		constexpr static const int MOUSE_IDLE_WAKE_MICRO = 1000;
+		//Mouse Frame Rate Default is the default rate in frames per second of the fixed rate mouse output, each frame
+		//sends at most one move of the distance covered since the last. Zero moves each axis on its own variable delay timer.
+		constexpr static const int MOUSE_FRAME_RATE_DEFAULT = 0;
+		//Mouse Frame Rate Max is the highest fixed mouse output frame rate allowed.
+		constexpr static const int MOUSE_FRAME_RATE_MAX = 2000;
+		//Mouse Move Miss Micro is how late in microseconds a mouse move may be, past the interval requested since the last move
+		//of its axis, before it counts as a missed deadline in the MoveTimingStats.
+		constexpr static const int MOUSE_MOVE_MISS_MICRO = 250;
+		//Timer Calibration Samples is the number of sleeps measured by the startup calibration of the timer.
+		constexpr static const int TIMER_CALIBRATION_SAMPLES = 500;
+		//Timer Calibration Sleep Micro is the length in microseconds of each sleep measured by the timer calibration.
+		constexpr static const int TIMER_CALIBRATION_SLEEP_MICRO = 200;
+		//Timer Spin Margin Medians is how many times the median lateness the calibrated spin margin may be, so a tail
+		//of outliers in the calibration does not turn every precise wait into a long spin.
+		constexpr static const int TIMER_SPIN_MARGIN_MEDIANS = 4;
+		//Timer Spin Margin Max Micro is the largest spin margin in microseconds the timer calibration sets.
+		constexpr static const int TIMER_SPIN_MARGIN_MAX_MICRO = 2000;
+		//Profile Cache Max is the number of compiled profiles the Mapper holds to switch between.
+		constexpr static const size_t PROFILE_CACHE_MAX = 64;
+		//Cache Line Size is the alignment that keeps data written by different threads on separate cache lines.
+		constexpr static const size_t CACHE_LINE_SIZE = 64;
+		//Counter Shards is the number of per-thread shards of the RuntimeCounters, threads beyond it share a shard.
+		constexpr static const size_t COUNTER_SHARDS = 16;
+		//Stats Dump Seconds is the period of the runtime counters dump in the console app, 0 disables it.
+		constexpr static const int STATS_DUMP_SECONDS = 30;
+		//Output Retry Queue Max is the number of INPUT records not inserted by SendInput that are kept to be retried.
+		constexpr static const size_t OUTPUT_RETRY_QUEUE_MAX = 256;
+		//Output Retry Backoff Min Micro is the wait in microseconds before the first retry, it doubles for each retry inserting nothing.
+		constexpr static const int OUTPUT_RETRY_BACKOFF_MIN_MICRO = 500;
+		//Output Retry Backoff Max Micro is the longest wait in microseconds between retries.
+		constexpr static const int OUTPUT_RETRY_BACKOFF_MAX_MICRO = 50000;
+		//Output Retry Persistent is the number of retries in a row inserting nothing that is counted as a persistent failure.
+		constexpr static const size_t OUTPUT_RETRY_PERSISTENT = 5;
+		//Output Flush Timeout Milli is how long the release of all held keys waits for the queued records to be delivered.
+		constexpr static const int OUTPUT_FLUSH_TIMEOUT_MILLI = 1000;
+		//Log Ring Capacity is the number of messages the AsyncLogger holds until its flush thread writes them, must be a power of two.
+		constexpr static const size_t LOG_RING_CAPACITY = 1024;
+		//Log Message Max is the length a logged message is truncated to.
+		constexpr static const size_t LOG_MESSAGE_MAX = 256;
+		//Log Flush Interval Milli is the period in milliseconds of the AsyncLogger flush thread.
+		constexpr static const int LOG_FLUSH_INTERVAL_MILLI = 50;
+		//Log Rate Limit Per Site is the number of messages one call site may log per rate window, the rest are suppressed.
+		constexpr static const std::uint32_t LOG_RATE_LIMIT_PER_SITE = 5;
+		//Log Rate Window Milli is the length in milliseconds of the rate limit window.
+		constexpr static const int LOG_RATE_WINDOW_MILLI = 1000;
+		//Log Rate Sites is the number of rate limit slots the call sites are hashed to.
+		constexpr static const size_t LOG_RATE_SITES = 256;
+		//Log Compiled Min Severity is the lowest severity (0 debug, 1 info, 2 warning, 3 error) of the XErrorLogger::LogFormat()
+		//statements compiled in, those below it compile to nothing. Debug statements are compiled out of release builds.
+#ifdef NDEBUG
+		constexpr static const int LOG_COMPILED_MIN_SEVERITY = 1;
+#else
+		constexpr static const int LOG_COMPILED_MIN_SEVERITY = 0;
+#endif
+		//Profile Pipe Name is the named pipe the PipeProfileSelector reads profile ids from, on Linux the name of
+		//a FIFO in the XDG_RUNTIME_DIR of the user, see PipeProfileSelector::DefaultPipeName().
+#ifdef _WIN32
+		constexpr static const char PROFILE_PIPE_NAME[] = R"(\\.\pipe\xinmapper-profile)";
+#else
+		constexpr static const char PROFILE_PIPE_NAME[] = "xinmapper-profile";
+#endif
 
 		//Static assertions about the const members
 		static_assert(SENSITIVITY_MAX < MICROSECONDS_MAX);
@@ -67,6 +156,33 @@ namespace sds
 		static_assert(MICROSECONDS_MIN < MICROSECONDS_MAX);
 		static_assert(MICROSECONDS_MIN_MAX < MICROSECONDS_MAX);
 		static_assert(MICROSECONDS_MIN_MAX > MICROSECONDS_MIN);
+		static_assert(MOUSE_COALESCE_MICRO >= 0 && MOUSE_COALESCE_MICRO < MICROSECONDS_MAX);
+		static_assert(PLAYER_COUNT > 0);
+		static_assert((FLIGHT_RECORDER_CAPACITY & (FLIGHT_RECORDER_CAPACITY - 1)) == 0);
+		static_assert(MACRO_STEPS_MAX > 0);
+		static_assert(MACRO_SPIN_MICRO >= 0);
+		static_assert(SLEEP_SPIN_MARGIN_MICRO >= 0 && SLEEP_SPIN_MARGIN_MICRO < MICROSECONDS_MAX);
+		static_assert(MOUSE_IDLE_WAKE_MICRO > 0 && MOUSE_IDLE_WAKE_MICRO < MICROSECONDS_MAX);
+		static_assert(MOUSE_FRAME_RATE_DEFAULT >= 0 && MOUSE_FRAME_RATE_DEFAULT <= MOUSE_FRAME_RATE_MAX);
+		static_assert(MOUSE_FRAME_RATE_MAX > 0 && MOUSE_FRAME_RATE_MAX <= 1'000'000);
+		static_assert(MOUSE_MOVE_MISS_MICRO > 0 && MOUSE_MOVE_MISS_MICRO < MICROSECONDS_MAX);
+		static_assert(TIMER_CALIBRATION_SAMPLES > 0);
+		static_assert(TIMER_CALIBRATION_SLEEP_MICRO > 0);
+		static_assert(TIMER_SPIN_MARGIN_MEDIANS > 0);
+		static_assert(TIMER_SPIN_MARGIN_MAX_MICRO >= SLEEP_SPIN_MARGIN_MICRO && TIMER_SPIN_MARGIN_MAX_MICRO < MICROSECONDS_MAX);
+		static_assert(PROFILE_CACHE_MAX > 0);
+		static_assert((CACHE_LINE_SIZE & (CACHE_LINE_SIZE - 1)) == 0);
+		static_assert(COUNTER_SHARDS > 0);
+		static_assert(STATS_DUMP_SECONDS >= 0);
+		static_assert(OUTPUT_RETRY_QUEUE_MAX > 0);
+		static_assert(OUTPUT_RETRY_BACKOFF_MIN_MICRO > 0 && OUTPUT_RETRY_BACKOFF_MIN_MICRO <= OUTPUT_RETRY_BACKOFF_MAX_MICRO);
+		static_assert(OUTPUT_RETRY_PERSISTENT > 0);
+		static_assert(LOG_RING_CAPACITY > 1 && (LOG_RING_CAPACITY & (LOG_RING_CAPACITY - 1)) == 0);
+		static_assert(LOG_MESSAGE_MAX > 0 && LOG_MESSAGE_MAX <= std::numeric_limits<std::uint16_t>::max());
+		static_assert(LOG_FLUSH_INTERVAL_MILLI > 0);
+		static_assert(LOG_RATE_WINDOW_MILLI > 0);
+		static_assert(LOG_RATE_SITES > 0);
+		static_assert(LOG_COMPILED_MIN_SEVERITY >= 0 && LOG_COMPILED_MIN_SEVERITY <= 3);
 
 		static bool IsValidSensitivityValue(int newSens)
 		{
@@ -80,6 +196,18 @@ namespace sds
 		{
 			return (thumb <= SMax) && (thumb >= SMin);
 		}
+		static bool IsValidCoalesceValue(int micros)
+		{
+			return (micros <= MICROSECONDS_MAX) && (micros >= 0);
+		}
+		static bool IsValidFrameRateValue(int hz)
+		{
+			return (hz <= MOUSE_FRAME_RATE_MAX) && (hz >= 0);
+		}
+		static bool IsValidMacroWaitValue(double millis)
+		{
+			return (millis <= MACRO_WAIT_MAX_MILLI) && (millis > 0.0);
+		}
 	};
 }
 
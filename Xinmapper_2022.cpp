@@ -3,6 +3,7 @@
 //Keep in mind need to run the .exe in administrator mode to work with programs running in admin mode.
 #include "stdafx.h"
 #include "GamepadUser.h"
+#include "TimerSettings.h"
 
 int _tmain(int argc, _TCHAR* argv[])
 {
@@ -12,6 +13,8 @@ int _tmain(int argc, _TCHAR* argv[])
 		std::cerr << e << std::endl;
 		return retVal;
 	};
+	//measure the sleep granularity of the host before the worker threads start, with the finer timer period requested
+	std::cout << "Timer " << Utilities::TimerSettings::Get().Calibrate(XinSettings::TIMER_CALIBRATION_SAMPLES, true).ToString() << std::endl;
 	MapInformation mapInfo;
 	GamepadUser gamepadUser;
 	mapInfo = "LTHUMB:LEFT:NORM:a LTHUMB:RIGHT:NORM:d LTHUMB:UP:NORM:w LTHUMB:DOWN:NORM:s X:NONE:NORM:r A:NONE:NORM:VK32 Y:NONE:NORM:VK164 B:NONE:NORM:VK160";
@@ -33,8 +36,16 @@ int _tmain(int argc, _TCHAR* argv[])
 	gamepadUser.mouse.EnableProcessing(MouseMap::RIGHT_STICK);
 	std::cout << "Xbox 360 controller polling started..." << std::endl;
 	std::cout << "Controller reported as: " << (gamepadUser.poller.IsControllerConnected() ? "Connected." : "Disconnected.") << std::endl;
+	auto lastStatsDump = std::chrono::steady_clock::now();
 	for( ;; )
 	{
+		//periodic dump of the runtime counters
+		if (XinSettings::STATS_DUMP_SECONDS > 0 && std::chrono::steady_clock::now() - lastStatsDump >= std::chrono::seconds(XinSettings::STATS_DUMP_SECONDS))
+		{
+			std::cout << "Stats " << gamepadUser.GetStats().ToString() << std::endl;
+			std::cout << "Mouse timing " << gamepadUser.mouse.GetMoveTiming().ToString() << std::endl;
+			lastStatsDump = std::chrono::steady_clock::now();
+		}
 		if(!gamepadUser.poller.IsRunning() && gamepadUser.poller.IsControllerConnected() )
 		{
 			std::cout << "Controller reported as: " << "Connected." << std::endl;
@@ -44,6 +55,7 @@ int _tmain(int argc, _TCHAR* argv[])
 		{
 			std::cout << "Controller reported as: " << "Disconnected." << std::endl;
 			gamepadUser.poller.Stop();
+			gamepadUser.mapper.ReleaseHeldKeys();
 		}
 		std::this_thread::yield();
 		std::this_thread::sleep_for(std::chrono::milliseconds(10));
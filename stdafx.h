@@ -13,14 +13,20 @@
 #endif
 
 
+#ifdef _WIN32
 #include <windows.h>
 #include <Xinput.h>
 //#include <process.h>
 #include <tchar.h>
+#else
+#include "LinuxCompat.h"
+#endif
 //#include <intrin.h>
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <vector>
 #include <sstream>
 #include <algorithm>
@@ -36,7 +42,11 @@
 #include <format>
 #include <chrono>
 #include <variant>
+#include <optional>
+#include <bit>
 #include <array>
+#include <atomic>
+#include <fstream>
 
 #include <cstdio>
 #include <cmath>
@@ -48,6 +58,8 @@
 #include "ActionDescriptors.h"
 #include "Globals.h"
 #include "MouseMap.h"
+#include "DeadzoneMode.h"
+#include "ExecutionMode.h"
 #include "PlayerInfo.h"
 #include "XinSettings.h"
 #include "XErrorLogger.h"